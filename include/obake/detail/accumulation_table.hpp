@@ -0,0 +1,268 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_DETAIL_ACCUMULATION_TABLE_HPP
+#define OBAKE_DETAIL_ACCUMULATION_TABLE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <obake/config.hpp>
+#include <obake/detail/limits.hpp>
+#include <obake/exceptions.hpp>
+
+namespace obake::detail
+{
+
+// A minimal open-addressing hash table (with linear probing)
+// for the accumulation of term-by-term products in the multiplication
+// routines. Unlike abseil's flat_hash_map, the value associated
+// to a new key is constructed in place only when the insertion actually
+// takes place, and the table is left in a consistent state if the
+// construction of the value (or the accumulation into an existing
+// value) throws. See:
+// https://github.com/abseil/abseil-cpp/issues/388
+// The table supports only insertion/accumulation and
+// draining of its content, no erasure.
+// NOTE: the hasher is expected to produce well-mixed values,
+// as the bucket index is computed by masking the low bits
+// of the hash (e.g., series_key_hasher).
+template <typename K, typename V, typename Hash, typename Eq>
+class accumulation_table
+{
+public:
+    using value_type = ::std::pair<K, V>;
+    using size_type = ::std::size_t;
+
+private:
+    // Uninitialised storage for an element.
+    struct slot {
+        alignas(value_type) unsigned char m_data[sizeof(value_type)];
+    };
+
+    // Min capacity and max load factor (expressed
+    // as a numerator over a denominator).
+    static constexpr size_type min_capacity = 16;
+    static constexpr size_type max_load_num = 3;
+    static constexpr size_type max_load_den = 4;
+
+    // Access the value stored in a slot.
+    // NOTE: go through void * in order to avoid
+    // cast-align warnings (the storage is suitably aligned).
+    static value_type *slot_value(slot &s)
+    {
+        return ::std::launder(static_cast<value_type *>(static_cast<void *>(s.m_data)));
+    }
+    static const value_type *slot_value(const slot &s)
+    {
+        return ::std::launder(static_cast<const value_type *>(static_cast<const void *>(s.m_data)));
+    }
+
+    value_type *slot_ptr(size_type idx)
+    {
+        return accumulation_table::slot_value(m_slots[idx]);
+    }
+
+    // Fetch the index of the first slot which is either empty
+    // or contains k, starting from the bucket of k.
+    // NOTE: the load factor guarantees that there's at
+    // least an empty slot, thus this will always terminate.
+    size_type probe(const K &k, size_type h) const
+    {
+        assert(m_capacity > 0u);
+
+        const auto mask = m_capacity - 1u;
+        auto idx = h & mask;
+        while (m_ctrl[idx] != 0u && !Eq{}(accumulation_table::slot_value(m_slots[idx])->first, k)) {
+            idx = (idx + 1u) & mask;
+        }
+
+        return idx;
+    }
+
+    // Move the elements into new storage with capacity new_cap.
+    // If an exception is thrown, the table is left unmodified.
+    void rehash(size_type new_cap)
+    {
+        // NOTE: the capacity must always be a power of 2.
+        assert(new_cap >= min_capacity && (new_cap & (new_cap - 1u)) == 0u);
+        assert(new_cap > m_size);
+
+        ::std::unique_ptr<slot[]> new_slots(new slot[new_cap]);
+        ::std::unique_ptr<unsigned char[]> new_ctrl(new unsigned char[new_cap]());
+
+        auto destroy_new = [&new_slots, &new_ctrl, new_cap]() {
+            for (size_type i = 0; i < new_cap; ++i) {
+                if (new_ctrl[i] != 0u) {
+                    accumulation_table::slot_value(new_slots[i])->~value_type();
+                }
+            }
+        };
+
+        try {
+            const auto mask = new_cap - 1u;
+            for (size_type i = 0; i < m_capacity; ++i) {
+                if (m_ctrl[i] == 0u) {
+                    continue;
+                }
+
+                auto &p = *slot_ptr(i);
+
+                // NOTE: the keys are unique, we just need
+                // to look for the first empty slot.
+                auto idx = static_cast<size_type>(Hash{}(p.first)) & mask;
+                while (new_ctrl[idx] != 0u) {
+                    idx = (idx + 1u) & mask;
+                }
+
+                ::new (static_cast<void *>(new_slots[idx].m_data)) value_type(::std::move_if_noexcept(p));
+                new_ctrl[idx] = 1;
+            }
+            // LCOV_EXCL_START
+        } catch (...) {
+            destroy_new();
+            throw;
+        }
+        // LCOV_EXCL_STOP
+
+        // Destroy the old elements and switch to the new storage.
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] != 0u) {
+                slot_ptr(i)->~value_type();
+            }
+        }
+
+        m_slots = ::std::move(new_slots);
+        m_ctrl = ::std::move(new_ctrl);
+        m_capacity = new_cap;
+    }
+
+    // Compute the capacity necessary to store n elements
+    // without exceeding the max load factor.
+    static size_type capacity_for(size_type n)
+    {
+        size_type cap = min_capacity;
+        while (cap / max_load_den * max_load_num < n) {
+            // LCOV_EXCL_START
+            if (obake_unlikely(cap > limits_max<size_type> / 2u)) {
+                obake_throw(::std::overflow_error,
+                            "Overflow detected while computing the capacity of an accumulation table");
+            }
+            // LCOV_EXCL_STOP
+            cap *= 2u;
+        }
+
+        return cap;
+    }
+
+public:
+    accumulation_table() = default;
+    accumulation_table(const accumulation_table &) = delete;
+    accumulation_table(accumulation_table &&) = delete;
+    accumulation_table &operator=(const accumulation_table &) = delete;
+    accumulation_table &operator=(accumulation_table &&) = delete;
+    ~accumulation_table()
+    {
+        clear();
+    }
+
+    size_type size() const
+    {
+        return m_size;
+    }
+
+    // Make sure that n elements can be inserted
+    // without triggering a rehash.
+    void reserve(size_type n)
+    {
+        if (const auto new_cap = capacity_for(n); new_cap > m_capacity) {
+            rehash(new_cap);
+        }
+    }
+
+    // If k is not in the table, insert it together with the value
+    // returned by ctor(). Otherwise, invoke acc() on the value
+    // associated to k. If ctor() or acc() throw, the table is left in
+    // a consistent state (and, in the case of ctor(), unmodified).
+    template <typename Ctor, typename Acc>
+    void insert_or_accumulate(const K &k, Ctor &&ctor, Acc &&acc)
+    {
+        if (obake_unlikely(m_capacity == 0u)) {
+            rehash(min_capacity);
+        }
+
+        const auto h = static_cast<size_type>(Hash{}(k));
+        auto idx = probe(k, h);
+
+        if (m_ctrl[idx] != 0u) {
+            // The key exists already, accumulate.
+            ::std::forward<Acc>(acc)(slot_ptr(idx)->second);
+            return;
+        }
+
+        // The key does not exist, check if we need
+        // to grow the table before inserting.
+        if (obake_unlikely(m_size + 1u > m_capacity / max_load_den * max_load_num)) {
+            rehash(capacity_for(m_size + 1u));
+            idx = probe(k, h);
+            assert(m_ctrl[idx] == 0u);
+        }
+
+        // NOTE: flag the slot as occupied only after
+        // the construction has succeeded.
+        ::new (static_cast<void *>(m_slots[idx].m_data)) value_type(k, ::std::forward<Ctor>(ctor)());
+        m_ctrl[idx] = 1;
+        ++m_size;
+    }
+
+    // Invoke f() on rvalue references to the key and value of
+    // each element, and then empty the table. The capacity
+    // of the table is preserved. If f() throws, the elements
+    // already visited will be in a valid but unspecified state.
+    template <typename F>
+    void consume(F &&f)
+    {
+        for (size_type i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] != 0u) {
+                auto &p = *slot_ptr(i);
+                f(::std::move(p.first), ::std::move(p.second));
+            }
+        }
+
+        clear();
+    }
+
+    // Destroy all elements, preserving the capacity.
+    void clear()
+    {
+        for (size_type i = 0; m_size > 0u && i < m_capacity; ++i) {
+            if (m_ctrl[i] != 0u) {
+                slot_ptr(i)->~value_type();
+                m_ctrl[i] = 0;
+                --m_size;
+            }
+        }
+
+        assert(m_size == 0u);
+    }
+
+private:
+    ::std::unique_ptr<slot[]> m_slots;
+    ::std::unique_ptr<unsigned char[]> m_ctrl;
+    size_type m_capacity = 0;
+    size_type m_size = 0;
+};
+
+} // namespace obake::detail
+
+#endif
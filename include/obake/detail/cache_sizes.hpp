@@ -0,0 +1,36 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_DETAIL_CACHE_SIZES_HPP
+#define OBAKE_DETAIL_CACHE_SIZES_HPP
+
+#include <cstddef>
+
+#include <obake/detail/visibility.hpp>
+
+namespace obake::detail
+{
+
+// The sizes (in bytes) of the L1 data cache,
+// and of the L2 and L3 caches of the system.
+// A value of zero means that the size
+// could not be determined.
+struct cache_sizes {
+    ::std::size_t l1d = 0;
+    ::std::size_t l2 = 0;
+    ::std::size_t l3 = 0;
+};
+
+// Return the cache sizes of the system.
+// The detection is run only once, on the first
+// invocation of this function.
+OBAKE_DLL_PUBLIC const cache_sizes &get_cache_sizes();
+
+} // namespace obake::detail
+
+#endif
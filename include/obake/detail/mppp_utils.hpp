@@ -13,6 +13,7 @@
 #include <type_traits>
 
 #include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
 
 namespace obake::detail
 {
@@ -30,6 +31,19 @@ struct is_mppp_integer<::mppp::integer<SSize>> : ::std::true_type {
 template <typename T>
 inline constexpr bool is_mppp_integer_v = is_mppp_integer<T>::value;
 
+// Small helper to detect if a type is an
+// mppp::rational.
+template <typename>
+struct is_mppp_rational : ::std::false_type {
+};
+
+template <::std::size_t SSize>
+struct is_mppp_rational<::mppp::rational<SSize>> : ::std::true_type {
+};
+
+template <typename T>
+inline constexpr bool is_mppp_rational_v = is_mppp_rational<T>::value;
+
 } // namespace obake::detail
 
 #endif
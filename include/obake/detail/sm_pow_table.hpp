@@ -0,0 +1,100 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_DETAIL_SM_POW_TABLE_HPP
+#define OBAKE_DETAIL_SM_POW_TABLE_HPP
+
+#include <cassert>
+#include <memory>
+#include <utility>
+
+#include <tbb/concurrent_unordered_map.h>
+
+#include <obake/math/pow.hpp>
+#include <obake/symbols.hpp>
+#include <obake/type_traits.hpp>
+
+namespace obake::detail
+{
+
+// A table of the powers of the values in a symbol_idx_map,
+// keyed by (position in the map, exponent). The powers are
+// computed lazily on first access, and the table can be accessed
+// concurrently from multiple threads. The table is meant to be
+// shared by all the keys of a series during a single evaluation
+// or substitution, so that the powers of the same value are
+// computed only once.
+// NOTE: the table stores a reference to the map, which
+// must thus outlive the table.
+template <typename U, typename E>
+class sm_pow_table
+{
+public:
+    // NOTE: use detected_t, so that the instantiation of the class
+    // (e.g., during ADL) does not error out if U is not exponentiable.
+    using value_type = remove_cvref_t<detected_t<pow_t, const U &, const E &>>;
+    using size_type = typename symbol_idx_map<U>::size_type;
+
+    explicit sm_pow_table(const symbol_idx_map<U> &sm)
+        : m_sm(sm), m_tables(::std::make_unique<table_t[]>(sm.size()))
+    {
+    }
+    sm_pow_table(const sm_pow_table &) = delete;
+    sm_pow_table(sm_pow_table &&) = delete;
+    sm_pow_table &operator=(const sm_pow_table &) = delete;
+    sm_pow_table &operator=(sm_pow_table &&) = delete;
+    ~sm_pow_table() = default;
+
+    const symbol_idx_map<U> &get_map() const
+    {
+        return m_sm;
+    }
+
+    // Fetch the power of the value at position i
+    // in the map to the exponent n.
+    const value_type &operator()(size_type i, const E &n)
+    {
+        assert(i < m_sm.size());
+
+        auto &tab = m_tables[i];
+
+        if (const auto it = tab.find(n); it != tab.end()) {
+            return it->second;
+        }
+
+        // NOTE: the power is computed without holding
+        // any lock, thus multiple threads may end up
+        // computing the same power concurrently. Only
+        // one of the results will be inserted into the table.
+        return tab.emplace(n, ::obake::pow((m_sm.cbegin() + i)->second, n)).first->second;
+    }
+
+private:
+    using table_t = ::tbb::concurrent_unordered_map<E, value_type>;
+
+    const symbol_idx_map<U> &m_sm;
+    ::std::unique_ptr<table_t[]> m_tables;
+};
+
+// Detect the key_evaluate() and monomial_subs() implementations
+// for the key type K backed by an sm_pow_table for values of type U.
+// The implementations are found via ADL, and the exponent type
+// of the table is the value type of K.
+template <typename K, typename U>
+using key_evaluate_with_table_t = decltype(key_evaluate_with_table(
+    ::std::declval<const K &>(), ::std::declval<sm_pow_table<U, typename K::value_type> &>(),
+    ::std::declval<const symbol_set &>()));
+
+template <typename K, typename U>
+using monomial_subs_with_table_t = decltype(monomial_subs_with_table(
+    ::std::declval<const K &>(), ::std::declval<sm_pow_table<U, typename K::value_type> &>(),
+    ::std::declval<const symbol_set &>()));
+
+} // namespace obake::detail
+
+#endif
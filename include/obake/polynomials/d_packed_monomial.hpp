@@ -41,6 +41,7 @@
 #include <obake/detail/limits.hpp>
 #include <obake/detail/mppp_utils.hpp>
 #include <obake/detail/safe_integral_arith.hpp>
+#include <obake/detail/sm_pow_table.hpp>
 #include <obake/detail/to_string.hpp>
 #include <obake/detail/type_c.hpp>
 #include <obake/detail/visibility.hpp>
@@ -1084,14 +1085,35 @@ inline constexpr int dpm_key_evaluate_algo = dpm_key_evaluate_algorithm<T, U>.fi
 template <typename T, typename U>
 using dpm_key_evaluate_ret_t = typename decltype(dpm_key_evaluate_algorithm<T, U>.second)::type;
 
-} // namespace detail
+// The evaluation (and substitution) via an sm_pow_table
+// requires also the in-place multiplication of the return
+// value by the const powers stored in the table (whose
+// type is the value type of the table).
+template <typename T, typename U>
+constexpr bool dpm_key_evaluate_with_table_algorithm_impl()
+{
+    if constexpr (dpm_key_evaluate_algo<T, U> != 0) {
+        using ret_t = dpm_key_evaluate_ret_t<T, U>;
 
-// Evaluation of a dynamic packed monomial.
+        return is_in_place_multipliable_v<::std::add_lvalue_reference_t<ret_t>,
+                                          const typename ::obake::detail::sm_pow_table<U, T>::value_type &>;
+    } else {
+        return false;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool dpm_key_evaluate_with_table_algo = detail::dpm_key_evaluate_with_table_algorithm_impl<T, U>();
+
+// Implementation of the evaluation of a dynamic packed monomial.
+// The power of the value pointed to by the iterator it
+// of sm to the exponent n is computed via pw(it, n).
 // NOTE: this requires that d is compatible with ss,
 // and that sm is consistent with ss.
-template <typename T, unsigned PSize, typename U, ::std::enable_if_t<detail::dpm_key_evaluate_algo<T, U> != 0, int> = 0>
-inline detail::dpm_key_evaluate_ret_t<T, U> key_evaluate(const d_packed_monomial<T, PSize> &d,
-                                                         const symbol_idx_map<U> &sm, const symbol_set &ss)
+template <typename T, unsigned PSize, typename U, typename F>
+inline dpm_key_evaluate_ret_t<T, U> dpm_key_evaluate_impl(const d_packed_monomial<T, PSize> &d,
+                                                          const symbol_idx_map<U> &sm, const symbol_set &ss,
+                                                          const F &pw)
 {
     assert(polynomials::key_is_compatible(d, ss));
     // sm and ss must have the same size, and the last element
@@ -1099,7 +1121,7 @@ inline detail::dpm_key_evaluate_ret_t<T, U> key_evaluate(const d_packed_monomial
     assert(sm.size() == ss.size() && (sm.empty() || (sm.cend() - 1)->first == ss.size() - 1u));
 
     // Init the return value.
-    detail::dpm_key_evaluate_ret_t<T, U> retval(1);
+    dpm_key_evaluate_ret_t<T, U> retval(1);
     T tmp;
     auto sm_it = sm.begin();
     const auto sm_end = sm.end();
@@ -1109,13 +1131,43 @@ inline detail::dpm_key_evaluate_ret_t<T, U> key_evaluate(const d_packed_monomial
 
         for (auto j = 0u; j < PSize && sm_it != sm_end; ++j, ++sm_it) {
             ku >> tmp;
-            retval *= ::obake::pow(sm_it->second, ::std::as_const(tmp));
+            retval *= pw(sm_it, ::std::as_const(tmp));
         }
     }
 
     return retval;
 }
 
+} // namespace detail
+
+// Evaluation of a dynamic packed monomial.
+// NOTE: this requires that d is compatible with ss,
+// and that sm is consistent with ss.
+template <typename T, unsigned PSize, typename U, ::std::enable_if_t<detail::dpm_key_evaluate_algo<T, U> != 0, int> = 0>
+inline detail::dpm_key_evaluate_ret_t<T, U> key_evaluate(const d_packed_monomial<T, PSize> &d,
+                                                         const symbol_idx_map<U> &sm, const symbol_set &ss)
+{
+    return detail::dpm_key_evaluate_impl(d, sm, ss,
+                                         [](const auto &it, const T &n) { return ::obake::pow(it->second, n); });
+}
+
+// Evaluation of a dynamic packed monomial, fetching
+// the powers from the table pt (see detail::sm_pow_table).
+// NOTE: this requires that d is compatible with ss,
+// and that the map of pt is consistent with ss.
+template <typename T, unsigned PSize, typename U,
+          ::std::enable_if_t<detail::dpm_key_evaluate_with_table_algo<T, U>, int> = 0>
+inline detail::dpm_key_evaluate_ret_t<T, U> key_evaluate_with_table(const d_packed_monomial<T, PSize> &d,
+                                                                    ::obake::detail::sm_pow_table<U, T> &pt,
+                                                                    const symbol_set &ss)
+{
+    const auto &sm = pt.get_map();
+
+    return detail::dpm_key_evaluate_impl(d, sm, ss, [&pt, &sm](const auto &it, const T &n) -> const auto & {
+        return pt(static_cast<decltype(sm.size())>(it - sm.cbegin()), n);
+    });
+}
+
 namespace detail
 {
 
@@ -1132,15 +1184,15 @@ inline constexpr int dpm_monomial_subs_algo = dpm_key_evaluate_algorithm<T, U>.f
 template <typename T, typename U>
 using dpm_monomial_subs_ret_t = typename decltype(dpm_key_evaluate_algorithm<T, U>.second)::type;
 
-} // namespace detail
-
-// Substitution of symbols in a dynamic packed monomial.
+// Implementation of the substitution of symbols in a dynamic packed monomial.
+// The power of the value pointed to by the iterator it
+// of sm to the exponent n is computed via pw(it, n).
 // NOTE: this requires that d is compatible with ss,
 // and that sm is consistent with ss.
-template <typename T, unsigned PSize, typename U,
-          ::std::enable_if_t<detail::dpm_monomial_subs_algo<T, U> != 0, int> = 0>
-inline ::std::pair<detail::dpm_monomial_subs_ret_t<T, U>, d_packed_monomial<T, PSize>>
-monomial_subs(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm, const symbol_set &ss)
+template <typename T, unsigned PSize, typename U, typename F>
+inline ::std::pair<dpm_monomial_subs_ret_t<T, U>, d_packed_monomial<T, PSize>>
+dpm_monomial_subs_impl(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm, const symbol_set &ss,
+                       const F &pw)
 {
     assert(polynomials::key_is_compatible(d, ss));
     // sm must not be larger than ss, and the last element
@@ -1154,7 +1206,7 @@ monomial_subs(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm,
     d_packed_monomial<T, PSize> out_dpm;
     auto &out_c = out_dpm._container();
     out_c.reserve(in_c.size());
-    detail::dpm_monomial_subs_ret_t<T, U> retval(1);
+    dpm_monomial_subs_ret_t<T, U> retval(1);
 
     symbol_idx idx = 0;
     auto sm_it = sm.begin();
@@ -1170,7 +1222,7 @@ monomial_subs(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm,
             if (sm_it != sm_end && sm_it->first == idx) {
                 // The current exponent is in the subs map,
                 // accumulate the result of the substitution.
-                retval *= ::obake::pow(sm_it->second, ::std::as_const(tmp));
+                retval *= pw(sm_it, ::std::as_const(tmp));
 
                 // Set the exponent to zero in the output
                 // monomial.
@@ -1193,6 +1245,37 @@ monomial_subs(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm,
     return ::std::make_pair(::std::move(retval), ::std::move(out_dpm));
 }
 
+} // namespace detail
+
+// Substitution of symbols in a dynamic packed monomial.
+// NOTE: this requires that d is compatible with ss,
+// and that sm is consistent with ss.
+template <typename T, unsigned PSize, typename U,
+          ::std::enable_if_t<detail::dpm_monomial_subs_algo<T, U> != 0, int> = 0>
+inline ::std::pair<detail::dpm_monomial_subs_ret_t<T, U>, d_packed_monomial<T, PSize>>
+monomial_subs(const d_packed_monomial<T, PSize> &d, const symbol_idx_map<U> &sm, const symbol_set &ss)
+{
+    return detail::dpm_monomial_subs_impl(d, sm, ss,
+                                          [](const auto &it, const T &n) { return ::obake::pow(it->second, n); });
+}
+
+// Substitution of symbols in a dynamic packed monomial, fetching
+// the powers from the table pt (see detail::sm_pow_table).
+// NOTE: this requires that d is compatible with ss,
+// and that the map of pt is consistent with ss.
+template <typename T, unsigned PSize, typename U,
+          ::std::enable_if_t<detail::dpm_key_evaluate_with_table_algo<T, U>, int> = 0>
+inline ::std::pair<detail::dpm_monomial_subs_ret_t<T, U>, d_packed_monomial<T, PSize>>
+monomial_subs_with_table(const d_packed_monomial<T, PSize> &d, ::obake::detail::sm_pow_table<U, T> &pt,
+                         const symbol_set &ss)
+{
+    const auto &sm = pt.get_map();
+
+    return detail::dpm_monomial_subs_impl(d, sm, ss, [&pt, &sm](const auto &it, const T &n) -> const auto & {
+        return pt(static_cast<decltype(sm.size())>(it - sm.cbegin()), n);
+    });
+}
+
 // Identify non-trimmable exponents in d.
 // NOTE: this requires that d is compatible with ss,
 // and that v has the same size as ss.
@@ -1340,6 +1423,58 @@ monomial_diff(const d_packed_monomial<dpm_default_s_t, dpm_default_psize> &, con
 extern template ::std::pair<dpm_default_u_t, d_packed_monomial<dpm_default_u_t, dpm_default_psize>>
 monomial_diff(const d_packed_monomial<dpm_default_u_t, dpm_default_psize> &, const symbol_idx &, const symbol_set &);
 
+// Monomial gradient: differentiate d with respect to all the
+// symbols in ss, unpacking d only once. On output, out[i]
+// contains the result of monomial_diff(d, i, ss).
+// NOTE: this requires that d is compatible with ss.
+template <typename T, unsigned PSize>
+inline void monomial_gradient(::std::vector<::std::pair<T, d_packed_monomial<T, PSize>>> &out,
+                              const d_packed_monomial<T, PSize> &d, const symbol_set &ss)
+{
+    assert(polynomials::key_is_compatible(d, ss));
+
+    out.clear();
+
+    const auto s_size = ss.size();
+    const auto &in_c = d._container();
+
+    const auto lim_min = ::obake::detail::kpack_get_lims<T>(PSize).first;
+    const auto delta = ::obake::detail::kpack_get_delta<T>(PSize);
+
+    symbol_idx i = 0;
+    T tmp;
+    for (decltype(in_c.size()) c_idx = 0; c_idx < in_c.size(); ++c_idx) {
+        kunpacker<T> ku(in_c[c_idx], PSize);
+        T cur_prod(1);
+
+        for (auto j = 0u; j < PSize && i < s_size; ++j, ++i) {
+            ku >> tmp;
+
+            if (tmp == T(0)) {
+                out.emplace_back(T(0), d);
+            } else if (obake_unlikely(tmp < lim_min + T(1))) {
+                // NOTE: the decremented exponent is outside
+                // the allowed range, let monomial_diff()
+                // deal with it.
+                out.push_back(polynomials::monomial_diff(d, i, ss));
+            } else {
+                // NOTE: because the Kronecker encoding is linear,
+                // decrementing the exponent amounts to subtracting
+                // from the packed value the corresponding
+                // component of the coding vector.
+                auto &ret = out.emplace_back(tmp, d);
+                ret.second._container()[c_idx] = static_cast<T>(in_c[c_idx] - cur_prod);
+            }
+
+            // NOTE: avoid computing the component past
+            // the last one, which might overflow.
+            if (j + 1u < PSize) {
+                cur_prod = static_cast<T>(cur_prod * delta);
+            }
+        }
+    }
+}
+
 // Monomial integration.
 // NOTE: this requires that d is compatible with ss,
 // and idx is within ss.
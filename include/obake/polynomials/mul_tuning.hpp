@@ -0,0 +1,114 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#ifndef OBAKE_POLYNOMIALS_MUL_TUNING_HPP
+#define OBAKE_POLYNOMIALS_MUL_TUNING_HPP
+
+#include <cstddef>
+
+#include <obake/detail/visibility.hpp>
+
+namespace obake::polynomials
+{
+
+namespace detail
+{
+
+// The default segment sizes, deduced from
+// the cache sizes detected at runtime.
+OBAKE_DLL_PUBLIC ::std::size_t mul_tuning_default_sparse_seg_size();
+OBAKE_DLL_PUBLIC ::std::size_t mul_tuning_default_dense_seg_size();
+
+} // namespace detail
+
+// Tunable parameters for the multithreaded
+// polynomial multiplication.
+struct OBAKE_DLL_PUBLIC mul_tuning {
+    // Target segment size (in bytes) for sparse products.
+    // Sparse products have a low computational density,
+    // thus we want large segments in order to amortise
+    // the parallelisation overhead.
+    ::std::size_t sparse_seg_size = detail::mul_tuning_default_sparse_seg_size();
+    // Target segment size (in bytes) for dense products.
+    // Dense products have a high computational density,
+    // thus we want small segments which stay in the fastest
+    // levels of the cache hierarchy.
+    ::std::size_t dense_seg_size = detail::mul_tuning_default_dense_seg_size();
+    // Estimated sparsity threshold above which a product
+    // is considered sparse (for the purpose of choosing
+    // the segment size).
+    // NOTE: the default thresholds are rule-of-thumb
+    // values inferred from the benchmarks.
+    double sparse_threshold = 1E-3;
+    // The multi-threaded multiplication (as well as the
+    // multiplication via primitive parts and the multi-modular
+    // multiplication) is used only if the byte size of the
+    // larger factor is at least mt_min_bytes. Smaller
+    // products are computed serially.
+    ::std::size_t mt_min_bytes = 30000;
+    // The dense multiplication engine is used only
+    // for products whose estimated sparsity is
+    // less than this value.
+    double dense_engine_max_sp = 1E-2;
+    // The heap-based multiplication is used only for products
+    // whose estimated sparsity is at least heap_min_sp and whose
+    // estimated size (in bytes) is at least heap_min_bytes.
+    // NOTE: by default, the heap-based multiplication kicks in when,
+    // on average, less than 2 term-by-term multiplications
+    // contribute to each term of the product, and the product
+    // is larger than 1GB.
+    double heap_min_sp = .5;
+    unsigned long long heap_min_bytes = 1ull << 30;
+    // The multi-modular multiplication is used for polynomials
+    // with mppp::integer coefficients only if the largest
+    // coefficient of each factor has at least this number of bits.
+    // NOTE: by default, 16 limbs. Below that, the mppp::integer arithmetic
+    // is competitive with the multiple multiplications and
+    // the reconstruction required by the multi-modular approach.
+    ::std::size_t crt_min_nbits = 1024;
+    // The multiplication of polynomials with mppp::rational
+    // coefficients is performed on the primitive parts of the
+    // factors only if, for each factor, the estimated average bit size
+    // of the coefficients of the primitive part is at most
+    // primitive_max_growth times the average bit size
+    // of the rational coefficients.
+    // NOTE: the rescaling to the primitive part inflates the
+    // coefficients when the denominators have few common factors,
+    // in which case the integral arithmetic on the inflated
+    // coefficients is slower than the rational arithmetic.
+    double primitive_max_growth = 4;
+
+    // The default tuning parameters (i.e., the values of a
+    // default-constructed mul_tuning), with segment sizes deduced
+    // from the cache sizes detected at runtime.
+    static mul_tuning get_default();
+};
+
+// Get/set/reset the global tuning parameters.
+// NOTE: the parameters are global (rather than, e.g.,
+// thread-local) because the multiplications run on
+// the TBB thread pool: the tasks of a single multiplication
+// (and the multiplications of the coefficients) can run
+// on any worker thread.
+OBAKE_DLL_PUBLIC mul_tuning get_mul_tuning();
+OBAKE_DLL_PUBLIC void set_mul_tuning(const mul_tuning &);
+OBAKE_DLL_PUBLIC void reset_mul_tuning();
+
+} // namespace obake::polynomials
+
+namespace obake
+{
+
+using polynomials::get_mul_tuning;
+using polynomials::mul_tuning;
+using polynomials::reset_mul_tuning;
+using polynomials::set_mul_tuning;
+
+} // namespace obake
+
+#endif
@@ -36,6 +36,7 @@
 #include <obake/config.hpp>
 #include <obake/detail/ignore.hpp>
 #include <obake/detail/mppp_utils.hpp>
+#include <obake/detail/sm_pow_table.hpp>
 #include <obake/detail/to_string.hpp>
 #include <obake/detail/type_c.hpp>
 #include <obake/detail/visibility.hpp>
@@ -609,14 +610,34 @@ inline constexpr int pm_key_evaluate_algo = pm_key_evaluate_algorithm<T, U>.firs
 template <typename T, typename U>
 using pm_key_evaluate_ret_t = typename decltype(pm_key_evaluate_algorithm<T, U>.second)::type;
 
-} // namespace detail
+// The evaluation (and substitution) via an sm_pow_table
+// requires also the in-place multiplication of the return
+// value by the const powers stored in the table (whose
+// type is the value type of the table).
+template <typename T, typename U>
+constexpr bool pm_key_evaluate_with_table_algorithm_impl()
+{
+    if constexpr (pm_key_evaluate_algo<T, U> != 0) {
+        using ret_t = pm_key_evaluate_ret_t<T, U>;
 
-// Evaluation of a packed monomial.
+        return is_in_place_multipliable_v<::std::add_lvalue_reference_t<ret_t>,
+                                          const typename ::obake::detail::sm_pow_table<U, T>::value_type &>;
+    } else {
+        return false;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool pm_key_evaluate_with_table_algo = detail::pm_key_evaluate_with_table_algorithm_impl<T, U>();
+
+// Implementation of the evaluation of a packed monomial.
+// The power of the value pointed to by the iterator it
+// of sm to the exponent n is computed via pw(it, n).
 // NOTE: this requires that p is compatible with ss,
 // and that sm is consistent with ss.
-template <typename T, typename U, ::std::enable_if_t<detail::pm_key_evaluate_algo<T, U> != 0, int> = 0>
-inline detail::pm_key_evaluate_ret_t<T, U> key_evaluate(const packed_monomial<T> &p, const symbol_idx_map<U> &sm,
-                                                        const symbol_set &ss)
+template <typename T, typename U, typename F>
+inline pm_key_evaluate_ret_t<T, U> pm_key_evaluate_impl(const packed_monomial<T> &p, const symbol_idx_map<U> &sm,
+                                                        const symbol_set &ss, const F &pw)
 {
     assert(polynomials::key_is_compatible(p, ss));
     // sm and ss must have the same size, and the last element
@@ -627,18 +648,46 @@ inline detail::pm_key_evaluate_ret_t<T, U> key_evaluate(const packed_monomial<T>
     const auto s_size = static_cast<unsigned>(ss.size());
 
     // Init the return value and the unpacking machinery.
-    detail::pm_key_evaluate_ret_t<T, U> retval(1);
+    pm_key_evaluate_ret_t<T, U> retval(1);
     kunpacker<T> ku(p.get_value(), s_size);
     T tmp;
     // Accumulate the result.
-    for (const auto &pr : sm) {
+    for (auto it = sm.cbegin(); it != sm.cend(); ++it) {
         ku >> tmp;
-        retval *= ::obake::pow(pr.second, ::std::as_const(tmp));
+        retval *= pw(it, ::std::as_const(tmp));
     }
 
     return retval;
 }
 
+} // namespace detail
+
+// Evaluation of a packed monomial.
+// NOTE: this requires that p is compatible with ss,
+// and that sm is consistent with ss.
+template <typename T, typename U, ::std::enable_if_t<detail::pm_key_evaluate_algo<T, U> != 0, int> = 0>
+inline detail::pm_key_evaluate_ret_t<T, U> key_evaluate(const packed_monomial<T> &p, const symbol_idx_map<U> &sm,
+                                                        const symbol_set &ss)
+{
+    return detail::pm_key_evaluate_impl(p, sm, ss,
+                                        [](const auto &it, const T &n) { return ::obake::pow(it->second, n); });
+}
+
+// Evaluation of a packed monomial, fetching the powers
+// from the table pt (see detail::sm_pow_table).
+// NOTE: this requires that p is compatible with ss,
+// and that the map of pt is consistent with ss.
+template <typename T, typename U, ::std::enable_if_t<detail::pm_key_evaluate_with_table_algo<T, U>, int> = 0>
+inline detail::pm_key_evaluate_ret_t<T, U>
+key_evaluate_with_table(const packed_monomial<T> &p, ::obake::detail::sm_pow_table<U, T> &pt, const symbol_set &ss)
+{
+    const auto &sm = pt.get_map();
+
+    return detail::pm_key_evaluate_impl(p, sm, ss, [&pt, &sm](const auto &it, const T &n) -> const auto & {
+        return pt(static_cast<decltype(sm.size())>(it - sm.cbegin()), n);
+    });
+}
+
 namespace detail
 {
 
@@ -655,14 +704,14 @@ inline constexpr int pm_monomial_subs_algo = pm_key_evaluate_algorithm<T, U>.fir
 template <typename T, typename U>
 using pm_monomial_subs_ret_t = typename decltype(pm_key_evaluate_algorithm<T, U>.second)::type;
 
-} // namespace detail
-
-// Substitution of symbols in a packed monomial.
+// Implementation of the substitution of symbols in a packed monomial.
+// The power of the value pointed to by the iterator it
+// of sm to the exponent n is computed via pw(it, n).
 // NOTE: this requires that p is compatible with ss,
 // and that sm is consistent with ss.
-template <typename T, typename U, ::std::enable_if_t<detail::pm_monomial_subs_algo<T, U> != 0, int> = 0>
-inline ::std::pair<detail::pm_monomial_subs_ret_t<T, U>, packed_monomial<T>>
-monomial_subs(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const symbol_set &ss)
+template <typename T, typename U, typename F>
+inline ::std::pair<pm_monomial_subs_ret_t<T, U>, packed_monomial<T>>
+pm_monomial_subs_impl(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const symbol_set &ss, const F &pw)
 {
     assert(polynomials::key_is_compatible(p, ss));
     // sm must not be larger than ss, and the last element
@@ -673,7 +722,7 @@ monomial_subs(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const sy
     const auto s_size = static_cast<unsigned>(ss.size());
 
     // Init the return value and the (un)packing machinery.
-    detail::pm_monomial_subs_ret_t<T, U> retval(1);
+    pm_monomial_subs_ret_t<T, U> retval(1);
     kunpacker<T> ku(p.get_value(), s_size);
     kpacker<T> kp(s_size);
     T tmp;
@@ -685,7 +734,7 @@ monomial_subs(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const sy
         if (sm_it != sm_end && sm_it->first == i) {
             // The current exponent is in the subs map,
             // accumulate the result of the substitution.
-            retval *= ::obake::pow(sm_it->second, ::std::as_const(tmp));
+            retval *= pw(sm_it, ::std::as_const(tmp));
 
             // Set the exponent to zero in the output
             // monomial.
@@ -705,6 +754,34 @@ monomial_subs(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const sy
     return ::std::make_pair(::std::move(retval), packed_monomial<T>(kp.get()));
 }
 
+} // namespace detail
+
+// Substitution of symbols in a packed monomial.
+// NOTE: this requires that p is compatible with ss,
+// and that sm is consistent with ss.
+template <typename T, typename U, ::std::enable_if_t<detail::pm_monomial_subs_algo<T, U> != 0, int> = 0>
+inline ::std::pair<detail::pm_monomial_subs_ret_t<T, U>, packed_monomial<T>>
+monomial_subs(const packed_monomial<T> &p, const symbol_idx_map<U> &sm, const symbol_set &ss)
+{
+    return detail::pm_monomial_subs_impl(p, sm, ss,
+                                         [](const auto &it, const T &n) { return ::obake::pow(it->second, n); });
+}
+
+// Substitution of symbols in a packed monomial, fetching
+// the powers from the table pt (see detail::sm_pow_table).
+// NOTE: this requires that p is compatible with ss,
+// and that the map of pt is consistent with ss.
+template <typename T, typename U, ::std::enable_if_t<detail::pm_key_evaluate_with_table_algo<T, U>, int> = 0>
+inline ::std::pair<detail::pm_monomial_subs_ret_t<T, U>, packed_monomial<T>>
+monomial_subs_with_table(const packed_monomial<T> &p, ::obake::detail::sm_pow_table<U, T> &pt, const symbol_set &ss)
+{
+    const auto &sm = pt.get_map();
+
+    return detail::pm_monomial_subs_impl(p, sm, ss, [&pt, &sm](const auto &it, const T &n) -> const auto & {
+        return pt(static_cast<decltype(sm.size())>(it - sm.cbegin()), n);
+    });
+}
+
 // Identify non-trimmable exponents in p.
 OBAKE_DLL_PUBLIC void key_trim_identify(::std::vector<int> &, const packed_monomial<::std::int32_t> &,
                                         const symbol_set &);
@@ -751,6 +828,54 @@ monomial_diff(const packed_monomial<::std::uint64_t> &, const symbol_idx &, cons
 
 #endif
 
+// Monomial gradient: differentiate p with respect to all the
+// symbols in ss, unpacking p only once. On output, out[i]
+// contains the result of monomial_diff(p, i, ss).
+// NOTE: because the Kronecker encoding is linear, decrementing
+// the i-th exponent amounts to subtracting from the code the
+// i-th component of the coding vector.
+// NOTE: this requires that p is compatible with ss.
+template <typename T>
+inline void monomial_gradient(::std::vector<::std::pair<T, packed_monomial<T>>> &out, const packed_monomial<T> &p,
+                              const symbol_set &ss)
+{
+    assert(polynomials::key_is_compatible(p, ss));
+
+    out.clear();
+
+    // NOTE: because we assume compatibility, the static cast is safe.
+    const auto s_size = static_cast<unsigned>(ss.size());
+    if (s_size == 0u) {
+        return;
+    }
+
+    const auto lim_min = ::obake::detail::kpack_get_lims<T>(s_size).first;
+    const auto delta = ::obake::detail::kpack_get_delta<T>(s_size);
+
+    kunpacker<T> ku(p.get_value(), s_size);
+    T tmp, cur_prod(1);
+    for (auto i = 0u; i < s_size; ++i) {
+        ku >> tmp;
+
+        if (tmp == T(0)) {
+            out.emplace_back(T(0), p);
+        } else if (obake_unlikely(tmp < lim_min + T(1))) {
+            // NOTE: the decremented exponent is outside
+            // the allowed range, let monomial_diff()
+            // deal with it.
+            out.push_back(polynomials::monomial_diff(p, i, ss));
+        } else {
+            out.emplace_back(tmp, packed_monomial<T>(static_cast<T>(p.get_value() - cur_prod)));
+        }
+
+        // NOTE: avoid computing the component past
+        // the last one, which might overflow.
+        if (i + 1u < s_size) {
+            cur_prod = static_cast<T>(cur_prod * delta);
+        }
+    }
+}
+
 // Monomial integration.
 OBAKE_DLL_PUBLIC ::std::pair<::std::int32_t, packed_monomial<::std::int32_t>>
 monomial_integrate(const packed_monomial<::std::int32_t> &, const symbol_idx &, const symbol_set &);
@@ -11,12 +11,19 @@
 
 #include <algorithm>
 #include <atomic>
+#include <bit>
 #include <cassert>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <exception>
+#include <future>
 #include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
 #include <random>
 #include <stdexcept>
 #include <string>
@@ -26,9 +33,9 @@
 #include <vector>
 
 #include <boost/container/container_fwd.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/iterator/permutation_iterator.hpp>
 #include <boost/iterator/transform_iterator.hpp>
-#include <boost/numeric/conversion/cast.hpp>
 #include <boost/serialization/tracking.hpp>
 
 #include <tbb/blocked_range.h>
@@ -36,24 +43,35 @@
 #include <tbb/parallel_invoke.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
 
 #include <obake/byte_size.hpp>
 #include <obake/config.hpp>
 #include <obake/detail/abseil.hpp>
+#include <obake/detail/accumulation_table.hpp>
+#include <obake/detail/atomic_flag_array.hpp>
+#include <obake/detail/atomic_lock_guard.hpp>
 #include <obake/detail/hc.hpp>
 #include <obake/detail/ignore.hpp>
 #include <obake/detail/it_diff_check.hpp>
+#include <obake/detail/limits.hpp>
 #include <obake/detail/make_array.hpp>
+#include <obake/detail/mppp_utils.hpp>
+#include <obake/detail/sm_pow_table.hpp>
 #include <obake/detail/ss_func_forward.hpp>
 #include <obake/detail/to_string.hpp>
 #include <obake/detail/type_c.hpp>
 #include <obake/detail/xoroshiro128_plus.hpp>
 #include <obake/exceptions.hpp>
 #include <obake/hash.hpp>
+#include <obake/kpack.hpp>
+#include <obake/key/key_evaluate.hpp>
 #include <obake/key/key_merge_symbols.hpp>
 #include <obake/math/diff.hpp>
+#include <obake/math/evaluate.hpp>
 #include <obake/math/fma3.hpp>
 #include <obake/math/is_zero.hpp>
 #include <obake/math/pow.hpp>
@@ -66,6 +84,8 @@
 #include <obake/polynomials/monomial_pow.hpp>
 #include <obake/polynomials/monomial_range_overflow_check.hpp>
 #include <obake/polynomials/monomial_subs.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
 #include <obake/ranges.hpp>
 #include <obake/s11n.hpp>
 #include <obake/series.hpp>
@@ -459,22 +479,167 @@ struct poly_mul_impl_pair_transform {
     }
 };
 
+// Helper to create a vector containing copies
+// of the terms of the series s.
+// The terms are stored in the vector following the
+// order of the segments of s, that is, sorted according
+// to the bucket they occupy in the segmented table of s.
+// If s is segmented, the copy is done in parallel (one
+// segment per task).
+// NOTE: drop the const from the key type in order
+// to allow mutability.
+template <typename S>
+inline auto poly_mul_impl_copy_terms(const S &s)
+{
+    using key_t = series_key_t<S>;
+    using cf_t = series_cf_t<S>;
+    using ret_t = ::std::vector<::std::pair<key_t, cf_t>>;
+
+    const auto &s_table = s._get_s_table();
+
+    if (s_table.size() == 1u) {
+        // Unsegmented series, just do a serial copy.
+        return ret_t(::boost::make_transform_iterator(s.begin(), poly_mul_impl_pair_transform{}),
+                     ::boost::make_transform_iterator(s.end(), poly_mul_impl_pair_transform{}));
+    }
+
+    // Compute the offsets of the segments in the output vector.
+    ::std::vector<typename S::size_type> offsets;
+    offsets.resize(::obake::safe_cast<decltype(offsets.size())>(s_table.size() + 1u));
+    for (decltype(s_table.size()) i = 0; i < s_table.size(); ++i) {
+        // NOTE: the total number of terms is representable
+        // by size_type, thus no overflow concerns here.
+        offsets[i + 1u] = offsets[i] + static_cast<typename S::size_type>(s_table[i].size());
+    }
+    assert(offsets.back() == s.size());
+
+    // NOTE: the key type is not required to be default-constructible,
+    // thus we resize with a key compatible with the symbol set of s.
+    ret_t retval;
+    retval.resize(::obake::safe_cast<decltype(retval.size())>(s.size()),
+                  ::std::make_pair(key_t(s.get_symbol_set()), cf_t{}));
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&s_table, &offsets, &retval](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                auto out_ptr = retval.data() + offsets[i];
+
+                                for (const auto &t : s_table[i]) {
+                                    out_ptr->first = t.first;
+                                    out_ptr->second = t.second;
+                                    ++out_ptr;
+                                }
+                            }
+                        });
+
+    return retval;
+}
+
+// Pseudo-random permutation of the integers in the [0, n) range,
+// used to sample term-by-term multiplications without repetitions.
+// The permutation is implemented as a full-period linear congruential
+// generator modulo 2**k (where 2**k is the smallest power of 2 not less
+// than n), followed by a bijective bit-mixing step to improve the quality
+// of the low bits. The values not less than n are skipped ("cycle walking"),
+// thus at most 2 iterations per value are needed on average.
+// See:
+// https://en.wikipedia.org/wiki/Linear_congruential_generator
+class poly_mul_idx_permutation
+{
+public:
+    template <typename Rng>
+    explicit poly_mul_idx_permutation(::std::uint64_t n, Rng &rng)
+        : m_n(n), m_nbits(static_cast<unsigned>(::std::bit_width(n - 1u))),
+          m_mask(m_nbits == 64u ? ~::std::uint64_t(0) : (::std::uint64_t(1) << m_nbits) - 1u),
+          // NOTE: by the Hull-Dobell theorem, the LCG has full period
+          // modulo a power of 2 if the increment is odd and the multiplier
+          // is congruent to 1 modulo 4.
+          m_a((rng() << 2) | 1u), m_c(rng() | 1u), m_mix(rng() | 1u), m_state(rng() & m_mask)
+    {
+        assert(n > 0u);
+    }
+
+    // Fetch the next value in the permutation.
+    ::std::uint64_t next()
+    {
+        while (true) {
+            m_state = (m_a * m_state + m_c) & m_mask;
+
+            if (const auto ret = mix(m_state); ret < m_n) {
+                return ret;
+            }
+        }
+    }
+
+private:
+    // Bijective mixing of the k-bit value v
+    // (xorshift-multiply-xorshift).
+    ::std::uint64_t mix(::std::uint64_t v) const
+    {
+        const auto shift = (m_nbits + 1u) / 2u;
+
+        if (shift == 0u) {
+            // NOTE: this happens only if n == 1.
+            return v;
+        }
+
+        v ^= v >> shift;
+        v = (v * m_mix) & m_mask;
+        v ^= v >> shift;
+
+        return v;
+    }
+
+    ::std::uint64_t m_n;
+    unsigned m_nbits;
+    ::std::uint64_t m_mask, m_a, m_c, m_mix, m_state;
+};
+
+// Statistics about the estimation of the size
+// of a polynomial product (see poly_mul_estimate_product_size()).
+struct poly_mul_est_stats {
+    // Number of trials.
+    unsigned n_trials = 0;
+    // Total number of sampled term-by-term multiplications.
+    unsigned long long n_samples = 0;
+    // Total number of duplicate terms detected
+    // in the sampled term-by-term multiplications.
+    unsigned long long n_dups = 0;
+    // Relative standard error of the estimate, that is, the
+    // standard deviation of the per-trial estimates divided by
+    // sqrt(n_trials) and by the estimate. A ~95% confidence interval
+    // for the (uncorrected) estimate is +-1.96 * rel_std_err.
+    double rel_std_err = 0;
+    // Whether or not the estimate is exact (i.e., all the
+    // term-by-term multiplications were sampled).
+    // NOTE: rel_std_err and exact are used to size the
+    // segmentation of the product (see poly_mul_seg_nterms()).
+    bool exact = false;
+};
+
 // This function will:
 // - estimate the size of the product of two input polynomials,
 // - compute the total number of term-by-term multiplications that will
 //   be performed in the computation of the polynomial product
 //   (which could be different from the product of the sizes of the
-//   factors due to truncation).
+//   factors due to truncation),
+// - return statistics about the estimation.
 // S1 and S2 are the types of the polynomials, x and y the polynomials
-// represented as vectors of terms. The extra arguments represent
+// represented as vectors of terms (or, in untruncated mode, as vectors
+// of pointers to terms). The extra arguments represent
 // the truncation limits.
 // Requires x and y not empty, y not shorter than x. The returned
-// value is guaranteed to be nonzero.
-// NOTE: by imposing that x is the shorter series, we are able to
-// greatly reduce the estimation overhead for highly rectangular
-// multiplications. The downside is that we overestimate the final
-// series size quite a bit. Not sure how we could proceed to
-// improve the situation.
+// estimate is guaranteed to be nonzero.
+// NOTE: the estimation works by sampling without repetitions the
+// term-by-term multiplications allowed by the truncation limits
+// (the "joint index space"), and by counting how many distinct terms
+// are generated. The joint index space is represented as the integer
+// range [0, tot_n_mults), where the term x[i] is mapped to a subrange
+// whose size is the number of terms in y it will be multiplied by.
+// The sampling is done via a pseudo-random permutation of the joint
+// index space, thus the number of samples is not limited by the size
+// of the shorter series (which in the past led to large overestimations
+// for highly rectangular products).
 template <typename S1, typename S2, typename T1, typename T2, typename... Args>
 inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::std::vector<T2> &y, const symbol_set &ss,
                                            const Args &...args)
@@ -485,26 +650,33 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
     assert(x.size() <= y.size());
     static_assert(sizeof...(args) <= 2u);
 
+    // The types of the terms.
+    using term1_t = ::std::remove_cv_t<::std::remove_pointer_t<T1>>;
+    using term2_t = ::std::remove_cv_t<::std::remove_pointer_t<T2>>;
+
+    // NOTE: the degree data can be computed only from vectors of terms.
+    static_assert(sizeof...(args) == 0u || ::std::conjunction_v<::std::negation<::std::is_pointer<T1>>,
+                                                                ::std::negation<::std::is_pointer<T2>>>);
+
     // Make sure that the input types are consistent.
-    using key_type = typename T1::first_type;
-    static_assert(::std::is_same_v<key_type, typename T2::first_type>);
+    using key_type = typename term1_t::first_type;
+    static_assert(::std::is_same_v<key_type, typename term2_t::first_type>);
     static_assert(::std::is_same_v<series_key_t<S1>, key_type>);
     static_assert(::std::is_same_v<series_key_t<S2>, key_type>);
-    static_assert(::std::is_same_v<series_cf_t<S1>, typename T1::second_type>);
-    static_assert(::std::is_same_v<series_cf_t<S2>, typename T2::second_type>);
+    static_assert(::std::is_same_v<series_cf_t<S1>, typename term1_t::second_type>);
+    static_assert(::std::is_same_v<series_cf_t<S2>, typename term2_t::second_type>);
 
     // Prepare the variable to hold the degree data.
     auto degree_data = detail::poly_mul_impl_prepare_degree_data<S1, S2>(x, y, ss, args...);
 
-    // Prepare vectors of indices into x/y.
-    decltype(detail::poly_mul_impl_par_make_idx_vector(x)) vidx1;
+    // Prepare a vector of indices into y.
     decltype(detail::poly_mul_impl_par_make_idx_vector(y)) vidx2;
 
     // Concurrently create the degree data for x and y, and fill
-    // in the vidx1/vidx2 vectors. vidx2 and y's degree data
+    // in the vidx2 vector. vidx2 and y's degree data
     // will also be sorted, if the multiplication is truncated.
     ::tbb::parallel_invoke(
-        [&vidx1, &x, &ss, &degree_data, &args...]() {
+        [&x, &ss, &degree_data, &args...]() {
             if constexpr (sizeof...(args) == 1u) {
                 // Total degree truncation.
                 ::obake::detail::ignore(args...);
@@ -520,10 +692,8 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
                 ::std::get<0>(degree_data) = customisation::internal::make_p_degree_vector<S1>(
                     x.cbegin(), x.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
             } else {
-                ::obake::detail::ignore(ss, degree_data, args...);
+                ::obake::detail::ignore(x, ss, degree_data, args...);
             }
-
-            vidx1 = detail::poly_mul_impl_par_make_idx_vector(x);
         },
         [&vidx2, &y, &ss, &degree_data, &args...]() {
             if constexpr (sizeof...(args) == 1u) {
@@ -569,107 +739,175 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
             }
         });
 
+    // In truncated multiplication, determine how many terms
+    // in y each term in x will be multiplied by. These are the
+    // sizes of the subranges of the joint index space.
+    using vidx2_size_t = typename decltype(vidx2)::size_type;
+    ::std::vector<vidx2_size_t> limits;
+    if constexpr (sizeof...(Args) > 0u) {
+        limits.resize(::obake::safe_cast<decltype(limits.size())>(x.size()));
+
+        // Fetch the truncation limit.
+        const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(limits.size())>(0, limits.size()),
+                            [&max_deg, &degree_data, &limits](const auto &range) {
+                                // Get the degree data for x and y.
+                                // NOTE: v2_deg is sorted according to the degree.
+                                const auto &[v1_deg, v2_deg] = degree_data;
+
+                                for (auto idx1 = range.begin(); idx1 != range.end(); ++idx1) {
+                                    // Fetch the degree of the current term in x.
+                                    const auto &d1 = v1_deg[idx1];
+
+                                    // Find the first degree d2 in v2_deg such that d1 + d2 > max_degree.
+                                    const auto it
+                                        = ::std::upper_bound(v2_deg.cbegin(), v2_deg.cend(), max_deg,
+                                                             [&d1](const auto &mdeg, const auto &d2) {
+                                                                 // NOTE: we require below
+                                                                 // comparability between const lvalue limit
+                                                                 // and rvalue of the sum of the degrees.
+                                                                 return mdeg < d1 + d2;
+                                                             });
+
+                                    // NOTE: we checked when constructing v2_deg that its iterator
+                                    // diff type can represent the total size. Because
+                                    // the sizes of vidx2 and v2_deg are the same, the static cast
+                                    // is also safe.
+                                    limits[idx1] = static_cast<vidx2_size_t>(it - v2_deg.cbegin());
+                                }
+                            });
+    } else {
+        ::obake::detail::ignore(degree_data);
+    }
+
     // Determine the total number of term-by-term multiplications
-    // that will be performed in the poly multiplication.
-    auto tot_n_mults = [&vidx1, &vidx2, &degree_data, &args...]() {
-        if constexpr (sizeof...(Args) == 0u) {
-            // In the untruncated case, the total number of term-by-term
-            // multiplications to be performed is simply the product
-            // of the series sizes.
-            ::obake::detail::ignore(degree_data, args...);
+    // that will be performed in the poly multiplication, and
+    // the boundaries of the subranges of the joint index space
+    // (only in truncated multiplication).
+    // NOTE: the joint index space is sampled via 64-bit integers. If
+    // its size does not fit in 64 bits, we restrict the sampling to
+    // the subranges of the first nx_samp terms of x (which are in
+    // a pseudo-random order), and we scale the estimate accordingly.
+    // This can happen only for extremely large multiplications.
+    using x_size_t = decltype(x.size());
+    ::mppp::integer<1> tot_n_mults;
+    ::std::uint64_t n_samp = 0;
+    ::std::vector<::std::uint64_t> bounds;
+    if constexpr (sizeof...(Args) == 0u) {
+        // In the untruncated case, the total number of term-by-term
+        // multiplications to be performed is simply the product
+        // of the series sizes.
+        tot_n_mults = ::mppp::integer<1>(x.size()) * y.size();
+
+        const auto nx_samp
+            = ::std::min(x.size(), static_cast<x_size_t>(::obake::detail::limits_max<::std::uint64_t>
+                                                         / static_cast<::std::uint64_t>(y.size())));
+        n_samp = static_cast<::std::uint64_t>(nx_samp) * static_cast<::std::uint64_t>(y.size());
+    } else {
+        // In the truncated case, we need to take into account
+        // the truncation limit term by term.
+        bounds.reserve(::obake::safe_cast<decltype(bounds.size())>(x.size() + 1u));
+        bounds.push_back(0);
+
+        bool overflow = false;
+        for (const auto &l : limits) {
+            tot_n_mults += l;
+
+            if (!overflow
+                && bounds.back() > ::obake::detail::limits_max<::std::uint64_t> - static_cast<::std::uint64_t>(l)) {
+                overflow = true;
+            }
 
-            return ::mppp::integer<1>(vidx1.size()) * vidx2.size();
-        } else {
-            // In the truncated case, we need to take into account
-            // the truncation limit term by term.
-            ::obake::detail::ignore(vidx2);
+            if (!overflow) {
+                bounds.push_back(bounds.back() + static_cast<::std::uint64_t>(l));
+            }
+        }
 
-            // Fetch the truncation limit.
-            const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+        n_samp = bounds.back();
+    }
+    assert(n_samp <= tot_n_mults);
 
-            return ::tbb::parallel_reduce(
-                ::tbb::blocked_range<decltype(vidx1.cbegin())>(vidx1.cbegin(), vidx1.cend()), ::mppp::integer<1>{},
-                [&max_deg, &degree_data](const auto &range, ::mppp::integer<1> cur) {
-                    // NOTE: vidx1 is unsorted, vidx2 is sorted according
-                    // to the degree.
-
-                    // Get the degree data for x and y.
-                    const auto &[v1_deg, v2_deg] = degree_data;
-
-                    for (auto idx1 : range) {
-                        // Fetch the degree of the current term in x.
-                        const auto &d1 = v1_deg[idx1];
-
-                        // Find the first degree d2 in v2_deg such that d1 + d2 > max_degree.
-                        const auto it = ::std::upper_bound(v2_deg.cbegin(), v2_deg.cend(), max_deg,
-                                                           [&d1](const auto &mdeg, const auto &d2) {
-                                                               // NOTE: we require below
-                                                               // comparability between const lvalue limit
-                                                               // and rvalue of the sum of the degrees.
-                                                               return mdeg < d1 + d2;
-                                                           });
-
-                        // Accumulate in cur how many terms in y would be multiplied
-                        // by the current term in x.
-                        // NOTE: we checked when constructing v2_deg that its iterator
-                        // diff type can represent the total size.
-                        cur += it - v2_deg.cbegin();
-                    }
+    // Exit early if no term-by-term multiplication
+    // will be performed (this can happen only
+    // in truncated multiplication).
+    if (n_samp == 0u) {
+        assert(sizeof...(Args) > 0u);
+
+        return ::std::make_tuple(::mppp::integer<1>{1}, ::std::move(tot_n_mults), poly_mul_est_stats{});
+    }
+
+    // Helper to map an index in the joint index space
+    // to a pair of indices into x and y.
+    auto idx_to_pair = [&y, &vidx2, &bounds](::std::uint64_t n) {
+        if constexpr (sizeof...(Args) == 0u) {
+            ::obake::detail::ignore(vidx2, bounds);
+
+            return ::std::make_pair(static_cast<x_size_t>(n / y.size()),
+                                    static_cast<decltype(y.size())>(n % y.size()));
+        } else {
+            // Locate the subrange containing n.
+            const auto it = ::std::upper_bound(bounds.cbegin() + 1, bounds.cend(), n) - 1;
+            const auto idx1 = static_cast<x_size_t>(it - bounds.cbegin());
 
-                    return cur;
-                },
-                [](const auto &a, const auto &b) { return a + b; });
+            return ::std::make_pair(idx1, vidx2[static_cast<vidx2_size_t>(n - *it)]);
         }
-    }();
+    };
+
+    // If the joint index space is small enough, a single
+    // trial sampling the whole space is cheap and gives the exact
+    // number of terms of the product (before cancellations).
+    const bool full_sampling = n_samp <= 4096u;
 
     // Parameters for the random trials.
-    // NOTE: the idea here is that the larger the
-    // multiplication, the larger the number of trials we can
-    // do. Doing more trials also helps stabilizing
-    // the estimation. The constant is inferred from
-    // testing on the usual benchmarks.
-    // NOTE: put a floor of 5 trials, which also ensures
-    // that ntrials is never estimated to 0.
-    const auto ntrials = ::std::max(5u, ::boost::numeric_cast<unsigned>(5e-8 * tot_n_mults));
-    // NOTE: we further divide by 2 below, so that the
-    // multiplier is actually 3/2.
-    const auto multiplier = 3u;
-
-    // NOTE: workaround for a GCC 7 issue.
-    using vidx2_size_t = typename ::std::vector<decltype(y.size())>::size_type;
+    // NOTE: the trials are run in parallel, and more trials help
+    // stabilising the estimation. The constants are rule-of-thumb
+    // values inferred from testing on the usual benchmarks.
+    const auto ntrials = full_sampling
+                             ? 1u
+                             : static_cast<unsigned>(::std::clamp(1E-8 * static_cast<double>(tot_n_mults), 5., 64.));
+    // The number of duplicate terms after which a trial stops.
+    const auto max_dups = full_sampling ? ::obake::detail::limits_max<unsigned long long> : 64ull;
+    // The max number of samples per trial. The number of samples needed
+    // to detect a given number of duplicates scales as the square root of the
+    // number of terms in the product, thus we bound the number of samples
+    // with a multiple of sqrt(n_samp) (so that the cost of the estimation
+    // is small with respect to the cost of the multiplication), and we
+    // also put an absolute cap to bound the memory usage. Like
+    // in the past, we allow for at least nx samples.
+    const auto max_samples
+        = full_sampling ? n_samp
+                        : ::std::min(n_samp, ::std::max(static_cast<::std::uint64_t>(x.size()),
+                                                        static_cast<::std::uint64_t>(::std::min(
+                                                            8. * ::std::sqrt(static_cast<double>(n_samp)),
+                                                            double(1ull << 20)))));
+    // The estimates are multiplied by 3/2. The distinct
+    // count estimation from a sample tends to underestimate when the
+    // frequencies of the terms in the product are very uneven,
+    // which is the case for dense polynomials.
+    constexpr double multiplier = 1.5;
+
+    // The results of the trials.
+    struct trial_result {
+        double est;
+        ::std::uint64_t n_samples;
+        unsigned long long n_dups;
+    };
+    ::std::vector<trial_result> trial_results;
+    trial_results.resize(::obake::safe_cast<decltype(trial_results.size())>(ntrials));
 
     // Run the trials.
-    // NOTE: ideally, we would like to select without repetition random term-by-term
-    // multiplications. This could be done by mapping the two sizes of v1 and v2
-    // into a single integer N (k-packing style), and then using a linear congruential
-    // generator with period N which guarantees that there are no repetitions within
-    // that period. See:
-    // https://stackoverflow.com/questions/9755538/how-do-i-create-a-list-of-random-numbers-without-duplicates/53646842
-    // https://en.wikipedia.org/wiki/Linear_congruential_generator
-    // (see the SO answer a bit down the page).
-    // However, I don't know how this would work when truncation is involved.
-    // The current approach is to shuffle v1 and then pick randomly into v2.
-    // This result in a choice of index in v1 without repetitions, but the
-    // random picking in v2 could have repetitions, so it's not precisely
-    // equivalent to having truly random term-by-term multiplications.
-    auto c_est = ::tbb::parallel_reduce(
-        ::tbb::blocked_range<unsigned>(0, ntrials), ::mppp::integer<1>{},
-        [multiplier, &degree_data, &x, &y, &vidx1, &vidx2, &ss, &args...](const auto &range, ::mppp::integer<1> cur) {
-            // Make a local copy of vidx1.
-            auto vidx1_copy(vidx1);
-
-            // Prepare a distribution for randomly indexing into vidx2.
-            using dist_type = ::std::uniform_int_distribution<vidx2_size_t>;
-            using dist_param_type = typename dist_type::param_type;
-            dist_type idist;
-
-            // Init the hash set we will be using for the trials.
+    ::tbb::parallel_for(
+        ::tbb::blocked_range<unsigned>(0, ntrials),
+        [&x, &y, &ss, &idx_to_pair, &trial_results, n_samp, max_samples, max_dups](const auto &range) {
+            // Init the hash map we will be using for the trials. It maps the terms
+            // of the product to the number of times they are generated.
             // NOTE: use exactly the same hasher/comparer as in series.hpp, so that
             // we are sure we are being consistent wrt type requirements, etc.
-            using local_set = ::absl::flat_hash_set<key_type, ::obake::detail::series_key_hasher,
+            using local_map = ::absl::flat_hash_map<key_type, ::std::uint64_t, ::obake::detail::series_key_hasher,
                                                     ::obake::detail::series_key_comparer>;
-            local_set ls;
-            ls.reserve(::obake::safe_cast<decltype(ls.size())>(vidx1.size()));
+            local_map lm;
+            lm.reserve(::obake::safe_cast<decltype(lm.size())>(::std::min(max_samples, ::std::uint64_t(1) << 16)));
 
             // Temporary object for monomial multiplications.
             key_type tmp_key(ss);
@@ -682,1465 +920,4951 @@ inline auto poly_mul_estimate_product_size(const ::std::vector<T1> &x, const ::s
                 ::obake::detail::xoroshiro128_plus rng{static_cast<::std::uint64_t>(i + s1),
                                                        static_cast<::std::uint64_t>(i + s2)};
 
-                // Shuffle the indices into the first series.
-                ::std::shuffle(vidx1_copy.begin(), vidx1_copy.end(), rng);
+                // Init the permutation of the joint index space.
+                poly_mul_idx_permutation perm(n_samp, rng);
 
-                // This will be used to determine the average number of terms in y
-                // that participate in the multiplication. It is used only in case
-                // there are no collisions at the end of the loop below.
-                ::mppp::integer<1> acc_y;
+                ::std::uint64_t n_samples = 0;
+                unsigned long long n_dups = 0;
+                for (; n_samples < max_samples && n_dups < max_dups; ++n_samples) {
+                    const auto [idx1, idx2] = idx_to_pair(perm.next());
 
-                for (auto idx1 : vidx1_copy) {
-                    // Get the upper limit for indexing in vidx2.
-                    // NOTE: this will be an index into a vector of indices.
-                    const auto limit = [&degree_data, idx1, &vidx2, &args...]() {
-                        if constexpr (sizeof...(args) == 0u) {
-                            // Untruncated case, just return the size of vidx2.
-                            ::obake::detail::ignore(degree_data, idx1);
+                    ::obake::monomial_mul(tmp_key, poly_term_key_ref_extractor{}(x[idx1]),
+                                          poly_term_key_ref_extractor{}(y[idx2]), ss);
 
-                            return vidx2.size();
-                        } else {
-                            // Truncated case: determine the first index
-                            // into vidx2 which does not satisfy the truncation
-                            // limit.
-                            ::obake::detail::ignore(vidx2);
-
-                            // Fetch the truncation limit.
-                            const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
-
-                            // Get the degree data for x and y.
-                            const auto &[v1_deg, v2_deg] = degree_data;
-
-                            // Fetch the degree of the current term in x.
-                            const auto &d1 = v1_deg[idx1];
-
-                            // Find the first degree d2 in v2_deg such that d1 + d2 > max_degree.
-                            const auto it = ::std::upper_bound(v2_deg.cbegin(), v2_deg.cend(), max_deg,
-                                                               [&d1](const auto &mdeg, const auto &d2) {
-                                                                   // NOTE: we require below
-                                                                   // comparability between const lvalue limit
-                                                                   // and rvalue of the sum of the degrees.
-                                                                   return mdeg < d1 + d2;
-                                                               });
-
-                            // We checked when constructing v2_deg that its iterator
-                            // diff type can represent the total size. Because
-                            // the sizes of vidx2 and v2_deg are the same, the static cast
-                            // is also safe.
-                            return static_cast<vidx2_size_t>(it - v2_deg.cbegin());
-                        }
-                    }();
+                    const auto ret = lm.try_emplace(tmp_key, 0);
+                    ++ret.first->second;
+                    n_dups += !ret.second;
+                }
 
-                    if (limit == 0u) {
-                        // The upper limit is 0, we cannot multiply by any
-                        // term in y without violating the truncation constraint.
-                        continue;
+                // Number of distinct terms in the sample.
+                const auto d = static_cast<double>(lm.size());
+
+                double est;
+                if (n_samples == n_samp) {
+                    // We sampled the whole joint index space,
+                    // the count is exact.
+                    est = d;
+                } else {
+                    // Count the terms which appeared exactly once and twice.
+                    double f1 = 0, f2 = 0;
+                    for (const auto &p : lm) {
+                        f1 += p.second == 1u;
+                        f2 += p.second == 2u;
                     }
 
-                    // Keep track of how many terms in y would be multiplied
-                    // by the current term in x in the full multiplication.
-                    acc_y += limit;
+                    // Use the (bias-corrected) Chao1 estimator for the number
+                    // of distinct terms. See:
+                    // https://en.wikipedia.org/wiki/Abundance_estimation
+                    // NOTE: if no duplicates were detected, this reduces to
+                    // the birthday-paradox estimate d + d * (d - 1) / 2.
+                    est = ::std::clamp(multiplier * (d + f1 * (f1 - 1) / (2 * (f2 + 1))), d,
+                                       static_cast<double>(n_samp));
+                }
 
-                    // Pick a random index in s2 within the limit.
-                    const auto idx2 = vidx2[idist(rng, dist_param_type(0u, limit - 1u))];
+                trial_results[i] = trial_result{est, n_samples, n_dups};
 
-                    // Try to do the multiplication.
-                    ::obake::monomial_mul(tmp_key, x[idx1].first, y[idx2].first, ss);
+                // Clear up the local map for the next iteration.
+                lm.clear();
+            }
+        });
 
-                    // Try the insertion into the local set.
-                    const auto ret = ls.insert(tmp_key);
-                    if (!ret.second) {
-                        // The key already exists, break out.
-                        break;
-                    }
-                }
+    // Combine the results of the trials.
+    poly_mul_est_stats stats;
+    stats.n_trials = ntrials;
+    double mean = 0;
+    for (const auto &tr : trial_results) {
+        mean += tr.est;
+        stats.n_samples += tr.n_samples;
+        stats.n_dups += tr.n_dups;
+    }
+    mean /= ntrials;
 
-                // Determine how many unique terms were generated
-                // in the loop above.
-                const auto count = ls.size();
-
-                if (count == vidx1_copy.size()) {
-                    // We generated as many unique terms as
-                    // the number of terms in x. This means that
-                    // we will estimate a perfect sparsity. In untruncated
-                    // multiplication, this means nx * ny, in a truncated
-                    // multiplication is less than that (depending on
-                    // how many terms were skipped due to the truncation
-                    // limits).
-                    cur += acc_y;
-                } else {
-                    // We detected a duplicate term, use the
-                    // quadratic estimate.
-                    cur += (::mppp::integer<1>{multiplier} * count * count) >> 1;
-                }
+    if (ntrials > 1u) {
+        double var = 0;
+        for (const auto &tr : trial_results) {
+            var += (tr.est - mean) * (tr.est - mean);
+        }
+        var /= (ntrials - 1u);
+        stats.rel_std_err = ::std::sqrt(var / ntrials) / mean;
+    }
 
-                // Clear up the local set for the next iteration.
-                ls.clear();
-            }
+    stats.exact = n_samp == tot_n_mults
+                  && ::std::all_of(trial_results.begin(), trial_results.end(),
+                                   [n_samp](const auto &tr) { return tr.n_samples == n_samp; });
 
-            // Return the accumulated estimate.
-            return cur;
-        },
-        [](const auto &a, const auto &b) { return a + b; });
+    // Scale the estimate if we could not sample
+    // the whole joint index space.
+    if (n_samp < tot_n_mults) {
+        mean *= static_cast<double>(tot_n_mults) / static_cast<double>(n_samp);
+    }
 
-    // Return the average of the estimates (but don't return zero).
-    // NOTE: ntrials is guaranteed to be nonzero from above.
-    auto ret = c_est / ntrials;
+    // Return the estimate (but don't return zero).
+    auto ret = ::mppp::integer<1>{::std::round(mean)};
     if (ret.is_zero()) {
-        return ::std::make_tuple(::mppp::integer<1>{1}, ::std::move(tot_n_mults));
-    } else {
-        return ::std::make_tuple(::std::move(ret), ::std::move(tot_n_mults));
+        ret = 1;
     }
+
+    return ::std::make_tuple(::std::move(ret), ::std::move(tot_n_mults), stats);
 }
 
-// The multi-threaded homomorphic implementation.
-template <typename Ret, typename T, typename U, typename... Args>
-inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args &...args)
+// Helper to compute the number of terms used to size the segmentation
+// of a polynomial product, given the estimated number of terms est_nterms
+// and the statistics est_stats of the estimation
+// (see poly_mul_estimate_product_size()).
+// NOTE: an overestimate results in too many segments and in
+// over-reserved tables, whereas an underestimate only results
+// in somewhat larger segments. Thus, unless the estimate is exact,
+// we use the lower end of the ~95% confidence interval, clamped to
+// half the estimate so that a noisy estimate cannot collapse
+// the segmentation.
+inline ::mppp::integer<1> poly_mul_seg_nterms(const ::mppp::integer<1> &est_nterms, const poly_mul_est_stats &est_stats)
 {
-    using cf1_t = series_cf_t<T>;
-    using cf2_t = series_cf_t<U>;
-    using ret_key_t = series_key_t<Ret>;
-    using ret_cf_t = series_cf_t<Ret>;
-    using s_size_t = typename Ret::s_size_type;
+    // NOTE: the negated comparison also catches NaNs.
+    if (est_stats.exact || !(est_stats.rel_std_err > 0)) {
+        return est_nterms;
+    }
 
-    // Preconditions.
-    static_assert(sizeof...(args) <= 2u);
-    assert(!x.empty());
-    assert(!y.empty());
-    assert(x.size() <= y.size());
-    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
-    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
-    assert(retval.empty());
-    assert(retval._get_s_table().size() == 1u);
+    const auto factor = ::std::max(.5, 1 - 1.96 * est_stats.rel_std_err);
 
-    // Cache the symbol set.
-    const auto &ss = retval.get_symbol_set();
+    // NOTE: don't return zero.
+    auto ret = ::mppp::integer<1>{::std::round(static_cast<double>(est_nterms) * factor)};
+    if (ret.is_zero()) {
+        ret = 1;
+    }
 
-    // Create vectors containing copies of
-    // the input terms.
-    // NOTE: in theory, it would be possible here
-    // to move the coefficients (in conjunction with
-    // rref_cleaner, as usual).
-    // NOTE: drop the const from the key type in order
-    // to allow mutability.
-    // NOTE: need to better assess the benefits of
-    // copying the input series.
-    ::std::vector<::std::pair<series_key_t<T>, cf1_t>> v1(
-        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_pair_transform{}),
-        ::boost::make_transform_iterator(x.end(), poly_mul_impl_pair_transform{}));
-    ::std::vector<::std::pair<series_key_t<U>, cf2_t>> v2(
-        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_pair_transform{}),
-        ::boost::make_transform_iterator(y.end(), poly_mul_impl_pair_transform{}));
+    return ret;
+}
 
-    // Do the monomial overflow checking, if supported.
-    // NOTE: we have to sequence the overflow checking before the product
-    // size estimation and the average term size estimation, as those two
-    // operations might generate overflows during monomial multiplication.
-    const auto r1
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
-    const auto r2
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
-    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
-        // The monomial overflow checking is supported, run it.
-        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
-            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
-                                               "attempting to multiply two polynomials");
-        }
-    }
+// Layout of the coefficient array used in the dense multiplication
+// engine for packed monomials (see poly_mul_impl_mt_dense()).
+// Each monomial in the product is mapped to a slot of the
+// array via a mixed-radix representation of its exponents: the i-th
+// exponent e_i contributes (e_i - min1[i] - min2[i]) * strides[i]
+// to the index of the slot, where min1[i] and min2[i] are the smallest
+// exponents of the i-th variable in the two factors. Because
+// the slot index of a term-by-term product is the sum of the
+// slot indices of the two factors (computed with respect to min1
+// and min2 respectively), the products can be accumulated in the
+// array with direct indexing. n_slots is the size of the array,
+// or zero if the dense engine cannot be used.
+template <typename T>
+struct poly_mul_dense_layout {
+    ::std::vector<T> min1, min2;
+    ::std::vector<::std::size_t> exts, strides;
+    ::std::size_t n_slots = 0;
+};
 
-    // Estimate the total number of terms, and compute the total number
-    // of term-by-term multiplications.
-    // NOTE: poly_mul_estimate_product_size() requires the shorter series first,
-    // which is ensured by the preconditions of this function.
-    const auto [est_nterms, tot_n_mults] = detail::poly_mul_estimate_product_size<T, U>(v1, v2, ss, args...);
-    // Exit early if the truncation limits
-    // result in an empty output series.
-    if (sizeof...(Args) > 0u && tot_n_mults.is_zero()) {
-        return;
-    }
+// Helper to establish the layout of the coefficient array
+// for the dense multiplication of the terms in v1 and v2.
+// est_nterms and est_sp are the estimated number of terms and
+// the estimated sparsity of the product, max_sp the sparsity
+// threshold above which the dense engine is never used.
+// If the dense engine is not deemed convenient, the n_slots
+// member of the returned layout will be zero.
+// NOTE: requires v1/v2 not empty, and the monomial overflow check to
+// have been run already, so that all the exponents in the product
+// are guaranteed to be within the limits.
+template <typename T1, typename T2>
+inline auto poly_mul_impl_dense_layout(const ::std::vector<T1> &v1, const ::std::vector<T2> &v2, const symbol_set &ss,
+                                       const ::mppp::integer<1> &est_nterms, double est_sp, double max_sp)
+{
+    using key_type = typename T1::first_type;
+    using value_type = typename key_type::value_type;
+    using mm_t = ::std::vector<::std::pair<value_type, value_type>>;
 
-    // Estimate the average term size.
-    // NOTE: once poly_mul_impl_estimate_average_term_size() becomes more computationally intensive,
-    // we can do it in parallel with poly_mul_estimate_product_size().
-    const auto avg_term_size = detail::poly_mul_impl_estimate_average_term_size<ret_cf_t>(v1, v2, ss);
+    static_assert(detail::same_packed_monomial_v<key_type, typename T2::first_type>);
 
-    // Compute the estimated sparsity.
-    const auto est_sp = static_cast<double>(est_nterms) / static_cast<double>(tot_n_mults);
+    // Preconditions.
+    assert(!v1.empty());
+    assert(!v2.empty());
 
-    // Establish the desired segment size in kilobytes.
-    // NOTE: the idea here is the following. For highly
-    // sparse polynomials (est_sp >= threshold), we want to pick
-    // a relatively large size so that it fits somewhere in L2
-    // cache, say. The reason is that we won't do much computation
-    // per segment due to the sparsity, thus we aim at reducing
-    // the parallelisation overhead by operating on larger chunks
-    // of the product series. When the sparsity is smaller, then
-    // we have a higher computational density, thus we will spend
-    // more time computing a single segment, and thus we can aim
-    // at staying in L1 cache instead, as the parallelisation overhead
-    // will be smaller. Note that these values will be just rule-of-thumb,
-    // because the sparsity is not estimated accurately and because
-    // of further manipulations below. Additionally, it is not clear
-    // to me how smooth the transition between high and low sparsity
-    // will be. Eventually, we may perhaps want to leave this parameter as
-    // a tunable parameter for the user or perhaps even determine
-    // the cache sizes at runtime and use those.
-    // NOTE: if est_sp is not finite, due to tot_n_mults being zero or other
-    // FP issues, go with a default value.
-    // NOTE: is it worth it to exit early if tot_n_mults is zero? This would
-    // mean that the truncation limits will produce an empty series.
-    const auto seg_size = (!::std::isfinite(est_sp) || est_sp >= 1E-3) ? 200ul : 20ul;
+    poly_mul_dense_layout<value_type> retval;
 
-    // Estimate the number of segments via the deduced segment size.
-    const auto est_nsegs = (est_nterms * avg_term_size) / (seg_size * 1024ul);
+    // NOTE: the dense engine pays off only if the product
+    // is not too sparse (i.e., on average many term-by-term
+    // multiplications end up in the same term of the product),
+    // and if the coefficient array is not too large with respect
+    // to the estimated number of terms. Because est_nterms <= tot_n_mults,
+    // the size of the array is also never larger than max_size_ratio * nx * ny.
+    // NOTE: this is a rule-of-thumb value inferred from the
+    // dense benchmarks.
+    constexpr unsigned max_size_ratio = 32;
 
-    // Fetch the base-2 logarithm + 1 of est_nsegs, making sure it does not
-    // overflow the max allowed value for the return polynomial type.
-    const auto log2_nsegs = ::std::min(::obake::safe_cast<unsigned>(est_nsegs.nbits()),
-                                       polynomial<ret_key_t, ret_cf_t>::get_max_s_size());
+    if (!::std::isfinite(est_sp) || est_sp >= max_sp) {
+        return retval;
+    }
 
-    // Setup the number of segments in retval.
-    retval.set_n_segments(log2_nsegs);
+    const auto nvars = ::obake::safe_cast<unsigned>(ss.size());
 
-    // Cache the actual number of segments.
-    const auto nsegs = s_size_t(1) << log2_nsegs;
+    // Helper to compute the min/max exponents
+    // for each variable in a vector of terms.
+    auto minmax_exps = [nvars](const auto &v) {
+        return ::tbb::parallel_reduce(
+            ::tbb::blocked_range<decltype(v.size())>(0, v.size()), mm_t{},
+            [&v, nvars](const auto &range, mm_t cur) {
+                value_type tmp;
 
-    // Helper to sort the input terms according to the hash value modulo
-    // 2**log2_nsegs. That is, sort them according to the bucket
-    // they would occupy in a segmented table with 2**log2_nsegs
-    // segments.
-    auto t_sorter = [log2_nsegs](const auto &p1, const auto &p2) {
-        const auto h1 = ::obake::hash(p1.first);
-        const auto h2 = ::obake::hash(p2.first);
+                for (auto i = range.begin(); i != range.end(); ++i) {
+                    kunpacker<value_type> ku(v[i].first.get_value(), nvars);
 
-        return h1 % (s_size_t(1) << log2_nsegs) < h2 % (s_size_t(1) << log2_nsegs);
+                    if (cur.empty()) {
+                        for (auto j = 0u; j < nvars; ++j) {
+                            ku >> tmp;
+                            cur.emplace_back(tmp, tmp);
+                        }
+                    } else {
+                        for (auto &[mn, mx] : cur) {
+                            ku >> tmp;
+                            mn = ::std::min(mn, tmp);
+                            mx = ::std::max(mx, tmp);
+                        }
+                    }
+                }
+
+                return cur;
+            },
+            [](mm_t a, const mm_t &b) {
+                if (a.empty()) {
+                    return b;
+                }
+
+                for (decltype(a.size()) i = 0; i < b.size(); ++i) {
+                    a[i].first = ::std::min(a[i].first, b[i].first);
+                    a[i].second = ::std::max(a[i].second, b[i].second);
+                }
+
+                return a;
+            });
     };
 
-    // Helper to compute the segmentation for the input series.
-    // The segmentation is a vector of ranges (represented
-    // as pairs of indices into v1/v2) paired to indices
-    // representing the bucket that the range
-    // would occupy in a segmented table
-    // with 2**log2_nsegs segments.
-    auto compute_vseg = [nsegs, log2_nsegs](const auto &v) {
-        // Ensure that the size of v is representable by
-        // its iterator's diff type. We need to do some
-        // iterator arithmetics below.
-        ::obake::detail::container_it_diff_check(v);
+    mm_t mm1, mm2;
+    ::tbb::parallel_invoke([&mm1, &v1, &minmax_exps]() { mm1 = minmax_exps(v1); },
+                           [&mm2, &v2, &minmax_exps]() { mm2 = minmax_exps(v2); });
+    assert(mm1.size() == nvars || (nvars == 0u && mm1.empty()));
+    assert(mm2.size() == mm1.size());
+
+    // Compute the extents and the strides, and the size of the array.
+    // NOTE: do it with multiprecision arithmetics, in order to
+    // avoid any overflow concern.
+    ::mppp::integer<1> n_slots{1};
+    for (decltype(mm1.size()) i = 0; i < mm1.size(); ++i) {
+        const auto ext = ::mppp::integer<1>{mm1[i].second} + mm2[i].second - mm1[i].first - mm2[i].first + 1;
+
+        // NOTE: n_slots is the stride of the current variable.
+        if (n_slots > ::obake::detail::limits_max<::std::size_t>) {
+            return retval;
+        }
+        retval.strides.push_back(static_cast<::std::size_t>(n_slots));
 
-        using idx_t = decltype(v.size());
-        ::std::vector<::std::tuple<idx_t, idx_t, s_size_t>> vseg;
-        // NOTE: the max possible size of vseg is the number of segments.
-        vseg.reserve(::obake::safe_cast<decltype(vseg.size())>(nsegs));
-
-        const auto v_begin = v.begin(), v_end = v.end();
-
-        // NOTE: if the number of terms in v is small enough,
-        // compute a sparse representation of vseg (meaning that
-        // the number of segmentation ranges will be less than
-        // nsegs and all the ranges will be non-empty). Otherwise,
-        // compute a dense representation, where the number
-        // of ranges is equal to nsegs and empty ranges might
-        // be present. We will later run different parallel
-        // functors depending on whether we are in the sparse
-        // or dense case.
-        // NOTE: the idea here is that we want to run
-        // the sparse functor only in highly sparse cases,
-        // because otherwise the more complicated logic
-        // of the sparse functor carries a measurable performance
-        // penalty in the "mostly-dense" cases.
-        if (v.size() < nsegs / 2u) {
-            for (auto it = v_begin; it != v_end;) {
-                // Get the bucket index of the current term.
-                const auto cur_b_idx = static_cast<s_size_t>(::obake::hash(it->first) % (s_size_t(1) << log2_nsegs));
-                // Look for the first term whose bucket index is greater than cur_b_idx.
-                const auto range_end
-                    = ::std::upper_bound(it, v_end, cur_b_idx, [log2_nsegs](const auto &b_idx, const auto &p) {
-                          return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
-                      });
-                // NOTE: because we are in the sparse representation case,
-                // range_end cannot be equal to it.
-                assert(range_end != it);
-                // Add the range to vseg.
-                // NOTE: the overflow check was done earlier.
-                vseg.emplace_back(static_cast<idx_t>(it - v_begin), static_cast<idx_t>(range_end - v_begin), cur_b_idx);
-                // Update 'it'.
-                it = range_end;
-            }
-        } else {
-            // NOTE: the segmentation in dense form may be
-            // parallelised easily if needed.
-            idx_t idx = 0;
-            auto it = v_begin;
-            for (s_size_t i = 0; i < nsegs; ++i) {
-                // Look for the first term whose bucket index is greater than i.
-                // NOTE: this might result in 'it' not changing, in which case
-                // the segmentation range will be empty.
-                it = ::std::upper_bound(it, v_end, i, [log2_nsegs](const auto &b_idx, const auto &p) {
-                    return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
-                });
-                const auto old_idx = idx;
-                // NOTE: the overflow check was done earlier.
-                idx = static_cast<idx_t>(it - v_begin);
-                vseg.emplace_back(old_idx, idx, i);
-            }
+        n_slots *= ext;
+        if (n_slots > est_nterms * max_size_ratio || n_slots > ::obake::detail::limits_max<::std::size_t>) {
+            return retval;
         }
+        retval.exts.push_back(static_cast<::std::size_t>(ext));
 
-        return vseg;
-    };
+        retval.min1.push_back(mm1[i].first);
+        retval.min2.push_back(mm2[i].first);
+    }
 
-    // Helper that, given a segmentation vseg into a vector of terms
-    // v, will:
-    //
-    // - create and return a vector vd
-    //   containing the total/partial degrees of all the
-    //   terms in v, with the degrees within each vseg range sorted
-    //   in ascending order,
-    // - sort v according to vd.
-    //
-    // v will be one of v1/v2, t is a type_c instance
-    // containing either T or U.
-    auto seg_sorter = [&ss, &args...](auto &v, auto t, const auto &vseg) {
-        if constexpr (sizeof...(args) == 0u) {
-            // Non-truncated case: seg_sorter will be a no-op.
-            ::obake::detail::ignore(v, t, vseg, ss, args...);
-        } else {
-            // Truncated case.
+    if (n_slots > est_nterms * max_size_ratio) {
+        return retval;
+    }
 
-            // NOTE: we will be using the machinery from the default implementation
-            // of degree() for series, so that we can re-use the concept checking bits
-            // as well.
-            using s_t = typename decltype(t)::type;
+    retval.n_slots = static_cast<::std::size_t>(n_slots);
 
-            // Compute the vector of degrees.
-            auto vd = [&v, &ss, &args...]() {
-                // NOTE: in the make_(p_)degree_vector() helpers we need
-                // to compute the size of v via iterator differences.
-                ::obake::detail::container_it_diff_check(v);
+    return retval;
+}
 
-                if constexpr (sizeof...(args) == 1u) {
-                    // Total degree.
-                    ::obake::detail::ignore(args...);
+// The multi-threaded dense implementation, for packed monomials.
+// The term-by-term products are accumulated in a flat array of coefficients
+// whose layout is described by dl. The array is split in blocks of block_size
+// slots which are processed in parallel. At the end, the nonzero
+// coefficients in the array are moved into retval.
+// NOTE: requires v1/v2 not empty, retval empty and already segmented,
+// and dl to have been computed via poly_mul_impl_dense_layout()
+// with a nonzero number of slots.
+template <typename Ret, typename T1, typename T2, typename V>
+inline void poly_mul_impl_mt_dense(Ret &retval, const ::std::vector<T1> &v1, const ::std::vector<T2> &v2,
+                                   const symbol_set &ss, const poly_mul_dense_layout<V> &dl, ::std::size_t block_size)
+{
+    using cf1_t = typename T1::second_type;
+    using cf2_t = typename T2::second_type;
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using s_size_t = typename Ret::s_size_type;
+    using uvalue_t = make_unsigned_t<V>;
 
-                    return customisation::internal::make_degree_vector<s_t>(v.cbegin(), v.cend(), ss, true);
-                } else {
-                    // Partial degree.
-                    static_assert(sizeof...(args) == 2u);
+    static_assert(::std::is_same_v<ret_key_t, typename T1::first_type>);
+    static_assert(::std::is_same_v<ret_key_t, typename T2::first_type>);
 
-                    return customisation::internal::make_p_degree_vector<s_t>(
-                        v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
-                }
-            }();
+    // Preconditions.
+    assert(!v1.empty());
+    assert(!v2.empty());
+    assert(retval.empty());
+    assert(dl.n_slots > 0u);
+    assert(block_size > 0u);
 
-            // Ensure that the size of vd is representable by the
-            // diff type of its iterators. We'll need to do some
-            // iterator arithmetics below.
-            // NOTE: cast to const as we will use cbegin/cend below.
-            ::obake::detail::container_it_diff_check(::std::as_const(vd));
+    const auto nvars = ::obake::safe_cast<unsigned>(ss.size());
 
-            // Create a vector of indices into vd.
-            auto vidx = detail::poly_mul_impl_par_make_idx_vector(vd);
+    // Helper to create a vector of (slot index, coefficient pointer)
+    // pairs from a vector of terms, sorted according to the slot index.
+    auto make_ivec = [nvars, &dl](const auto &v, const auto &mins) {
+        using cf_t = typename remove_cvref_t<decltype(v)>::value_type::second_type;
 
-            // Sort indirectly each range from vseg according to the degree.
-            // NOTE: capture vd as const ref because in the lt-comparable requirements for the degree
-            // type we are using const lrefs.
-            ::tbb::parallel_for(
-                ::tbb::blocked_range<decltype(vseg.cbegin())>(vseg.cbegin(), vseg.cend()),
-                [&vidx, &vdc = ::std::as_const(vd)](const auto &range) {
-                    for (const auto &r : range) {
-                        // NOTE: note sure if it is worth to run
-                        // a parallel sort here.
-                        ::std::sort(vidx.data() + ::std::get<0>(r), vidx.data() + ::std::get<1>(r),
-                                    [&vdc](const auto &idx1, const auto &idx2) { return vdc[idx1] < vdc[idx2]; });
-                    }
-                });
+        ::std::vector<::std::pair<::std::size_t, const cf_t *>> ret;
+        ret.resize(::obake::safe_cast<decltype(ret.size())>(v.size()));
 
-            // Apply the sorting to vd and v. Ensure we don't run
-            // into overflows during the permutated access.
-            ::obake::detail::container_it_diff_check(vd);
-            // NOTE: use cbegin/cend on vd to ensure the copy ctor of
-            // the degree type is being called.
-            vd = decltype(vd)(::boost::make_permutation_iterator(vd.cbegin(), vidx.cbegin()),
-                              ::boost::make_permutation_iterator(vd.cend(), vidx.cend()));
-            ::obake::detail::container_it_diff_check(v);
-            v = ::std::remove_reference_t<decltype(v)>(::boost::make_permutation_iterator(v.cbegin(), vidx.cbegin()),
-                                                       ::boost::make_permutation_iterator(v.cend(), vidx.cend()));
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(v.size())>(0, v.size()),
+                            [&v, &ret, &mins, nvars, &dl](const auto &range) {
+                                V tmp;
 
-#if !defined(NDEBUG)
-            // Check the results in debug mode.
-            for (const auto &r : vseg) {
-                const auto &idx_begin = ::std::get<0>(r);
-                const auto &idx_end = ::std::get<1>(r);
+                                for (auto i = range.begin(); i != range.end(); ++i) {
+                                    kunpacker<V> ku(v[i].first.get_value(), nvars);
 
-                // NOTE: add constness to vd in order to ensure that
-                // the degrees are compared via const refs.
-                assert(::std::is_sorted(::std::as_const(vd).data() + idx_begin, ::std::as_const(vd).data() + idx_end));
+                                    ::std::size_t idx = 0;
+                                    for (auto j = 0u; j < nvars; ++j) {
+                                        ku >> tmp;
+                                        // NOTE: tmp - mins[j] is never negative and it is
+                                        // less than the extent of the variable, thus
+                                        // the computation of idx cannot overflow.
+                                        idx += static_cast<::std::size_t>(static_cast<uvalue_t>(
+                                                   static_cast<uvalue_t>(tmp) - static_cast<uvalue_t>(mins[j])))
+                                               * dl.strides[j];
+                                    }
 
-                if constexpr (sizeof...(args) == 1u) {
-                    using d_impl = customisation::internal::series_default_degree_impl;
+                                    ret[i] = ::std::make_pair(idx, &v[i].second);
+                                }
+                            });
 
-                    assert(::std::equal(
-                        vd.data() + idx_begin, vd.data() + idx_end,
-                        ::boost::make_transform_iterator(v.data() + idx_begin, d_impl::d_extractor<s_t>{&ss}),
-                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
-                } else {
-                    using d_impl = customisation::internal::series_default_p_degree_impl;
+        ::tbb::parallel_sort(ret.begin(), ret.end(),
+                             [](const auto &p1, const auto &p2) { return p1.first < p2.first; });
 
-                    const auto &s = ::std::get<1>(::std::forward_as_tuple(args...));
-                    const auto si = ::obake::detail::ss_intersect_idx(s, ss);
+        return ret;
+    };
 
-                    assert(::std::equal(
-                        vd.data() + idx_begin, vd.data() + idx_end,
-                        ::boost::make_transform_iterator(v.data() + idx_begin, d_impl::d_extractor<s_t>{&s, &si, &ss}),
-                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
+    decltype(make_ivec(v1, dl.min1)) iv1;
+    decltype(make_ivec(v2, dl.min2)) iv2;
+    ::tbb::parallel_invoke([&iv1, &v1, &dl, &make_ivec]() { iv1 = make_ivec(v1, dl.min1); },
+                           [&iv2, &v2, &dl, &make_ivec]() { iv2 = make_ivec(v2, dl.min2); });
+
+    // The max slot index in the second factor.
+    const auto max_idx2 = iv2.back().first;
+    assert(iv1.back().first + max_idx2 < dl.n_slots);
+
+    // Comparator for the binary searches on iv1/iv2.
+    auto lb_cmp = [](const auto &p, const auto &idx) { return p.first < idx; };
+
+    // Number of blocks in the array.
+    const auto n_blocks = dl.n_slots / block_size + static_cast<::std::size_t>(dl.n_slots % block_size != 0u);
+
+    try {
+        // Create the dense array.
+        // NOTE: the coefficients are value-initialised,
+        // i.e., they are all zero.
+        ::std::vector<ret_cf_t> dense(dl.n_slots);
+
+        // Accumulate the term-by-term products, block by block.
+        ::tbb::parallel_for(::tbb::blocked_range<::std::size_t>(0, n_blocks), [&iv1, &iv2, &dense, &dl, block_size,
+                                                                                max_idx2, lb_cmp](const auto &range) {
+            const auto dptr = dense.data();
+
+            for (auto b_idx = range.begin(); b_idx != range.end(); ++b_idx) {
+                // The slot range of the current block.
+                const auto lo = b_idx * block_size, hi = ::std::min(lo + block_size, dl.n_slots);
+
+                // Locate the terms in iv1 which can contribute to the
+                // slots in [lo, hi): a term with slot index i1 contributes
+                // to the slots in [i1, i1 + max_idx2].
+                auto it1 = ::std::lower_bound(iv1.begin(), iv1.end(), lo > max_idx2 ? lo - max_idx2 : 0u, lb_cmp);
+                const auto end1 = ::std::lower_bound(it1, iv1.end(), hi, lb_cmp);
+
+                for (; it1 != end1; ++it1) {
+                    const auto [i1, c1ptr] = *it1;
+                    const auto &c1 = *c1ptr;
+
+                    // Locate the terms in iv2 whose products by
+                    // the current term end up in [lo, hi).
+                    // NOTE: i1 < hi, thus hi - i1 cannot underflow.
+                    const auto it2_begin = ::std::lower_bound(iv2.begin(), iv2.end(), lo > i1 ? lo - i1 : 0u, lb_cmp);
+                    const auto it2_end = ::std::lower_bound(it2_begin, iv2.end(), hi - i1, lb_cmp);
+
+                    const auto bptr = dptr + i1;
+                    for (auto it2 = it2_begin; it2 != it2_end; ++it2) {
+                        auto &rc = *(bptr + it2->first);
+
+                        if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
+                            ::obake::fma3(rc, c1, *it2->second);
+                        } else {
+                            rc += c1 * *it2->second;
+                        }
+                    }
                 }
             }
-#endif
+        });
 
-            // Return the vector of degrees.
-            return vd;
-        }
-    };
+        // Now we need to move the nonzero coefficients into retval.
+        // First we count the nonzero coefficients in each block.
+        ::std::vector<::std::size_t> nz_counts;
+        nz_counts.resize(::obake::safe_cast<decltype(nz_counts.size())>(n_blocks + 1u));
+        ::tbb::parallel_for(::tbb::blocked_range<::std::size_t>(0, n_blocks),
+                            [&dense, &nz_counts, &dl, block_size](const auto &range) {
+                                for (auto b_idx = range.begin(); b_idx != range.end(); ++b_idx) {
+                                    const auto lo = b_idx * block_size,
+                                               hi = ::std::min(lo + block_size, dl.n_slots);
+
+                                    nz_counts[b_idx + 1u] = static_cast<::std::size_t>(
+                                        ::std::count_if(dense.data() + lo, dense.data() + hi, [](const auto &c) {
+                                            return !::obake::is_zero(c);
+                                        }));
+                                }
+                            });
+        // Turn the counts into offsets.
+        // NOTE: the total number of nonzero coefficients
+        // is not greater than n_slots, thus there are no
+        // overflow concerns here.
+        ::std::partial_sum(nz_counts.begin(), nz_counts.end(), nz_counts.begin());
+
+        // Build a vector of (code, slot index) pairs for the nonzero
+        // coefficients, and sort it according to the segment index
+        // that each code will occupy in retval.
+        const auto log2_nsegs = retval.get_s_size();
+        ::std::vector<::std::pair<V, ::std::size_t>> nz_slots;
+        nz_slots.resize(::obake::safe_cast<decltype(nz_slots.size())>(nz_counts.back()));
+        ::tbb::parallel_for(
+            ::tbb::blocked_range<::std::size_t>(0, n_blocks),
+            [&dense, &nz_counts, &nz_slots, &dl, block_size, nvars](const auto &range) {
+                for (auto b_idx = range.begin(); b_idx != range.end(); ++b_idx) {
+                    const auto lo = b_idx * block_size, hi = ::std::min(lo + block_size, dl.n_slots);
+
+                    auto out_idx = nz_counts[b_idx];
+                    for (auto idx = lo; idx != hi; ++idx) {
+                        if (::obake::is_zero(::std::as_const(dense[idx]))) {
+                            continue;
+                        }
 
-    // Prepare the variables to hold the segmentations
-    // and the degrees of the terms, if we are in a
-    // truncated multiplication.
-    decltype(compute_vseg(v1)) vseg1;
-    decltype(compute_vseg(v2)) vseg2;
-    auto degree_data = detail::poly_mul_impl_prepare_degree_data<T, U>(v1, v2, ss, args...);
+                        // Decode the exponents from the slot index,
+                        // and pack them into a code.
+                        kpacker<V> kp(nvars);
+                        for (auto j = 0u; j < nvars; ++j) {
+                            const auto digit = static_cast<uvalue_t>((idx / dl.strides[j]) % dl.exts[j]);
+                            kp << static_cast<V>(static_cast<uvalue_t>(
+                                static_cast<uvalue_t>(dl.min1[j]) + static_cast<uvalue_t>(dl.min2[j]) + digit));
+                        }
 
-    // For both x and y, concurrently:
-    // - sort v1/v2 according to the segmentation order,
-    // - compute the segmentation ranges,
-    // - compute the degrees of the terms and sort according
-    //   to the degree within each segment (only for truncated
-    //   multiplication).
-    ::tbb::parallel_invoke(
-        [&v1, t_sorter, &vseg1, compute_vseg, &degree_data, seg_sorter]() {
-            ::tbb::parallel_sort(v1.begin(), v1.end(), t_sorter);
-            vseg1 = compute_vseg(v1);
-            if constexpr (sizeof...(Args) > 0u) {
-                ::std::get<0>(degree_data) = seg_sorter(v1, ::obake::detail::type_c<T>{}, vseg1);
-            } else {
-                ::obake::detail::ignore(degree_data, seg_sorter);
-            }
-        },
-        [&v2, t_sorter, &vseg2, compute_vseg, &degree_data, seg_sorter]() {
-            ::tbb::parallel_sort(v2.begin(), v2.end(), t_sorter);
-            vseg2 = compute_vseg(v2);
-            if constexpr (sizeof...(Args) > 0u) {
-                ::std::get<1>(degree_data) = seg_sorter(v2, ::obake::detail::type_c<U>{}, vseg2);
-            } else {
-                ::obake::detail::ignore(degree_data, seg_sorter);
-            }
+                        nz_slots[out_idx++] = ::std::make_pair(kp.get(), idx);
+                    }
+
+                    assert(out_idx == nz_counts[b_idx + 1u]);
+                }
+            });
+
+        auto seg_idx_ext = [log2_nsegs](const auto &p) {
+            return static_cast<s_size_t>(::obake::hash(ret_key_t(p.first)) % (s_size_t(1) << log2_nsegs));
+        };
+        ::tbb::parallel_sort(nz_slots.begin(), nz_slots.end(), [&seg_idx_ext](const auto &p1, const auto &p2) {
+            return seg_idx_ext(p1) < seg_idx_ext(p2);
         });
 
-#if !defined(NDEBUG)
-    {
-        // Check the segmentations in debug mode.
-        assert(vseg1.size() <= nsegs);
-        assert(vseg2.size() <= nsegs);
-
-        auto verify_seg = [log2_nsegs, nsegs](const auto &vs, const auto &v) {
-            // Counter for the number of terms represented in the
-            // segmentation vector.
-            decltype(v.size()) counter = 0;
-
-            for (const auto &t : vs) {
-                const auto &[start, end, b_idx] = t;
-                assert(end <= v.size());
-                // NOTE: different check depending
-                // on whether we are in the sparse or
-                // dense case.
-                if (vs.size() < nsegs) {
-                    assert(start < end);
-                } else {
-                    assert(start <= end);
+        // Fill in retval, segment by segment.
+        ::tbb::parallel_for(
+            ::tbb::blocked_range<s_size_t>(0, s_size_t(1) << log2_nsegs),
+            [&retval, &dense, &nz_slots, &seg_idx_ext, mts = retval._get_max_table_size()](const auto &range) {
+                for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                    auto &table = retval._get_s_table()[seg_idx];
+
+                    // Locate the range of nz_slots
+                    // which ends up in the current segment.
+                    const auto r_begin = ::std::lower_bound(
+                        nz_slots.begin(), nz_slots.end(), seg_idx,
+                        [&seg_idx_ext](const auto &p, const auto &s_idx) { return seg_idx_ext(p) < s_idx; });
+                    const auto r_end = ::std::upper_bound(
+                        r_begin, nz_slots.end(), seg_idx,
+                        [&seg_idx_ext](const auto &s_idx, const auto &p) { return s_idx < seg_idx_ext(p); });
+
+                    table.reserve(static_cast<decltype(table.size())>(r_end - r_begin));
+
+                    for (auto it = r_begin; it != r_end; ++it) {
+                        // NOTE: the keys are unique, thus
+                        // the insertion will always succeed.
+                        [[maybe_unused]] const auto res
+                            = table.try_emplace(ret_key_t(it->first), ::std::move(dense[it->second]));
+                        assert(res.second);
+                    }
+
+                    // LCOV_EXCL_START
+                    // Check the table size against the max allowed size.
+                    if (obake_unlikely(table.size() > mts)) {
+                        obake_throw(::std::overflow_error, "The dense multithreaded multiplication of two "
+                                                           "polynomials resulted in a table whose size ("
+                                                               + ::obake::detail::to_string(table.size())
+                                                               + ") is larger than the maximum allowed value ("
+                                                               + ::obake::detail::to_string(mts) + ")");
+                    }
+                    // LCOV_EXCL_STOP
                 }
-                counter += end - start;
+            });
+        // LCOV_EXCL_START
+    } catch (...) {
+        // In case of exceptions, clear retval before
+        // rethrowing to ensure a known sane state.
+        retval.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
+
+// Helper to decide whether or not to use the heap-based multiplication
+// (see poly_mul_impl_heap()) in place of the hashing-based multithreaded
+// implementation. est_nterms, est_sp and avg_term_size are the estimated number
+// of terms, the estimated sparsity and the estimated average term size
+// of the product. min_sp and min_bytes are the sparsity and size thresholds
+// (see mul_tuning).
+// NOTE: the heap-based multiplication performs more work per term-by-term
+// product than the hashing-based implementation (due to the priority queue
+// operations), thus we want to use it only when the product is very sparse
+// (so that there is little computation per term) and the working set of the
+// hashing-based implementation (i.e., the estimated byte size of the product
+// before cancellations) becomes large enough to hinder performance and
+// memory utilisation. The heap-based multiplication only needs to store
+// the terms which survive cancellations.
+inline bool poly_mul_impl_use_heap(const ::mppp::integer<1> &est_nterms, double est_sp, ::std::size_t avg_term_size,
+                                   double min_sp, unsigned long long min_bytes)
+{
+    return ::std::isfinite(est_sp) && est_sp >= min_sp && est_nterms * avg_term_size >= min_bytes;
+}
+
+// Heap-based multiplication for packed monomials (Monagan-Pearce algorithm).
+// v1 and v2 are the terms of the two factors (as returned by
+// poly_mul_impl_copy_terms()), which are sorted (indirectly) according to the
+// Kronecker codes of their monomials. Because the code of the product of two
+// monomials is the sum of the codes of the factors, the term-by-term products
+// for a fixed term of v1 are sorted as well, and they can be merged via a
+// priority queue whose size is never larger than v1.size(). The terms of the
+// product are thus generated in sorted order, and they can be accumulated and
+// checked for cancellation one at a time before being inserted into retval.
+// The merge is parallelised by splitting the range of the codes of the product
+// into (at most) n_chunks chunks, whose boundaries are estimated by sampling
+// the term-by-term products. The chunks are merged independently, and the
+// insertions into the tables of retval are protected by per-table spinlocks.
+// The working memory is then O(v1.size() + v2.size()) per chunk being
+// processed, plus the size of the result after cancellations.
+// NOTE: this implementation does not support truncation.
+// NOTE: requires v1 and v2 not empty, v1 not longer than v2, retval empty,
+// n_chunks nonzero and the monomial overflow check to have been run already.
+// The segmentation of retval is preserved.
+template <typename Ret, typename P1, typename P2>
+inline void poly_mul_impl_heap(Ret &retval, const ::std::vector<P1> &v1, const ::std::vector<P2> &v2,
+                               unsigned n_chunks)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using cf1_t = typename P1::second_type;
+    using cf2_t = typename P2::second_type;
+    using s_size_t = typename Ret::s_size_type;
+    using value_t = typename ret_key_t::value_type;
+
+    static_assert(detail::same_packed_monomial_v<typename P1::first_type, typename P2::first_type>);
+    static_assert(::std::is_same_v<ret_key_t, typename P1::first_type>);
+
+    // Preconditions.
+    assert(!v1.empty());
+    assert(!v2.empty());
+    assert(v1.size() <= v2.size());
+    assert(retval.empty());
+    assert(n_chunks > 0u);
+
+    // Helper to construct a vector of pointers to the terms
+    // in v, sorted according to the codes of the monomials.
+    auto make_sorted_ptrs = [](const auto &v) {
+        ::std::vector<const typename remove_cvref_t<decltype(v)>::value_type *> ret;
+        ret.reserve(v.size());
+        for (const auto &t : v) {
+            ret.push_back(&t);
+        }
+
+        ::tbb::parallel_sort(ret.begin(), ret.end(), [](const auto &p1, const auto &p2) {
+            return p1->first.get_value() < p2->first.get_value();
+        });
+
+        return ret;
+    };
+    decltype(make_sorted_ptrs(v1)) pv1;
+    decltype(make_sorted_ptrs(v2)) pv2;
+    ::tbb::parallel_invoke([&pv1, &v1, &make_sorted_ptrs]() { pv1 = make_sorted_ptrs(v1); },
+                           [&pv2, &v2, &make_sorted_ptrs]() { pv2 = make_sorted_ptrs(v2); });
+
+    using idx_t = decltype(pv1.size());
+    static_assert(::std::is_same_v<idx_t, decltype(pv2.size())>);
+
+    // Helper to compute the code of the product of the i-th
+    // term of pv1 by the j-th term of pv2.
+    // NOTE: the codes of the products cannot overflow
+    // thanks to the overflow check.
+    auto prod_code = [&pv1, &pv2](idx_t i, idx_t j) {
+        return static_cast<value_t>(pv1[i]->first.get_value() + pv2[j]->first.get_value());
+    };
+
+    // Establish the boundaries of the chunks: the k-th chunk
+    // contains the products whose codes c satisfy
+    // bounds[k - 1] <= c < bounds[k] (the first and last
+    // chunks being unbounded below and above respectively).
+    // The boundaries are the quantiles of a random sample
+    // of the codes of the term-by-term products.
+    ::std::vector<value_t> bounds;
+    if (n_chunks > 1u) {
+        // Init a xoroshiro rng, with some compile-time
+        // randomness mixed in with the sizes of v1/v2.
+        constexpr ::std::uint64_t s1 = 9186021367521468457ull;
+        constexpr ::std::uint64_t s2 = 12723541590542180761ull;
+        ::obake::detail::xoroshiro128_plus rng{static_cast<::std::uint64_t>(s1 + v1.size()),
+                                               static_cast<::std::uint64_t>(s2 + v2.size())};
+
+        ::std::uniform_int_distribution<idx_t> dist1(0, pv1.size() - 1u);
+        ::std::uniform_int_distribution<idx_t> dist2(0, pv2.size() - 1u);
+
+        // NOTE: a few samples per chunk are enough
+        // to obtain a reasonable balance.
+        constexpr auto samples_per_chunk = 16u;
+        const auto n_samples = ::obake::safe_cast<::std::size_t>(n_chunks) * samples_per_chunk;
+
+        ::std::vector<value_t> samples;
+        samples.reserve(n_samples);
+        for (::std::size_t i = 0; i < n_samples; ++i) {
+            const auto idx1 = dist1(rng);
+            const auto idx2 = dist2(rng);
+            samples.push_back(prod_code(idx1, idx2));
+        }
+        ::std::sort(samples.begin(), samples.end());
+
+        for (::std::size_t k = 1; k < n_chunks; ++k) {
+            bounds.push_back(samples[k * samples_per_chunk]);
+        }
+        // NOTE: remove the duplicate boundaries,
+        // which would produce empty chunks.
+        bounds.erase(::std::unique(bounds.begin(), bounds.end()), bounds.end());
+    }
+
+    try {
+        const auto log2_nsegs = retval.get_s_size();
+        auto &s_table = retval._get_s_table();
+
+        auto seg_idx = [log2_nsegs](const value_t &code) {
+            return static_cast<s_size_t>(::obake::hash(ret_key_t(code)) % (s_size_t(1) << log2_nsegs));
+        };
+
+        // The spinlocks for the tables of retval.
+        ::obake::detail::atomic_flag_array sl_array(::obake::safe_cast<::std::size_t>(s_table.size()));
+
+        ::tbb::parallel_for(
+            ::tbb::blocked_range<decltype(bounds.size())>(0, bounds.size() + 1u, 1),
+            [&pv1, &pv2, &prod_code, &bounds, &seg_idx, &sl_array, &s_table](const auto &range) {
+                // The heap of (code, i, j) tuples, representing the
+                // products of the i-th term of pv1 by the j-th term of pv2.
+                using h_item_t = ::std::tuple<value_t, idx_t, idx_t>;
+                ::std::vector<h_item_t> heap;
+                heap.reserve(pv1.size());
+                // NOTE: std heaps are max heaps, flip the comparison.
+                const auto h_cmp
+                    = [](const h_item_t &a, const h_item_t &b) { return ::std::get<0>(a) > ::std::get<0>(b); };
+
+                // For each term of pv1, the end index of the
+                // corresponding range of terms of pv2 in the current chunk.
+                ::std::vector<idx_t> j_end(pv1.size());
+
+                // Helper to insert a term of the product into retval,
+                // if it was not cancelled.
+                auto insert = [&seg_idx, &sl_array, &s_table](const value_t &code, ret_cf_t &c) {
+                    if (!::obake::is_zero(::std::as_const(c))) {
+                        const auto idx = seg_idx(code);
+
+                        ::obake::detail::atomic_lock_guard lock(sl_array[static_cast<::std::size_t>(idx)]);
+
+                        // NOTE: each code is produced in a single chunk,
+                        // thus the codes inserted into retval are unique.
+                        [[maybe_unused]] const auto res = s_table[idx].try_emplace(ret_key_t(code), ::std::move(c));
+                        assert(res.second);
+                    }
+                };
+
+                for (auto k = range.begin(); k != range.end(); ++k) {
+                    // Init the heap with the first product of each term
+                    // of pv1 in the current chunk.
+                    heap.clear();
+                    for (idx_t i = 0; i < pv1.size(); ++i) {
+                        const auto c1 = pv1[i]->first.get_value();
+
+                        // Helper to locate the first term of pv2 whose
+                        // product by the i-th term of pv1 has a code
+                        // not less than b.
+                        auto find_j = [&pv2, c1](const value_t &b) {
+                            return static_cast<idx_t>(
+                                ::std::lower_bound(pv2.begin(), pv2.end(), b,
+                                                   [c1](const auto &p, const value_t &bb) {
+                                                       return static_cast<value_t>(c1 + p->first.get_value()) < bb;
+                                                   })
+                                - pv2.begin());
+                        };
+
+                        const auto j_begin = k == 0u ? idx_t(0) : find_j(bounds[k - 1u]);
+                        j_end[i] = k == bounds.size() ? pv2.size() : find_j(bounds[k]);
+
+                        if (j_begin < j_end[i]) {
+                            heap.emplace_back(prod_code(i, j_begin), i, j_begin);
+                        }
+                    }
+                    ::std::make_heap(heap.begin(), heap.end(), h_cmp);
+
+                    // The term of the product currently being accumulated.
+                    bool has_cur = false;
+                    value_t cur_code{};
+                    ret_cf_t cur_cf{};
+
+                    while (!heap.empty()) {
+                        ::std::pop_heap(heap.begin(), heap.end(), h_cmp);
+                        const auto [code, i, j] = heap.back();
+                        heap.pop_back();
+
+                        const auto &c1 = pv1[i]->second;
+                        const auto &c2 = pv2[j]->second;
+
+                        if (has_cur && cur_code == code) {
+                            // Accumulate into the current term.
+                            // NOTE: do it with fma3(), if possible.
+                            if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
+                                ::obake::fma3(cur_cf, c1, c2);
+                            } else {
+                                cur_cf += c1 * c2;
+                            }
+                        } else {
+                            // A new term. Before starting it, insert
+                            // the current term into retval.
+                            if (has_cur) {
+                                insert(cur_code, cur_cf);
+                            }
+                            has_cur = true;
+                            cur_code = code;
+                            cur_cf = c1 * c2;
+                        }
 
-                // Check that all elements in the range
-                // hash to the correct bucket index.
-                for (auto idx = start; idx < end; ++idx) {
-                    assert(::obake::hash(v[idx].first) % (s_size_t(1) << log2_nsegs) == b_idx);
+                        if (j + 1u < j_end[i]) {
+                            heap.emplace_back(prod_code(i, j + 1u), i, j + 1u);
+                            ::std::push_heap(heap.begin(), heap.end(), h_cmp);
+                        }
+                    }
+                    if (has_cur) {
+                        insert(cur_code, cur_cf);
+                    }
                 }
+            });
+
+        // LCOV_EXCL_START
+        // Check the table sizes.
+        const auto mts = retval._get_max_table_size();
+        for (const auto &table : s_table) {
+            if (obake_unlikely(table.size() > mts)) {
+                obake_throw(::std::overflow_error, "The heap-based multiplication of two "
+                                                   "polynomials resulted in a table whose size ("
+                                                       + ::obake::detail::to_string(table.size())
+                                                       + ") is larger than the maximum allowed value ("
+                                                       + ::obake::detail::to_string(mts) + ")");
             }
+        }
+        // LCOV_EXCL_STOP
+        // LCOV_EXCL_START
+    } catch (...) {
+        // In case of exceptions, clear retval before
+        // rethrowing to ensure a known sane state.
+        retval.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
 
-            assert(counter == v.size());
-        };
+// Meta-programming to establish if the product of the polynomials
+// T and U can be computed via the squaring algorithm, that is,
+// by performing only the term-by-term multiplications on and above
+// the diagonal, and doubling the off-diagonal contributions.
+// This requires T and U to be the same type, and the
+// coefficient type to be closed under addition.
+template <typename T, typename U>
+constexpr bool poly_mul_sqr_algorithm_impl()
+{
+    if constexpr (::std::is_same_v<T, U>) {
+        using cf_t = series_cf_t<T>;
 
-        verify_seg(vseg1, v1);
-        verify_seg(vseg2, v2);
+        return ::std::conjunction_v<
+            ::std::is_same<detected_t<::obake::detail::add_t, const cf_t &, const cf_t &>, cf_t>,
+            ::std::is_copy_constructible<cf_t>>;
+    } else {
+        return false;
     }
-#endif
+}
 
-    // Functor to compute the end index in the
-    // inner multiplication loops below, given
-    // an index into the first series and a segmentation
-    // range into the second series. In non-truncated
-    // mode, this functor will always return the end
-    // of the range, otherwise the returned
-    // value will ensure that the truncation limits
-    // are respected.
-    auto compute_end_idx2 = [&degree_data, &args...]() {
-        if constexpr (sizeof...(Args) == 0u) {
-            ::obake::detail::ignore(degree_data, args...);
+template <typename T, typename U>
+inline constexpr bool poly_mul_sqr_algo = detail::poly_mul_sqr_algorithm_impl<T, U>();
 
-            return [](const auto &, const auto &r2) { return ::std::get<1>(r2); };
+// Helper to establish if the product of x and y
+// can be computed via the squaring algorithm, that is,
+// if x and y are the same object.
+template <typename T, typename U>
+inline bool poly_mul_impl_is_sqr(const T &x, const U &y)
+{
+    if constexpr (poly_mul_sqr_algo<T, U>) {
+        return &x == &y;
+    } else {
+        ::obake::detail::ignore(x, y);
+
+        return false;
+    }
+}
+
+// Helper to insert the term with key k and coefficient c1 * c2
+// into the accumulation table acc_table, or to accumulate
+// c1 * c2 into the coefficient of an existing term.
+template <typename RetCf, typename Table, typename K, typename C1, typename C2>
+inline void poly_mul_impl_accumulate(Table &acc_table, const K &k, const C1 &c1, const C2 &c2)
+{
+    acc_table.insert_or_accumulate(
+        k, [&c1, &c2]() -> RetCf { return c1 * c2; },
+        [&c1, &c2](RetCf &rc) {
+            // NOTE: do it with fma3(), if possible.
+            if constexpr (is_mult_addable_v<RetCf &, const C1 &, const C2 &>) {
+                ::obake::fma3(rc, c1, c2);
+            } else {
+                rc += c1 * c2;
+            }
+        });
+}
+
+// Default releaser for the polynomial multiplication
+// implementations (see poly_mul_impl_in_place()): do nothing.
+struct poly_mul_impl_no_release {
+    void operator()() const noexcept {}
+};
+
+// Helper to compute the vector of the total/partial degrees
+// (depending on the truncation arguments args) of the terms in v,
+// which belong to a polynomial of type S. In untruncated
+// mode, an empty tuple is returned.
+template <typename S, typename V, typename... Args>
+inline auto poly_mul_impl_make_degree_vector(const V &v, const symbol_set &ss, const Args &...args)
+{
+    if constexpr (sizeof...(args) == 0u) {
+        ::obake::detail::ignore(v, ss);
+
+        return ::std::make_tuple();
+    } else {
+        // NOTE: in the make_(p_)degree_vector() helpers we need
+        // to compute the size of v via iterator differences.
+        ::obake::detail::container_it_diff_check(v);
+
+        if constexpr (sizeof...(args) == 1u) {
+            // Total degree.
+            ::obake::detail::ignore(args...);
+
+            return customisation::internal::make_degree_vector<S>(v.cbegin(), v.cend(), ss, true);
         } else {
-            // Create and return the functor. The degree data
-            // for the two series will be moved in as vd1 and vd2.
-#if defined(_MSC_VER) && !defined(__clang__)
-            // Until MS fixes the lambda capture.
-            auto vd1 = ::std::move(::std::get<0>(degree_data));
-            auto vd2 = ::std::move(::std::get<1>(degree_data));
-            return [&, vd1, vd2]
-#else
-            return [vd1 = ::std::move(::std::get<0>(degree_data)), vd2 = ::std::move(::std::get<1>(degree_data)),
-                    // NOTE: max_deg is captured via const lref this way,
-                    // as args is passed as a const lref pack.
-                    &max_deg = ::std::get<0>(::std::forward_as_tuple(args...))]
-#endif
-                (const auto &i, const auto &r2) {
-                    using idx_t = remove_cvref_t<decltype(i)>;
+            // Partial degree.
+            static_assert(sizeof...(args) == 2u);
 
-#if defined(_MSC_VER) && !defined(__clang__)
-                    const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
-#endif
+            return customisation::internal::make_p_degree_vector<S>(
+                v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), true);
+        }
+    }
+}
 
-                    // Get the total/partial degree of the current term
-                    // in the first series.
-                    const auto &d_i = vd1[i];
+// The data of an operand of the multi-threaded homomorphic
+// multiplication, segmented according to a number of segments 2**log2_nsegs:
+// - v contains the terms of the operand, sorted according to the bucket
+//   they would occupy in a segmented table with 2**log2_nsegs segments,
+// - vseg is the segmentation, that is, a vector of ranges (represented
+//   as pairs of indices into v) paired to the indices of the buckets,
+// - in truncated mode, vd contains the degrees of the terms, v and vd
+//   being sorted by degree within each segmentation range.
+template <typename S, typename... Args>
+struct poly_mul_impl_mt_hm_seg_data {
+    using terms_t = ::std::vector<::std::pair<series_key_t<S>, series_cf_t<S>>>;
+    using idx_t = typename terms_t::size_type;
+    using s_size_t = typename S::s_size_type;
+
+    terms_t v;
+    ::std::vector<::std::tuple<idx_t, idx_t, s_size_t>> vseg;
+    decltype(detail::poly_mul_impl_make_degree_vector<S>(::std::declval<const terms_t &>(),
+                                                         ::std::declval<const symbol_set &>(),
+                                                         ::std::declval<const Args &>()...)) vd;
+};
 
-                    // Find the first term in the range r2 such
-                    // that d_i + d_j > max_deg.
-                    // NOTE: we checked above that the static cast
-                    // to the it diff type is safe.
-                    using it_diff_t = decltype(vd2.cend() - vd2.cbegin());
-                    const auto it = ::std::upper_bound(vd2.cbegin() + static_cast<it_diff_t>(::std::get<0>(r2)),
-                                                       vd2.cbegin() + static_cast<it_diff_t>(::std::get<1>(r2)),
-                                                       max_deg, [&d_i](const auto &mdeg, const auto &d_j) {
-                                                           // NOTE: we require below
-                                                           // comparability between const lvalue limit
-                                                           // and rvalue of the sum of the degrees.
-                                                           return mdeg < d_i + d_j;
-                                                       });
+// Helper to segment the terms in sd.v according to the number
+// of segments 2**log2_nsegs (see poly_mul_impl_mt_hm_seg_data).
+// If skip_sort is true, sd.v is assumed to be already sorted
+// according to the bucket index (e.g., because it was copied
+// from a series with the same segmentation).
+template <typename S, typename... Args>
+inline void poly_mul_impl_mt_hm_segment(poly_mul_impl_mt_hm_seg_data<S, Args...> &sd, unsigned log2_nsegs,
+                                        bool skip_sort, const symbol_set &ss, const Args &...args)
+{
+    using idx_t = typename poly_mul_impl_mt_hm_seg_data<S, Args...>::idx_t;
+    using s_size_t = typename poly_mul_impl_mt_hm_seg_data<S, Args...>::s_size_t;
 
-                    // Turn the iterator into an index and return it.
-                    // NOTE: we checked above that the iterator diff
-                    // type can safely be used as an index (for both
-                    // vd1 and vd2).
-                    return static_cast<idx_t>(it - vd2.cbegin());
-                };
+    auto &v = sd.v;
+    auto &vseg = sd.vseg;
+
+    // Cache the number of segments.
+    const auto nsegs = s_size_t(1) << log2_nsegs;
+
+    // Sort the input terms according to the hash value modulo
+    // 2**log2_nsegs. That is, sort them according to the bucket
+    // they would occupy in a segmented table with 2**log2_nsegs
+    // segments.
+    auto t_sorter = [log2_nsegs](const auto &p1, const auto &p2) {
+        const auto h1 = ::obake::hash(p1.first);
+        const auto h2 = ::obake::hash(p2.first);
+
+        return h1 % (s_size_t(1) << log2_nsegs) < h2 % (s_size_t(1) << log2_nsegs);
+    };
+    if (skip_sort) {
+        assert(::std::is_sorted(v.begin(), v.end(), t_sorter));
+    } else {
+        ::tbb::parallel_sort(v.begin(), v.end(), t_sorter);
+    }
+
+    // Compute the segmentation.
+    // Ensure that the size of v is representable by
+    // its iterator's diff type. We need to do some
+    // iterator arithmetics below.
+    ::obake::detail::container_it_diff_check(v);
+
+    // NOTE: the max possible size of vseg is the number of segments.
+    vseg.clear();
+    vseg.reserve(::obake::safe_cast<decltype(vseg.size())>(nsegs));
+
+    const auto v_begin = v.begin(), v_end = v.end();
+
+    // NOTE: if the number of terms in v is small enough,
+    // compute a sparse representation of vseg (meaning that
+    // the number of segmentation ranges will be less than
+    // nsegs and all the ranges will be non-empty). Otherwise,
+    // compute a dense representation, where the number
+    // of ranges is equal to nsegs and empty ranges might
+    // be present. We will later run different parallel
+    // functors depending on whether we are in the sparse
+    // or dense case.
+    // NOTE: the idea here is that we want to run
+    // the sparse functor only in highly sparse cases,
+    // because otherwise the more complicated logic
+    // of the sparse functor carries a measurable performance
+    // penalty in the "mostly-dense" cases.
+    if (v.size() < nsegs / 2u) {
+        for (auto it = v_begin; it != v_end;) {
+            // Get the bucket index of the current term.
+            const auto cur_b_idx = static_cast<s_size_t>(::obake::hash(it->first) % (s_size_t(1) << log2_nsegs));
+            // Look for the first term whose bucket index is greater than cur_b_idx.
+            const auto range_end
+                = ::std::upper_bound(it, v_end, cur_b_idx, [log2_nsegs](const auto &b_idx, const auto &p) {
+                      return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
+                  });
+            // NOTE: because we are in the sparse representation case,
+            // range_end cannot be equal to it.
+            assert(range_end != it);
+            // Add the range to vseg.
+            // NOTE: the overflow check was done earlier.
+            vseg.emplace_back(static_cast<idx_t>(it - v_begin), static_cast<idx_t>(range_end - v_begin), cur_b_idx);
+            // Update 'it'.
+            it = range_end;
         }
-    }();
+    } else {
+        // NOTE: the segmentation in dense form may be
+        // parallelised easily if needed.
+        idx_t idx = 0;
+        auto it = v_begin;
+        for (s_size_t i = 0; i < nsegs; ++i) {
+            // Look for the first term whose bucket index is greater than i.
+            // NOTE: this might result in 'it' not changing, in which case
+            // the segmentation range will be empty.
+            it = ::std::upper_bound(it, v_end, i, [log2_nsegs](const auto &b_idx, const auto &p) {
+                return b_idx < ::obake::hash(p.first) % (s_size_t(1) << log2_nsegs);
+            });
+            const auto old_idx = idx;
+            // NOTE: the overflow check was done earlier.
+            idx = static_cast<idx_t>(it - v_begin);
+            vseg.emplace_back(old_idx, idx, i);
+        }
+    }
+
+    if constexpr (sizeof...(args) == 0u) {
+        // Non-truncated case: no degree data needed.
+        ::obake::detail::ignore(ss);
+    } else {
+        // Truncated case: compute the vector of degrees
+        // and sort each range from vseg according to the degree.
+        // NOTE: we will be using the machinery from the default implementation
+        // of degree() for series, so that we can re-use the concept checking bits
+        // as well.
+        auto &vd = sd.vd;
+        vd = detail::poly_mul_impl_make_degree_vector<S>(v, ss, args...);
+
+        // Ensure that the size of vd is representable by the
+        // diff type of its iterators. We'll need to do some
+        // iterator arithmetics below.
+        // NOTE: cast to const as we will use cbegin/cend below.
+        ::obake::detail::container_it_diff_check(::std::as_const(vd));
+
+        // Create a vector of indices into vd.
+        auto vidx = detail::poly_mul_impl_par_make_idx_vector(vd);
+
+        // Sort indirectly each range from vseg according to the degree.
+        // NOTE: capture vd as const ref because in the lt-comparable requirements for the degree
+        // type we are using const lrefs.
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(vseg.cbegin())>(vseg.cbegin(), vseg.cend()),
+                            [&vidx, &vdc = ::std::as_const(vd)](const auto &range) {
+                                for (const auto &r : range) {
+                                    // NOTE: note sure if it is worth to run
+                                    // a parallel sort here.
+                                    ::std::sort(vidx.data() + ::std::get<0>(r), vidx.data() + ::std::get<1>(r),
+                                                [&vdc](const auto &idx1, const auto &idx2) {
+                                                    return vdc[idx1] < vdc[idx2];
+                                                });
+                                }
+                            });
+
+        // Apply the sorting to vd and v. Ensure we don't run
+        // into overflows during the permutated access.
+        ::obake::detail::container_it_diff_check(vd);
+        // NOTE: use cbegin/cend on vd to ensure the copy ctor of
+        // the degree type is being called.
+        vd = remove_cvref_t<decltype(vd)>(::boost::make_permutation_iterator(vd.cbegin(), vidx.cbegin()),
+                                          ::boost::make_permutation_iterator(vd.cend(), vidx.cend()));
+        ::obake::detail::container_it_diff_check(v);
+        v = remove_cvref_t<decltype(v)>(::boost::make_permutation_iterator(v.cbegin(), vidx.cbegin()),
+                                        ::boost::make_permutation_iterator(v.cend(), vidx.cend()));
 
 #if !defined(NDEBUG)
-    // Variable that we use in debug mode to
-    // check that all term-by-term multiplications
-    // are performed.
-    ::std::atomic<unsigned long long> n_mults(0);
+        // Check the results in debug mode.
+        for (const auto &r : vseg) {
+            const auto &idx_begin = ::std::get<0>(r);
+            const auto &idx_end = ::std::get<1>(r);
+
+            // NOTE: add constness to vd in order to ensure that
+            // the degrees are compared via const refs.
+            assert(::std::is_sorted(::std::as_const(vd).data() + idx_begin, ::std::as_const(vd).data() + idx_end));
+
+            if constexpr (sizeof...(args) == 1u) {
+                using d_impl = customisation::internal::series_default_degree_impl;
+
+                assert(::std::equal(vd.data() + idx_begin, vd.data() + idx_end,
+                                    ::boost::make_transform_iterator(v.data() + idx_begin, d_impl::d_extractor<S>{&ss}),
+                                    [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
+            } else {
+                using d_impl = customisation::internal::series_default_p_degree_impl;
+
+                const auto &s = ::std::get<1>(::std::forward_as_tuple(args...));
+                const auto si = ::obake::detail::ss_intersect_idx(s, ss);
+
+                assert(::std::equal(
+                    vd.data() + idx_begin, vd.data() + idx_end,
+                    ::boost::make_transform_iterator(v.data() + idx_begin, d_impl::d_extractor<S>{&s, &si, &ss}),
+                    [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
+            }
+        }
 #endif
+    }
 
-    // The parallel multiplication functor for the sparse case.
-    auto sparse_par_functor
-        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2
 #if !defined(NDEBUG)
-           ,
-           log2_nsegs, &n_mults
+    {
+        // Check the segmentation in debug mode.
+        assert(vseg.size() <= nsegs);
+
+        // Counter for the number of terms represented in the
+        // segmentation vector.
+        decltype(v.size()) counter = 0;
+
+        for (const auto &t : vseg) {
+            const auto &[start, end, b_idx] = t;
+            assert(end <= v.size());
+            // NOTE: different check depending
+            // on whether we are in the sparse or
+            // dense case.
+            if (vseg.size() < nsegs) {
+                assert(start < end);
+            } else {
+                assert(start <= end);
+            }
+            counter += end - start;
+
+            // Check that all elements in the range
+            // hash to the correct bucket index.
+            for (auto idx = start; idx < end; ++idx) {
+                assert(::obake::hash(v[idx].first) % (s_size_t(1) << log2_nsegs) == b_idx);
+            }
+        }
+
+        assert(counter == v.size());
+    }
 #endif
-    ](const auto &range) {
-              // Cache the pointers to the terms data.
-              // NOTE: doing it here rather than in the lambda
-              // capture seems to help performance on GCC.
-              auto vptr1 = v1.data();
-              auto vptr2 = v2.data();
+}
 
-              // Temporary variable used in monomial multiplication.
-              ret_key_t tmp_key(ss);
+// An operand of the multi-threaded homomorphic multiplication
+// shared among several products (see poly_mul_many_impl()). The terms
+// are copied only once, and the segmented data is computed
+// (on first use) only once for each number of segments.
+// NOTE: seg_data() can be invoked concurrently.
+template <typename S, typename... Args>
+class poly_mul_impl_mt_hm_shared
+{
+public:
+    using seg_data_t = poly_mul_impl_mt_hm_seg_data<S, Args...>;
+    using terms_t = typename seg_data_t::terms_t;
+
+    // NOTE: if ovf_checked is true, the overflow checking for
+    // the products involving s is assumed to have been performed.
+    explicit poly_mul_impl_mt_hm_shared(const S &s, bool ovf_checked)
+        : m_s(s), m_terms(detail::poly_mul_impl_copy_terms(s)), m_ovf_checked(ovf_checked)
+    {
+    }
 
-              // Cache begin/end interators into vseg2.
-              const auto vseg2_begin = vseg2.begin(), vseg2_end = vseg2.end();
+    const terms_t &terms() const
+    {
+        return m_terms;
+    }
+    bool ovf_checked() const
+    {
+        return m_ovf_checked;
+    }
 
-              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
-                  // Get a reference to the current table in retval.
-                  auto &table = retval._get_s_table()[seg_idx];
+    // Fetch the segmented data for 2**log2_nsegs segments.
+    // NOTE: the segmented data is computed outside the mutex by the
+    // first thread requesting it. Other threads requesting the same
+    // number of segments wait for the result, while the requests for
+    // other numbers of segments are not blocked.
+    const seg_data_t &seg_data(unsigned log2_nsegs, const symbol_set &ss, const Args &...args) const
+    {
+        ::std::promise<const seg_data_t *> p;
+        auto fut = p.get_future().share();
 
-                  // The iterator in vseg2 that we will use
-                  // as the end point in the binary search below.
-                  // Initially, it is just the end of vseg2
-                  // (so that all of vseg2 is searched).
-                  auto end_search = vseg2_end;
+        bool builder = false;
+        {
+            ::std::lock_guard<::std::mutex> lock(m_mutex);
 
-                  // The wrap around flag (see below).
-                  bool wrap_around = false;
+            const auto [it, inserted] = m_seg_futs.try_emplace(log2_nsegs, fut);
+            if (inserted) {
+                builder = true;
+            } else {
+                fut = it->second;
+            }
+        }
 
-                  for (const auto &r1 : vseg1) {
-                      // Unpack in local variables.
-                      const auto [r1_start, r1_end, bi1] = r1;
+        if (!builder) {
+            return *fut.get();
+        }
 
-                      // The first time that bi1 is > seg_idx
-                      // we have a wrap-around. This means that:
-                      // - the search range in vseg2 will be reset
-                      //   to [vseg2_begin, vseg2_end),
-                      // - the bucket idx we need to look for
-                      //   in vseg2 is not seg_idx any more, but
-                      //   seg_idx + nsegs.
-                      // E.g., if seg_idx is 4, bi1 is 5 and nsegs
-                      // is 8, then there is no bucket index bi2 in
-                      // vseg2 such that 5 + bi2 = 4, but there might
+        try {
+            seg_data_t sd;
+            sd.v = m_terms;
+            // NOTE: the segmentation spawns TBB tasks. Run it in an isolated
+            // region, so that this thread cannot pick up, while waiting, another
+            // product invoking seg_data() with the same number of segments
+            // (which would then wait on p forever).
+            ::tbb::this_task_arena::isolate([&]() {
+                detail::poly_mul_impl_mt_hm_segment(sd, log2_nsegs, m_s.get_s_size() == log2_nsegs, ss, args...);
+            });
+
+            const seg_data_t *ret;
+            {
+                ::std::lock_guard<::std::mutex> lock(m_mutex);
+
+                ret = &m_seg_data.emplace(log2_nsegs, ::std::move(sd)).first->second;
+            }
+
+            p.set_value(ret);
+
+            return *ret;
+        } catch (...) {
+            // Remove the future, so that the segmented data
+            // can be recomputed by the next request, and
+            // propagate the error to the waiting threads.
+            {
+                ::std::lock_guard<::std::mutex> lock(m_mutex);
+
+                m_seg_futs.erase(log2_nsegs);
+            }
+
+            p.set_exception(::std::current_exception());
+
+            throw;
+        }
+    }
+
+private:
+    const S &m_s;
+    terms_t m_terms;
+    bool m_ovf_checked;
+    mutable ::std::mutex m_mutex;
+    // NOTE: the references into std::map
+    // are never invalidated by insertions.
+    mutable ::std::map<unsigned, ::std::shared_future<const seg_data_t *>> m_seg_futs;
+    mutable ::std::map<unsigned, seg_data_t> m_seg_data;
+};
+
+// The multi-threaded homomorphic implementation.
+// rel is a nullary function object that will be invoked
+// once the terms of x and y are not needed any more (i.e.,
+// after they have been copied into the internal data structures
+// and before the storage for the product is allocated).
+// sh1 and sh2 are optional (i.e., possibly null) pointers to
+// the shared data of x and y (see poly_mul_impl_mt_hm_shared): if
+// provided, the copy and the segmentation of the terms of the
+// corresponding operand are fetched from the shared data.
+// NOTE: after the invocation of rel, x and y must not be accessed.
+template <typename Rel, typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_mt_hm_sh_rel(const Rel &rel, Ret &retval, const T &x,
+                                       const poly_mul_impl_mt_hm_shared<T, Args...> *sh1, const U &y,
+                                       const poly_mul_impl_mt_hm_shared<U, Args...> *sh2, const Args &...args)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using s_size_t = typename Ret::s_size_type;
+
+    // Preconditions.
+    static_assert(sizeof...(args) <= 2u);
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+    assert(retval.empty());
+    assert(retval._get_s_table().size() == 1u);
+
+    // Cache the symbol set.
+    const auto &ss = retval.get_symbol_set();
+
+    // Create vectors containing copies of
+    // the input terms.
+    // NOTE: in theory, it would be possible here
+    // to move the coefficients (in conjunction with
+    // rref_cleaner, as usual).
+    // NOTE: need to better assess the benefits of
+    // copying the input series. Working directly on views
+    // into the tables of x and y would avoid the copies,
+    // but it would also introduce an extra indirection
+    // (and worse memory locality) in the multiplication loops.
+    // NOTE: the copies are not needed for the operands
+    // whose shared data is provided.
+    poly_mul_impl_mt_hm_seg_data<T, Args...> sd1;
+    poly_mul_impl_mt_hm_seg_data<U, Args...> sd2;
+    ::tbb::parallel_invoke(
+        [&sd1, &x, sh1]() {
+            if (sh1 == nullptr) {
+                sd1.v = detail::poly_mul_impl_copy_terms(x);
+            }
+        },
+        [&sd2, &y, sh2]() {
+            if (sh2 == nullptr) {
+                sd2.v = detail::poly_mul_impl_copy_terms(y);
+            }
+        });
+    const auto &t1 = sh1 == nullptr ? sd1.v : sh1->terms();
+    const auto &t2 = sh2 == nullptr ? sd2.v : sh2->terms();
+
+    // Do the monomial overflow checking, if supported.
+    // NOTE: we have to sequence the overflow checking before the product
+    // size estimation and the average term size estimation, as those two
+    // operations might generate overflows during monomial multiplication.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(t1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(t1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(t2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(t2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        // The monomial overflow checking is supported, run it
+        // (unless it was already performed for a shared operand).
+        const auto ovf_checked = (sh1 != nullptr && sh1->ovf_checked()) || (sh2 != nullptr && sh2->ovf_checked());
+        if (!ovf_checked && obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
+                                               "attempting to multiply two polynomials");
+        }
+    }
+
+    // Estimate the total number of terms, and compute the total number
+    // of term-by-term multiplications.
+    // NOTE: poly_mul_estimate_product_size() requires the shorter series first,
+    // which is ensured by the preconditions of this function.
+    const auto [est_nterms, tot_n_mults, est_stats]
+        = detail::poly_mul_estimate_product_size<T, U>(t1, t2, ss, args...);
+    // Exit early if the truncation limits
+    // result in an empty output series.
+    if (sizeof...(Args) > 0u && tot_n_mults.is_zero()) {
+        return;
+    }
+
+    // Estimate the average term size.
+    // NOTE: once poly_mul_impl_estimate_average_term_size() becomes more computationally intensive,
+    // we can do it in parallel with poly_mul_estimate_product_size().
+    const auto avg_term_size = detail::poly_mul_impl_estimate_average_term_size<ret_cf_t>(t1, t2, ss);
+
+    // Compute the estimated sparsity.
+    const auto est_sp = static_cast<double>(est_nterms) / static_cast<double>(tot_n_mults);
+
+    // Fetch the tuning parameters.
+    const auto tuning = ::obake::polynomials::get_mul_tuning();
+
+    // Establish the desired segment size in bytes.
+    // NOTE: the idea here is the following. For highly
+    // sparse polynomials (est_sp >= threshold), we want to pick
+    // a relatively large size so that it fits somewhere in L2
+    // cache, say. The reason is that we won't do much computation
+    // per segment due to the sparsity, thus we aim at reducing
+    // the parallelisation overhead by operating on larger chunks
+    // of the product series. When the sparsity is smaller, then
+    // we have a higher computational density, thus we will spend
+    // more time computing a single segment, and thus we can aim
+    // at staying in L1 cache instead, as the parallelisation overhead
+    // will be smaller. Note that these values will be just rule-of-thumb,
+    // because the sparsity is not estimated accurately and because
+    // of further manipulations below. Additionally, it is not clear
+    // to me how smooth the transition between high and low sparsity
+    // will be. The default segment sizes are deduced from the cache
+    // sizes detected at runtime, and they can be overridden by the user
+    // (see mul_tuning).
+    // NOTE: if est_sp is not finite, due to tot_n_mults being zero or other
+    // FP issues, go with a default value.
+    // NOTE: is it worth it to exit early if tot_n_mults is zero? This would
+    // mean that the truncation limits will produce an empty series.
+    const auto seg_size = (!::std::isfinite(est_sp) || est_sp >= tuning.sparse_threshold) ? tuning.sparse_seg_size
+                                                                                            : tuning.dense_seg_size;
+
+    // Estimate the number of segments via the deduced segment size.
+    const auto est_nsegs = (detail::poly_mul_seg_nterms(est_nterms, est_stats) * avg_term_size) / seg_size;
+
+    // Fetch the base-2 logarithm + 1 of est_nsegs, making sure it does not
+    // overflow the max allowed value for the return polynomial type.
+    const auto log2_nsegs = ::std::min(::obake::safe_cast<unsigned>(est_nsegs.nbits()),
+                                       polynomial<ret_key_t, ret_cf_t>::get_max_s_size());
+
+    // Setup the number of segments in retval.
+    retval.set_n_segments(log2_nsegs);
+
+    // Cache the actual number of segments.
+    const auto nsegs = s_size_t(1) << log2_nsegs;
+
+    // In untruncated multiplication, check if the product is sparse and
+    // large enough to warrant the use of the heap-based multiplication.
+    if constexpr (sizeof...(Args) == 0u
+                  && detail::same_packed_monomial_v<series_key_t<T>, series_key_t<U>>) {
+        if (detail::poly_mul_impl_use_heap(est_nterms, est_sp, avg_term_size, tuning.heap_min_sp,
+                                           tuning.heap_min_bytes)) {
+            rel();
+
+            // NOTE: split the merge into a few chunks per core
+            // in order to improve the load balancing.
+            detail::poly_mul_impl_heap(retval, t1, t2,
+                                       ::obake::detail::hc() == 1u ? 1u : ::obake::detail::hc() * 4u);
+
+            return;
+        }
+    }
+
+    // In untruncated multiplication, check if we can
+    // use the dense multiplication engine.
+    // NOTE: in the dense engine, the segment size is
+    // used to determine the size of the blocks of the dense
+    // array which are processed in parallel.
+    if constexpr (sizeof...(Args) == 0u
+                  && detail::same_packed_monomial_v<series_key_t<T>, series_key_t<U>>) {
+        if (const auto dl
+            = detail::poly_mul_impl_dense_layout(t1, t2, ss, est_nterms, est_sp, tuning.dense_engine_max_sp);
+            dl.n_slots > 0u) {
+            rel();
+
+            detail::poly_mul_impl_mt_dense(retval, t1, t2, ss, dl,
+                                           ::std::max(::std::size_t(1), seg_size / sizeof(ret_cf_t)));
+
+            return;
+        }
+    }
+
+    // For both x and y, concurrently (unless the shared
+    // data is provided):
+    // - sort the terms according to the segmentation order,
+    // - compute the segmentation ranges,
+    // - compute the degrees of the terms and sort according
+    //   to the degree within each segment (only for truncated
+    //   multiplication).
+    // NOTE: if x/y have the same segmentation as retval, the copies
+    // of the terms are already sorted according to the segmentation order
+    // (see poly_mul_impl_copy_terms()), and we can skip the sorting.
+    // NOTE: in the squaring case, the data of y is rebuilt from the data of x below.
+    const auto sqr = detail::poly_mul_impl_is_sqr(x, y);
+    const poly_mul_impl_mt_hm_seg_data<T, Args...> *psd1 = &sd1;
+    const poly_mul_impl_mt_hm_seg_data<U, Args...> *psd2 = &sd2;
+    ::tbb::parallel_invoke(
+        [&sd1, &psd1, sh1, log2_nsegs, skip_sort = x.get_s_size() == log2_nsegs, &ss, &args...]() {
+            if (sh1 == nullptr) {
+                detail::poly_mul_impl_mt_hm_segment(sd1, log2_nsegs, skip_sort, ss, args...);
+            } else {
+                psd1 = &sh1->seg_data(log2_nsegs, ss, args...);
+            }
+        },
+        [&sd2, &psd2, sh2, log2_nsegs, skip_sort = y.get_s_size() == log2_nsegs, &ss, sqr, &args...]() {
+            if (sqr) {
+                return;
+            }
+
+            if (sh2 == nullptr) {
+                detail::poly_mul_impl_mt_hm_segment(sd2, log2_nsegs, skip_sort, ss, args...);
+            } else {
+                psd2 = &sh2->seg_data(log2_nsegs, ss, args...);
+            }
+        });
+
+    // In the squaring case, replace the data of y with a copy of the data
+    // of x in which the coefficients are doubled. The ranges of v1 will
+    // be multiplied only by the ranges of v2 with the same or
+    // greater bucket index: the off-diagonal term-by-term multiplications
+    // will use the doubled coefficients, the diagonal ones
+    // the original coefficients in v1.
+    if constexpr (poly_mul_sqr_algo<T, U>) {
+        if (sqr) {
+            sd2.v = psd1->v;
+            sd2.vseg = psd1->vseg;
+            sd2.vd = psd1->vd;
+            psd2 = &sd2;
+
+            auto &v = sd2.v;
+            ::tbb::parallel_for(::tbb::blocked_range<decltype(v.size())>(0, v.size()), [&v](const auto &range) {
+                for (auto i = range.begin(); i != range.end(); ++i) {
+                    auto &c = v[i].second;
+                    c = ::std::as_const(c) + ::std::as_const(c);
+                }
+            });
+        }
+    }
+
+    // The segmented data of x and y.
+    const auto &v1 = psd1->v;
+    const auto &v2 = psd2->v;
+    const auto &vseg1 = psd1->vseg;
+    const auto &vseg2 = psd2->vseg;
+    [[maybe_unused]] const auto &vd1 = psd1->vd;
+    [[maybe_unused]] const auto &vd2 = psd2->vd;
+
+    // Functor to compute the end index in the
+    // inner multiplication loops below, given
+    // an index into the first series and a segmentation
+    // range into the second series. In non-truncated
+    // mode, this functor will always return the end
+    // of the range, otherwise the returned
+    // value will ensure that the truncation limits
+    // are respected.
+    auto compute_end_idx2 = [&vd1, &vd2, &args...]() {
+        if constexpr (sizeof...(Args) == 0u) {
+            ::obake::detail::ignore(vd1, vd2, args...);
+
+            return [](const auto &, const auto &r2) { return ::std::get<1>(r2); };
+        } else {
+            // Create and return the functor. The degree data
+            // for the two series is captured by reference.
+#if defined(_MSC_VER) && !defined(__clang__)
+            // Until MS fixes the lambda capture.
+            return [&]
+#else
+            return [&vd1, &vd2,
+                    // NOTE: max_deg is captured via const lref this way,
+                    // as args is passed as a const lref pack.
+                    &max_deg = ::std::get<0>(::std::forward_as_tuple(args...))]
+#endif
+                (const auto &i, const auto &r2) {
+                    using idx_t = remove_cvref_t<decltype(i)>;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+                    const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+#endif
+
+                    // Get the total/partial degree of the current term
+                    // in the first series.
+                    const auto &d_i = vd1[i];
+
+                    // Find the first term in the range r2 such
+                    // that d_i + d_j > max_deg.
+                    // NOTE: we checked above that the static cast
+                    // to the it diff type is safe.
+                    using it_diff_t = decltype(vd2.cend() - vd2.cbegin());
+                    const auto it = ::std::upper_bound(vd2.cbegin() + static_cast<it_diff_t>(::std::get<0>(r2)),
+                                                       vd2.cbegin() + static_cast<it_diff_t>(::std::get<1>(r2)),
+                                                       max_deg, [&d_i](const auto &mdeg, const auto &d_j) {
+                                                           // NOTE: we require below
+                                                           // comparability between const lvalue limit
+                                                           // and rvalue of the sum of the degrees.
+                                                           return mdeg < d_i + d_j;
+                                                       });
+
+                    // Turn the iterator into an index and return it.
+                    // NOTE: we checked above that the iterator diff
+                    // type can safely be used as an index (for both
+                    // vd1 and vd2).
+                    return static_cast<idx_t>(it - vd2.cbegin());
+                };
+        }
+    }();
+
+#if !defined(NDEBUG)
+    // Variable that we use in debug mode to
+    // check that all term-by-term multiplications
+    // are performed.
+    ::std::atomic<unsigned long long> n_mults(0);
+#endif
+
+    // Functor to multiply the range r of v1 by itself
+    // in the squaring case. Only the term-by-term multiplications
+    // on and above the diagonal are performed.
+    auto sqr_diag_mult = [&v1, &v2, &ss, &compute_end_idx2
+#if !defined(NDEBUG)
+                          ,
+                          &n_mults
+#endif
+    ](auto &acc_table, auto &tmp_key, const auto &r) {
+        if constexpr (poly_mul_sqr_algo<T, U>) {
+            const auto [r_start, r_end, bi] = r;
+            ::obake::detail::ignore(bi);
+
+            auto vptr1 = v1.data();
+            auto vptr2 = v2.data();
+
+            for (auto idx1 = r_start; idx1 != r_end; ++idx1) {
+                const auto &[k1, c1] = *(vptr1 + idx1);
+
+                // Compute the end index in the range
+                // for the current value of idx1.
+                const auto idx_end2 = compute_end_idx2(idx1, r);
+
+                // The end index is non-increasing in idx1
+                // (see the truncated case in the functors below),
+                // thus if it does not exceed idx1 there is no more work to do.
+                if (idx_end2 <= idx1) {
+                    break;
+                }
+
+                // The diagonal term.
+                ::obake::monomial_mul(tmp_key, k1, k1, ss);
+                detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c1);
+
+#if !defined(NDEBUG)
+                ++n_mults;
+#endif
+
+                // The off-diagonal terms, with the doubled coefficients.
+                const auto end2 = vptr2 + idx_end2;
+                for (auto ptr2 = vptr2 + idx1 + 1; ptr2 != end2; ++ptr2) {
+                    const auto &[k2, c2] = *ptr2;
+
+                    ::obake::monomial_mul(tmp_key, k1, k2, ss);
+                    detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+
+#if !defined(NDEBUG)
+                    n_mults += 2u;
+#endif
+                }
+            }
+        } else {
+            ::obake::detail::ignore(acc_table, tmp_key, r);
+        }
+    };
+
+    // The parallel multiplication functor for the sparse case.
+    auto sparse_par_functor
+        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2,
+           sqr, &sqr_diag_mult
+#if !defined(NDEBUG)
+           ,
+           log2_nsegs, &n_mults
+#endif
+    ](const auto &range) {
+              // Cache the pointers to the terms data.
+              // NOTE: doing it here rather than in the lambda
+              // capture seems to help performance on GCC.
+              auto vptr1 = v1.data();
+              auto vptr2 = v2.data();
+
+              // Temporary variable used in monomial multiplication.
+              ret_key_t tmp_key(ss);
+
+              // The table used to accumulate the terms of the
+              // current segment, before moving them into retval.
+              ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                                  ::obake::detail::series_key_comparer>
+                  acc_table;
+
+              // Cache begin/end interators into vseg2.
+              const auto vseg2_begin = vseg2.begin(), vseg2_end = vseg2.end();
+
+              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                  // Get a reference to the current table in retval.
+                  auto &table = retval._get_s_table()[seg_idx];
+
+                  // The iterator in vseg2 that we will use
+                  // as the end point in the binary search below.
+                  // Initially, it is just the end of vseg2
+                  // (so that all of vseg2 is searched).
+                  auto end_search = vseg2_end;
+
+                  // The wrap around flag (see below).
+                  bool wrap_around = false;
+
+                  for (const auto &r1 : vseg1) {
+                      // Unpack in local variables.
+                      const auto [r1_start, r1_end, bi1] = r1;
+
+                      // The first time that bi1 is > seg_idx
+                      // we have a wrap-around. This means that:
+                      // - the search range in vseg2 will be reset
+                      //   to [vseg2_begin, vseg2_end),
+                      // - the bucket idx we need to look for
+                      //   in vseg2 is not seg_idx any more, but
+                      //   seg_idx + nsegs.
+                      // E.g., if seg_idx is 4, bi1 is 5 and nsegs
+                      // is 8, then there is no bucket index bi2 in
+                      // vseg2 such that 5 + bi2 = 4, but there might
                       // be a bi2 such that 5 + bi2 = 4 + 8.
                       if (!wrap_around && bi1 > seg_idx) {
                           wrap_around = true;
                           end_search = vseg2_end;
                       }
 
-                      // Compute the target idx: this is seg_idx in case we
-                      // have not wrapped around yet, otherwise seg_idx + nsegs
-                      // (so that tgt_idx % nsegs == seg_idx).
-                      // NOTE: the guarantee on get_max_s_size() ensures that
-                      // we can always compute seg_idx + nsegs without overflow.
-                      const auto tgt_idx = wrap_around ? (seg_idx + nsegs) : seg_idx;
+                      // Compute the target idx: this is seg_idx in case we
+                      // have not wrapped around yet, otherwise seg_idx + nsegs
+                      // (so that tgt_idx % nsegs == seg_idx).
+                      // NOTE: the guarantee on get_max_s_size() ensures that
+                      // we can always compute seg_idx + nsegs without overflow.
+                      const auto tgt_idx = wrap_around ? (seg_idx + nsegs) : seg_idx;
+
+                      // Locate a range in vseg2 such that the bucket idx of that range + bi1
+                      // is equal to tgt_idx.
+                      const auto it = ::std::lower_bound(
+                          vseg2_begin, end_search, tgt_idx,
+                          [bi1_ = bi1](const auto &t, const auto &b_idx) { return ::std::get<2>(t) + bi1_ < b_idx; });
+
+                      if (it == end_search || ::std::get<2>(*it) + bi1 != tgt_idx) {
+                          // There is no range in vseg2 such that its multiplication
+                          // by the current range in vseg1 results in terms which
+                          // end up at the bucket index seg_idx in the destination
+                          // segmented table. Move to the next range in vseg1.
+                          continue;
+                      }
+                      // Update the end point of the binary search. We know that
+                      // the next vseg1 range will bump up bi1 at least by one, thus,
+                      // in the next binary search, we know that anything we may find
+                      // must be *before* it.
+                      end_search = it;
+
+                      // Unpack in local variables.
+                      const auto &r2 = *it;
+                      const auto [r2_start, r2_end, bi2] = r2;
+                      ::obake::detail::ignore(r2_end, bi2);
+
+                      if (sqr) {
+                          // In the squaring case, the multiplication of the
+                          // ranges with bucket indices bi1 > bi2 is accounted for
+                          // by the doubled coefficients of v2, and the ranges
+                          // with bi1 == bi2 are multiplied by sqr_diag_mult.
+                          if (bi1 > bi2) {
+                              continue;
+                          }
+
+                          if (bi1 == bi2) {
+                              sqr_diag_mult(acc_table, tmp_key, r1);
+                              continue;
+                          }
+                      }
+
+                      // The O(N**2) multiplication loop over the ranges.
+                      for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
+                          const auto &[k1, c1] = *(vptr1 + idx1);
+
+                          // Compute the end index in the second range
+                          // for the current value of idx1.
+                          const auto idx_end2 = compute_end_idx2(idx1, r2);
+
+                          // In the truncated case, check if the end index
+                          // coincides with the begin index. In such a case,
+                          // we can skip all the remaining indices in r1 because
+                          // none of them will ever generate a term which respects
+                          // the truncation limits (both r1 and r2 are sorted
+                          // according to the degree).
+                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
+                              break;
+                          }
+
+                          const auto end2 = vptr2 + idx_end2;
+                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
+                              const auto &[k2, c2] = *ptr2;
+
+                              // Do the monomial multiplication.
+                              ::obake::monomial_mul(tmp_key, k1, k2, ss);
+
+                              // Check that the result ends up in the correct bucket.
+                              assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
+
+                              // Insert the product of the coefficients, or accumulate
+                              // it into an existing coefficient.
+                              // NOTE: the product of the coefficients is computed only
+                              // if the insertion actually takes place, and acc_table is left
+                              // in a consistent state if the coefficient arithmetic throws.
+                              detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+
+#if !defined(NDEBUG)
+                              // NOTE: in the squaring case, each multiplication
+                              // accounts for two term-by-term multiplications.
+                              n_mults += sqr ? 2u : 1u;
+#endif
+                          }
+                      }
+                  }
+
+                  // Move the terms with nonzero coefficients
+                  // from acc_table into the current table.
+                  // NOTE: this also empties acc_table (preserving
+                  // its capacity) for use in the next segment.
+                  table.reserve(static_cast<decltype(table.size())>(acc_table.size()));
+                  acc_table.consume([&table](ret_key_t &&k, ret_cf_t &&c) {
+                      if (obake_likely(!::obake::is_zero(::std::as_const(c)))) {
+                          // NOTE: the keys in acc_table are unique,
+                          // thus the insertion will always succeed.
+                          [[maybe_unused]] const auto res = table.try_emplace(::std::move(k), ::std::move(c));
+                          assert(res.second);
+                      }
+                  });
+
+                  // LCOV_EXCL_START
+                  // Check the table size against the max allowed size.
+                  if (obake_unlikely(table.size() > mts)) {
+                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
+                                                         "polynomials resulted in a table whose size ("
+                                                             + ::obake::detail::to_string(table.size())
+                                                             + ") is larger than the maximum allowed value ("
+                                                             + ::obake::detail::to_string(mts) + ")");
+                  }
+                  // LCOV_EXCL_STOP
+              }
+          };
+
+    // The parallel multiplication functor for the dense case.
+    auto dense_par_functor
+        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2,
+           sqr, &sqr_diag_mult
+#if !defined(NDEBUG)
+           ,
+           log2_nsegs, &n_mults
+#endif
+    ](const auto &range) {
+              // Cache the pointers to the terms data.
+              // NOTE: doing it here rather than in the lambda
+              // capture seems to help performance on GCC.
+              auto vptr1 = v1.data();
+              auto vptr2 = v2.data();
+
+              // Temporary variable used in monomial multiplication.
+              ret_key_t tmp_key(ss);
+
+              // The table used to accumulate the terms of the
+              // current segment, before moving them into retval.
+              ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                                  ::obake::detail::series_key_comparer>
+                  acc_table;
+
+              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                  // Get a reference to the current table in retval.
+                  auto &table = retval._get_s_table()[seg_idx];
+
+                  // The objective here is to perform all term-by-term multiplications
+                  // whose results end up in the current table (i.e., the table in retval
+                  // at index seg_idx). Due to homomorphic hashing, we know that,
+                  // given two indices i and j in vseg1 and vseg2,
+                  // the terms generated by the multiplication of the
+                  // ranges vseg1[i] and vseg2[j] end up at the bucket
+                  // (i + j) % nsegs in retval. Thus, we need to select
+                  // all i, j pairs such that (i + j) % nsegs == seg_idx.
+                  for (s_size_t i = 0; i < nsegs; ++i) {
+                      const auto j = seg_idx >= i ? (seg_idx - i) : (nsegs - i + seg_idx);
+                      assert(j < vseg2.size());
+
+                      if (sqr) {
+                          // Squaring case, see the
+                          // explanation in the sparse functor.
+                          if (i > j) {
+                              continue;
+                          }
+
+                          if (i == j) {
+                              sqr_diag_mult(acc_table, tmp_key, vseg1[i]);
+                              continue;
+                          }
+                      }
+
+                      // Fetch the corresponding ranges.
+                      const auto [r1_start, r1_end, bi1] = vseg1[i];
+                      const auto &r2 = vseg2[j];
+                      const auto [r2_start, r2_end, bi2] = r2;
+                      ::obake::detail::ignore(r2_end);
+
+                      // NOTE: in the dense case, the bucket
+                      // indices must be equal to i/j.
+                      assert(bi1 == i);
+                      assert(bi2 == j);
+                      ::obake::detail::ignore(bi1);
+                      ::obake::detail::ignore(bi2);
+
+                      // The O(N**2) multiplication loop over the ranges.
+                      for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
+                          const auto &[k1, c1] = *(vptr1 + idx1);
+
+                          // Compute the end index in the second range
+                          // for the current value of idx1.
+                          const auto idx_end2 = compute_end_idx2(idx1, r2);
+
+                          // In the truncated case, check if the end index
+                          // coincides with the begin index. In such a case,
+                          // we can skip all the remaining indices in r1 because
+                          // none of them will ever generate a term which respects
+                          // the truncation limits (both r1 and r2 are sorted
+                          // according to the degree).
+                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
+                              break;
+                          }
+
+                          const auto end2 = vptr2 + idx_end2;
+                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
+                              const auto &[k2, c2] = *ptr2;
+
+                              // Do the monomial multiplication.
+                              ::obake::monomial_mul(tmp_key, k1, k2, ss);
+
+                              // Check that the result ends up in the correct bucket.
+                              assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
+
+                              // Insert the product of the coefficients, or accumulate
+                              // it into an existing coefficient.
+                              // NOTE: the product of the coefficients is computed only
+                              // if the insertion actually takes place, and acc_table is left
+                              // in a consistent state if the coefficient arithmetic throws.
+                              detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+
+#if !defined(NDEBUG)
+                              // NOTE: in the squaring case, each multiplication
+                              // accounts for two term-by-term multiplications.
+                              n_mults += sqr ? 2u : 1u;
+#endif
+                          }
+                      }
+                  }
+
+                  // Move the terms with nonzero coefficients
+                  // from acc_table into the current table.
+                  // NOTE: this also empties acc_table (preserving
+                  // its capacity) for use in the next segment.
+                  table.reserve(static_cast<decltype(table.size())>(acc_table.size()));
+                  acc_table.consume([&table](ret_key_t &&k, ret_cf_t &&c) {
+                      if (obake_likely(!::obake::is_zero(::std::as_const(c)))) {
+                          // NOTE: the keys in acc_table are unique,
+                          // thus the insertion will always succeed.
+                          [[maybe_unused]] const auto res = table.try_emplace(::std::move(k), ::std::move(c));
+                          assert(res.second);
+                      }
+                  });
+
+                  // LCOV_EXCL_START
+                  // Check the table size against the max allowed size.
+                  if (obake_unlikely(table.size() > mts)) {
+                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
+                                                         "polynomials resulted in a table whose size ("
+                                                             + ::obake::detail::to_string(table.size())
+                                                             + ") is larger than the maximum allowed value ("
+                                                             + ::obake::detail::to_string(mts) + ")");
+                  }
+                  // LCOV_EXCL_STOP
+              }
+          };
+
+#if !defined(NDEBUG)
+    // NOTE: fetch the sizes of x and y before
+    // the invocation of rel.
+    [[maybe_unused]] const auto n_mults_tot
+        = static_cast<unsigned long long>(x.size()) * static_cast<unsigned long long>(y.size());
+#endif
+
+    // The terms of x and y are not needed any more.
+    rel();
+
+    try {
+        if (vseg1.size() == nsegs && vseg2.size() == nsegs) {
+            // Both vseg1 and vseg2 are represented in dense
+            // form, run the dense functor.
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), dense_par_functor);
+        } else {
+            // At least one of vseg1/vseg2 are represented
+            // in sparse form, run the sparse functor.
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), sparse_par_functor);
+        }
+
+#if !defined(NDEBUG)
+        // Verify the number of term multiplications we performed,
+        // but only if we are in non-truncated mode.
+        if constexpr (sizeof...(args) == 0u) {
+            assert(n_mults.load() == n_mults_tot);
+        }
+#endif
+        // LCOV_EXCL_START
+    } catch (...) {
+        // In case of exceptions, clear retval before
+        // rethrowing to ensure a known sane state.
+        retval.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
+
+// The multi-threaded homomorphic implementation, without shared data.
+template <typename Rel, typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_mt_hm_rel(const Rel &rel, Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    detail::poly_mul_impl_mt_hm_sh_rel(rel, retval, x,
+                                       static_cast<const poly_mul_impl_mt_hm_shared<T, Args...> *>(nullptr), y,
+                                       static_cast<const poly_mul_impl_mt_hm_shared<U, Args...> *>(nullptr), args...);
+}
+
+// The multi-threaded homomorphic implementation, without releaser.
+template <typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_mt_hm(Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    detail::poly_mul_impl_mt_hm_rel(poly_mul_impl_no_release{}, retval, x, y, args...);
+}
+
+#if defined(_MSC_VER) && !defined(__clang__)
+
+#pragma warning(pop)
+
+#endif
+
+// Extract a pointer from a const reference.
+struct poly_mul_impl_ptr_extractor {
+    template <typename T>
+    auto operator()(const T &x) const
+    {
+        return &x;
+    }
+};
+
+// Simple poly mult implementation: just multiply
+// term by term, no parallelisation, no segmentation,
+// no copying of the operands, etc.
+// rel is a nullary function object that will be invoked
+// once the terms of x and y are not needed any more
+// (see poly_mul_impl_mt_hm_rel()).
+template <typename Rel, typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_simple_rel(const Rel &rel, Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using cf2_t = series_cf_t<U>;
+
+    // Preconditions.
+    static_assert(sizeof...(args) <= 2u);
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+    assert(retval.empty());
+    assert(retval._get_s_table().size() == 1u);
+
+    // Cache the symbol set.
+    const auto &ss = retval.get_symbol_set();
+
+    // Construct the vectors of pointer to the terms.
+    ::std::vector<const series_term_t<T> *> v1(
+        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(x.end(), poly_mul_impl_ptr_extractor{}));
+    ::std::vector<const series_term_t<U> *> v2(
+        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(y.end(), poly_mul_impl_ptr_extractor{}));
+
+    // Do the monomial overflow checking, if possible.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        // Do the monomial overflow checking.
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(
+                ::std::overflow_error,
+                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        }
+    }
+
+    // This functor will be used to compute the
+    // upper limit of the j index (in the usual half-open
+    // range fashion) for a given i index
+    // in the nested for-loop below that performs
+    // the term-by-term multiplications.
+    // In the non-truncated case, compute_j_end will
+    // always return the size of y (that is, every
+    // term of x will be multiplied by every term of
+    // of y). In the truncated cases, the returned
+    // j value will ensure that the truncation limits
+    // are respected.
+    auto compute_j_end = [&v1, &v2, &ss, &args...]() {
+        if constexpr (sizeof...(args) == 0u) {
+            ::obake::detail::ignore(v1, ss);
+
+            return [v2_size = v2.size()](const auto &) { return v2_size; };
+        } else {
+            // Helper that will:
+            //
+            // - create and return a sorted vector vd
+            //   containing the total/partial degrees of all the
+            //   terms in v,
+            // - sort v according to the order defined in vd.
+            //
+            // v will be one of v1/v2, t is a type_c instance
+            // containing either T or U.
+            auto sorter = [&ss, &args...](auto &v, auto t) {
+                // NOTE: we will be using the machinery from the default implementation
+                // of degree() for series, so that we can re-use the concept checking bits
+                // as well.
+                using s_t = typename decltype(t)::type;
+
+                // Compute the vector of degrees.
+                auto vd = [&v, &ss, &args...]() {
+                    if constexpr (sizeof...(args) == 1u) {
+                        // Total degree.
+                        ::obake::detail::ignore(args...);
+
+                        // NOTE: in the make_degree_vector() helper we need
+                        // to compute the size of v via iterator differences.
+                        ::obake::detail::container_it_diff_check(v);
+
+                        return customisation::internal::make_degree_vector<s_t>(v.cbegin(), v.cend(), ss, false);
+                    } else {
+                        // NOTE: in the make_p_degree_vector() helper we need
+                        // to compute the size of v via iterator differences.
+                        ::obake::detail::container_it_diff_check(v);
+
+                        return customisation::internal::make_p_degree_vector<s_t>(
+                            v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), false);
+                    }
+                }();
+
+                // Ensure that the size of vd is representable by the
+                // diff type of its iterators. We'll need to do some
+                // iterator arithmetics below.
+                // NOTE: cast to const as we will use cbegin/cend below.
+                ::obake::detail::container_it_diff_check(::std::as_const(vd));
+
+                // Create a vector of indices into vd.
+                ::std::vector<decltype(vd.size())> vidx;
+                vidx.resize(::obake::safe_cast<decltype(vidx.size())>(vd.size()));
+                ::std::iota(vidx.begin(), vidx.end(), decltype(vd.size())(0));
+
+                // Sort indirectly.
+                // NOTE: capture vd as const ref because in the lt-comparable requirements for the degree
+                // type we are using const lrefs.
+                ::std::sort(vidx.begin(), vidx.end(), [&vdc = ::std::as_const(vd)](const auto &idx1, const auto &idx2) {
+                    return vdc[idx1] < vdc[idx2];
+                });
+
+                // Apply the sorting to vd and v. Check that permutated
+                // access does not result in overflow.
+                ::obake::detail::container_it_diff_check(vd);
+                // NOTE: use cbegin/cend on vd to ensure the copy ctor of
+                // the degree type is being called.
+                vd = decltype(vd)(::boost::make_permutation_iterator(vd.cbegin(), vidx.cbegin()),
+                                  ::boost::make_permutation_iterator(vd.cend(), vidx.cend()));
+                ::obake::detail::container_it_diff_check(v);
+                v = ::std::remove_reference_t<decltype(v)>(
+                    ::boost::make_permutation_iterator(v.cbegin(), vidx.cbegin()),
+                    ::boost::make_permutation_iterator(v.cend(), vidx.cend()));
+
+#if !defined(NDEBUG)
+                // Check the results in debug mode.
+                // NOTE: use cbegin/cend in order to ensure
+                // that the degrees are compared via const lvalue refs.
+                assert(::std::is_sorted(vd.cbegin(), vd.cend()));
+
+                if constexpr (sizeof...(args) == 1u) {
+                    using d_impl = customisation::internal::series_default_degree_impl;
+
+                    assert(::std::equal(vd.begin(), vd.end(),
+                                        ::boost::make_transform_iterator(v.cbegin(), d_impl::d_extractor<s_t>{&ss}),
+                                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
+                } else {
+                    using d_impl = customisation::internal::series_default_p_degree_impl;
+
+                    const auto &s = ::std::get<1>(::std::forward_as_tuple(args...));
+                    const auto si = ::obake::detail::ss_intersect_idx(s, ss);
+
+                    assert(::std::equal(
+                        vd.begin(), vd.end(),
+                        ::boost::make_transform_iterator(v.cbegin(), d_impl::d_extractor<s_t>{&s, &si, &ss}),
+                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
+                }
+#endif
+
+                return vd;
+            };
+
+            using ::obake::detail::type_c;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+            return [&, vd1 = sorter(v1, type_c<T>{}), vd2 = sorter(v2, type_c<U>{})]
+#else
+            return [vd1 = sorter(v1, type_c<T>{}), vd2 = sorter(v2, type_c<U>{}),
+                    // NOTE: max_deg is captured via const lref this way,
+                    // as args is passed as a const lref pack.
+                    &max_deg = ::std::get<0>(::std::forward_as_tuple(args...))]
+#endif
+                (const auto &i) {
+                    using idx_t = remove_cvref_t<decltype(i)>;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+                    const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+#endif
+
+                    // Get the total/partial degree of the current term
+                    // in the first series.
+                    const auto &d_i = vd1[i];
+
+                    // Find the first term in the second series such
+                    // that d_i + d_j > max_deg.
+                    const auto it = ::std::upper_bound(vd2.cbegin(), vd2.cend(), max_deg,
+                                                       [&d_i](const auto &mdeg, const auto &d_j) {
+                                                           // NOTE: we require below
+                                                           // comparability between const lvalue limit
+                                                           // and rvalue of the sum of the degrees.
+                                                           return mdeg < d_i + d_j;
+                                                       });
+
+                    // Turn the iterator into an index and return it.
+                    // NOTE: we checked above that the iterator diff
+                    // type can safely be used as an index (for both
+                    // vd1 and vd2).
+                    return static_cast<idx_t>(it - vd2.cbegin());
+                };
+        }
+    }();
+
+    // In the squaring case, x and y are the same object and
+    // v1/v2 are identical (the sorting in compute_j_end is deterministic).
+    // We compute the doubled coefficients of the terms, which are
+    // used in the off-diagonal term-by-term multiplications.
+    const auto sqr = detail::poly_mul_impl_is_sqr(x, y);
+    ::std::vector<cf2_t> dc2;
+    if constexpr (poly_mul_sqr_algo<T, U>) {
+        if (sqr) {
+            assert(v1 == v2);
+
+            dc2.reserve(v2.size());
+            for (const auto *t : v2) {
+                dc2.push_back(t->second + t->second);
+            }
+        }
+    }
+
+    // Proceed with the multiplication.
+    auto &tab = retval._get_s_table()[0];
+
+    try {
+        // Temporary variable used in monomial multiplication.
+        ret_key_t tmp_key(ss);
+
+        // The table used to accumulate the terms of the product.
+        ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                            ::obake::detail::series_key_comparer>
+            acc_table;
+
+        const auto v1_size = v1.size();
+        for (decltype(v1.size()) i = 0; i < v1_size; ++i) {
+            const auto &t1 = v1[i];
+            const auto &k1 = t1->first;
+            const auto &c1 = t1->second;
+
+            // Get the upper limit of the multiplication
+            // range in v2.
+            const auto j_end = compute_j_end(i);
+            if (sizeof...(Args) != 0u && j_end == 0u) {
+                // In truncated mode, if j_end is zero, we don't need to perform
+                // any more term multiplications as the remaining
+                // ones will all end up above the truncation limit.
+                break;
+            }
+
+            if constexpr (poly_mul_sqr_algo<T, U>) {
+                if (sqr) {
+                    // In the squaring case, perform only the multiplications
+                    // on and above the diagonal. j_end is non-increasing
+                    // in i, thus if j_end <= i there is no more work to do.
+                    if (j_end <= i) {
+                        break;
+                    }
+
+                    // The diagonal term.
+                    ::obake::monomial_mul(tmp_key, k1, k1, ss);
+                    detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c1);
+
+                    // The off-diagonal terms, with the doubled coefficients.
+                    for (auto j = i + 1u; j < j_end; ++j) {
+                        ::obake::monomial_mul(tmp_key, k1, v2[j]->first, ss);
+                        detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, dc2[j]);
+                    }
+
+                    continue;
+                }
+            }
+
+            for (decltype(v2.size()) j = 0; j < j_end; ++j) {
+                const auto &t2 = v2[j];
+                const auto &c2 = t2->second;
+
+                // Multiply the monomial.
+                ::obake::monomial_mul(tmp_key, k1, t2->first, ss);
+
+                // Insert the new term, or accumulate it
+                // into an existing term.
+                // NOTE: see the explanation in the other
+                // multiplication function about why we use
+                // an accumulation table.
+                detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+            }
+        }
+
+        // The terms of x and y are not needed any more.
+        rel();
+
+        // Move the terms with nonzero coefficients
+        // into the return value.
+        tab.reserve(static_cast<decltype(tab.size())>(acc_table.size()));
+        acc_table.consume([&tab](ret_key_t &&k, ret_cf_t &&c) {
+            if (obake_likely(!::obake::is_zero(::std::as_const(c)))) {
+                [[maybe_unused]] const auto res = tab.try_emplace(::std::move(k), ::std::move(c));
+                assert(res.second);
+            }
+        });
+
+        // NOTE: no need to check the table size, as retval
+        // is not segmented.
+        // LCOV_EXCL_START
+    } catch (...) {
+        // retval may now contain a subset of the terms.
+        // Make sure to clear it before rethrowing.
+        tab.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
+
+// Simple poly mult implementation, without releaser.
+template <typename Ret, typename T, typename U, typename... Args>
+inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args &...args)
+{
+    detail::poly_mul_impl_simple_rel(poly_mul_impl_no_release{}, retval, x, y, args...);
+}
+
+// The multi-threaded implementation for monomials without homomorphic hashing.
+// The term-by-term multiplications are split in a grid of blocks, each block
+// covering a range of terms in x (rows) and a range of terms in y (columns).
+// The blocks are processed in parallel, in waves of consecutive blocks. Each block
+// accumulates its products in a local table, whose terms are then grouped
+// by the segment of retval they belong to. At the end of each wave, the segments
+// of retval are updated in parallel (one segment per task), merging
+// the contributions of the blocks in block order.
+// NOTE: because the contributions to each term of the product are accumulated
+// in an order which depends only on the block decomposition (and not on the
+// scheduling of the tasks), the result is reproducible also for coefficient
+// types whose addition is not associative (e.g., floating-point types).
+// NOTE: this implementation does not support truncation.
+template <typename Ret, typename T, typename U>
+inline void poly_mul_impl_mt_lock(Ret &retval, const T &x, const U &y)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using s_size_t = typename Ret::s_size_type;
+
+    // Preconditions.
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
+    assert(retval.empty());
+    assert(retval._get_s_table().size() == 1u);
+
+    // Cache the symbol set.
+    const auto &ss = retval.get_symbol_set();
+
+    // Construct the vectors of pointer to the terms.
+    ::std::vector<const series_term_t<T> *> v1(
+        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(x.end(), poly_mul_impl_ptr_extractor{}));
+    ::std::vector<const series_term_t<U> *> v2(
+        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(y.end(), poly_mul_impl_ptr_extractor{}));
+
+    // Do the monomial overflow checking, if possible.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        // Do the monomial overflow checking.
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(
+                ::std::overflow_error,
+                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        }
+    }
+
+    // Setup the number of segments in retval.
+    // NOTE: without homomorphic hashing the segments of retval
+    // are not related to the terms of x and y, thus here we just
+    // want enough segments to balance the merging of the blocks.
+    // Aim for 16 segments per core, which will be rounded up
+    // to the next power of 2.
+    const auto log2_nsegs
+        = ::std::min(::obake::safe_cast<unsigned>(
+                         ::mppp::integer<1>{::obake::detail::hc() * static_cast<unsigned long long>(16) - 1u}.nbits()),
+                     Ret::get_max_s_size());
+    retval.set_n_segments(log2_nsegs);
+    const auto nsegs = s_size_t(1) << log2_nsegs;
+
+    // Setup the block decomposition.
+    // NOTE: the number of term-by-term multiplications in a block,
+    // and thus the size of its local table, is bounded by
+    // max_block_mults. The blocks are as square as possible,
+    // with at least min_block_cols columns so that the multiplications
+    // in a block are not dominated by the overhead. Highly rectangular
+    // products (e.g., with a very short x) are thus split
+    // over the terms of y as well.
+    constexpr ::std::size_t max_block_mults = 1ul << 14, min_block_cols = 1ul << 7;
+    const auto n1 = v1.size(), n2 = v2.size();
+    const auto bc = ::std::min(n2, ::std::max(min_block_cols, max_block_mults / n1));
+    const auto br = ::std::min(n1, ::std::max(::std::size_t(1), max_block_mults / bc));
+    const auto nbr = n1 / br + static_cast<::std::size_t>(n1 % br != 0u);
+    const auto nbc = n2 / bc + static_cast<::std::size_t>(n2 % bc != 0u);
+    const auto nblocks = ::obake::safe_cast<::std::size_t>(::mppp::integer<1>{nbr} * nbc);
+
+    // Number of blocks per wave.
+    // NOTE: the blocks of a wave are stored in memory
+    // until they are merged into retval, thus we need
+    // to bound the number of blocks in a wave. Because the blocks
+    // are merged in block order, the size of the waves does not influence
+    // the result, and it can depend on the number of cores.
+    const auto wave_size = ::std::min(nblocks, ::obake::safe_cast<::std::size_t>(::obake::detail::hc()) * 8u);
+
+    // The terms of the blocks in the current wave,
+    // grouped by segment index, and the offsets
+    // of the segments in the vectors of terms.
+    ::std::vector<::std::vector<::std::pair<s_size_t, ::std::pair<ret_key_t, ret_cf_t>>>> blk_terms(wave_size);
+    ::std::vector<::std::vector<::std::size_t>> blk_offsets(wave_size);
+
+    try {
+        for (::std::size_t wave_begin = 0; wave_begin < nblocks; wave_begin += wave_size) {
+            const auto cur_wave_size = ::std::min(wave_size, nblocks - wave_begin);
+
+            // Compute the products in the blocks of the wave.
+            ::tbb::parallel_for(
+                ::tbb::blocked_range<::std::size_t>(0, cur_wave_size),
+                [&v1, &v2, &ss, &blk_terms, &blk_offsets, wave_begin, n1, n2, br, bc, nbc, nsegs,
+                 log2_nsegs](const auto &range) {
+                    // Temporary variable used in monomial multiplication.
+                    ret_key_t tmp_key(ss);
+
+                    // The local accumulation table.
+                    ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                                        ::obake::detail::series_key_comparer>
+                        acc_table;
+
+                    for (auto bi = range.begin(); bi != range.end(); ++bi) {
+                        // Establish the ranges of rows and columns.
+                        const auto b = wave_begin + bi;
+                        const auto i_begin = (b / nbc) * br, j_begin = (b % nbc) * bc;
+                        const auto i_end = ::std::min(n1, i_begin + br), j_end = ::std::min(n2, j_begin + bc);
+
+                        for (auto i = i_begin; i != i_end; ++i) {
+                            const auto &[k1, c1] = *v1[i];
+
+                            for (auto j = j_begin; j != j_end; ++j) {
+                                const auto &[k2, c2] = *v2[j];
+
+                                // Do the monomial multiplication.
+                                ::obake::monomial_mul(tmp_key, k1, k2, ss);
+
+                                detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+                            }
+                        }
+
+                        // Move the terms of the local table into
+                        // the storage of the block, grouping them
+                        // by segment.
+                        auto &mv = blk_terms[bi];
+                        assert(mv.empty());
+
+                        mv.reserve(acc_table.size());
+                        acc_table.consume([&mv, log2_nsegs](ret_key_t &&k, ret_cf_t &&c) {
+                            if (!::obake::is_zero(::std::as_const(c))) {
+                                const auto seg_idx = static_cast<s_size_t>(::obake::hash(::std::as_const(k))
+                                                                           % (s_size_t(1) << log2_nsegs));
+                                mv.emplace_back(seg_idx, ::std::make_pair(::std::move(k), ::std::move(c)));
+                            }
+                        });
+
+                        ::std::sort(mv.begin(), mv.end(),
+                                    [](const auto &p1, const auto &p2) { return p1.first < p2.first; });
+
+                        auto &offsets = blk_offsets[bi];
+                        offsets.assign(static_cast<::std::size_t>(nsegs) + 1u, 0);
+                        for (const auto &p : mv) {
+                            ++offsets[static_cast<::std::size_t>(p.first) + 1u];
+                        }
+                        ::std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+                    }
+                });
+
+            // Merge the blocks into retval, one segment
+            // per task, in block order.
+            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs),
+                                [&retval, &blk_terms, &blk_offsets, cur_wave_size](const auto &range) {
+                                    for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                                        auto &table = retval._get_s_table()[seg_idx];
+                                        const auto s_idx = static_cast<::std::size_t>(seg_idx);
+
+                                        for (::std::size_t bi = 0; bi < cur_wave_size; ++bi) {
+                                            auto &mv = blk_terms[bi];
+                                            const auto &offsets = blk_offsets[bi];
+
+                                            for (auto i = offsets[s_idx]; i != offsets[s_idx + 1u]; ++i) {
+                                                auto &[k, c] = mv[i].second;
+
+                                                const auto res = table.try_emplace(k, ::std::move(c));
+                                                if (!res.second) {
+                                                    // NOTE: the term exists already, accumulate.
+                                                    // try_emplace() does not touch c if the
+                                                    // insertion fails.
+                                                    res.first->second += ::std::move(c);
+                                                }
+                                            }
+                                        }
+                                    }
+                                });
+
+            for (auto &mv : blk_terms) {
+                mv.clear();
+            }
+        }
+
+        // Locate and erase terms with zero coefficients, and check
+        // the table sizes.
+        // NOTE: zero coefficients can appear in retval when
+        // the contributions from different blocks cancel out.
+        ::tbb::parallel_for(
+            ::tbb::blocked_range<s_size_t>(0, nsegs), [&retval, mts = retval._get_max_table_size()](const auto &range) {
+                for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                    auto &table = retval._get_s_table()[seg_idx];
+
+                    const auto it_f = table.end();
+                    for (auto it = table.begin(); it != it_f;) {
+                        // NOTE: abseil's flat_hash_map returns void on erase(),
+                        // thus we need to increase 'it' before possibly erasing.
+                        if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
+                            table.erase(it++);
+                        } else {
+                            ++it;
+                        }
+                    }
+
+                    // LCOV_EXCL_START
+                    // Check the table size against the max allowed size.
+                    if (obake_unlikely(table.size() > mts)) {
+                        obake_throw(::std::overflow_error, "The multithreaded multiplication of two "
+                                                           "polynomials resulted in a table whose size ("
+                                                               + ::obake::detail::to_string(table.size())
+                                                               + ") is larger than the maximum allowed value ("
+                                                               + ::obake::detail::to_string(mts) + ")");
+                    }
+                    // LCOV_EXCL_STOP
+                }
+            });
+        // LCOV_EXCL_START
+    } catch (...) {
+        // In case of exceptions, clear retval before
+        // rethrowing to ensure a known sane state.
+        retval.clear();
+        throw;
+        // LCOV_EXCL_STOP
+    }
+}
+
+template <typename Rel, typename T, typename U, typename... Args>
+inline auto poly_mul_impl_identical_ss_rel(const Rel &, const T &, const U &, const Args &...);
+
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl_identical_ss(const T &, const U &, const Args &...);
+
+// Meta-programming to establish if the product of the polynomials
+// T and U can be computed via the primitive parts of the factors
+// (see poly_mul_impl_primitive()). This is the case if both T and U
+// have coefficients of the same mppp::rational type, and if the
+// polynomials with the corresponding mppp::integer coefficients
+// can be multiplied.
+template <typename T, typename U>
+constexpr bool poly_mul_primitive_algorithm_impl()
+{
+    using cf1_t = series_cf_t<T>;
+    using cf2_t = series_cf_t<U>;
+
+    if constexpr (::std::conjunction_v<::obake::detail::is_mppp_rational<cf1_t>, ::std::is_same<cf1_t, cf2_t>,
+                                       ::std::is_same<series_cf_t<poly_mul_ret_t<T, U>>, cf1_t>>) {
+        using int_t = remove_cvref_t<decltype(::std::declval<const cf1_t &>().get_num())>;
+        using int_poly_t = polynomial<series_key_t<T>, int_t>;
+
+        return poly_mul_algo<int_poly_t, int_poly_t> != 0;
+    } else {
+        return false;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool poly_mul_primitive_algo = detail::poly_mul_primitive_algorithm_impl<T, U>();
+
+// The content of a polynomial with mppp::rational coefficients
+// (see poly_mul_impl_rat_content()): the GCD g of the numerators
+// and the LCM l of the denominators of the coefficients, together
+// with the average bit sizes of the numerators and of the denominators.
+template <typename Int>
+struct poly_mul_rat_content {
+    Int g, l;
+    double avg_num_nbits, avg_den_nbits;
+};
+
+// Helper to compute the content of a polynomial with
+// mppp::rational coefficients (see poly_mul_rat_content).
+// If x is segmented, the computation is done in parallel (one
+// segment per task).
+// NOTE: requires x not empty.
+template <typename T>
+inline auto poly_mul_impl_rat_content(const T &x)
+{
+    using int_t = remove_cvref_t<decltype(::std::declval<const series_cf_t<T> &>().get_num())>;
+
+    assert(!x.empty());
+
+    const auto &s_table = x._get_s_table();
+
+    // The content of each segment, and the total
+    // bit sizes of its numerators and denominators.
+    ::std::vector<poly_mul_rat_content<int_t>> seg_cont;
+    seg_cont.resize(::obake::safe_cast<decltype(seg_cont.size())>(s_table.size()));
+
+    // Helper to fold the content of a coefficient
+    // into the content cont. tmp is a temporary
+    // variable used in the LCM computation.
+    auto fold = [](auto &cont, int_t &tmp, const auto &num, const auto &den) {
+        // NOTE: gcd(0, n) == abs(n), thus the initial
+        // zero value of the GCD is handled correctly.
+        ::mppp::gcd(cont.g, cont.g, num);
+
+        if (!den.is_one()) {
+            // lcm(a, b) = a / gcd(a, b) * b.
+            ::mppp::gcd(tmp, cont.l, den);
+            ::mppp::divexact(tmp, den, tmp);
+            cont.l *= tmp;
+        }
+    };
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&s_table, &seg_cont, &fold](const auto &range) {
+                            int_t tmp;
+
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                auto &cont = seg_cont[i];
+                                cont.l = 1;
+                                cont.avg_num_nbits = 0;
+                                cont.avg_den_nbits = 0;
+
+                                for (const auto &t : s_table[i]) {
+                                    const auto &num = t.second.get_num();
+                                    const auto &den = t.second.get_den();
+
+                                    fold(cont, tmp, num, den);
+
+                                    // NOTE: accumulate the total bit sizes,
+                                    // the averages are computed at the end.
+                                    cont.avg_num_nbits += static_cast<double>(num.nbits());
+                                    cont.avg_den_nbits += static_cast<double>(den.nbits());
+                                }
+                            }
+                        });
+
+    // Combine the contents of the segments.
+    poly_mul_rat_content<int_t> retval{int_t{}, int_t{1}, 0, 0};
+    int_t tmp;
+    for (const auto &cont : seg_cont) {
+        if (!cont.g.is_zero()) {
+            // NOTE: empty segments have a zero GCD,
+            // skip them.
+            fold(retval, tmp, cont.g, cont.l);
+
+            retval.avg_num_nbits += cont.avg_num_nbits;
+            retval.avg_den_nbits += cont.avg_den_nbits;
+        }
+    }
+
+    retval.avg_num_nbits /= static_cast<double>(x.size());
+    retval.avg_den_nbits /= static_cast<double>(x.size());
+
+    assert(retval.g.sgn() == 1);
+    assert(retval.l.sgn() == 1);
+
+    return retval;
+}
+
+// Helper to establish if the multiplication via the primitive parts
+// (see poly_mul_impl_primitive()) is convenient for an operand with
+// content cont (as computed by poly_mul_impl_rat_content()).
+// The coefficients of the primitive part are num * (l / den) / g, where
+// num / den are the coefficients of the operand. If the denominators have
+// few common factors (e.g., if they are pairwise coprime), l is much larger
+// than the denominators, and the rescaling inflates the coefficients:
+// the term-by-term multiplications would then operate on integers
+// much larger than the rational coefficients, which is slower than
+// the rational arithmetic despite the GCD computations.
+// max_growth is the maximum allowed ratio between the estimated
+// average bit sizes of the coefficients of the primitive part
+// and of the rational coefficients (see mul_tuning).
+template <typename Int>
+inline bool poly_mul_impl_primitive_is_convenient(const poly_mul_rat_content<Int> &cont, double max_growth)
+{
+    const auto pp_nbits = cont.avg_num_nbits + static_cast<double>(cont.l.nbits()) - cont.avg_den_nbits
+                          - static_cast<double>(cont.g.nbits());
+
+    // NOTE: the cost of the arithmetic on coefficients
+    // fitting in a single limb does not depend on their
+    // bit size, hence the lower bound.
+    const auto rat_nbits = ::std::max(cont.avg_num_nbits + cont.avg_den_nbits,
+                                      static_cast<double>(::obake::detail::limits_digits<::mp_limb_t>));
+
+    return pp_nbits <= max_growth * rat_nbits;
+}
+
+// Helper to compute the primitive part of a polynomial with
+// mppp::rational coefficients, given its content cont
+// (as computed by poly_mul_impl_rat_content()).
+// The primitive part is returned as a polynomial with
+// mppp::integer coefficients whose segmentation is the same as x.
+// If x is segmented, the computation is done in parallel (one
+// segment per task).
+template <typename T, typename Cont>
+inline auto poly_mul_impl_rat_primitive_part(const T &x, const Cont &cont)
+{
+    using int_t = remove_cvref_t<decltype(::std::declval<const series_cf_t<T> &>().get_num())>;
+    using ret_t = polynomial<series_key_t<T>, int_t>;
+
+    const auto &g = cont.g;
+    const auto &l = cont.l;
+
+    ret_t retval;
+    retval.set_symbol_set_fw(x.get_symbol_set_fw());
+    retval.set_n_segments(x.get_s_size());
+
+    const auto &s_table = x._get_s_table();
+    auto &r_table = retval._get_s_table();
+
+    // NOTE: the keys do not change, thus they will end up
+    // in the same segments as in x.
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&s_table, &r_table, &g, &l](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                const auto &in_table = s_table[i];
+                                auto &out_table = r_table[i];
+
+                                out_table.reserve(in_table.size());
+
+                                for (const auto &t : in_table) {
+                                    const auto &num = t.second.get_num();
+                                    const auto &den = t.second.get_den();
+
+                                    // The new coefficient is num * (l / den) / g.
+                                    int_t n;
+                                    if (den == l) {
+                                        n = num;
+                                    } else {
+                                        ::mppp::divexact(n, l, den);
+                                        n *= num;
+                                    }
+                                    if (!g.is_one()) {
+                                        ::mppp::divexact(n, n, g);
+                                    }
+
+                                    [[maybe_unused]] const auto res = out_table.emplace(t.first, ::std::move(n));
+                                    assert(res.second);
+                                }
+                            }
+                        });
+
+    return retval;
+}
+
+// Helper to multiply the content g / l back into the product pp
+// of the primitive parts of two polynomials with mppp::rational
+// coefficients (see poly_mul_impl_primitive()). The return value,
+// of type Ret, has the same segmentation as pp.
+// If pp is segmented, the computation is done in parallel (one
+// segment per task).
+template <typename Ret, typename P, typename Int>
+inline Ret poly_mul_impl_rat_rescale(const P &pp, const Int &g, const Int &l)
+{
+    using ret_cf_t = series_cf_t<Ret>;
+
+    Ret retval;
+    retval.set_symbol_set_fw(pp.get_symbol_set_fw());
+    retval.set_n_segments(pp.get_s_size());
+
+    const auto &pp_table = pp._get_s_table();
+    auto &r_table = retval._get_s_table();
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(pp_table.size())>(0, pp_table.size()),
+                        [&pp_table, &r_table, &g, &l](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                const auto &in_table = pp_table[i];
+                                auto &out_table = r_table[i];
+
+                                out_table.reserve(in_table.size());
+
+                                for (const auto &t : in_table) {
+                                    // NOTE: the product of the primitive
+                                    // parts does not contain zero coefficients,
+                                    // and the product of the contents is nonzero.
+                                    assert(!t.second.is_zero());
+
+                                    ret_cf_t q;
+                                    auto &num = q._get_num();
+                                    num = t.second;
+                                    if (!g.is_one()) {
+                                        num *= g;
+                                    }
+                                    if (!l.is_one()) {
+                                        q._get_den() = l;
+                                        q.canonicalise();
+                                    }
+
+                                    [[maybe_unused]] const auto res = out_table.emplace(t.first, ::std::move(q));
+                                    assert(res.second);
+                                }
+                            }
+                        });
+
+    return retval;
+}
+
+// Polynomial multiplication via the primitive parts of the factors,
+// for polynomials with mppp::rational coefficients.
+// The rational coefficients of x and y are rescaled to integers
+// by factoring out their contents, the integral primitive parts are multiplied,
+// and finally the contents are multiplied back into the coefficients
+// of the product. In this way, the GCD computations required by rational
+// arithmetic are performed once per term of the factors
+// and once per term of the product, rather than once per
+// term-by-term multiplication, and the hot loop of the multiplication
+// runs on integers.
+// cont_x and cont_y are the contents of x and y (as computed
+// by poly_mul_impl_rat_content()).
+// NOTE: requires x and y not empty, x not longer than y,
+// and identical symbol sets. rel is invoked once the primitive
+// parts have been computed (see poly_mul_impl_mt_hm_rel()).
+template <typename Rel, typename T, typename CT, typename U, typename CU, typename... Args>
+inline auto poly_mul_impl_primitive(const Rel &rel, const T &x, const CT &cont_x, const U &y, const CU &cont_y,
+                                    const Args &...args)
+{
+    assert(!x.empty() && !y.empty());
+    assert(x.size() <= y.size());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    const auto pp = [&]() {
+        if (detail::poly_mul_impl_is_sqr(x, y)) {
+            // In the squaring case, compute the primitive part
+            // only once, so that its square is computed
+            // via the squaring algorithm.
+            const auto pp_x = detail::poly_mul_impl_rat_primitive_part(x, cont_x);
+            rel();
+
+            return detail::poly_mul_impl_identical_ss(pp_x, pp_x, args...);
+        } else {
+            const auto pp_x = detail::poly_mul_impl_rat_primitive_part(x, cont_x);
+            const auto pp_y = detail::poly_mul_impl_rat_primitive_part(y, cont_y);
+            rel();
+
+            return detail::poly_mul_impl_identical_ss(pp_x, pp_y, args...);
+        }
+    }();
+
+    // Multiply the content of the product back in.
+    return detail::poly_mul_impl_rat_rescale<poly_mul_ret_t<T, U>>(pp, cont_x.g * cont_y.g, cont_x.l * cont_y.l);
+}
+
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+// Meta-programming to establish if the product of the polynomials
+// T and U can be computed via the multi-modular
+// algorithm (see poly_mul_impl_crt()). This is the case if both T and U
+// have coefficients of the same mppp::integer type, and if the
+// polynomials with 128-bit unsigned coefficients (which are used
+// to accumulate the products modulo word-sized primes) can be multiplied.
+template <typename T, typename U>
+constexpr bool poly_mul_crt_algorithm_impl()
+{
+    using cf1_t = series_cf_t<T>;
+    using cf2_t = series_cf_t<U>;
+
+    if constexpr (::std::conjunction_v<::obake::detail::is_mppp_integer<cf1_t>, ::std::is_same<cf1_t, cf2_t>>) {
+        using mod_poly_t = polynomial<series_key_t<T>, __uint128_t>;
+
+        if constexpr (poly_mul_algo<T, U> != 0 && poly_mul_algo<mod_poly_t, mod_poly_t> != 0) {
+            return ::std::is_same_v<series_cf_t<poly_mul_ret_t<T, U>>, cf1_t>;
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+}
+
+template <typename T, typename U>
+inline constexpr bool poly_mul_crt_algo = detail::poly_mul_crt_algorithm_impl<T, U>();
+
+// Modular multiplication and exponentiation
+// for 64-bit unsigned integers.
+inline ::std::uint64_t poly_mul_crt_mulmod(::std::uint64_t a, ::std::uint64_t b, ::std::uint64_t p)
+{
+    return static_cast<::std::uint64_t>(static_cast<__uint128_t>(a) * b % p);
+}
+
+inline ::std::uint64_t poly_mul_crt_powmod(::std::uint64_t a, ::std::uint64_t e, ::std::uint64_t p)
+{
+    ::std::uint64_t retval = 1u % p;
+
+    for (a %= p; e != 0u; e >>= 1) {
+        if (e & 1u) {
+            retval = detail::poly_mul_crt_mulmod(retval, a, p);
+        }
+        a = detail::poly_mul_crt_mulmod(a, a, p);
+    }
+
+    return retval;
+}
+
+// Deterministic Miller-Rabin primality test for 64-bit integers.
+// See:
+// https://en.wikipedia.org/wiki/Miller%E2%80%93Rabin_primality_test
+inline bool poly_mul_crt_is_prime(::std::uint64_t n)
+{
+    // NOTE: testing these bases is enough
+    // for all 64-bit integers.
+    constexpr ::std::uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+
+    if (n < 2u) {
+        return false;
+    }
+
+    for (auto b : bases) {
+        if (n % b == 0u) {
+            return n == b;
+        }
+    }
+
+    // Write n - 1 as d * 2**s, with d odd.
+    const auto s = static_cast<unsigned>(::std::countr_zero(n - 1u));
+    const auto d = (n - 1u) >> s;
+
+    for (auto b : bases) {
+        auto x = detail::poly_mul_crt_powmod(b, d, n);
+
+        if (x == 1u || x == n - 1u) {
+            continue;
+        }
+
+        auto composite = true;
+        for (unsigned i = 1; i < s; ++i) {
+            x = detail::poly_mul_crt_mulmod(x, x, n);
+            if (x == n - 1u) {
+                composite = false;
+                break;
+            }
+        }
+
+        if (composite) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Generate n distinct primes in the (2**(nbits-1), 2**nbits) range.
+// NOTE: requires 2 < nbits < 64.
+inline ::std::vector<::std::uint64_t> poly_mul_crt_make_primes(unsigned nbits, ::std::size_t n)
+{
+    assert(nbits > 2u && nbits < 64u);
+
+    const auto lb = ::std::uint64_t(1) << (nbits - 1u);
+
+    ::std::vector<::std::uint64_t> retval;
+    retval.reserve(n);
+
+    // Search downwards from 2**nbits - 1.
+    for (auto cand = (lb << 1) - 1u; retval.size() < n; cand -= 2u) {
+        if (obake_unlikely(cand <= lb)) {
+            // LCOV_EXCL_START
+            obake_throw(::std::overflow_error, "Cannot find " + ::obake::detail::to_string(n) + " primes of "
+                                                   + ::obake::detail::to_string(nbits)
+                                                   + " bits for the multi-modular polynomial multiplication");
+            // LCOV_EXCL_STOP
+        }
+
+        if (detail::poly_mul_crt_is_prime(cand)) {
+            retval.push_back(cand);
+        }
+    }
+
+    return retval;
+}
+
+// Helper to compute the maximum number of bits of the coefficients
+// of a polynomial with mppp::integer coefficients.
+// If x is segmented, the computation is done in parallel (one
+// segment per task).
+template <typename T>
+inline auto poly_mul_crt_max_nbits(const T &x)
+{
+    const auto &s_table = x._get_s_table();
+
+    using nbits_t = decltype(::std::declval<const series_cf_t<T> &>().nbits());
+    ::std::vector<nbits_t> seg_nbits;
+    seg_nbits.resize(::obake::safe_cast<decltype(seg_nbits.size())>(s_table.size()));
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&s_table, &seg_nbits](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                nbits_t cur = 0;
+
+                                for (const auto &t : s_table[i]) {
+                                    cur = ::std::max(cur, t.second.nbits());
+                                }
+
+                                seg_nbits[i] = cur;
+                            }
+                        });
+
+    return *::std::max_element(seg_nbits.begin(), seg_nbits.end());
+}
+
+// Helper to reduce the coefficients of a polynomial with
+// mppp::integer coefficients modulo the prime p.
+// The return value is a polynomial with 128-bit unsigned coefficients
+// whose segmentation is the same as x. The residues are
+// represented in the [1, p] range (rather than [0, p)), so that
+// terms whose coefficient is divisible by p are not discarded, and
+// all the polynomial products modulo the different primes contain
+// exactly the same monomials (i.e., those in the product before cancellations).
+// If x is segmented, the computation is done in parallel (one
+// segment per task).
+template <typename T>
+inline auto poly_mul_crt_reduce(const T &x, ::std::uint64_t p)
+{
+    using int_t = series_cf_t<T>;
+    using ret_t = polynomial<series_key_t<T>, __uint128_t>;
+
+    ret_t retval;
+    retval.set_symbol_set_fw(x.get_symbol_set_fw());
+    retval.set_n_segments(x.get_s_size());
+
+    const auto &s_table = x._get_s_table();
+    auto &r_table = retval._get_s_table();
+
+    const int_t p_int(p);
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+                        [&s_table, &r_table, &p_int, p](const auto &range) {
+                            int_t tmp;
+
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                const auto &in_table = s_table[i];
+                                auto &out_table = r_table[i];
+
+                                out_table.reserve(in_table.size());
+
+                                for (const auto &t : in_table) {
+                                    tmp = t.second % p_int;
+                                    if (tmp.sgn() < 0) {
+                                        tmp += p_int;
+                                    }
+
+                                    auto r = static_cast<::std::uint64_t>(tmp);
+                                    if (r == 0u) {
+                                        r = p;
+                                    }
+
+                                    [[maybe_unused]] const auto res
+                                        = out_table.emplace(t.first, static_cast<__uint128_t>(r));
+                                    assert(res.second);
+                                }
+                            }
+                        });
+
+    return retval;
+}
+
+// Helper to establish the size (in bits) of the primes used in the
+// multi-modular multiplication, given a bound n on the number of
+// term-by-term products contributing to each coefficient of the product.
+// NOTE: because the coefficients of the products modulo the primes are
+// accumulated without reductions, the size of the primes is chosen so that
+// the accumulation cannot overflow.
+inline unsigned poly_mul_crt_nbits_p(::std::uint64_t n)
+{
+    // The bit width of n is a bound on the number
+    // of bits needed to represent the number of addends.
+    const auto nbits_n = static_cast<unsigned>(::std::bit_width(n));
+    assert(nbits_n > 0u && nbits_n <= 64u);
+
+    // The residues are less than 2**nbits_p, their products less
+    // than 2**(2*nbits_p), and the sum of the products less
+    // than 2**(2*nbits_p + nbits_n), which must not overflow 128 bits.
+    return ::std::min(62u, (128u - nbits_n) / 2u);
+}
+
+// Helper to establish the number of primes of nbits_p bits needed
+// to represent the coefficients of the product of two polynomials
+// whose coefficients have at most nbits_x and nbits_y bits. n is a bound
+// on the number of term-by-term products contributing to each
+// coefficient of the product.
+inline ::std::size_t poly_mul_crt_n_primes(::std::uint64_t n, unsigned nbits_p, ::std::size_t nbits_x,
+                                           ::std::size_t nbits_y)
+{
+    const auto nbits_n = static_cast<unsigned>(::std::bit_width(n));
+
+    // The coefficients of the product are less than
+    // 2**(nbits_x + nbits_y + nbits_n) in absolute value. The product
+    // of the primes must be larger than twice that, and each prime
+    // is larger than 2**(nbits_p - 1).
+    // NOTE: no overflow concerns here, as the number of bits of the
+    // coefficients is limited by the available memory.
+    const auto nbits_bound = nbits_x + nbits_y + nbits_n + 1u;
+
+    return (nbits_bound + nbits_p - 2u) / (nbits_p - 1u);
+}
+
+// Reconstruction of a polynomial of type Ret, with mppp::integer
+// coefficients, from the polynomials of its residues modulo a sequence
+// of primes, via the Chinese remainder theorem. The residues are added
+// one prime at a time via add(), using the mixed-radix (Garner)
+// representation, and the polynomial is then extracted via get().
+// The computations are done in parallel, one segment per task.
+// NOTE: the residues polynomials must all contain the same monomials
+// (see poly_mul_crt_reduce()).
+template <typename Ret>
+class poly_mul_crt_rec
+{
+    using int_t = series_cf_t<Ret>;
+
+public:
+    // Add the polynomial prod of the residues modulo the prime p.
+    template <typename P>
+    void add(const P &prod, ::std::uint64_t p)
+    {
+        const int_t p_int(p);
+
+        if (m_m.is_one()) {
+            // First prime: init m_retval with the residues,
+            // preserving the segmentation.
+            m_retval.set_symbol_set_fw(prod.get_symbol_set_fw());
+            m_retval.set_n_segments(prod.get_s_size());
+
+            const auto &p_table = prod._get_s_table();
+            auto &r_table = m_retval._get_s_table();
+
+            ::tbb::parallel_for(::tbb::blocked_range<decltype(p_table.size())>(0, p_table.size()),
+                                [&p_table, &r_table, p](const auto &range) {
+                                    for (auto i = range.begin(); i != range.end(); ++i) {
+                                        const auto &in_table = p_table[i];
+                                        auto &out_table = r_table[i];
+
+                                        out_table.reserve(in_table.size());
+
+                                        for (const auto &t : in_table) {
+                                            [[maybe_unused]] const auto res = out_table.emplace(
+                                                t.first, int_t(static_cast<::std::uint64_t>(t.second % p)));
+                                            assert(res.second);
+                                        }
+                                    }
+                                });
+        } else {
+            // The products modulo all the primes
+            // contain the same monomials.
+            assert(prod.size() == m_retval.size());
+
+            // The inverse of m modulo p.
+            const auto m_inv = detail::poly_mul_crt_powmod(static_cast<::std::uint64_t>(m_m % p_int), p - 2u, p);
+
+            // Update the coefficients c of m_retval, so that
+            // they are correct modulo m * p:
+            // c -> c + m * ((r - c) * m**-1 mod p),
+            // where r is the residue modulo p.
+            auto &r_table = m_retval._get_s_table();
+
+            ::tbb::parallel_for(::tbb::blocked_range<decltype(r_table.size())>(0, r_table.size()),
+                                [&r_table, &prod, &m = m_m, &p_int, p, m_inv](const auto &range) {
+                                    int_t tmp;
+
+                                    for (auto i = range.begin(); i != range.end(); ++i) {
+                                        for (auto &t : r_table[i]) {
+                                            const auto it = prod.find(t.first);
+                                            assert(it != prod.end());
+
+                                            const auto r = static_cast<::std::uint64_t>(it->second % p);
+
+                                            // NOTE: the coefficients of m_retval
+                                            // are in the [0, m) range.
+                                            tmp = t.second % p_int;
+                                            const auto c = static_cast<::std::uint64_t>(tmp);
+
+                                            const auto d = detail::poly_mul_crt_mulmod(r >= c ? r - c : r + (p - c),
+                                                                                       m_inv, p);
+                                            if (d != 0u) {
+                                                tmp = d;
+                                                ::mppp::addmul(t.second, m, tmp);
+                                            }
+                                        }
+                                    }
+                                });
+        }
+
+        m_m *= p_int;
+    }
+
+    // Extract the reconstructed polynomial.
+    // NOTE: requires at least one invocation of add().
+    Ret get() &&
+    {
+        assert(!m_m.is_one());
+
+        // Move the coefficients to the symmetric range (-m/2, m/2),
+        // and remove the terms which cancelled out.
+        const auto half_m = m_m >> 1;
+        auto &r_table = m_retval._get_s_table();
+
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(r_table.size())>(0, r_table.size()),
+                            [&r_table, &m = m_m, &half_m](const auto &range) {
+                                for (auto i = range.begin(); i != range.end(); ++i) {
+                                    auto &table = r_table[i];
+                                    const auto it_f = table.end();
+
+                                    for (auto it = table.begin(); it != it_f;) {
+                                        auto &c = it->second;
+
+                                        if (c.is_zero()) {
+                                            // NOTE: abseil's flat_hash_map returns void on erase(),
+                                            // thus we need to increase 'it' before erasing.
+                                            table.erase(it++);
+                                        } else {
+                                            if (c > half_m) {
+                                                c -= m;
+                                            }
+                                            ++it;
+                                        }
+                                    }
+                                }
+                            });
+
+        return ::std::move(m_retval);
+    }
+
+private:
+    Ret m_retval;
+    // The product of the primes processed so far.
+    int_t m_m{1};
+};
+
+// Multi-modular polynomial multiplication, for polynomials
+// with mppp::integer coefficients. nbits_x and nbits_y are
+// the max number of bits of the coefficients of x and y
+// (as computed by poly_mul_crt_max_nbits()).
+// The factors are reduced modulo a set of word-sized primes,
+// large enough to represent all the coefficients of the product, and
+// the product modulo each prime is computed via the usual machinery, using
+// 128-bit unsigned integers as coefficients. The coefficients
+// of the product are then reconstructed via the Chinese remainder
+// theorem (see poly_mul_crt_rec).
+// NOTE: requires x and y not empty, x not longer than y,
+// and identical symbol sets.
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl_crt(const T &x, const U &y, ::std::size_t nbits_x, ::std::size_t nbits_y,
+                              const Args &...args)
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+
+    assert(!x.empty() && !y.empty());
+    assert(x.size() <= y.size());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Each coefficient of the product is the sum
+    // of at most x.size() term-by-term products.
+    const auto n = static_cast<::std::uint64_t>(x.size());
+    const auto nbits_p = detail::poly_mul_crt_nbits_p(n);
+    const auto primes
+        = detail::poly_mul_crt_make_primes(nbits_p, detail::poly_mul_crt_n_primes(n, nbits_p, nbits_x, nbits_y));
+
+    poly_mul_crt_rec<ret_t> rec;
+
+    const auto sqr = detail::poly_mul_impl_is_sqr(x, y);
+
+    for (const auto p : primes) {
+        // Compute the product modulo p. In the squaring case,
+        // reduce x only once, so that its square is computed
+        // via the squaring algorithm.
+        if (sqr) {
+            const auto x_p = detail::poly_mul_crt_reduce(x, p);
+
+            rec.add(detail::poly_mul_impl_identical_ss(x_p, x_p, args...), p);
+        } else {
+            rec.add(detail::poly_mul_impl_identical_ss(detail::poly_mul_crt_reduce(x, p),
+                                                       detail::poly_mul_crt_reduce(y, p), args...),
+                    p);
+        }
+    }
+
+    return ::std::move(rec).get();
+}
+
+#endif
+
+// Metaprogramming to establish if the product of the polynomials
+// T and U can be computed via the multi-threaded homomorphic
+// implementation (see poly_mul_impl_mt_hm_rel()). This requires
+// homomorphic hashing, and the ability to measure the byte size of
+// the factors and of the key/cf of the return type via const
+// lvalue references.
+// NOTE: perhaps the size measurability is too much of a hard requirement,
+// and we can make this optional (if not supported, fix the nsegs
+// to something like twice the cores).
+template <typename T, typename U>
+constexpr bool poly_mul_mt_hm_algorithm_impl()
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+    using ret_key_t = series_key_t<ret_t>;
+
+    return ::std::conjunction_v<is_homomorphically_hashable_monomial<ret_key_t>, is_size_measurable<const T &>,
+                                is_size_measurable<const U &>, is_size_measurable<const ret_key_t &>,
+                                is_size_measurable<const series_cf_t<ret_t> &>>;
+}
+
+template <typename T, typename U>
+inline constexpr bool poly_mul_mt_hm_algo = detail::poly_mul_mt_hm_algorithm_impl<T, U>();
+
+// Helper to compute the byte size of the polynomial x, if possible.
+// Otherwise, zero is returned.
+template <typename T>
+inline ::std::size_t poly_mul_impl_byte_size(const T &x)
+{
+    if constexpr (is_size_measurable<const T &>::value) {
+        return ::obake::byte_size(x);
+    } else {
+        ::obake::detail::ignore(x);
+
+        return 0;
+    }
+}
+
+// Helper to compute the data of the operand s of a product of
+// polynomials of types T and U which is needed by the algorithm
+// selection (see poly_mul_impl_select()): the content for the
+// multiplication via primitive parts, the max number of bits
+// of the coefficients for the multi-modular multiplication.
+// NOTE: requires s not empty.
+template <typename T, typename U, typename S>
+inline auto poly_mul_impl_make_algo_data(const S &s)
+{
+    if constexpr (poly_mul_primitive_algo<T, U>) {
+        return detail::poly_mul_impl_rat_content(s);
+    }
+#if defined(OBAKE_HAVE_GCC_INT128)
+    else if constexpr (poly_mul_crt_algo<T, U>) {
+        return detail::poly_mul_crt_max_nbits(s);
+    }
+#endif
+    else {
+        ::obake::detail::ignore(s);
+
+        return 0;
+    }
+}
+
+template <typename T, typename U, typename S>
+using poly_mul_impl_algo_data_t
+    = decltype(detail::poly_mul_impl_make_algo_data<T, U>(::std::declval<const S &>()));
+
+// The algorithms for the multiplication of polynomials
+// with identical symbol sets (see poly_mul_impl_select()).
+enum class poly_mul_impl_algo {
+    // The simple implementation (see poly_mul_impl_simple_rel()).
+    simple,
+    // Multiplication via the primitive parts (see poly_mul_impl_primitive()).
+    primitive,
+    // Multi-modular multiplication (see poly_mul_impl_crt()).
+    crt,
+    // Multi-threaded implementation: homomorphic if poly_mul_mt_hm_algo
+    // is true (see poly_mul_impl_mt_hm_rel()), lock-based
+    // otherwise (see poly_mul_impl_mt_lock()).
+    mt
+};
+
+// Helper to select the algorithm for the multiplication of the polynomials
+// x and y, which must be non-empty and have identical symbol sets.
+// Truncated signals whether the multiplication is truncated.
+// bs_x and bs_y are the byte sizes of x and y (as computed by
+// poly_mul_impl_byte_size()), dx and dy nullary function objects returning
+// the data of x and y (as computed by poly_mul_impl_make_algo_data()).
+// dx and dy are invoked only if the data is needed (i.e., if the
+// operands are large), so that the data can be computed on demand.
+// t are the tuning parameters.
+// NOTE: this is the only place where the selection criteria are
+// encoded, both for the regular multiplication (see
+// poly_mul_impl_identical_ss_rel()) and for the batched one
+// (see poly_mul_many_impl()).
+template <bool Truncated, typename T, typename U, typename DX, typename DY>
+inline poly_mul_impl_algo poly_mul_impl_select(const T &x, const U &y, ::std::size_t bs_x, ::std::size_t bs_y,
+                                               const DX &dx, const DY &dy, const mul_tuning &t)
+{
+    using algo = poly_mul_impl_algo;
+
+    assert(!x.empty() && !y.empty());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    if constexpr (::std::conjunction_v<is_size_measurable<const T &>, is_size_measurable<const U &>>) {
+        if ((x.size() == 1u && y.size() == 1u) || ::std::max(bs_x, bs_y) < t.mt_min_bytes) {
+            // Run the simple implementation if either:
+            // - both polys have only 1 term, or
+            // - the maximum operand size is less than a threshold value.
+            return algo::simple;
+        }
+
+        if constexpr (poly_mul_primitive_algo<T, U>) {
+            // Rational coefficients: multiply the primitive
+            // parts, unless the rescaling inflates the coefficients.
+            if (detail::poly_mul_impl_primitive_is_convenient(dx(), t.primitive_max_growth)
+                && detail::poly_mul_impl_primitive_is_convenient(dy(), t.primitive_max_growth)) {
+                return algo::primitive;
+            }
+        }
+
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+        if constexpr (poly_mul_crt_algo<T, U>) {
+            // Integral coefficients: use the multi-modular multiplication
+            // if the coefficients are large enough.
+            if (::std::min(dx(), dy()) >= t.crt_min_nbits) {
+                return algo::crt;
+            }
+        }
+
+#endif
+
+        if (::obake::detail::hc() == 1u) {
+            // Just 1 core.
+            return algo::simple;
+        }
+
+        if constexpr (poly_mul_mt_hm_algo<T, U> || !Truncated) {
+            return algo::mt;
+        } else {
+            // The monomial does not have homomorphic hashing,
+            // and the lock-based implementation does not
+            // support truncation.
+            return algo::simple;
+        }
+    } else {
+        ::obake::detail::ignore(bs_x, bs_y, dx, dy, t);
+
+        return algo::simple;
+    }
+}
+
+// Implementation of poly multiplication with identical symbol sets.
+// Requires that x is not longer than y. rel is invoked
+// at most once, after which x and y are not accessed
+// any more (see poly_mul_impl_mt_hm_rel()).
+template <typename Rel, typename T, typename U, typename... Args>
+inline auto poly_mul_impl_identical_ss_rel(const Rel &rel, const T &x, const U &y, const Args &...args)
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+    using algo = poly_mul_impl_algo;
+
+    // Check the preconditions.
+    assert(x.size() <= y.size());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Init the return value.
+    ret_t retval;
+    retval.set_symbol_set_fw(x.get_symbol_set_fw());
+
+    if (x.empty() || y.empty()) {
+        // Exit early if either series is empty.
+        return retval;
+    }
+
+    // Select the algorithm. The data of x and y
+    // is computed only if needed by the selection.
+    ::std::optional<poly_mul_impl_algo_data_t<T, U, T>> dx;
+    ::std::optional<poly_mul_impl_algo_data_t<T, U, U>> dy;
+    const auto a = detail::poly_mul_impl_select<(sizeof...(Args) > 0u)>(
+        x, y, detail::poly_mul_impl_byte_size(x), detail::poly_mul_impl_byte_size(y),
+        [&x, &dx]() -> const auto & {
+            if (!dx) {
+                dx.emplace(detail::poly_mul_impl_make_algo_data<T, U>(x));
+            }
+            return *dx;
+        },
+        [&y, &dy]() -> const auto & {
+            if (!dy) {
+                dy.emplace(detail::poly_mul_impl_make_algo_data<T, U>(y));
+            }
+            return *dy;
+        },
+        ::obake::polynomials::get_mul_tuning());
+
+    if constexpr (poly_mul_primitive_algo<T, U>) {
+        if (a == algo::primitive) {
+            // NOTE: the contents have been computed
+            // during the selection.
+            return detail::poly_mul_impl_primitive(rel, x, *dx, y, *dy, args...);
+        }
+    }
+
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+    if constexpr (poly_mul_crt_algo<T, U>) {
+        if (a == algo::crt) {
+            return detail::poly_mul_impl_crt(x, y, *dx, *dy, args...);
+        }
+    }
+
+#endif
+
+    if constexpr (poly_mul_mt_hm_algo<T, U>) {
+        if (a == algo::mt) {
+            detail::poly_mul_impl_mt_hm_rel(rel, retval, x, y, args...);
+
+            return retval;
+        }
+    } else if constexpr (sizeof...(Args) == 0u) {
+        if (a == algo::mt) {
+            detail::poly_mul_impl_mt_lock(retval, x, y);
+
+            return retval;
+        }
+    }
+
+    assert(a == algo::simple);
+    detail::poly_mul_impl_simple_rel(rel, retval, x, y, args...);
+
+    return retval;
+}
+
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...args)
+{
+    return detail::poly_mul_impl_identical_ss_rel(poly_mul_impl_no_release{}, x, y, args...);
+}
+
+// Top level function for poly multiplication. Requires that
+// x is not longer than y.
+// NOTE: future improvements:
+// - make the ntrials for the estimation of the average term size
+//   dependent on the number of term-by-term multiplications (need data for that).
+// NOTE: performance considerations:
+// - the multithreaded implementation still computes
+//   the degrees of the terms of the input series twice. This
+//   could be reduced at the price of changing a bit the code structure
+//   and at the cost of additional indirect sorting (because we
+//   would be computing the degree vectors at the beginning and then
+//   we would need to sort them for segmentation purposes). It's not
+//   clear to me if this is worth it at this time, need to profile;
+// - in highly rectangular multiplications, quite a bit of time
+//   is spent copying the larger operand into a vector of terms.
+//   The copy is parallelised for segmented series, but perhaps
+//   it could be avoided altogether?
+// - in highly rectangular multiplications, the series size
+//   estimation is quite poor (see comments on top of the
+//   function). Not sure what we could do about it;
+// - when constructing vectors of indices, or when building
+//   vectors of degrees, we could improve performance by using
+//   a default-constructing allocator, in order to avoid zeroing
+//   out data which we will be overwriting anyway;
+// - perhaps vector permutations could be done in parallel?
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
+{
+    // Check the precondition.
+    assert(x.size() <= y.size());
+
+    if (x.get_symbol_set_fw() == y.get_symbol_set_fw()) {
+        return detail::poly_mul_impl_identical_ss(x, y, args...);
+    } else {
+        // Merge the symbol sets.
+        const auto &[merged_ss, ins_map_x, ins_map_y]
+            = ::obake::detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+
+        // The insertion maps cannot be both empty, as we already handled
+        // the identical symbol sets case above.
+        assert(!ins_map_x.empty() || !ins_map_y.empty());
+
+        // Create a flag indicating empty insertion maps:
+        // - 0 -> both non-empty,
+        // - 1 -> x is empty,
+        // - 2 -> y is empty.
+        // (Cannot both be empty as we handled identical symbol sets already).
+        const auto flag = static_cast<unsigned>(ins_map_x.empty()) + (static_cast<unsigned>(ins_map_y.empty()) << 1);
+
+        switch (flag) {
+            case 1u: {
+                // x already has the correct symbol
+                // set, extend only y.
+                U b;
+                b.set_symbol_set(merged_ss);
+                ::obake::detail::series_sym_extender(b, y, ins_map_y);
+
+                return detail::poly_mul_impl_identical_ss(x, ::std::move(b), args...);
+            }
+            case 2u: {
+                // y already has the correct symbol
+                // set, extend only x.
+                T a;
+                a.set_symbol_set(merged_ss);
+                ::obake::detail::series_sym_extender(a, x, ins_map_x);
+
+                return detail::poly_mul_impl_identical_ss(::std::move(a), y, args...);
+            }
+        }
+
+        // Both x and y need to be extended.
+        T a;
+        U b;
+        a.set_symbol_set(merged_ss);
+        b.set_symbol_set(merged_ss);
+        ::obake::detail::series_sym_extender(a, x, ins_map_x);
+        ::obake::detail::series_sym_extender(b, y, ins_map_y);
+
+        return detail::poly_mul_impl_identical_ss(::std::move(a), ::std::move(b), args...);
+    }
+}
+
+// Helper to ensure that poly_mul_impl() is called with the
+// shorter poly first, switching around the arguments if necessary.
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_impl_switch(const T &x, const U &y, const Args &...args)
+{
+    if (x.size() <= y.size()) {
+        return detail::poly_mul_impl(x, y, args...);
+    } else {
+        return detail::poly_mul_impl(y, x, args...);
+    }
+}
 
-                      // Locate a range in vseg2 such that the bucket idx of that range + bi1
-                      // is equal to tgt_idx.
-                      const auto it = ::std::lower_bound(
-                          vseg2_begin, end_search, tgt_idx,
-                          [bi1_ = bi1](const auto &t, const auto &b_idx) { return ::std::get<2>(t) + bi1_ < b_idx; });
+// In-place poly multiplication: x is replaced by the product
+// of x and y. Requires that the type of the product is T.
+// If the symbol sets of x and y are identical, the terms of x
+// are released as soon as they are not needed any more, so that
+// the peak memory usage is reduced. y may alias x.
+// NOTE: in case of exceptions, x is left in a valid
+// but unspecified state.
+template <typename T, typename U, typename... Args>
+inline void poly_mul_impl_in_place(T &x, const U &y, const Args &...args)
+{
+    static_assert(::std::is_same_v<T, poly_mul_ret_t<T, U>>);
 
-                      if (it == end_search || ::std::get<2>(*it) + bi1 != tgt_idx) {
-                          // There is no range in vseg2 such that its multiplication
-                          // by the current range in vseg1 results in terms which
-                          // end up at the bucket index seg_idx in the destination
-                          // segmented table. Move to the next range in vseg1.
-                          continue;
-                      }
-                      // Update the end point of the binary search. We know that
-                      // the next vseg1 range will bump up bi1 at least by one, thus,
-                      // in the next binary search, we know that anything we may find
-                      // must be *before* it.
-                      end_search = it;
+    if (x.get_symbol_set_fw() == y.get_symbol_set_fw()) {
+        // NOTE: clear_terms() preserves the symbol set
+        // of x, which is the symbol set of the product.
+        const auto rel = [&x]() { x.clear_terms(); };
 
-                      // Unpack in local variables.
-                      const auto &r2 = *it;
-                      const auto [r2_start, r2_end, bi2] = r2;
-                      ::obake::detail::ignore(r2_end, bi2);
+        if (x.size() <= y.size()) {
+            auto ret = detail::poly_mul_impl_identical_ss_rel(rel, x, y, args...);
+            x = ::std::move(ret);
+        } else {
+            auto ret = detail::poly_mul_impl_identical_ss_rel(rel, y, x, args...);
+            x = ::std::move(ret);
+        }
+    } else {
+        // The operands need to be extended to a common
+        // symbol set, use the out-of-place implementation.
+        x = detail::poly_mul_impl_switch(x, y, args...);
+    }
+}
 
-                      // The O(N**2) multiplication loop over the ranges.
-                      for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
-                          const auto &[k1, c1] = *(vptr1 + idx1);
+// Helper to change the number of segments of the polynomial r
+// to 2**l. The terms of r are moved into the new segmentation.
+// NOTE: in case of exceptions, r is left in a valid
+// but unspecified state.
+template <typename Ret>
+inline void poly_fma3_impl_resegment(Ret &r, unsigned l)
+{
+    Ret tmp;
+    tmp.set_symbol_set_fw(r.get_symbol_set_fw());
+    tmp.set_n_segments(l);
+    tmp.reserve(r.size());
+
+    for (auto &t : r._get_s_table()) {
+        for (auto &term : t) {
+            // NOTE: the terms of r are unique and nonzero, only
+            // the table size needs to be checked.
+            ::obake::detail::series_add_term<true, ::obake::detail::sat_check_zero::off,
+                                             ::obake::detail::sat_check_compat_key::off,
+                                             ::obake::detail::sat_check_table_size::on,
+                                             ::obake::detail::sat_assume_unique::on>(tmp, term.first,
+                                                                                     ::std::move(term.second));
+        }
+    }
 
-                          // Compute the end index in the second range
-                          // for the current value of idx1.
-                          const auto idx_end2 = compute_end_idx2(idx1, r2);
+    r = ::std::move(tmp);
+}
+
+// Implementation of the fused multiply-accumulate r += x * y
+// for monomials with homomorphic hashing.
+// Thanks to homomorphic hashing, the products between the terms of x
+// in the bucket i and the terms of y in the bucket j end up in the bucket
+// (i + j) % nsegs of r. Thus, the term-by-term products are computed
+// in parallel segment by segment, following the segmentation of r.
+// The products for each segment are accumulated in a local table,
+// which is then merged into the corresponding table of r while
+// it is still hot in cache. In this way, neither the memory for
+// the full product nor an extra pass over it are needed.
+// NOTE: requires x and y not empty, x not longer than y,
+// identical symbol sets and r distinct from x and y.
+// NOTE: if an exception is thrown while the products are being
+// merged into r, r is left empty. Otherwise (e.g., in case of
+// overflow in the exponents), r is left unchanged (apart
+// possibly from its segmentation).
+template <typename Ret, typename T, typename U>
+inline void poly_fma3_impl_mt_hm(Ret &r, const T &x, const U &y)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+    using s_size_t = typename Ret::s_size_type;
+
+    // Preconditions.
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.size() <= y.size());
+    assert(r.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(r.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Cache the symbol set.
+    const auto &ss = r.get_symbol_set();
+
+    // NOTE: all the preparation steps which might throw
+    // are performed before r is modified, so that, e.g., an
+    // overflow in the exponents leaves r unchanged.
+
+    // Create vectors containing copies of the input terms.
+    auto v1 = detail::poly_mul_impl_copy_terms(x);
+    auto v2 = detail::poly_mul_impl_copy_terms(y);
+
+    // Do the monomial overflow checking, if supported.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
+                                               "attempting to multiply two polynomials");
+        }
+    }
+
+    // If the operands are large enough to warrant a multithreaded
+    // multiplication (see the criteria in poly_mul_impl_identical_ss_rel()),
+    // estimate the number of segments as in poly_mul_impl_mt_hm_rel(), accounting
+    // also for the terms already in r. r is re-segmented only if it has
+    // fewer segments than estimated, so that, in an accumulation loop,
+    // the re-segmentation takes place only a few times.
+    const auto tuning = ::obake::polynomials::get_mul_tuning();
+    if (::std::max(::obake::byte_size(x), ::obake::byte_size(y)) >= tuning.mt_min_bytes
+        && ::obake::detail::hc() > 1u) {
+        const auto [est_nterms, tot_n_mults, est_stats] = detail::poly_mul_estimate_product_size<T, U>(v1, v2, ss);
+        const auto avg_term_size = detail::poly_mul_impl_estimate_average_term_size<ret_cf_t>(v1, v2, ss);
+        const auto est_sp = static_cast<double>(est_nterms) / static_cast<double>(tot_n_mults);
+        const auto seg_size = (!::std::isfinite(est_sp) || est_sp >= tuning.sparse_threshold) ? tuning.sparse_seg_size
+                                                                                               : tuning.dense_seg_size;
+        const auto est_nsegs
+            = ((detail::poly_mul_seg_nterms(est_nterms, est_stats) + r.size()) * avg_term_size) / seg_size;
+        const auto log2_nsegs = ::std::min(::obake::safe_cast<unsigned>(est_nsegs.nbits()), Ret::get_max_s_size());
+
+        if (log2_nsegs > r.get_s_size()) {
+            detail::poly_fma3_impl_resegment(r, log2_nsegs);
+        }
+    }
+
+    const auto nsegs = s_size_t(1) << r.get_s_size();
+
+    // Sort the input terms according to the bucket
+    // they would occupy in r.
+    auto t_sorter = [nsegs](const auto &p1, const auto &p2) {
+        return (::obake::hash(p1.first) & (nsegs - 1u)) < (::obake::hash(p2.first) & (nsegs - 1u));
+    };
+    ::tbb::parallel_invoke([&v1, &t_sorter]() { ::std::sort(v1.begin(), v1.end(), t_sorter); },
+                           [&v2, &t_sorter]() { ::std::sort(v2.begin(), v2.end(), t_sorter); });
+
+    // Compute the offsets of the buckets in v1/v2.
+    auto compute_offsets = [nsegs](const auto &v) {
+        ::std::vector<decltype(v.size())> retval;
+        retval.resize(::obake::safe_cast<decltype(retval.size())>(nsegs) + 1u);
+
+        for (const auto &p : v) {
+            ++retval[static_cast<decltype(retval.size())>(::obake::hash(p.first) & (nsegs - 1u)) + 1u];
+        }
+        ::std::partial_sum(retval.begin(), retval.end(), retval.begin());
+
+        return retval;
+    };
+    const auto off1 = compute_offsets(v1), off2 = compute_offsets(v2);
+
+    // The indices of the non-empty buckets of v1.
+    ::std::vector<s_size_t> nz1;
+    for (s_size_t i = 0; i < nsegs; ++i) {
+        if (off1[i] != off1[i + 1u]) {
+            nz1.push_back(i);
+        }
+    }
+
+    try {
+        auto &r_table = r._get_s_table();
+
+        ::tbb::parallel_for(
+            ::tbb::blocked_range<s_size_t>(0, nsegs),
+            [&v1, &v2, &off1, &off2, &nz1, nsegs, &r, &r_table, &ss, mts = r._get_max_table_size()](const auto &range) {
+                // Temporary variable used in monomial multiplication.
+                ret_key_t tmp_key(ss);
+
+                // The table used to accumulate the products of the
+                // current segment, before merging them into r.
+                ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                                    ::obake::detail::series_key_comparer>
+                    acc_table;
+
+                for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                    for (const auto bi1 : nz1) {
+                        // The bucket of v2 whose products with the
+                        // bucket bi1 of v1 end up in seg_idx.
+                        const auto bi2 = static_cast<s_size_t>(seg_idx - bi1) & (nsegs - 1u);
+
+                        for (auto idx1 = off1[bi1]; idx1 != off1[bi1 + 1u]; ++idx1) {
+                            const auto &[k1, c1] = v1[idx1];
+
+                            for (auto idx2 = off2[bi2]; idx2 != off2[bi2 + 1u]; ++idx2) {
+                                const auto &[k2, c2] = v2[idx2];
+
+                                ::obake::monomial_mul(tmp_key, k1, k2, ss);
+
+                                // Check that the result ends up in the correct bucket.
+                                assert((::obake::hash(tmp_key) & (nsegs - 1u)) == seg_idx);
+
+                                detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+                            }
+                        }
+                    }
+
+                    // Merge the products into the current table of r.
+                    // NOTE: this also empties acc_table (preserving
+                    // its capacity) for use in the next segment.
+                    auto &table = r_table[seg_idx];
+                    acc_table.consume([&r, &table](ret_key_t &&k, ret_cf_t &&c) {
+                        // NOTE: the zero check is needed because the products
+                        // may cancel out among themselves or with the terms of r.
+                        ::obake::detail::series_add_term_table<
+                            true, ::obake::detail::sat_check_zero::on, ::obake::detail::sat_check_compat_key::off,
+                            ::obake::detail::sat_check_table_size::off, ::obake::detail::sat_assume_unique::off>(
+                            r, table, ::std::move(k), ::std::move(c));
+                    });
+
+                    // LCOV_EXCL_START
+                    // Check the table size against the max allowed size.
+                    if (obake_unlikely(table.size() > mts)) {
+                        obake_throw(::std::overflow_error, "The fused multiply-accumulate of two "
+                                                           "polynomials resulted in a table whose size ("
+                                                               + ::obake::detail::to_string(table.size())
+                                                               + ") is larger than the maximum allowed value ("
+                                                               + ::obake::detail::to_string(mts) + ")");
+                    }
+                    // LCOV_EXCL_STOP
+                }
+            });
+    } catch (...) {
+        // In case of exceptions, clear r before
+        // rethrowing to ensure a known sane state.
+        r.clear_terms();
+        throw;
+    }
+}
+
+// Implementation of the fused multiply-accumulate r += x * y
+// for monomials without homomorphic hashing. The term-by-term
+// products are accumulated in a local table, which is then
+// merged into r.
+// NOTE: requires x and y not empty, identical symbol sets
+// and r distinct from x and y.
+// NOTE: if an exception is thrown while the products are being
+// merged into r, r is left empty. Otherwise (e.g., in case of
+// overflow in the exponents), r is left unchanged.
+template <typename Ret, typename T, typename U>
+inline void poly_fma3_impl_simple(Ret &r, const T &x, const U &y)
+{
+    using ret_key_t = series_key_t<Ret>;
+    using ret_cf_t = series_cf_t<Ret>;
+
+    // Preconditions.
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(r.get_symbol_set_fw() == x.get_symbol_set_fw());
+    assert(r.get_symbol_set_fw() == y.get_symbol_set_fw());
+
+    // Cache the symbol set.
+    const auto &ss = r.get_symbol_set();
+
+    // Do the monomial overflow checking, if supported.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(x.begin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(x.end(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(y.begin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(y.end(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(::std::overflow_error, "An overflow in the monomial exponents was detected while "
+                                               "attempting to multiply two polynomials");
+        }
+    }
+
+    // NOTE: the products are accumulated in a local table,
+    // thus r is not modified until the merge below.
+    ret_key_t tmp_key(ss);
+    ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                        ::obake::detail::series_key_comparer>
+        acc_table;
+
+    for (const auto &[k1, c1] : x) {
+        for (const auto &[k2, c2] : y) {
+            ::obake::monomial_mul(tmp_key, k1, k2, ss);
+            detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
+        }
+    }
+
+    try {
+        // Merge the products into r.
+        acc_table.consume([&r](ret_key_t &&k, ret_cf_t &&c) {
+            ::obake::detail::series_add_term<true, ::obake::detail::sat_check_zero::on,
+                                             ::obake::detail::sat_check_compat_key::off,
+                                             ::obake::detail::sat_check_table_size::on,
+                                             ::obake::detail::sat_assume_unique::off>(r, ::std::move(k),
+                                                                                      ::std::move(c));
+        });
+    } catch (...) {
+        // In case of exceptions, clear r before
+        // rethrowing to ensure a known sane state.
+        r.clear_terms();
+        throw;
+    }
+}
+
+// Fused multiply-accumulate: r += x * y.
+// Requires that the type of x * y is Ret.
+// If the symbol sets of r, x and y are identical, the term-by-term
+// products are accumulated directly into r, without
+// constructing x * y. Otherwise, or if r aliases x or y,
+// x * y is computed and then added to r.
+// NOTE: in case of exceptions, r is left in a valid
+// but unspecified state. Errors detected before r is
+// modified (e.g., overflows in the exponents) leave r unchanged.
+template <typename Ret, typename T, typename U>
+inline void poly_fma3_impl(Ret &r, const T &x, const U &y)
+{
+    static_assert(::std::is_same_v<Ret, poly_mul_ret_t<T, U>>);
+
+    if (r.get_symbol_set_fw() == x.get_symbol_set_fw() && r.get_symbol_set_fw() == y.get_symbol_set_fw()
+        && static_cast<const void *>(&r) != static_cast<const void *>(&x)
+        && static_cast<const void *>(&r) != static_cast<const void *>(&y)) {
+        if (x.empty() || y.empty()) {
+            return;
+        }
+
+        if constexpr (::std::conjunction_v<is_homomorphically_hashable_monomial<series_key_t<Ret>>,
+                                           is_size_measurable<const T &>, is_size_measurable<const U &>>) {
+            if (x.size() <= y.size()) {
+                detail::poly_fma3_impl_mt_hm(r, x, y);
+            } else {
+                detail::poly_fma3_impl_mt_hm(r, y, x);
+            }
+        } else {
+            detail::poly_fma3_impl_simple(r, x, y);
+        }
+    } else {
+        r += detail::poly_mul_impl_switch(x, y);
+    }
+}
+
+} // namespace detail
+
+template <typename K, typename C0, typename C1>
+requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0) inline detail::poly_mul_ret_t<
+    polynomial<K, C0>, polynomial<K, C1>> series_mul(const polynomial<K, C0> &x, const polynomial<K, C1> &y)
+{
+    return detail::poly_mul_impl_switch(x, y);
+}
+
+template <typename K, typename C0, typename C1>
+requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0) && ::std::is_same_v<
+    detail::poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>>,
+    polynomial<K, C0>> inline polynomial<K, C0> &series_in_place_mul(polynomial<K, C0> &x, const polynomial<K, C1> &y)
+{
+    detail::poly_mul_impl_in_place(x, y);
+
+    return x;
+}
+
+// Fused multiply-accumulate (see detail::poly_fma3_impl()).
+template <typename K, typename C0, typename C1, typename C2>
+requires(detail::poly_mul_algo<polynomial<K, C1>, polynomial<K, C2>> != 0) && ::std::is_same_v<
+    detail::poly_mul_ret_t<polynomial<K, C1>, polynomial<K, C2>>,
+    polynomial<K, C0>> inline void fma3(polynomial<K, C0> &r, const polynomial<K, C1> &x, const polynomial<K, C2> &y)
+{
+    detail::poly_fma3_impl(r, x, y);
+}
+
+namespace detail
+{
+
+// Metaprogramming to establish if we can perform
+// truncated total/partial degree multiplication on the
+// polynomial operands T and U with degree limit of type V.
+// NOTE: at this time, truncated multiplication is implemented
+// only if only the key is with degree.
+template <typename T, typename U, typename V, bool Total>
+constexpr auto poly_mul_truncated_degree_algorithm_impl()
+{
+    // Preconditions: T and U are not cvr-qualified, both are series types,
+    // they have the same key and tag types and V is not cvr-qualified.
+    static_assert(::std::is_same_v<remove_cvref_t<T>, T>);
+    static_assert(::std::is_same_v<remove_cvref_t<U>, U>);
+    static_assert(any_series<T>);
+    static_assert(any_series<U>);
+    static_assert(::std::is_same_v<series_key_t<T>, series_key_t<U>>);
+    static_assert(::std::is_same_v<series_tag_t<T>, series_tag_t<U>>);
+    static_assert(::std::is_same_v<remove_cvref_t<V>, V>);
+
+    // Check first if we can do the untruncated multiplication. If we cannot,
+    // truncated mult is not possible.
+    if constexpr (poly_mul_algo<T, U> == 0) {
+        return 0;
+    } else {
+        // Check if we can compute the degree of the terms via the default
+        // implementation for series.
+        using d_impl = ::std::conditional_t<Total, customisation::internal::series_default_degree_impl,
+                                            customisation::internal::series_default_p_degree_impl>;
+        constexpr auto algo1 = d_impl::template algo<T>;
+        constexpr auto algo2 = d_impl::template algo<U>;
+
+        // NOTE: algo == 3 means that only the key is with degree.
+        if constexpr (algo1 == 3 && algo2 == 3) {
+            // Fetch the degree types.
+            using deg1_t = typename d_impl::template ret_t<T>;
+            using deg2_t = typename d_impl::template ret_t<U>;
+
+            // The degree types need to be:
+            // - copy/move ctible (need to handle vectors of them, note that
+            //   in the series default degree machinery we check for returnability,
+            //   but here we need explicitly both copy and move ctible),
+            // - addable via const lref,
+            // - V must be lt-comparable to the type of their sum via const lrefs.
+            using deg_add_t = detected_t<::obake::detail::add_t, const deg1_t &, const deg2_t &>;
+
+            return static_cast<int>(::std::conjunction_v<
+                                    // NOTE: this will ensure that switching around
+                                    // the degree operands still works and produces the same
+                                    // type. This is necessary because in the poly moltiplication
+                                    // function we might end up swapping the operands.
+                                    // NOTE: this will also verify that deg_add_t is present.
+                                    is_addable<const deg1_t &, const deg2_t &>, ::std::is_copy_constructible<deg1_t>,
+                                    ::std::is_copy_constructible<deg2_t>, ::std::is_move_constructible<deg1_t>,
+                                    ::std::is_move_constructible<deg2_t>,
+                                    // NOTE: in the implementation functions, we always compare
+                                    // an lvalue ref to the limit V to an rvalue resulting
+                                    // from adding the degrees of one term from each series.
+                                    is_less_than_comparable<const V &, deg_add_t>>);
+        } else {
+            return 0;
+        }
+    }
+}
+
+template <typename T, typename U, typename V>
+inline constexpr auto poly_mul_truncated_degree_algo
+    = detail::poly_mul_truncated_degree_algorithm_impl<T, U, V, true>();
+
+template <typename T, typename U, typename V>
+inline constexpr auto poly_mul_truncated_p_degree_algo
+    = detail::poly_mul_truncated_degree_algorithm_impl<T, U, V, false>();
+
+} // namespace detail
 
-                          // In the truncated case, check if the end index
-                          // coincides with the begin index. In such a case,
-                          // we can skip all the remaining indices in r1 because
-                          // none of them will ever generate a term which respects
-                          // the truncation limits (both r1 and r2 are sorted
-                          // according to the degree).
-                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
-                              break;
-                          }
+// Truncated multiplication.
+// NOTE: do we need the type traits/concepts as well?
+// NOTE: should these be function objects?
+template <typename K, typename C0, typename C1, typename V>
+requires(detail::poly_mul_truncated_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline detail::
+    poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>> truncated_mul(const polynomial<K, C0> &x,
+                                                                       const polynomial<K, C1> &y, const V &max_degree)
+{
+    return detail::poly_mul_impl_switch(x, y, max_degree);
+}
 
-                          const auto end2 = vptr2 + idx_end2;
-                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
-                              const auto &[k2, c2] = *ptr2;
+template <typename K, typename C0, typename C1, typename V>
+requires(detail::poly_mul_truncated_p_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline detail::
+    poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>> truncated_mul(const polynomial<K, C0> &x,
+                                                                       const polynomial<K, C1> &y, const V &max_degree,
+                                                                       const symbol_set &s)
+{
+    return detail::poly_mul_impl_switch(x, y, max_degree, s);
+}
 
-                              // Do the monomial multiplication.
-                              ::obake::monomial_mul(tmp_key, k1, k2, ss);
+namespace detail
+{
 
-                              // Check that the result ends up in the correct bucket.
-                              assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
+// Helper to sort the vector v of pointers to the terms of
+// a polynomial of type S according to the total/partial degree
+// of the terms (depending on the truncation arguments args).
+// The sorted vector of degrees is returned.
+template <typename S, typename V, typename... Args>
+inline auto poly_mul_many_sort_by_degree(V &v, const symbol_set &ss, const Args &...args)
+{
+    static_assert(sizeof...(args) == 1u || sizeof...(args) == 2u);
 
-                              // Attempt the insertion.
-                              // NOTE: this will attempt to insert a term with a default-constructed
-                              // coefficient. This is wasteful, it would be better to directly
-                              // construct the coefficient product only if the insertion actually
-                              // takes place (using a lazy multiplication approach).
-                              // Unfortunately, abseil's hash map is not exception safe,
-                              // and if the lazy multiplication throws, the table will be left
-                              // in an inconsistent state. See:
-                              // https://github.com/abseil/abseil-cpp/issues/388
-                              // See the commit
-                              // 3e334f560d5844f5f2d8face05aa58be21649ff8
-                              // for an implementation of the lazy multiplication approach.
-                              // If they fix the exception safety issue, we can re-enable the
-                              // lazy approach.
-                              // NOTE: the coefficient concept demands default constructibility,
-                              // thus we can always emplace without arguments for the coefficient.
-                              const auto res = table.try_emplace(tmp_key);
-
-                              // NOTE: optimise with likely/unlikely here?
-                              if (res.second) {
-                                  // NOTE: coefficients are guaranteed to be move-assignable.
-                                  res.first->second = c1 * c2;
-                              } else {
-                                  // The insertion failed, a term with the same monomial
-                                  // exists already. Accumulate c1*c2 into the
-                                  // existing coefficient.
-                                  // NOTE: do it with fma3(), if possible.
-                                  if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
-                                      ::obake::fma3(res.first->second, c1, c2);
-                                  } else {
-                                      res.first->second += c1 * c2;
-                                  }
-                              }
+    // NOTE: in the make_degree_vector() helpers we need
+    // to compute the size of v via iterator differences.
+    ::obake::detail::container_it_diff_check(v);
 
-#if !defined(NDEBUG)
-                              ++n_mults;
-#endif
-                          }
-                      }
-                  }
+    // Compute the vector of degrees.
+    auto vd = [&v, &ss, &args...]() {
+        if constexpr (sizeof...(args) == 1u) {
+            // Total degree.
+            ::obake::detail::ignore(args...);
 
-                  // Locate and erase terms with zero coefficients
-                  // in the current table.
-                  const auto it_f = table.end();
-                  for (auto it = table.begin(); it != it_f;) {
-                      // NOTE: abseil's flat_hash_map returns void on erase(),
-                      // thus we need to increase 'it' before possibly erasing.
-                      // erase() does not cause rehash and thus will not invalidate
-                      // any other iterator apart from the one being erased.
-                      if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
-                          table.erase(it++);
-                      } else {
-                          ++it;
-                      }
-                  }
+            return customisation::internal::make_degree_vector<S>(v.cbegin(), v.cend(), ss, false);
+        } else {
+            // Partial degree.
+            return customisation::internal::make_p_degree_vector<S>(
+                v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), false);
+        }
+    }();
+    ::obake::detail::container_it_diff_check(::std::as_const(vd));
+
+    // Sort indirectly.
+    ::std::vector<decltype(vd.size())> vidx;
+    vidx.resize(::obake::safe_cast<decltype(vidx.size())>(vd.size()));
+    ::std::iota(vidx.begin(), vidx.end(), decltype(vd.size())(0));
+    ::std::sort(vidx.begin(), vidx.end(), [&vdc = ::std::as_const(vd)](const auto &idx1, const auto &idx2) {
+        return vdc[idx1] < vdc[idx2];
+    });
 
-                  // LCOV_EXCL_START
-                  // Check the table size against the max allowed size.
-                  if (obake_unlikely(table.size() > mts)) {
-                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
-                                                         "polynomials resulted in a table whose size ("
-                                                             + ::obake::detail::to_string(table.size())
-                                                             + ") is larger than the maximum allowed value ("
-                                                             + ::obake::detail::to_string(mts) + ")");
-                  }
-                  // LCOV_EXCL_STOP
-              }
-          };
+    // Apply the sorting to vd and v.
+    vd = decltype(vd)(::boost::make_permutation_iterator(vd.cbegin(), vidx.cbegin()),
+                      ::boost::make_permutation_iterator(vd.cend(), vidx.cend()));
+    v = V(::boost::make_permutation_iterator(v.cbegin(), vidx.cbegin()),
+          ::boost::make_permutation_iterator(v.cend(), vidx.cend()));
 
-    // The parallel multiplication functor for the dense case.
-    auto dense_par_functor
-        = [&v1, &v2, &vseg1, &vseg2, nsegs, &retval, &ss, mts = retval._get_max_table_size(), &compute_end_idx2
-#if !defined(NDEBUG)
-           ,
-           log2_nsegs, &n_mults
-#endif
-    ](const auto &range) {
-              // Cache the pointers to the terms data.
-              // NOTE: doing it here rather than in the lambda
-              // capture seems to help performance on GCC.
-              auto vptr1 = v1.data();
-              auto vptr2 = v2.data();
+    return vd;
+}
 
-              // Temporary variable used in monomial multiplication.
-              ret_key_t tmp_key(ss);
+// Serial multiplication of the shared operand x of a batched
+// multiplication by y. x is represented by the vector v1 of pointers
+// to its terms and, in truncated mode, by the vector vd1 of their
+// degrees (v1 being sorted by degree). If ovf_checked is true,
+// the monomial overflow checking is assumed to have been
+// performed already.
+// NOTE: requires x and y not empty and identical symbol sets.
+template <typename T, typename U, typename V1, typename VD1, typename... Args>
+inline auto poly_mul_many_impl_simple(const T &x, const V1 &v1, const VD1 &vd1, bool ovf_checked, const U &y,
+                                      const Args &...args)
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+    using ret_key_t = series_key_t<ret_t>;
+    using ret_cf_t = series_cf_t<ret_t>;
 
-              for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
-                  // Get a reference to the current table in retval.
-                  auto &table = retval._get_s_table()[seg_idx];
+    // Preconditions.
+    assert(!x.empty());
+    assert(!y.empty());
+    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
+    assert(v1.size() == x.size());
 
-                  // The objective here is to perform all term-by-term multiplications
-                  // whose results end up in the current table (i.e., the table in retval
-                  // at index seg_idx). Due to homomorphic hashing, we know that,
-                  // given two indices i and j in vseg1 and vseg2,
-                  // the terms generated by the multiplication of the
-                  // ranges vseg1[i] and vseg2[j] end up at the bucket
-                  // (i + j) % nsegs in retval. Thus, we need to select
-                  // all i, j pairs such that (i + j) % nsegs == seg_idx.
-                  for (s_size_t i = 0; i < nsegs; ++i) {
-                      const auto j = seg_idx >= i ? (seg_idx - i) : (nsegs - i + seg_idx);
-                      assert(j < vseg2.size());
+    // Cache the symbol set.
+    const auto &ss = x.get_symbol_set();
 
-                      // Fetch the corresponding ranges.
-                      const auto [r1_start, r1_end, bi1] = vseg1[i];
-                      const auto &r2 = vseg2[j];
-                      const auto [r2_start, r2_end, bi2] = r2;
-                      ::obake::detail::ignore(r2_end);
+    // Construct the vector of pointers to the terms of y.
+    ::std::vector<const series_term_t<U> *> v2(
+        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(y.end(), poly_mul_impl_ptr_extractor{}));
 
-                      // NOTE: in the dense case, the bucket
-                      // indices must be equal to i/j.
-                      assert(bi1 == i);
-                      assert(bi2 == j);
-                      ::obake::detail::ignore(bi1);
-                      ::obake::detail::ignore(bi2);
+    // Do the monomial overflow checking, if possible.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        if (!ovf_checked && obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
+            obake_throw(
+                ::std::overflow_error,
+                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        }
+    } else {
+        ::obake::detail::ignore(ovf_checked);
+    }
 
-                      // The O(N**2) multiplication loop over the ranges.
-                      for (auto idx1 = r1_start; idx1 != r1_end; ++idx1) {
-                          const auto &[k1, c1] = *(vptr1 + idx1);
+    // In truncated mode, sort the terms of y by degree.
+    [[maybe_unused]] const auto vd2 = [&v2, &ss, &args...]() {
+        if constexpr (sizeof...(args) == 0u) {
+            ::obake::detail::ignore(v2, ss);
 
-                          // Compute the end index in the second range
-                          // for the current value of idx1.
-                          const auto idx_end2 = compute_end_idx2(idx1, r2);
+            return 0;
+        } else {
+            return detail::poly_mul_many_sort_by_degree<U>(v2, ss, args...);
+        }
+    }();
 
-                          // In the truncated case, check if the end index
-                          // coincides with the begin index. In such a case,
-                          // we can skip all the remaining indices in r1 because
-                          // none of them will ever generate a term which respects
-                          // the truncation limits (both r1 and r2 are sorted
-                          // according to the degree).
-                          if (sizeof...(Args) > 0u && idx_end2 == r2_start) {
-                              break;
-                          }
+    // Helper to compute the end index in v1 for
+    // the term of index j in v2. In the non-truncated
+    // case, every term of y is multiplied by every term of x.
+    auto compute_i_end = [&v1, &vd1, &vd2, &args...](const auto &j) {
+        using idx_t = decltype(v1.size());
 
-                          const auto end2 = vptr2 + idx_end2;
-                          for (auto ptr2 = vptr2 + r2_start; ptr2 != end2; ++ptr2) {
-                              const auto &[k2, c2] = *ptr2;
+        if constexpr (sizeof...(args) == 0u) {
+            ::obake::detail::ignore(vd1, vd2, j);
 
-                              // Do the monomial multiplication.
-                              ::obake::monomial_mul(tmp_key, k1, k2, ss);
+            return v1.size();
+        } else {
+            const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
+            const auto &d_j = vd2[j];
 
-                              // Check that the result ends up in the correct bucket.
-                              assert(::obake::hash(tmp_key) % (s_size_t(1) << log2_nsegs) == seg_idx);
+            // Find the first term in x such that d_i + d_j > max_deg.
+            const auto it = ::std::upper_bound(vd1.cbegin(), vd1.cend(), max_deg,
+                                               [&d_j](const auto &mdeg, const auto &d_i) { return mdeg < d_i + d_j; });
 
-                              // Attempt the insertion.
-                              // NOTE: this will attempt to insert a term with a default-constructed
-                              // coefficient. This is wasteful, it would be better to directly
-                              // construct the coefficient product only if the insertion actually
-                              // takes place (using a lazy multiplication approach).
-                              // Unfortunately, abseil's hash map is not exception safe,
-                              // and if the lazy multiplication throws, the table will be left
-                              // in an inconsistent state. See:
-                              // https://github.com/abseil/abseil-cpp/issues/388
-                              // See the commit
-                              // 3e334f560d5844f5f2d8face05aa58be21649ff8
-                              // for an implementation of the lazy multiplication approach.
-                              // If they fix the exception safety issue, we can re-enable the
-                              // lazy approach.
-                              // NOTE: the coefficient concept demands default constructibility,
-                              // thus we can always emplace without arguments for the coefficient.
-                              const auto res = table.try_emplace(tmp_key);
-
-                              // NOTE: optimise with likely/unlikely here?
-                              if (res.second) {
-                                  // NOTE: coefficients are guaranteed to be move-assignable.
-                                  res.first->second = c1 * c2;
-                              } else {
-                                  // The insertion failed, a term with the same monomial
-                                  // exists already. Accumulate c1*c2 into the
-                                  // existing coefficient.
-                                  // NOTE: do it with fma3(), if possible.
-                                  if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
-                                      ::obake::fma3(res.first->second, c1, c2);
-                                  } else {
-                                      res.first->second += c1 * c2;
-                                  }
-                              }
+            return static_cast<idx_t>(it - vd1.cbegin());
+        }
+    };
 
-#if !defined(NDEBUG)
-                              ++n_mults;
-#endif
-                          }
-                      }
-                  }
+    ret_t retval;
+    retval.set_symbol_set_fw(x.get_symbol_set_fw());
+    auto &tab = retval._get_s_table()[0];
 
-                  // Locate and erase terms with zero coefficients
-                  // in the current table.
-                  const auto it_f = table.end();
-                  for (auto it = table.begin(); it != it_f;) {
-                      // NOTE: abseil's flat_hash_map returns void on erase(),
-                      // thus we need to increase 'it' before possibly erasing.
-                      // erase() does not cause rehash and thus will not invalidate
-                      // any other iterator apart from the one being erased.
-                      if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
-                          table.erase(it++);
-                      } else {
-                          ++it;
-                      }
-                  }
+    ret_key_t tmp_key(ss);
+    ::obake::detail::accumulation_table<ret_key_t, ret_cf_t, ::obake::detail::series_key_hasher,
+                                        ::obake::detail::series_key_comparer>
+        acc_table;
+
+    for (decltype(v2.size()) j = 0; j < v2.size(); ++j) {
+        const auto &[k2, c2] = *v2[j];
+
+        const auto i_end = compute_i_end(j);
+        if (sizeof...(Args) > 0u && i_end == 0u) {
+            // NOTE: the terms of y are sorted by degree, thus
+            // none of the remaining terms will generate terms
+            // which respect the truncation limits.
+            break;
+        }
 
-                  // LCOV_EXCL_START
-                  // Check the table size against the max allowed size.
-                  if (obake_unlikely(table.size() > mts)) {
-                      obake_throw(::std::overflow_error, "The homomorphic multithreaded multiplication of two "
-                                                         "polynomials resulted in a table whose size ("
-                                                             + ::obake::detail::to_string(table.size())
-                                                             + ") is larger than the maximum allowed value ("
-                                                             + ::obake::detail::to_string(mts) + ")");
-                  }
-                  // LCOV_EXCL_STOP
-              }
-          };
+        for (decltype(v1.size()) i = 0; i < i_end; ++i) {
+            const auto &[k1, c1] = *v1[i];
 
-    try {
-        if (vseg1.size() == nsegs && vseg2.size() == nsegs) {
-            // Both vseg1 and vseg2 are represented in dense
-            // form, run the dense functor.
-            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), dense_par_functor);
-        } else {
-            // At least one of vseg1/vseg2 are represented
-            // in sparse form, run the sparse functor.
-            ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), sparse_par_functor);
+            ::obake::monomial_mul(tmp_key, k1, k2, ss);
+            detail::poly_mul_impl_accumulate<ret_cf_t>(acc_table, tmp_key, c1, c2);
         }
+    }
 
-#if !defined(NDEBUG)
-        // Verify the number of term multiplications we performed,
-        // but only if we are in non-truncated mode.
-        if constexpr (sizeof...(args) == 0u) {
-            assert(n_mults.load()
-                   == static_cast<unsigned long long>(x.size()) * static_cast<unsigned long long>(y.size()));
+    // Move the terms with nonzero coefficients
+    // into the return value.
+    tab.reserve(static_cast<decltype(tab.size())>(acc_table.size()));
+    acc_table.consume([&tab](ret_key_t &&k, ret_cf_t &&c) {
+        if (obake_likely(!::obake::is_zero(::std::as_const(c)))) {
+            [[maybe_unused]] const auto res = tab.try_emplace(::std::move(k), ::std::move(c));
+            assert(res.second);
         }
-#endif
-        // LCOV_EXCL_START
-    } catch (...) {
-        // In case of exceptions, clear retval before
-        // rethrowing to ensure a known sane state.
-        retval.clear();
-        throw;
-        // LCOV_EXCL_STOP
+    });
+
+    return retval;
+}
+
+// The kinds of products in a batched multiplication
+// (see poly_mul_many_impl()).
+enum class poly_mul_many_kind {
+    // One of the operands is empty.
+    empty,
+    // Serial implementation, with shared x.
+    serial,
+    // Multi-threaded homomorphic implementation, with shared x.
+    mt_hm,
+    // Lock-based multi-threaded implementation.
+    mt_lock,
+    // Multiplication via the primitive parts, with shared
+    // content and primitive part of x.
+    primitive,
+    // Multi-modular multiplication, with shared residues of x.
+    crt,
+    // Top-level multiplication (i.e., different symbol sets
+    // or squaring).
+    other
+};
+
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_many_impl(const T &, const ::std::vector<const U *> &, const Args &...);
+
+// Implementation of the products of a batched multiplication
+// (see poly_mul_many_impl()) which are computed via the primitive parts.
+// x is the shared operand and cont_x its content, idx the indices
+// in ys of the products to be computed, cont_ys the contents of
+// the ys (as computed during the algorithm selection).
+// The products are written into retval. The content and the primitive
+// part of x are computed only once, and the products of the
+// primitive parts are computed via a batched multiplication,
+// so that the preprocessing of the primitive part of x is shared as well.
+template <typename T, typename CT, typename U, typename CU, typename Ret, typename... Args>
+inline void poly_mul_many_impl_primitive(const T &x, const CT &cont_x, const ::std::vector<const U *> &ys,
+                                         const ::std::vector<::std::optional<CU>> &cont_ys,
+                                         const ::std::vector<decltype(ys.size())> &idx, ::std::vector<Ret> &retval,
+                                         const Args &...args)
+{
+    using pp_t = remove_cvref_t<decltype(detail::poly_mul_impl_rat_primitive_part(x, cont_x))>;
+
+    const auto pp_x = detail::poly_mul_impl_rat_primitive_part(x, cont_x);
+
+    ::std::vector<pp_t> pp_ys;
+    pp_ys.resize(::obake::safe_cast<decltype(pp_ys.size())>(idx.size()));
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(idx.size())>(0, idx.size()),
+                        [&ys, &cont_ys, &idx, &pp_ys](const auto &range) {
+                            for (auto k = range.begin(); k != range.end(); ++k) {
+                                pp_ys[k] = detail::poly_mul_impl_rat_primitive_part(*ys[idx[k]], *cont_ys[idx[k]]);
+                            }
+                        });
+
+    ::std::vector<const pp_t *> pp_ptrs;
+    pp_ptrs.reserve(pp_ys.size());
+    for (const auto &pp_y : pp_ys) {
+        pp_ptrs.push_back(&pp_y);
     }
+
+    const auto pp_prods = detail::poly_mul_many_impl(pp_x, pp_ptrs, args...);
+
+    // Multiply the contents of the products back in.
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(idx.size())>(0, idx.size()),
+                        [&cont_x, &cont_ys, &idx, &pp_prods, &retval](const auto &range) {
+                            for (auto k = range.begin(); k != range.end(); ++k) {
+                                const auto &cont_y = *cont_ys[idx[k]];
+
+                                retval[idx[k]] = detail::poly_mul_impl_rat_rescale<Ret>(
+                                    pp_prods[k], cont_x.g * cont_y.g, cont_x.l * cont_y.l);
+                            }
+                        });
 }
 
-#if defined(_MSC_VER) && !defined(__clang__)
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+// Implementation of the products of a batched multiplication
+// (see poly_mul_many_impl()) which are computed via the multi-modular
+// multiplication. x is the shared operand and nbits_x the max number of
+// bits of its coefficients, idx the indices in ys of the products to be
+// computed, nbits_ys the max number of bits of the coefficients of the ys
+// (as computed during the algorithm selection). The products are
+// written into retval. The same primes are used for all the products
+// (each product using as many primes as it needs), so that x is reduced
+// only once per prime, and the products modulo each prime are computed
+// via a batched multiplication, so that the preprocessing of the residues
+// of x is shared as well.
+template <typename T, typename U, typename Ret, typename... Args>
+inline void poly_mul_many_impl_crt(const T &x, ::std::size_t nbits_x, const ::std::vector<const U *> &ys,
+                                   const ::std::vector<::std::optional<::std::size_t>> &nbits_ys,
+                                   const ::std::vector<decltype(ys.size())> &idx, ::std::vector<Ret> &retval,
+                                   const Args &...args)
+{
+    using mod_t = remove_cvref_t<decltype(detail::poly_mul_crt_reduce(x, ::std::uint64_t(0)))>;
 
-#pragma warning(pop)
+    assert(!idx.empty());
 
-#endif
+    // Each coefficient of a product is the sum of at most
+    // min(x.size(), y.size()) term-by-term products. Take the max over
+    // the batch, so that the same primes can be used for all the products.
+    ::std::uint64_t n = 0;
+    for (const auto i : idx) {
+        n = ::std::max(n, ::std::min(static_cast<::std::uint64_t>(x.size()),
+                                     static_cast<::std::uint64_t>(ys[i]->size())));
+    }
+    const auto nbits_p = detail::poly_mul_crt_nbits_p(n);
 
-// Extract a pointer from a const reference.
-struct poly_mul_impl_ptr_extractor {
-    template <typename T>
-    auto operator()(const T &x) const
-    {
-        return &x;
+    // The number of primes needed by each product.
+    ::std::vector<::std::size_t> n_primes;
+    n_primes.reserve(idx.size());
+    for (const auto i : idx) {
+        n_primes.push_back(detail::poly_mul_crt_n_primes(n, nbits_p, nbits_x, *nbits_ys[i]));
     }
-};
 
-// Simple poly mult implementation: just multiply
-// term by term, no parallelisation, no segmentation,
-// no copying of the operands, etc.
-template <typename Ret, typename T, typename U, typename... Args>
-inline void poly_mul_impl_simple(Ret &retval, const T &x, const U &y, const Args &...args)
-{
-    using ret_key_t = series_key_t<Ret>;
-    using ret_cf_t = series_cf_t<Ret>;
-    using cf1_t = series_cf_t<T>;
-    using cf2_t = series_cf_t<U>;
+    // NOTE: the primes are generated deterministically in decreasing
+    // order, thus the primes needed by each product are a prefix of
+    // the primes needed by the whole batch.
+    const auto primes
+        = detail::poly_mul_crt_make_primes(nbits_p, *::std::max_element(n_primes.begin(), n_primes.end()));
 
-    // Preconditions.
-    static_assert(sizeof...(args) <= 2u);
-    assert(!x.empty());
-    assert(!y.empty());
-    assert(x.size() <= y.size());
-    assert(retval.get_symbol_set_fw() == x.get_symbol_set_fw());
-    assert(retval.get_symbol_set_fw() == y.get_symbol_set_fw());
-    assert(retval.empty());
-    assert(retval._get_s_table().size() == 1u);
+    ::std::vector<poly_mul_crt_rec<Ret>> recs;
+    recs.resize(::obake::safe_cast<decltype(recs.size())>(idx.size()));
 
-    // Cache the symbol set.
-    const auto &ss = retval.get_symbol_set();
+    // Helper vectors, re-used for all the primes.
+    ::std::vector<decltype(idx.size())> cur;
+    ::std::vector<mod_t> y_ps;
+    ::std::vector<const mod_t *> ptrs;
 
-    // Construct the vectors of pointer to the terms.
-    ::std::vector<const series_term_t<T> *> v1(
-        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_ptr_extractor{}),
-        ::boost::make_transform_iterator(x.end(), poly_mul_impl_ptr_extractor{}));
-    ::std::vector<const series_term_t<U> *> v2(
-        ::boost::make_transform_iterator(y.begin(), poly_mul_impl_ptr_extractor{}),
-        ::boost::make_transform_iterator(y.end(), poly_mul_impl_ptr_extractor{}));
+    for (decltype(primes.size()) j = 0; j < primes.size(); ++j) {
+        const auto p = primes[j];
 
-    // Do the monomial overflow checking, if possible.
-    const auto r1
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
-    const auto r2
-        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
-                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
-    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
-        // Do the monomial overflow checking.
-        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, ss))) {
-            obake_throw(
-                ::std::overflow_error,
-                "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        // The products which need the current prime.
+        cur.clear();
+        for (decltype(idx.size()) k = 0; k < idx.size(); ++k) {
+            if (n_primes[k] > j) {
+                cur.push_back(k);
+            }
+        }
+
+        // Reduce x once, and the ys in parallel.
+        const auto x_p = detail::poly_mul_crt_reduce(x, p);
+
+        y_ps.clear();
+        y_ps.resize(::obake::safe_cast<decltype(y_ps.size())>(cur.size()));
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(cur.size())>(0, cur.size()),
+                            [&ys, &idx, &cur, &y_ps, p](const auto &range) {
+                                for (auto c = range.begin(); c != range.end(); ++c) {
+                                    y_ps[c] = detail::poly_mul_crt_reduce(*ys[idx[cur[c]]], p);
+                                }
+                            });
+
+        ptrs.clear();
+        for (const auto &y_p : y_ps) {
+            ptrs.push_back(&y_p);
         }
+
+        const auto prods = detail::poly_mul_many_impl(x_p, ptrs, args...);
+
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(cur.size())>(0, cur.size()),
+                            [&recs, &cur, &prods, p](const auto &range) {
+                                for (auto c = range.begin(); c != range.end(); ++c) {
+                                    recs[cur[c]].add(prods[c], p);
+                                }
+                            });
     }
 
-    // This functor will be used to compute the
-    // upper limit of the j index (in the usual half-open
-    // range fashion) for a given i index
-    // in the nested for-loop below that performs
-    // the term-by-term multiplications.
-    // In the non-truncated case, compute_j_end will
-    // always return the size of y (that is, every
-    // term of x will be multiplied by every term of
-    // of y). In the truncated cases, the returned
-    // j value will ensure that the truncation limits
-    // are respected.
-    auto compute_j_end = [&v1, &v2, &ss, &args...]() {
-        if constexpr (sizeof...(args) == 0u) {
-            ::obake::detail::ignore(v1, ss);
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(idx.size())>(0, idx.size()),
+                        [&idx, &recs, &retval](const auto &range) {
+                            for (auto k = range.begin(); k != range.end(); ++k) {
+                                retval[idx[k]] = ::std::move(recs[k]).get();
+                            }
+                        });
+}
 
-            return [v2_size = v2.size()](const auto &) { return v2_size; };
-        } else {
-            // Helper that will:
-            //
-            // - create and return a sorted vector vd
-            //   containing the total/partial degrees of all the
-            //   terms in v,
-            // - sort v according to the order defined in vd.
-            //
-            // v will be one of v1/v2, t is a type_c instance
-            // containing either T or U.
-            auto sorter = [&ss, &args...](auto &v, auto t) {
-                // NOTE: we will be using the machinery from the default implementation
-                // of degree() for series, so that we can re-use the concept checking bits
-                // as well.
-                using s_t = typename decltype(t)::type;
+#endif
 
-                // Compute the vector of degrees.
-                auto vd = [&v, &ss, &args...]() {
-                    if constexpr (sizeof...(args) == 1u) {
-                        // Total degree.
-                        ::obake::detail::ignore(args...);
+// Implementation of the batched multiplication of x by the polynomials
+// pointed to by the elements of ys. Each product is dispatched to the
+// algorithm selected by poly_mul_impl_select() (i.e., the same one
+// that would be used for the single product), but the preprocessing
+// of x is performed only once and shared among the products:
+// - the monomial overflow checking is performed only once for the
+//   whole batch,
+// - for the serial implementation, the vector of pointers to the
+//   terms of x (sorted by degree in truncated mode) is built only once,
+// - for the multi-threaded homomorphic implementation, the copy of the
+//   terms of x and its segmentation are computed only once
+//   (see poly_mul_impl_mt_hm_shared),
+// - for the multiplication via the primitive parts, the content and
+//   the primitive part of x are computed only once, and the products
+//   of the primitive parts are computed via a batched multiplication
+//   (see poly_mul_many_impl_primitive()),
+// - for the multi-modular multiplication, the residues of x are
+//   computed only once per prime, and the products modulo each prime
+//   are computed via a batched multiplication (see poly_mul_many_impl_crt()).
+// The products are distributed over the TBB thread pool. The products
+// by small polynomials are computed via the serial implementation
+// if the batch contains enough products to keep all the cores busy.
+template <typename T, typename U, typename... Args>
+inline auto poly_mul_many_impl(const T &x, const ::std::vector<const U *> &ys, const Args &...args)
+{
+    using ret_t = poly_mul_ret_t<T, U>;
+    using kind = poly_mul_many_kind;
+    using algo = poly_mul_impl_algo;
 
-                        // NOTE: in the make_degree_vector() helper we need
-                        // to compute the size of v via iterator differences.
-                        ::obake::detail::container_it_diff_check(v);
+    // Can we use the multi-threaded homomorphic implementation?
+    constexpr auto mt_hm_algo = poly_mul_mt_hm_algo<T, U>;
 
-                        return customisation::internal::make_degree_vector<s_t>(v.cbegin(), v.cend(), ss, false);
-                    } else {
-                        // NOTE: in the make_p_degree_vector() helper we need
-                        // to compute the size of v via iterator differences.
-                        ::obake::detail::container_it_diff_check(v);
+    ::std::vector<ret_t> retval;
+    retval.resize(::obake::safe_cast<decltype(retval.size())>(ys.size()));
 
-                        return customisation::internal::make_p_degree_vector<s_t>(
-                            v.cbegin(), v.cend(), ss, ::std::get<1>(::std::forward_as_tuple(args...)), false);
-                    }
-                }();
+    // Cache the symbol set.
+    const auto &ss = x.get_symbol_set();
 
-                // Ensure that the size of vd is representable by the
-                // diff type of its iterators. We'll need to do some
-                // iterator arithmetics below.
-                // NOTE: cast to const as we will use cbegin/cend below.
-                ::obake::detail::container_it_diff_check(::std::as_const(vd));
+    // Cache the tuning parameters and the byte size of x.
+    const auto tuning = ::obake::polynomials::get_mul_tuning();
+    const auto bs_x = detail::poly_mul_impl_byte_size(x);
+
+    // The data of x and of the ys for the algorithm selection
+    // (see poly_mul_impl_make_algo_data()). They are computed
+    // on demand, and the data of x only once for the whole batch.
+    // NOTE: the selection runs in parallel, hence the
+    // std::call_once() for the data of x.
+    ::std::optional<poly_mul_impl_algo_data_t<T, U, T>> dx;
+    ::std::once_flag dx_flag;
+    ::std::vector<::std::optional<poly_mul_impl_algo_data_t<T, U, U>>> dys;
+    dys.resize(::obake::safe_cast<decltype(dys.size())>(ys.size()));
+
+    // Establish the kind of the product by the i-th y.
+    auto compute_kind = [&x, &ys, &tuning, bs_x, &dx, &dx_flag, &dys](const auto &i) {
+        const auto &y = *ys[i];
+
+        if (x.get_symbol_set_fw() != y.get_symbol_set_fw() || detail::poly_mul_impl_is_sqr(x, y)) {
+            return kind::other;
+        }
 
-                // Create a vector of indices into vd.
-                ::std::vector<decltype(vd.size())> vidx;
-                vidx.resize(::obake::safe_cast<decltype(vidx.size())>(vd.size()));
-                ::std::iota(vidx.begin(), vidx.end(), decltype(vd.size())(0));
+        if (x.empty() || y.empty()) {
+            return kind::empty;
+        }
 
-                // Sort indirectly.
-                // NOTE: capture vd as const ref because in the lt-comparable requirements for the degree
-                // type we are using const lrefs.
-                ::std::sort(vidx.begin(), vidx.end(), [&vdc = ::std::as_const(vd)](const auto &idx1, const auto &idx2) {
-                    return vdc[idx1] < vdc[idx2];
-                });
+        const auto bs_y = detail::poly_mul_impl_byte_size(y);
+        auto &dy = dys[i];
+
+        const auto a = detail::poly_mul_impl_select<(sizeof...(Args) > 0u)>(
+            x, y, bs_x, bs_y,
+            [&x, &dx, &dx_flag]() -> const auto & {
+                ::std::call_once(dx_flag, [&x, &dx]() { dx.emplace(detail::poly_mul_impl_make_algo_data<T, U>(x)); });
+                return *dx;
+            },
+            [&y, &dy]() -> const auto & {
+                if (!dy) {
+                    dy.emplace(detail::poly_mul_impl_make_algo_data<T, U>(y));
+                }
+                return *dy;
+            },
+            tuning);
 
-                // Apply the sorting to vd and v. Check that permutated
-                // access does not result in overflow.
-                ::obake::detail::container_it_diff_check(vd);
-                // NOTE: use cbegin/cend on vd to ensure the copy ctor of
-                // the degree type is being called.
-                vd = decltype(vd)(::boost::make_permutation_iterator(vd.cbegin(), vidx.cbegin()),
-                                  ::boost::make_permutation_iterator(vd.cend(), vidx.cend()));
-                ::obake::detail::container_it_diff_check(v);
-                v = ::std::remove_reference_t<decltype(v)>(
-                    ::boost::make_permutation_iterator(v.cbegin(), vidx.cbegin()),
-                    ::boost::make_permutation_iterator(v.cend(), vidx.cend()));
+        if (a == algo::simple) {
+            return kind::serial;
+        }
 
-#if !defined(NDEBUG)
-                // Check the results in debug mode.
-                // NOTE: use cbegin/cend in order to ensure
-                // that the degrees are compared via const lvalue refs.
-                assert(::std::is_sorted(vd.cbegin(), vd.cend()));
+        if (a == algo::primitive) {
+            return kind::primitive;
+        }
 
-                if constexpr (sizeof...(args) == 1u) {
-                    using d_impl = customisation::internal::series_default_degree_impl;
+        if (a == algo::crt) {
+            return kind::crt;
+        }
 
-                    assert(::std::equal(vd.begin(), vd.end(),
-                                        ::boost::make_transform_iterator(v.cbegin(), d_impl::d_extractor<s_t>{&ss}),
-                                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
-                } else {
-                    using d_impl = customisation::internal::series_default_p_degree_impl;
+        assert(a == algo::mt);
 
-                    const auto &s = ::std::get<1>(::std::forward_as_tuple(args...));
-                    const auto si = ::obake::detail::ss_intersect_idx(s, ss);
+        if (bs_y < tuning.mt_min_bytes && ys.size() >= ::obake::detail::hc()) {
+            // A small y in a batch large enough
+            // to keep all the cores busy.
+            return kind::serial;
+        }
 
-                    assert(::std::equal(
-                        vd.begin(), vd.end(),
-                        ::boost::make_transform_iterator(v.cbegin(), d_impl::d_extractor<s_t>{&s, &si, &ss}),
-                        [](const auto &a, const auto &b) { return !(a < b) && !(b < a); }));
-                }
-#endif
+        return mt_hm_algo ? kind::mt_hm : kind::mt_lock;
+    };
 
-                return vd;
-            };
+    ::std::vector<kind> kinds;
+    kinds.resize(::obake::safe_cast<decltype(kinds.size())>(ys.size()));
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(ys.size())>(0, ys.size()),
+                        [&kinds, &compute_kind](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                kinds[i] = compute_kind(i);
+                            }
+                        });
+
+    // Compute the products via the primitive parts
+    // and the multi-modular multiplication, if any.
+    // NOTE: in both cases, the data of x has
+    // been computed during the selection.
+    const auto collect_idx = [&kinds](kind k) {
+        ::std::vector<decltype(kinds.size())> idx;
+        for (decltype(kinds.size()) i = 0; i < kinds.size(); ++i) {
+            if (kinds[i] == k) {
+                idx.push_back(i);
+            }
+        }
+        return idx;
+    };
 
-            using ::obake::detail::type_c;
+    if constexpr (poly_mul_primitive_algo<T, U>) {
+        if (const auto idx = collect_idx(kind::primitive); !idx.empty()) {
+            detail::poly_mul_many_impl_primitive(x, *dx, ys, dys, idx, retval, args...);
+        }
+    }
 
-#if defined(_MSC_VER) && !defined(__clang__)
-            return [&, vd1 = sorter(v1, type_c<T>{}), vd2 = sorter(v2, type_c<U>{})]
-#else
-            return [vd1 = sorter(v1, type_c<T>{}), vd2 = sorter(v2, type_c<U>{}),
-                    // NOTE: max_deg is captured via const lref this way,
-                    // as args is passed as a const lref pack.
-                    &max_deg = ::std::get<0>(::std::forward_as_tuple(args...))]
-#endif
-                (const auto &i) {
-                    using idx_t = remove_cvref_t<decltype(i)>;
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+    if constexpr (poly_mul_crt_algo<T, U>) {
+        if (const auto idx = collect_idx(kind::crt); !idx.empty()) {
+            detail::poly_mul_many_impl_crt(x, *dx, ys, dys, idx, retval, args...);
+        }
+    }
 
-#if defined(_MSC_VER) && !defined(__clang__)
-                    const auto &max_deg = ::std::get<0>(::std::forward_as_tuple(args...));
 #endif
 
-                    // Get the total/partial degree of the current term
-                    // in the first series.
-                    const auto &d_i = vd1[i];
+    // Prepare the shared operand for the serial implementation.
+    ::std::vector<const series_term_t<T> *> v1(
+        ::boost::make_transform_iterator(x.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(x.end(), poly_mul_impl_ptr_extractor{}));
+    const auto vd1 = [&v1, &ss, &args...]() {
+        if constexpr (sizeof...(args) == 0u) {
+            ::obake::detail::ignore(v1, ss);
 
-                    // Find the first term in the second series such
-                    // that d_i + d_j > max_deg.
-                    const auto it = ::std::upper_bound(vd2.cbegin(), vd2.cend(), max_deg,
-                                                       [&d_i](const auto &mdeg, const auto &d_j) {
-                                                           // NOTE: we require below
-                                                           // comparability between const lvalue limit
-                                                           // and rvalue of the sum of the degrees.
-                                                           return mdeg < d_i + d_j;
-                                                       });
+            return 0;
+        } else {
+            return detail::poly_mul_many_sort_by_degree<T>(v1, ss, args...);
+        }
+    }();
 
-                    // Turn the iterator into an index and return it.
-                    // NOTE: we checked above that the iterator diff
-                    // type can safely be used as an index (for both
-                    // vd1 and vd2).
-                    return static_cast<idx_t>(it - vd2.cbegin());
-                };
+    // Run the monomial overflow checking, if supported, for all the
+    // products with shared x at once. If it succeeds, none of the products
+    // overflows. Otherwise, the checking is repeated for each product,
+    // so that only the overflowing products throw.
+    const auto ovf_checked = [&]() {
+        ::std::vector<const series_term_t<U> *> v2;
+        for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+            if (kinds[i] == kind::serial || kinds[i] == kind::mt_hm) {
+                v2.insert(v2.end(), ::boost::make_transform_iterator(ys[i]->begin(), poly_mul_impl_ptr_extractor{}),
+                          ::boost::make_transform_iterator(ys[i]->end(), poly_mul_impl_ptr_extractor{}));
+            }
+        }
+
+        const auto r1
+            = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                          ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+        const auto r2
+            = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                          ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+        if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+            return !v2.empty() && ::obake::monomial_range_overflow_check(r1, r2, ss);
+        } else {
+            return false;
         }
     }();
 
-    // Proceed with the multiplication.
-    auto &tab = retval._get_s_table()[0];
+    // Prepare the shared operand for the multi-threaded
+    // homomorphic implementation, if needed.
+    using sh_t = poly_mul_impl_mt_hm_shared<T, Args...>;
+    ::std::unique_ptr<sh_t> sh;
+    if constexpr (mt_hm_algo) {
+        if (::std::find(kinds.begin(), kinds.end(), kind::mt_hm) != kinds.end()) {
+            sh = ::std::make_unique<sh_t>(x, ovf_checked);
+        }
+    }
 
-    try {
-        // Temporary variable used in monomial multiplication.
-        ret_key_t tmp_key(ss);
+    ::tbb::parallel_for(
+        ::tbb::blocked_range<decltype(ys.size())>(0, ys.size()),
+        [&x, &ys, &kinds, &retval, &v1, &vd1, ovf_checked, &sh, &args...](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                const auto &y = *ys[i];
 
-        const auto v1_size = v1.size();
-        for (decltype(v1.size()) i = 0; i < v1_size; ++i) {
-            const auto &t1 = v1[i];
-            const auto &k1 = t1->first;
-            const auto &c1 = t1->second;
+                switch (kinds[i]) {
+                    case kind::empty:
+                        retval[i].set_symbol_set_fw(x.get_symbol_set_fw());
+                        break;
+                    case kind::serial:
+                        retval[i] = detail::poly_mul_many_impl_simple(x, v1, vd1, ovf_checked, y, args...);
+                        break;
+                    case kind::mt_hm:
+                        // NOTE: kind::mt_hm is selected only if mt_hm_algo is true.
+                        if constexpr (mt_hm_algo) {
+                            retval[i].set_symbol_set_fw(x.get_symbol_set_fw());
+
+                            // NOTE: the multi-threaded homomorphic implementation
+                            // requires the shorter operand first.
+                            if (x.size() <= y.size()) {
+                                detail::poly_mul_impl_mt_hm_sh_rel(
+                                    poly_mul_impl_no_release{}, retval[i], x, sh.get(), y,
+                                    static_cast<const poly_mul_impl_mt_hm_shared<U, Args...> *>(nullptr), args...);
+                            } else {
+                                detail::poly_mul_impl_mt_hm_sh_rel(
+                                    poly_mul_impl_no_release{}, retval[i], y,
+                                    static_cast<const poly_mul_impl_mt_hm_shared<U, Args...> *>(nullptr), x, sh.get(),
+                                    args...);
+                            }
+                        }
+                        break;
+                    case kind::mt_lock:
+                        // NOTE: kind::mt_lock is selected only in non-truncated mode.
+                        if constexpr (sizeof...(Args) == 0u) {
+                            retval[i].set_symbol_set_fw(x.get_symbol_set_fw());
+
+                            if (x.size() <= y.size()) {
+                                detail::poly_mul_impl_mt_lock(retval[i], x, y);
+                            } else {
+                                detail::poly_mul_impl_mt_lock(retval[i], y, x);
+                            }
+                        }
+                        break;
+                    case kind::primitive:
+                    case kind::crt:
+                        // NOTE: these products have already been computed.
+                        break;
+                    case kind::other:
+                        retval[i] = detail::poly_mul_impl_switch(x, y, args...);
+                }
+            }
+        });
 
-            // Get the upper limit of the multiplication
-            // range in v2.
-            const auto j_end = compute_j_end(i);
-            if (sizeof...(Args) != 0u && j_end == 0u) {
-                // In truncated mode, if j_end is zero, we don't need to perform
-                // any more term multiplications as the remaining
-                // ones will all end up above the truncation limit.
-                break;
+    return retval;
+}
+
+// The type of the polynomials in the range R.
+template <typename R>
+using poly_mul_many_value_t = remove_cvref_t<decltype(*::obake::begin(::std::declval<R>()))>;
+
+// Metaprogramming to establish if the batched multiplication of
+// the polynomial T by the polynomials in the range R is possible.
+// The range must yield lvalues, and Check is the meta-function
+// establishing if the product of T by the value type of R is possible.
+template <typename T, typename R, template <typename, typename> typename Check>
+constexpr bool poly_mul_many_algorithm_impl()
+{
+    if constexpr (is_input_range_v<R>) {
+        if constexpr (::std::is_lvalue_reference_v<decltype(*::obake::begin(::std::declval<R>()))>) {
+            using u_t = poly_mul_many_value_t<R>;
+
+            if constexpr (is_polynomial_v<u_t>) {
+                if constexpr (::std::is_same_v<series_key_t<T>, series_key_t<u_t>>) {
+                    return Check<T, u_t>::value;
+                } else {
+                    return false;
+                }
+            } else {
+                return false;
             }
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+}
 
-            for (decltype(v2.size()) j = 0; j < j_end; ++j) {
-                const auto &t2 = v2[j];
-                const auto &c2 = t2->second;
+template <typename T, typename U>
+struct poly_mul_many_check : ::std::bool_constant<poly_mul_algo<T, U> != 0> {
+};
 
-                // Multiply the monomial.
-                ::obake::monomial_mul(tmp_key, k1, t2->first, ss);
+template <typename V>
+struct poly_mul_many_truncated_check {
+    template <typename T, typename U>
+    struct total : ::std::bool_constant<poly_mul_truncated_degree_algo<T, U, V> != 0> {
+    };
+    template <typename T, typename U>
+    struct partial : ::std::bool_constant<poly_mul_truncated_p_degree_algo<T, U, V> != 0> {
+    };
+};
 
-                // Try to insert the new term.
-                // NOTE: see the explanation in the other
-                // multiplication function about why we adopt
-                // this scheme (i.e., default-emplace the coefficient).
-                const auto res = tab.try_emplace(tmp_key);
+template <typename T, typename R>
+inline constexpr bool poly_mul_many_algo = detail::poly_mul_many_algorithm_impl<T, R, poly_mul_many_check>();
+
+template <typename T, typename R, typename V>
+inline constexpr bool poly_mul_many_truncated_degree_algo
+    = detail::poly_mul_many_algorithm_impl<T, R, poly_mul_many_truncated_check<V>::template total>();
+
+template <typename T, typename R, typename V>
+inline constexpr bool poly_mul_many_truncated_p_degree_algo
+    = detail::poly_mul_many_algorithm_impl<T, R, poly_mul_many_truncated_check<V>::template partial>();
+
+// Helper to collect pointers to the polynomials in the range ys
+// and run the batched multiplication.
+template <typename T, typename R, typename... Args>
+inline auto poly_mul_many_range_impl(const T &x, R &&ys, const Args &...args)
+{
+    ::std::vector<const poly_mul_many_value_t<R &&> *> v;
+    for (auto b = ::obake::begin(ys), e = ::obake::end(ys); b != e; ++b) {
+        v.push_back(&*b);
+    }
+
+    return detail::poly_mul_many_impl(x, v, args...);
+}
+
+} // namespace detail
+
+// Batched multiplication: compute the products of x by
+// each polynomial in the range ys, returning them in a vector.
+// This is more efficient than multiplying x by each polynomial
+// in ys separately, as the preprocessing of x is performed
+// only once and the products are computed in parallel.
+template <typename K, typename C, typename R>
+requires(detail::poly_mul_many_algo<polynomial<K, C>, R &&>) inline auto mul_many(const polynomial<K, C> &x, R &&ys)
+{
+    return detail::poly_mul_many_range_impl(x, ::std::forward<R>(ys));
+}
+
+// Truncated batched multiplication.
+template <typename K, typename C, typename R, typename V>
+requires(detail::poly_mul_many_truncated_degree_algo<polynomial<K, C>, R &&, V>) inline auto truncated_mul_many(
+    const polynomial<K, C> &x, R &&ys, const V &max_degree)
+{
+    return detail::poly_mul_many_range_impl(x, ::std::forward<R>(ys), max_degree);
+}
+
+template <typename K, typename C, typename R, typename V>
+requires(detail::poly_mul_many_truncated_p_degree_algo<polynomial<K, C>, R &&, V>) inline auto truncated_mul_many(
+    const polynomial<K, C> &x, R &&ys, const V &max_degree, const symbol_set &s)
+{
+    return detail::poly_mul_many_range_impl(x, ::std::forward<R>(ys), max_degree, s);
+}
+
+namespace detail
+{
 
-                // NOTE: optimise with likely/unlikely here?
-                if (res.second) {
-                    res.first->second = c1 * c2;
+// Metaprogramming to establish if the product of the
+// polynomials in the range R can be computed via prod().
+// The polynomial type must be closed under multiplication
+// and constructible from int (for the empty product).
+template <typename R>
+constexpr bool poly_prod_algorithm_impl()
+{
+    if constexpr (is_input_range_v<R>) {
+        if constexpr (::std::is_lvalue_reference_v<decltype(*::obake::begin(::std::declval<R>()))>) {
+            using p_t = poly_mul_many_value_t<R>;
+
+            if constexpr (is_polynomial_v<p_t>) {
+                if constexpr (poly_mul_algo<p_t, p_t> != 0) {
+                    return ::std::conjunction_v<::std::is_same<poly_mul_ret_t<p_t, p_t>, p_t>,
+                                                ::std::is_constructible<p_t, int>>;
                 } else {
-                    // The insertion failed, accumulate c1*c2 into the
-                    // existing coefficient.
-                    // NOTE: do it with fma3(), if possible.
-                    if constexpr (is_mult_addable_v<ret_cf_t &, const cf1_t &, const cf2_t &>) {
-                        ::obake::fma3(res.first->second, c1, c2);
-                    } else {
-                        res.first->second += c1 * c2;
-                    }
+                    return false;
                 }
-            }
-        }
-
-        // Determine and remove the keys whose coefficients are zero
-        // in the return value.
-        const auto it_f = tab.end();
-        for (auto it = tab.begin(); it != it_f;) {
-            // NOTE: abseil's flat_hash_map returns void on erase(),
-            // thus we need to increase 'it' before possibly erasing.
-            // erase() does not cause rehash and thus will not invalidate
-            // any other iterator apart from the one being erased.
-            if (obake_unlikely(::obake::is_zero(::std::as_const(it->second)))) {
-                tab.erase(it++);
             } else {
-                ++it;
+                return false;
             }
+        } else {
+            return false;
         }
-
-        // NOTE: no need to check the table size, as retval
-        // is not segmented.
-        // LCOV_EXCL_START
-    } catch (...) {
-        // retval may now contain zero coefficients.
-        // Make sure to clear it before rethrowing.
-        tab.clear();
-        throw;
-        // LCOV_EXCL_STOP
+    } else {
+        return false;
     }
 }
 
-// Implementation of poly multiplication with identical symbol sets.
-// Requires that x is not longer than y.
-template <typename T, typename U, typename... Args>
-inline auto poly_mul_impl_identical_ss(const T &x, const U &y, const Args &...args)
-{
-    using ret_t = poly_mul_ret_t<T, U>;
-    using ret_key_t = series_key_t<ret_t>;
-
-    // Check the preconditions.
-    assert(x.size() <= y.size());
-    assert(x.get_symbol_set_fw() == y.get_symbol_set_fw());
-
-    // Init the return value.
-    ret_t retval;
-    retval.set_symbol_set_fw(x.get_symbol_set_fw());
+template <typename R>
+inline constexpr bool poly_prod_algo = detail::poly_prod_algorithm_impl<R>();
 
+// Helper to estimate the number of terms in the product
+// of the polynomials x and y, for use in poly_prod_impl().
+// If the estimation via poly_mul_estimate_product_size() is not
+// possible (e.g., different symbol sets or an overflow in the
+// exponents), the product of the sizes is returned instead.
+// NOTE: the estimation works on vectors of pointers to the terms,
+// so that the coefficients are never copied.
+template <typename T>
+inline ::mppp::integer<1> poly_prod_estimate_size(const T &x, const T &y)
+{
     if (x.empty() || y.empty()) {
-        // Exit early if either series is empty.
-        return retval;
+        return ::mppp::integer<1>{};
     }
 
-    if constexpr (::std::conjunction_v<is_homomorphically_hashable_monomial<ret_key_t>,
-                                       // Need also to be able to measure the byte size
-                                       // of x, y, and the key/cf of ret_t, via const lvalue references.
-                                       // NOTE: perhaps this is too much of a hard requirement,
-                                       // and we can make this optional (if not supported,
-                                       // fix the nsegs to something like twice the cores).
-                                       is_size_measurable<const T &>, is_size_measurable<const U &>,
-                                       is_size_measurable<const ret_key_t &>,
-                                       is_size_measurable<const series_cf_t<ret_t> &>>) {
-        // Homomorphic hashing is available, we can run
-        // the multi-threaded implementation.
+    // NOTE: poly_mul_estimate_product_size() requires
+    // the shorter series first.
+    const auto &a = x.size() <= y.size() ? x : y;
+    const auto &b = x.size() <= y.size() ? y : x;
 
-        // Establish the max byte size of the input series.
-        const auto max_bs = ::std::max(::obake::byte_size(x), ::obake::byte_size(y));
+    if (a.get_symbol_set_fw() != b.get_symbol_set_fw()) {
+        return ::mppp::integer<1>{a.size()} * b.size();
+    }
 
-        if ((x.size() == 1u && y.size() == 1u) || max_bs < 30000ul || ::obake::detail::hc() == 1u) {
-            // Run the simple implementation if either:
-            // - both polys have only 1 term, or
-            // - the maximum operand size is less than a threshold value, or
-            // - we have just 1 core.
-            detail::poly_mul_impl_simple(retval, x, y, args...);
-        } else {
-            // Otherwise, run the MT implementation.
-            detail::poly_mul_impl_mt_hm(retval, x, y, args...);
+    const ::std::vector<const series_term_t<T> *> v1(
+        ::boost::make_transform_iterator(a.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(a.end(), poly_mul_impl_ptr_extractor{}));
+    const ::std::vector<const series_term_t<T> *> v2(
+        ::boost::make_transform_iterator(b.begin(), poly_mul_impl_ptr_extractor{}),
+        ::boost::make_transform_iterator(b.end(), poly_mul_impl_ptr_extractor{}));
+
+    // NOTE: as in poly_mul_impl_mt_hm(), the overflow checking
+    // must be sequenced before the estimation. The ranges are
+    // random-access, thus the checking can run in parallel.
+    const auto r1
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v1.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v1.cend(), poly_term_key_ref_extractor{}));
+    const auto r2
+        = ::obake::detail::make_range(::boost::make_transform_iterator(v2.cbegin(), poly_term_key_ref_extractor{}),
+                                      ::boost::make_transform_iterator(v2.cend(), poly_term_key_ref_extractor{}));
+    if constexpr (are_overflow_testable_monomial_ranges_v<decltype(r1) &, decltype(r2) &>) {
+        if (obake_unlikely(!::obake::monomial_range_overflow_check(r1, r2, a.get_symbol_set()))) {
+            // The multiplication will throw, the estimate
+            // does not matter.
+            return ::mppp::integer<1>{a.size()} * b.size();
         }
-    } else {
-        // The monomial does not have homomorphic hashing,
-        // just use the simple implementation.
-        detail::poly_mul_impl_simple(retval, x, y, args...);
     }
 
-    return retval;
+    return ::std::get<0>(detail::poly_mul_estimate_product_size<T, T>(v1, v2, a.get_symbol_set()));
 }
 
-// Top level function for poly multiplication. Requires that
-// x is not longer than y.
-// NOTE: future improvements:
-// - make the ntrials for the estimation of the average term size
-//   dependent on the number of term-by-term multiplications (need data for that).
-// NOTE: performance considerations:
-// - the multithreaded implementation still computes
-//   the degrees of the terms of the input series twice. This
-//   could be reduced at the price of changing a bit the code structure
-//   and at the cost of additional indirect sorting (because we
-//   would be computing the degree vectors at the beginning and then
-//   we would need to sort them for segmentation purposes). It's not
-//   clear to me if this is worth it at this time, need to profile;
-// - in highly rectangular multiplications, quite a bit of time
-//   is spent copying the larger operand into a vector of terms.
-//   Perhaps this could be parallelised for segmented series?
-// - in highly rectangular multiplications, the series size
-//   estimation is quite poor (see comments on top of the
-//   function). Not sure what we could do about it;
-// - when constructing vectors of indices, or when building
-//   vectors of degrees, we could improve performance by using
-//   a default-constructing allocator, in order to avoid zeroing
-//   out data which we will be overwriting anyway;
-// - perhaps vector permutations could be done in parallel?
-template <typename T, typename U, typename... Args>
-inline auto poly_mul_impl(const T &x, const U &y, const Args &...args)
+// Implementation of the product of the polynomials pointed
+// to by the elements of v. The product is computed
+// Huffman-style: the factors are kept in a min-heap keyed
+// on their (estimated) number of terms, and the two smallest
+// factors are always multiplied together, the product being
+// re-inserted in the heap keyed on the estimate provided by
+// poly_mul_estimate_product_size(). In this way, the intermediate
+// products are kept as small as possible.
+// The products are not computed immediately: they are
+// collected in a batch of independent multiplications, which
+// is computed in parallel as soon as one of the two smallest factors
+// is a not-yet-computed product. After the computation of a batch,
+// the estimated sizes are replaced by the actual ones.
+// NOTE: ties in the heap are broken by insertion order.
+// The order of the products thus depends only on the sizes
+// of the factors and on the size estimates.
+template <typename T>
+inline T poly_prod_impl(const ::std::vector<const T *> &v)
 {
-    // Check the precondition.
-    assert(x.size() <= y.size());
+    if (v.empty()) {
+        // Empty product.
+        return T(1);
+    }
 
-    if (x.get_symbol_set_fw() == y.get_symbol_set_fw()) {
-        return detail::poly_mul_impl_identical_ss(x, y, args...);
-    } else {
-        // Merge the symbol sets.
-        const auto &[merged_ss, ins_map_x, ins_map_y]
-            = ::obake::detail::merge_symbol_sets(x.get_symbol_set(), y.get_symbol_set());
+    // A factor in the heap. It is either ready (i.e., it points
+    // to one of the original factors or to an intermediate product,
+    // owned by the factor), or pending (i.e., it is the result of the
+    // multiplication at index idx in the current batch).
+    struct factor {
+        ::mppp::integer<1> key;
+        ::std::size_t seq;
+        const T *ptr;
+        ::std::unique_ptr<T> owned;
+        bool pending;
+        ::std::size_t idx;
+    };
 
-        // The insertion maps cannot be both empty, as we already handled
-        // the identical symbol sets case above.
-        assert(!ins_map_x.empty() || !ins_map_y.empty());
+    // A multiplication in the current batch. The operands are moved
+    // in here in order to keep the intermediate products alive.
+    struct mult {
+        factor a, b;
+        ::std::unique_ptr<T> res;
+    };
 
-        // Create a flag indicating empty insertion maps:
-        // - 0 -> both non-empty,
-        // - 1 -> x is empty,
-        // - 2 -> y is empty.
-        // (Cannot both be empty as we handled identical symbol sets already).
-        const auto flag = static_cast<unsigned>(ins_map_x.empty()) + (static_cast<unsigned>(ins_map_y.empty()) << 1);
+    // NOTE: comparator for a min-heap.
+    const auto cmp = [](const factor &f1, const factor &f2) {
+        return f1.key > f2.key || (f1.key == f2.key && f1.seq > f2.seq);
+    };
 
-        switch (flag) {
-            case 1u: {
-                // x already has the correct symbol
-                // set, extend only y.
-                U b;
-                b.set_symbol_set(merged_ss);
-                ::obake::detail::series_sym_extender(b, y, ins_map_y);
+    ::std::vector<factor> heap;
+    heap.reserve(v.size());
+    ::std::size_t seq = 0;
+    for (const auto *p : v) {
+        heap.push_back(factor{::mppp::integer<1>{p->size()}, seq++, p, nullptr, false, 0});
+    }
+    ::std::make_heap(heap.begin(), heap.end(), cmp);
 
-                return detail::poly_mul_impl_identical_ss(x, ::std::move(b), args...);
+    ::std::vector<mult> batch;
+
+    // Compute the multiplications in the batch, and turn
+    // the pending factors into ready ones.
+    auto flush = [&heap, &batch, &cmp]() {
+        ::tbb::parallel_for(::tbb::blocked_range<decltype(batch.size())>(0, batch.size()), [&batch](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                batch[i].res = ::std::make_unique<T>(*batch[i].a.ptr * *batch[i].b.ptr);
             }
-            case 2u: {
-                // y already has the correct symbol
-                // set, extend only x.
-                T a;
-                a.set_symbol_set(merged_ss);
-                ::obake::detail::series_sym_extender(a, x, ins_map_x);
+        });
 
-                return detail::poly_mul_impl_identical_ss(::std::move(a), y, args...);
+        for (auto &f : heap) {
+            if (f.pending) {
+                f.owned = ::std::move(batch[f.idx].res);
+                f.ptr = f.owned.get();
+                f.key = f.ptr->size();
+                f.pending = false;
             }
         }
 
-        // Both x and y need to be extended.
-        T a;
-        U b;
-        a.set_symbol_set(merged_ss);
-        b.set_symbol_set(merged_ss);
-        ::obake::detail::series_sym_extender(a, x, ins_map_x);
-        ::obake::detail::series_sym_extender(b, y, ins_map_y);
+        batch.clear();
+        ::std::make_heap(heap.begin(), heap.end(), cmp);
+    };
 
-        return detail::poly_mul_impl_identical_ss(::std::move(a), ::std::move(b), args...);
-    }
-}
+    // Pop the smallest factor from the heap.
+    auto pop = [&heap, &cmp]() {
+        ::std::pop_heap(heap.begin(), heap.end(), cmp);
+        auto ret = ::std::move(heap.back());
+        heap.pop_back();
+        return ret;
+    };
 
-// Helper to ensure that poly_mul_impl() is called with the
-// shorter poly first, switching around the arguments if necessary.
-template <typename T, typename U, typename... Args>
-inline auto poly_mul_impl_switch(const T &x, const U &y, const Args &...args)
-{
-    if (x.size() <= y.size()) {
-        return detail::poly_mul_impl(x, y, args...);
-    } else {
-        return detail::poly_mul_impl(y, x, args...);
-    }
-}
+    // Push f into the heap.
+    auto push = [&heap, &cmp](factor &&f) {
+        heap.push_back(::std::move(f));
+        ::std::push_heap(heap.begin(), heap.end(), cmp);
+    };
 
-} // namespace detail
+    while (heap.size() > 1u) {
+        auto a = pop();
+        if (a.pending) {
+            push(::std::move(a));
+            flush();
+            continue;
+        }
 
-template <typename K, typename C0, typename C1>
-requires(detail::poly_mul_algo<polynomial<K, C0>, polynomial<K, C1>> != 0) inline detail::poly_mul_ret_t<
-    polynomial<K, C0>, polynomial<K, C1>> series_mul(const polynomial<K, C0> &x, const polynomial<K, C1> &y)
-{
-    return detail::poly_mul_impl_switch(x, y);
-}
+        auto b = pop();
+        if (b.pending) {
+            push(::std::move(a));
+            push(::std::move(b));
+            flush();
+            continue;
+        }
 
-namespace detail
-{
+        auto est = detail::poly_prod_estimate_size(*a.ptr, *b.ptr);
+        batch.push_back(mult{::std::move(a), ::std::move(b), nullptr});
+        push(factor{::std::move(est), seq++, nullptr, nullptr, true, batch.size() - 1u});
+    }
 
-// Metaprogramming to establish if we can perform
-// truncated total/partial degree multiplication on the
-// polynomial operands T and U with degree limit of type V.
-// NOTE: at this time, truncated multiplication is implemented
-// only if only the key is with degree.
-template <typename T, typename U, typename V, bool Total>
-constexpr auto poly_mul_truncated_degree_algorithm_impl()
-{
-    // Preconditions: T and U are not cvr-qualified, both are series types,
-    // they have the same key and tag types and V is not cvr-qualified.
-    static_assert(::std::is_same_v<remove_cvref_t<T>, T>);
-    static_assert(::std::is_same_v<remove_cvref_t<U>, U>);
-    static_assert(any_series<T>);
-    static_assert(any_series<U>);
-    static_assert(::std::is_same_v<series_key_t<T>, series_key_t<U>>);
-    static_assert(::std::is_same_v<series_tag_t<T>, series_tag_t<U>>);
-    static_assert(::std::is_same_v<remove_cvref_t<V>, V>);
+    flush();
 
-    // Check first if we can do the untruncated multiplication. If we cannot,
-    // truncated mult is not possible.
-    if constexpr (poly_mul_algo<T, U> == 0) {
-        return 0;
+    assert(heap.size() == 1u);
+    if (heap[0].owned) {
+        return ::std::move(*heap[0].owned);
     } else {
-        // Check if we can compute the degree of the terms via the default
-        // implementation for series.
-        using d_impl = ::std::conditional_t<Total, customisation::internal::series_default_degree_impl,
-                                            customisation::internal::series_default_p_degree_impl>;
-        constexpr auto algo1 = d_impl::template algo<T>;
-        constexpr auto algo2 = d_impl::template algo<U>;
-
-        // NOTE: algo == 3 means that only the key is with degree.
-        if constexpr (algo1 == 3 && algo2 == 3) {
-            // Fetch the degree types.
-            using deg1_t = typename d_impl::template ret_t<T>;
-            using deg2_t = typename d_impl::template ret_t<U>;
-
-            // The degree types need to be:
-            // - copy/move ctible (need to handle vectors of them, note that
-            //   in the series default degree machinery we check for returnability,
-            //   but here we need explicitly both copy and move ctible),
-            // - addable via const lref,
-            // - V must be lt-comparable to the type of their sum via const lrefs.
-            using deg_add_t = detected_t<::obake::detail::add_t, const deg1_t &, const deg2_t &>;
-
-            return static_cast<int>(::std::conjunction_v<
-                                    // NOTE: this will ensure that switching around
-                                    // the degree operands still works and produces the same
-                                    // type. This is necessary because in the poly moltiplication
-                                    // function we might end up swapping the operands.
-                                    // NOTE: this will also verify that deg_add_t is present.
-                                    is_addable<const deg1_t &, const deg2_t &>, ::std::is_copy_constructible<deg1_t>,
-                                    ::std::is_copy_constructible<deg2_t>, ::std::is_move_constructible<deg1_t>,
-                                    ::std::is_move_constructible<deg2_t>,
-                                    // NOTE: in the implementation functions, we always compare
-                                    // an lvalue ref to the limit V to an rvalue resulting
-                                    // from adding the degrees of one term from each series.
-                                    is_less_than_comparable<const V &, deg_add_t>>);
-        } else {
-            return 0;
-        }
+        // Single factor.
+        return *heap[0].ptr;
     }
 }
 
-template <typename T, typename U, typename V>
-inline constexpr auto poly_mul_truncated_degree_algo
-    = detail::poly_mul_truncated_degree_algorithm_impl<T, U, V, true>();
-
-template <typename T, typename U, typename V>
-inline constexpr auto poly_mul_truncated_p_degree_algo
-    = detail::poly_mul_truncated_degree_algorithm_impl<T, U, V, false>();
-
 } // namespace detail
 
-// Truncated multiplication.
-// NOTE: do we need the type traits/concepts as well?
-// NOTE: should these be function objects?
-template <typename K, typename C0, typename C1, typename V>
-requires(detail::poly_mul_truncated_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline detail::
-    poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>> truncated_mul(const polynomial<K, C0> &x,
-                                                                       const polynomial<K, C1> &y, const V &max_degree)
+// Product of the polynomials in the range r (see
+// detail::poly_prod_impl()). The product of an empty range is 1.
+template <typename R>
+requires(detail::poly_prod_algo<R &&>) inline auto prod(R &&r)
 {
-    return detail::poly_mul_impl_switch(x, y, max_degree);
-}
+    using p_t = detail::poly_mul_many_value_t<R &&>;
 
-template <typename K, typename C0, typename C1, typename V>
-requires(detail::poly_mul_truncated_p_degree_algo<polynomial<K, C0>, polynomial<K, C1>, V> != 0) inline detail::
-    poly_mul_ret_t<polynomial<K, C0>, polynomial<K, C1>> truncated_mul(const polynomial<K, C0> &x,
-                                                                       const polynomial<K, C1> &y, const V &max_degree,
-                                                                       const symbol_set &s)
-{
-    return detail::poly_mul_impl_switch(x, y, max_degree, s);
+    ::std::vector<const p_t *> v;
+    for (auto b = ::obake::begin(r), e = ::obake::end(r); b != e; ++b) {
+        v.push_back(&*b);
+    }
+
+    return detail::poly_prod_impl(v);
 }
 
 namespace detail
@@ -2247,28 +5971,165 @@ constexpr auto poly_subs_algorithm_impl()
             } else {
                 return failure;
             }
-        } else {
-            return failure;
+        } else {
+            return failure;
+        }
+    }
+}
+
+template <typename T, typename U>
+inline constexpr auto poly_subs_algorithm = detail::poly_subs_algorithm_impl<T, U>();
+
+template <typename T, typename U>
+inline constexpr int poly_subs_algo = poly_subs_algorithm<T, U>.first;
+
+template <typename T, typename U>
+using poly_subs_ret_t = typename decltype(poly_subs_algorithm<T, U>.second)::type;
+
+// Helper to sum the values in v via a balanced reduction tree.
+// At each level, the sums of adjacent pairs are computed in parallel.
+// The result is left in v[0].
+// NOTE: the summation order does not depend on the scheduling,
+// thus the result is deterministic.
+template <typename R>
+inline void poly_subs_reduce(::std::vector<R> &v)
+{
+    using size_type = decltype(v.size());
+
+    for (size_type stride = 1; stride < v.size(); stride *= 2u) {
+        const auto n_pairs = (v.size() - 1u) / (stride * 2u) + 1u;
+
+        ::tbb::parallel_for(::tbb::blocked_range<size_type>(0, n_pairs), [&v, stride](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                const auto idx = i * stride * 2u;
+
+                if (idx + stride < v.size()) {
+                    v[idx] += ::std::move(v[idx + stride]);
+                }
+            }
+        });
+
+        // NOTE: avoid overflow in the computation
+        // of the stride for the next level.
+        if (stride > v.size() / 2u) {
+            break;
         }
     }
 }
 
-template <typename T, typename U>
-inline constexpr auto poly_subs_algorithm = detail::poly_subs_algorithm_impl<T, U>();
+// Implementation of the polynomial subs algorithm.
+// The terms of x are processed in parallel, one task per segment.
+// Within a segment, the terms are grouped by the monomial resulting
+// from the substitution, and the products of the substituted keys
+// and coefficients in each group are summed before being multiplied
+// by the monomial. The partial results are then combined via
+// a parallel reduction tree. The monomial substitutions are
+// performed via ks(k).
+template <typename T, typename U, typename KS>
+inline auto poly_subs_impl_segmented(const remove_cvref_t<T> &x, const symbol_map<U> &sm, const KS &ks)
+{
+    using rT = remove_cvref_t<T>;
+    using ret_t = poly_subs_ret_t<T &&, U>;
+    using key_t = series_key_t<rT>;
+    using key_subs_t = typename ::obake::detail::monomial_subs_t<const key_t &, U>::first_type;
+    using cf_subs_t = ::obake::detail::subs_t<const series_cf_t<rT> &, U>;
+    using subs_prod_t = ::obake::detail::mul_t<key_subs_t, cf_subs_t>;
+
+    const auto &s_table = x._get_s_table();
+
+    // The partial results for each segment.
+    ::std::vector<ret_t> seg_res;
+    seg_res.resize(::obake::safe_cast<decltype(seg_res.size())>(s_table.size()));
+
+    ::tbb::parallel_for(
+        ::tbb::blocked_range<decltype(s_table.size())>(0, s_table.size()),
+        [&x, &sm, &ks, &s_table, &seg_res](const auto &range) {
+            // Init a temp poly that we will use below.
+            rT tmp_poly;
+            tmp_poly.set_symbol_set_fw(x.get_symbol_set_fw());
+            tmp_poly.tag() = x.tag();
+
+            // Helper to multiply the result of the substitution
+            // in the coefficient(s) by the monomial k.
+            auto mul_mon = [&tmp_poly](auto &&c, const key_t &k) {
+                // Clear up tmp_poly, add a term with unitary
+                // coefficient containing k.
+                tmp_poly.clear_terms();
+                tmp_poly.add_term(k, 1);
+
+                return ::std::forward<decltype(c)>(c) * ::std::as_const(tmp_poly);
+            };
 
-template <typename T, typename U>
-inline constexpr int poly_subs_algo = poly_subs_algorithm<T, U>.first;
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                const auto &table = s_table[i];
+
+                // The products for the current segment.
+                ::std::vector<ret_t> prods;
+
+                if constexpr (is_in_place_addable_v<::std::add_lvalue_reference_t<subs_prod_t>, subs_prod_t>) {
+                    // Group the terms by the monomial resulting
+                    // from the substitution.
+                    ::obake::detail::accumulation_table<key_t, subs_prod_t, ::obake::detail::series_key_hasher,
+                                                        ::obake::detail::series_key_comparer>
+                        groups;
+
+                    for (const auto &t : table) {
+                        // Do the monomial substitution.
+                        auto k_sub(ks(t.first));
+
+                        auto prod_sub = [&k_sub, &c = t.second, &sm]() -> subs_prod_t {
+                            return ::std::move(k_sub.first) * ::obake::subs(c, sm);
+                        };
+                        groups.insert_or_accumulate(
+                            k_sub.second, prod_sub, [&prod_sub](subs_prod_t &acc) { acc += prod_sub(); });
+                    }
 
-template <typename T, typename U>
-using poly_subs_ret_t = typename decltype(poly_subs_algorithm<T, U>.second)::type;
+                    prods.reserve(groups.size());
+                    groups.consume([&prods, &mul_mon](key_t &&k, subs_prod_t &&c) {
+                        prods.push_back(mul_mon(::std::move(c), k));
+                    });
+                } else {
+                    // No grouping possible, compute
+                    // the product term by term.
+                    prods.reserve(static_cast<decltype(prods.size())>(table.size()));
+
+                    for (const auto &t : table) {
+                        auto k_sub(ks(t.first));
+
+                        prods.push_back(
+                            mul_mon(::std::move(k_sub.first) * ::obake::subs(t.second, sm), k_sub.second));
+                    }
+                }
+
+                if (!prods.empty()) {
+                    detail::poly_subs_reduce(prods);
+                    seg_res[i] = ::std::move(prods[0]);
+                }
+            }
+        });
+
+    // Combine the results of the segments.
+    // NOTE: the final accumulation into a default-constructed
+    // value ensures the result is the same as summing
+    // all the products into an initially empty ret_t.
+    ret_t retval;
+
+    if (!seg_res.empty()) {
+        detail::poly_subs_reduce(seg_res);
+        retval += ::std::move(seg_res[0]);
+    }
+
+    return retval;
+}
 
-// Implementation of the polynomial subs algorithm.
 template <typename T, typename U>
 inline auto poly_subs_impl(T &&x_, const symbol_map<U> &sm)
 {
     // Sanity check.
     static_assert(poly_subs_algo<T &&, U> == 1);
 
+    using key_t = series_key_t<remove_cvref_t<T>>;
+
     // Need only const access to x.
     const auto &x = ::std::as_const(x_);
 
@@ -2278,49 +6139,23 @@ inline auto poly_subs_impl(T &&x_, const symbol_map<U> &sm)
     // Compute the intersection between sm and ss.
     const auto si = ::obake::detail::sm_intersect_idx(sm, ss);
 
-    // Init a temp poly that we will use in the loop below.
-    remove_cvref_t<T> tmp_poly;
-    tmp_poly.set_symbol_set_fw(x.get_symbol_set_fw());
-    tmp_poly.tag() = x.tag();
-
-    // The return value (this will default-construct
-    // an empty polynomial).
-    poly_subs_ret_t<T &&, U> retval;
-
-    // NOTE: parallelisation opportunities here
-    // for segmented tables.
-    for (const auto &t : x) {
-        const auto &k = t.first;
-        const auto &c = t.second;
-
-        // Do the monomial substitution.
-        auto k_sub(::obake::monomial_subs(k, si, ss));
-
-        // Clear up tmp_poly, add a term with unitary
-        // coefficient containing the monomial result of the
-        // substitution above.
-        tmp_poly.clear_terms();
-        tmp_poly.add_term(::std::move(k_sub.second), 1);
-
-        // Compute the product of the substitutions and accumulate
-        // it into the return value.
-        // NOTE: if the type of retval coincides with the type
-        // of the original poly, we could probably optimise this
-        // to do term insertions rather than going through with
-        // the multiplications. E.g., substitution with integral
-        // values in a polynomial with integral coefficients.
-        // NOTE: another optimisation is possible if
-        // the type of subs(c, sm) is the coefficient type of
-        // tmp_poly. In that case we can avoid one multiplication
-        // and call tmp_poly.add_term() above directly with
-        // subs(c, sm) as a coefficient instead of 1.
-        // NOTE: if we implement the above suggestions, we will
-        // have to think about the implication wrt power series
-        // and truncation.
-        retval += ::std::move(k_sub.first) * ::obake::subs(c, sm) * ::std::as_const(tmp_poly);
+    if constexpr (::std::conjunction_v<
+                      ::std::negation<is_arithmetic<U>>,
+                      ::std::is_same<detected_t<::obake::detail::monomial_subs_with_table_t, key_t, U>,
+                                     ::obake::detail::monomial_subs_t<const key_t &, U>>>) {
+        // The key supports fetching the powers of the
+        // substitution values from a table shared among
+        // all the terms (and all the threads). For values
+        // of arithmetic type, the computation of the powers
+        // is cheaper than the lookup.
+        ::obake::detail::sm_pow_table<U, typename key_t::value_type> pt(si);
+
+        return detail::poly_subs_impl_segmented<T>(
+            x, sm, [&pt, &ss](const key_t &k) { return monomial_subs_with_table(k, pt, ss); });
+    } else {
+        return detail::poly_subs_impl_segmented<T>(
+            x, sm, [&si, &ss](const key_t &k) { return ::obake::monomial_subs(k, si, ss); });
     }
-
-    return retval;
 }
 
 } // namespace detail
@@ -2336,6 +6171,230 @@ requires Polynomial<remove_cvref_t<T>> &&(
 namespace detail
 {
 
+// Helper to extract the exponents of a key via key_evaluate().
+// The evaluation of a key with the tracer of index i associated
+// to the i-th symbol yields the list of the (symbol index, exponent)
+// pairs of the key, in the symbol order (zero exponents are omitted).
+template <typename E>
+struct poly_eval_tracer {
+    poly_eval_tracer() = default;
+    poly_eval_tracer(int) {}
+
+    poly_eval_tracer &operator*=(const poly_eval_tracer &other)
+    {
+        m_exps.insert(m_exps.end(), other.m_exps.begin(), other.m_exps.end());
+
+        return *this;
+    }
+
+    friend poly_eval_tracer pow(const poly_eval_tracer &t, const E &n)
+    {
+        poly_eval_tracer retval;
+
+        if (n != E(0)) {
+            retval.m_exps.emplace_back(t.m_idx, n);
+        }
+
+        return retval;
+    }
+
+    symbol_idx m_idx = 0;
+    ::std::vector<::std::pair<symbol_idx, E>> m_exps;
+};
+
+template <typename K>
+using poly_eval_program_exp_t = typename K::value_type;
+
+// Metaprogramming to establish if a polynomial with key type
+// K can be compiled into an eval_program.
+template <typename K>
+constexpr bool poly_eval_program_key_impl()
+{
+    if constexpr (is_detected_v<poly_eval_program_exp_t, K>) {
+        using tracer_t = poly_eval_tracer<typename K::value_type>;
+
+        return ::std::is_same_v<detected_t<::obake::detail::key_evaluate_t, const K &, tracer_t>, tracer_t>;
+    } else {
+        return false;
+    }
+}
+
+template <typename K>
+inline constexpr bool poly_eval_program_key = detail::poly_eval_program_key_impl<K>();
+
+// Metaprogramming to establish the return type of the
+// evaluation of an eval_program with key type K and coefficient
+// type C at values of type U.
+template <typename K, typename C, typename U>
+constexpr auto poly_eval_program_algorithm_impl()
+{
+    [[maybe_unused]] constexpr auto failure = ::std::make_pair(0, ::obake::detail::type_c<void>{});
+
+    // The evaluation of the coefficients must be the identity
+    // (that is, the coefficients must not be series and
+    // they must not depend on the evaluation values).
+    if constexpr (::std::conjunction_v<is_exponentiable<const U &, const typename K::value_type &>,
+                                       ::std::negation<is_cvr_series<C>>,
+                                       ::std::is_same<detected_t<::obake::detail::evaluate_t, const C &, U>, C>>) {
+        // The type of the powers of the values.
+        using pow_t = ::obake::detail::pow_t<const U &, const typename K::value_type &>;
+        using ret_t = detected_t<::obake::detail::mul_t, pow_t, const C &>;
+
+        if constexpr (::std::conjunction_v<
+                          ::std::is_constructible<pow_t, int>,
+                          is_in_place_multipliable<::std::add_lvalue_reference_t<pow_t>, const pow_t &>,
+                          // NOTE: this will also verify that ret_t is detected.
+                          is_in_place_addable<::std::add_lvalue_reference_t<ret_t>, ret_t>,
+                          ::std::is_constructible<ret_t, int>, is_returnable<ret_t>>) {
+            return ::std::make_pair(1, ::obake::detail::type_c<ret_t>{});
+        } else {
+            return failure;
+        }
+    } else {
+        return failure;
+    }
+}
+
+template <typename K, typename C, typename U>
+inline constexpr auto poly_eval_program_algorithm = detail::poly_eval_program_algorithm_impl<K, C, U>();
+
+template <typename K, typename C, typename U>
+inline constexpr int poly_eval_program_algo = poly_eval_program_algorithm<K, C, U>.first;
+
+template <typename K, typename C, typename U>
+using poly_eval_program_ret_t = typename decltype(poly_eval_program_algorithm<K, C, U>.second)::type;
+
+} // namespace detail
+
+// A polynomial compiled into a straight-line evaluation program.
+// The program consists of the list of the distinct powers of the
+// symbols appearing in the polynomial, and, for each term, of the
+// indices of the powers whose product yields the key, plus the
+// coefficient. The evaluation at a vector of values (one per symbol,
+// in the order of the symbol set) computes each power only once, and
+// then walks the flat arrays of the terms, with no unpacking of the
+// keys, no hashing and no lookup of the symbols.
+// NOTE: the terms are stored in the iteration order of the
+// polynomial, and the powers are multiplied in the symbol order,
+// thus the result is the same as evaluate()'s.
+template <typename K, typename C>
+requires(detail::poly_eval_program_key<K>) class eval_program
+{
+    using exp_t = typename K::value_type;
+
+public:
+    using size_type = ::std::size_t;
+
+    explicit eval_program(const polynomial<K, C> &p) : m_ss(p.get_symbol_set())
+    {
+        const auto s_size = m_ss.size();
+
+        // Init the tracers.
+        symbol_idx_map<detail::poly_eval_tracer<exp_t>> sm;
+        for (symbol_idx i = 0; i < s_size; ++i) {
+            detail::poly_eval_tracer<exp_t> t;
+            t.m_idx = i;
+            sm.emplace_hint(sm.cend(), i, ::std::move(t));
+        }
+
+        // Extract the exponents of the keys.
+        ::std::vector<::std::vector<::std::pair<symbol_idx, exp_t>>> exps;
+        exps.reserve(static_cast<decltype(exps.size())>(p.size()));
+        m_cfs.reserve(static_cast<decltype(m_cfs.size())>(p.size()));
+        for (const auto &t : p) {
+            exps.push_back(::std::move(::obake::key_evaluate(t.first, sm, m_ss).m_exps));
+            m_cfs.push_back(t.second);
+        }
+
+        // Collect the distinct powers, sorted
+        // by symbol and exponent.
+        for (const auto &v : exps) {
+            m_powers.insert(m_powers.end(), v.begin(), v.end());
+        }
+        ::std::sort(m_powers.begin(), m_powers.end());
+        m_powers.erase(::std::unique(m_powers.begin(), m_powers.end()), m_powers.end());
+
+        // Encode the terms.
+        m_offsets.reserve(exps.size() + 1u);
+        m_offsets.push_back(0);
+        for (const auto &v : exps) {
+            for (const auto &pr : v) {
+                const auto it = ::std::lower_bound(m_powers.begin(), m_powers.end(), pr);
+                assert(it != m_powers.end() && *it == pr);
+
+                m_slots.push_back(static_cast<size_type>(it - m_powers.begin()));
+            }
+
+            m_offsets.push_back(m_slots.size());
+        }
+    }
+
+    const symbol_set &get_symbol_set() const
+    {
+        return m_ss;
+    }
+    // Number of terms.
+    size_type size() const
+    {
+        return m_cfs.size();
+    }
+    // Number of distinct powers.
+    size_type get_n_powers() const
+    {
+        return m_powers.size();
+    }
+
+    // Evaluation at the values in vals, which must
+    // be ordered as the symbol set of the program.
+    template <typename U>
+    requires(detail::poly_eval_program_algo<K, C, U> != 0) detail::poly_eval_program_ret_t<K, C, U> operator()(
+        const ::std::vector<U> &vals) const
+    {
+        using pow_t = ::obake::detail::pow_t<const U &, const exp_t &>;
+
+        if (obake_unlikely(vals.size() != m_ss.size())) {
+            obake_throw(::std::invalid_argument,
+                        "Cannot evaluate a compiled polynomial: the number of values ("
+                            + ::obake::detail::to_string(vals.size()) + ") differs from the number of symbols ("
+                            + ::obake::detail::to_string(m_ss.size()) + ")");
+        }
+
+        // Compute the powers.
+        ::boost::container::small_vector<pow_t, 16> pws;
+        pws.reserve(m_powers.size());
+        for (const auto &[idx, n] : m_powers) {
+            pws.push_back(::obake::pow(vals[idx], n));
+        }
+
+        // Accumulate the terms.
+        detail::poly_eval_program_ret_t<K, C, U> retval(0);
+        for (size_type i = 0; i < m_cfs.size(); ++i) {
+            pow_t kv(1);
+            for (auto j = m_offsets[i]; j < m_offsets[i + 1u]; ++j) {
+                kv *= ::std::as_const(pws[m_slots[j]]);
+            }
+
+            retval += ::std::move(kv) * m_cfs[i];
+        }
+
+        return retval;
+    }
+
+private:
+    symbol_set m_ss;
+    // The distinct powers.
+    ::std::vector<::std::pair<symbol_idx, exp_t>> m_powers;
+    // The indices of the powers of each term,
+    // and the offsets of the terms into m_slots.
+    ::std::vector<size_type> m_slots;
+    ::std::vector<size_type> m_offsets;
+    // The coefficients.
+    ::std::vector<C> m_cfs;
+};
+
+namespace detail
+{
+
 // Meta-programming for the selection of the
 // truncate_degree() algorithm.
 // NOTE: at this time, we support only truncation
@@ -2465,6 +6524,128 @@ inline void truncate_p_degree(T &x, U &&y_, const symbol_set &s)
 namespace detail
 {
 
+// Helper to apply in parallel a term-wise transformation
+// to a segmented polynomial x, writing the result into retval.
+// retval must be empty, and it must have the same symbol set
+// and segmentation as x. f(t, emit) is invoked on each term t
+// of x, and it must invoke emit(k, c) (with k and c rvalues)
+// for each term produced from t. Because the transformation
+// may alter the keys, the produced terms do not necessarily
+// end up in the segment of t. Thus, the terms are first produced
+// in parallel over the segments of x, then sorted according to
+// their destination segments, and finally each segment of retval
+// is filled by a single task. Terms with identical keys are
+// accumulated, and zero terms are discarded.
+template <typename T, typename F>
+inline void poly_termwise_segmented(T &retval, const T &x, const F &f)
+{
+    using s_size_t = typename T::s_size_type;
+    using key_t = series_key_t<T>;
+    using cf_t = series_cf_t<T>;
+
+    assert(retval.empty());
+    assert(retval.get_symbol_set() == x.get_symbol_set());
+    assert(retval.get_s_size() == x.get_s_size());
+
+    const auto nsegs = s_size_t(1) << x.get_s_size();
+
+    // A produced term, together with the index
+    // of its destination segment and its position
+    // in the sequence of the produced terms.
+    // NOTE: the position is used to make the sorting below
+    // deterministic, so that the accumulation of terms with
+    // identical keys always happens in the same order.
+    struct term_t {
+        s_size_t seg_idx;
+        ::std::size_t pos;
+        key_t key;
+        cf_t cf;
+    };
+
+    // Produce the terms, segment by segment.
+    ::std::vector<::std::vector<term_t>> v_terms;
+    v_terms.resize(::obake::safe_cast<decltype(v_terms.size())>(nsegs));
+    ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&x, &f, &v_terms, nsegs](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            const auto &tab = x._get_s_table()[i];
+            auto &v = v_terms[static_cast<decltype(v_terms.size())>(i)];
+
+            v.reserve(static_cast<decltype(v.size())>(tab.size()));
+
+            auto emit = [&v, nsegs](key_t &&k, cf_t &&c) {
+                if (!::obake::is_zero(::std::as_const(c))) {
+                    const auto seg_idx = static_cast<s_size_t>(::obake::hash(::std::as_const(k)) & (nsegs - 1u));
+                    v.push_back(term_t{seg_idx, 0, ::std::move(k), ::std::move(c)});
+                }
+            };
+
+            for (const auto &t : tab) {
+                f(t, emit);
+            }
+        }
+    });
+
+    // Concatenate the produced terms.
+    // NOTE: the total number of produced terms is
+    // the size of data already in memory, thus there
+    // are no overflow concerns here.
+    ::std::vector<::std::size_t> offsets;
+    offsets.reserve(v_terms.size() + 1u);
+    offsets.push_back(0);
+    for (const auto &v : v_terms) {
+        offsets.push_back(offsets.back() + static_cast<::std::size_t>(v.size()));
+    }
+    ::std::vector<term_t> terms;
+    terms.resize(::obake::safe_cast<decltype(terms.size())>(offsets.back()));
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(v_terms.size())>(0, v_terms.size()),
+                        [&v_terms, &offsets, &terms](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                auto pos = offsets[i];
+                                for (auto &t : v_terms[i]) {
+                                    t.pos = pos;
+                                    terms[static_cast<decltype(terms.size())>(pos++)] = ::std::move(t);
+                                }
+
+                                // Free the memory.
+                                v_terms[i] = ::std::vector<term_t>{};
+                            }
+                        });
+
+    // Sort according to the destination segment.
+    ::tbb::parallel_sort(terms.begin(), terms.end(), [](const term_t &t1, const term_t &t2) {
+        return t1.seg_idx < t2.seg_idx || (t1.seg_idx == t2.seg_idx && t1.pos < t2.pos);
+    });
+
+    // Fill in retval, segment by segment.
+    ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&retval, &terms](const auto &range) {
+        for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+            auto &table = retval._get_s_table()[seg_idx];
+
+            // Locate the range of terms which
+            // end up in the current segment.
+            const auto r_begin
+                = ::std::lower_bound(terms.begin(), terms.end(), seg_idx,
+                                     [](const term_t &t, const s_size_t &s_idx) { return t.seg_idx < s_idx; });
+            const auto r_end
+                = ::std::upper_bound(r_begin, terms.end(), seg_idx,
+                                     [](const s_size_t &s_idx, const term_t &t) { return s_idx < t.seg_idx; });
+
+            table.reserve(static_cast<decltype(table.size())>(r_end - r_begin));
+
+            for (auto it = r_begin; it != r_end; ++it) {
+                // NOTE: the keys are compatible (they were produced
+                // by monomial operations on compatible keys), but they
+                // may not be unique and the accumulation may result in zero.
+                ::obake::detail::series_add_term_table<true, ::obake::detail::sat_check_zero::on,
+                                                       ::obake::detail::sat_check_compat_key::off,
+                                                       ::obake::detail::sat_check_table_size::on,
+                                                       ::obake::detail::sat_assume_unique::off>(
+                    retval, table, ::std::move(it->key), ::std::move(it->cf));
+            }
+        }
+    });
+}
+
 // Meta-programming for the selection of the
 // diff() algorithm.
 template <typename T>
@@ -2625,6 +6806,24 @@ inline auto poly_diff_impl(T &&x_, const ::std::string &s)
         retval.set_symbol_set_fw(ss_fw);
         retval.tag() = x.tag();
         retval.set_n_segments(x.get_s_size());
+
+        if (x.get_s_size() > 0u) {
+            // Segmented x: produce the terms in parallel.
+            detail::poly_termwise_segmented(retval, x, [&s, idx, s_present, &ss](const auto &t, auto &emit) {
+                const auto &k = t.first;
+                const auto &c = t.second;
+
+                emit(series_key_t<ret_t>(k), ::obake::diff(c, s));
+
+                if (s_present) {
+                    auto key_diff(::obake::monomial_diff(k, idx, ss));
+                    emit(::std::move(key_diff.second), c * ::std::move(key_diff.first));
+                }
+            });
+
+            return retval;
+        }
+
         retval.reserve(x.size());
 
         for (const auto &t : x) {
@@ -2671,6 +6870,218 @@ requires Polynomial<remove_cvref_t<T>> &&(detail::poly_diff_algo<T &&> != 0) inl
 namespace detail
 {
 
+// Detect the presence of a monomial_gradient() implementation
+// for the key type K (found via ADL).
+template <typename K>
+using poly_monomial_gradient_t = decltype(monomial_gradient(
+    ::std::declval<::std::vector<remove_cvref_t<::obake::detail::monomial_diff_t<const K &>>> &>(),
+    ::std::declval<const K &>(), ::std::declval<const symbol_set &>()));
+
+// Compute the derivatives of the monomial k with respect to all
+// the symbols in ss, writing them into out. If the key type does not
+// provide a monomial_gradient() implementation, fall back to
+// the differentiation symbol by symbol.
+template <typename K>
+inline void poly_monomial_gradient(::std::vector<remove_cvref_t<::obake::detail::monomial_diff_t<const K &>>> &out,
+                                   const K &k, const symbol_set &ss)
+{
+    if constexpr (is_detected_v<poly_monomial_gradient_t, K>) {
+        monomial_gradient(out, k, ss);
+    } else {
+        out.clear();
+        for (symbol_idx i = 0; i < ss.size(); ++i) {
+            out.push_back(::obake::monomial_diff(k, i, ss));
+        }
+    }
+}
+
+// Meta-programming for the selection of the
+// gradient() algorithm. The algorithms mirror the diff()
+// ones: if diff() is implemented via term insertions,
+// the gradient is computed in a single pass over the terms,
+// otherwise the polynomial is differentiated with respect
+// to one symbol at a time.
+template <typename T>
+constexpr auto poly_gradient_algorithm_impl()
+{
+    [[maybe_unused]] constexpr auto failure = ::std::make_pair(0, ::obake::detail::type_c<void>{});
+
+    if constexpr (is_polynomial_v<T>) {
+        constexpr auto d_algo = poly_diff_algo<const T &>;
+
+        if constexpr (d_algo == 2) {
+            using exp_t =
+                typename remove_cvref_t<::obake::detail::monomial_diff_t<const series_key_t<T> &>>::first_type;
+
+            if constexpr (is_zero_testable_v<const exp_t &>) {
+                return ::std::make_pair(2, ::obake::detail::type_c<T>{});
+            } else {
+                return ::std::make_pair(1, ::obake::detail::type_c<T>{});
+            }
+        } else if constexpr (d_algo == 1) {
+            return ::std::make_pair(1, ::obake::detail::type_c<poly_diff_ret_t<const T &>>{});
+        } else {
+            return failure;
+        }
+    } else {
+        return failure;
+    }
+}
+
+template <typename T>
+inline constexpr auto poly_gradient_algorithm = detail::poly_gradient_algorithm_impl<T>();
+
+template <typename T>
+inline constexpr int poly_gradient_algo = poly_gradient_algorithm<T>.first;
+
+template <typename T>
+using poly_gradient_ret_t = typename decltype(poly_gradient_algorithm<T>.second)::type;
+
+// Compute the derivatives of x with respect to
+// all the symbols in vars. vars may contain symbols
+// which are not in the symbol set of x.
+template <typename T>
+inline ::std::vector<poly_gradient_ret_t<T>> poly_gradient_impl(const T &x, const symbol_set &vars)
+{
+    using ret_t = poly_gradient_ret_t<T>;
+    constexpr auto algo = poly_gradient_algo<T>;
+
+    // Sanity check.
+    static_assert(algo == 1 || algo == 2);
+
+    ::std::vector<ret_t> retval;
+    retval.reserve(vars.size());
+
+    if constexpr (algo == 1) {
+        for (const auto &s : vars) {
+            retval.push_back(detail::poly_diff_impl(x, s));
+        }
+    } else {
+        // The return type must be the original poly type.
+        static_assert(::std::is_same_v<ret_t, T>);
+
+        using key_t = series_key_t<T>;
+
+        // Cache the symbol set.
+        const auto &ss = x.get_symbol_set();
+        const auto &ss_fw = x.get_symbol_set_fw();
+
+        // Init the return values, using the same symbol set,
+        // tag and segmentation from x.
+        ::std::vector<symbol_idx> v_idx;
+        v_idx.reserve(vars.size());
+        for (const auto &s : vars) {
+            // NOTE: if s is not in the symbol set,
+            // its index will be ss.size().
+            v_idx.push_back(ss.index_of(ss.find(s)));
+
+            ret_t tmp;
+            tmp.set_symbol_set_fw(ss_fw);
+            tmp.tag() = x.tag();
+            tmp.set_n_segments(x.get_s_size());
+            retval.push_back(::std::move(tmp));
+        }
+
+        // Single pass over the terms: each monomial is differentiated
+        // with respect to all the symbols at once, and the results
+        // are distributed among the return values.
+        ::std::vector<remove_cvref_t<::obake::detail::monomial_diff_t<const key_t &>>> grad;
+        for (const auto &t : x) {
+            const auto &k = t.first;
+            const auto &c = t.second;
+
+            detail::poly_monomial_gradient(grad, k, ss);
+            assert(grad.size() == ss.size());
+
+            auto it = vars.begin();
+            for (decltype(vars.size()) i = 0; i < vars.size(); ++i, ++it) {
+                auto &r = retval[i];
+
+                // Add the term corresponding to the differentiation
+                // of the coefficient.
+                auto c_diff(::obake::diff(c, *it));
+                if (!::obake::is_zero(::std::as_const(c_diff))) {
+                    r.add_term(k, ::std::move(c_diff));
+                }
+
+                if (v_idx[i] != ss.size()) {
+                    // The symbol is present in the symbol set,
+                    // add the term corresponding to the differentiation
+                    // of the monomial.
+                    auto &[n, dk] = grad[v_idx[i]];
+                    if (!::obake::is_zero(::std::as_const(n))) {
+                        r.add_term(::std::move(dk), c * ::std::move(n));
+                    }
+                }
+            }
+        }
+    }
+
+    return retval;
+}
+
+// Metaprogramming to establish if the Jacobian of the
+// polynomials in the range R can be computed via jacobian().
+template <typename R>
+constexpr bool poly_jacobian_algorithm_impl()
+{
+    if constexpr (is_input_range_v<R>) {
+        if constexpr (::std::is_lvalue_reference_v<decltype(*::obake::begin(::std::declval<R>()))>) {
+            return poly_gradient_algo<poly_mul_many_value_t<R>> != 0;
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+}
+
+template <typename R>
+inline constexpr bool poly_jacobian_algo = detail::poly_jacobian_algorithm_impl<R>();
+
+} // namespace detail
+
+// Gradient of the polynomial x: the derivatives of x with respect
+// to all the symbols of its symbol set, in the symbol set order.
+template <typename T>
+requires(detail::poly_gradient_algo<T> != 0) inline ::std::vector<detail::poly_gradient_ret_t<T>> gradient(
+    const T &x)
+{
+    return detail::poly_gradient_impl(x, x.get_symbol_set());
+}
+
+// Jacobian of the polynomials in the range r: the i-th row
+// contains the derivatives of the i-th polynomial with respect to
+// the symbols in the union of the symbol sets of the polynomials,
+// in the symbol set order. The rows are computed in parallel.
+template <typename R>
+requires(detail::poly_jacobian_algo<R &&>) inline auto jacobian(R &&r)
+{
+    using p_t = detail::poly_mul_many_value_t<R &&>;
+
+    ::std::vector<const p_t *> v;
+    symbol_set vars;
+    for (auto b = ::obake::begin(r), e = ::obake::end(r); b != e; ++b) {
+        v.push_back(&*b);
+        vars = ::std::get<0>(::obake::detail::merge_symbol_sets(vars, b->get_symbol_set()));
+    }
+
+    ::std::vector<::std::vector<detail::poly_gradient_ret_t<p_t>>> retval;
+    retval.resize(v.size());
+
+    ::tbb::parallel_for(::tbb::blocked_range<decltype(v.size())>(0, v.size()),
+                        [&v, &vars, &retval](const auto &range) {
+                            for (auto i = range.begin(); i != range.end(); ++i) {
+                                retval[i] = detail::poly_gradient_impl(*v[i], vars);
+                            }
+                        });
+
+    return retval;
+}
+
+namespace detail
+{
+
 // Meta-programming for the selection of the
 // integrate() algorithm.
 // NOTE: this currently supports only the case
@@ -2817,6 +7228,24 @@ inline auto poly_integrate_impl(T &&x_, const ::std::string &s)
             retval.set_symbol_set_fw(ss_fw);
             retval.tag() = x.tag();
             retval.set_n_segments(x.get_s_size());
+
+            if (x.get_s_size() > 0u) {
+                // Segmented x: produce the terms in parallel.
+                detail::poly_termwise_segmented(
+                    retval, x, [&s, idx, &ss, &cf_diff_err_msg](const auto &t, auto &emit) {
+                        const auto &c = t.second;
+
+                        if (obake_unlikely(!::obake::is_zero(::obake::diff(c, s)))) {
+                            obake_throw(::std::invalid_argument, cf_diff_err_msg);
+                        }
+
+                        auto key_int(::obake::monomial_integrate(t.first, idx, ss));
+                        emit(::std::move(key_int.second), c / ::std::move(key_int.first));
+                    });
+
+                return retval;
+            }
+
             retval.reserve(x.size());
 
             for (const auto &t : x) {
@@ -2885,6 +7314,20 @@ requires Polynomial<remove_cvref_t<T>> &&(
 
 } // namespace polynomials
 
+// Export the batched multiplication functions.
+using polynomials::mul_many;
+using polynomials::truncated_mul_many;
+
+// Export the product of a range of polynomials.
+using polynomials::prod;
+
+// Export the compiled evaluation program.
+using polynomials::eval_program;
+
+// Export the gradient and Jacobian functions.
+using polynomials::gradient;
+using polynomials::jacobian;
+
 } // namespace obake
 
 #endif
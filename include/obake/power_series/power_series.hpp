@@ -1377,6 +1377,80 @@ requires(detail::ps_mul_algo<p_series<K, C0>, p_series<K, C1>>() == true) inline
         ::obake::get_truncation(ps0), ::obake::get_truncation(ps1));
 }
 
+// In-place multiplication between two power series with the same rank, enabled
+// when the result of the multiplication has the same type as ps0. The truncation
+// rules are the same as in series_mul(), but the terms of ps0 are released
+// during the multiplication (see polynomials::detail::poly_mul_impl_in_place()).
+// NOTE: the truncation limits passed to poly_mul_impl_in_place() are references
+// into the tags of ps0/ps1, which are not accessed after ps0 is overwritten.
+template <typename K, typename C0, typename C1>
+requires(detail::ps_mul_algo<p_series<K, C0>, p_series<K, C1>>() == true) && ::std::is_same_v<
+    ::obake::polynomials::detail::poly_mul_ret_t<p_series<K, C0>, p_series<K, C1>>,
+    p_series<K, C0>> inline p_series<K, C0> &series_in_place_mul(p_series<K, C0> &ps0, const p_series<K, C1> &ps1)
+{
+    // Fetch the (partial) degree type.
+    using deg_t [[maybe_unused]] = decltype(::obake::degree(ps0));
+
+    ::std::visit(
+        [&ps0, &ps1](const auto &v0, const auto &v1) {
+            using type0 = remove_cvref_t<decltype(v0)>;
+            using type1 = remove_cvref_t<decltype(v1)>;
+
+            if constexpr (::std::is_same_v<type0, type1>) {
+                if (obake_unlikely(v0 != v1)) {
+                    throw ::std::invalid_argument(
+                        "Unable to multiply two power series if their truncation levels do not match");
+                }
+
+                // Store the original tag.
+                auto orig_tag = ps0.tag();
+
+                if constexpr (::std::is_same_v<type0, detail::no_truncation>) {
+                    // Untruncated multiplication.
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1);
+                } else if constexpr (::std::is_same_v<type0, deg_t>) {
+                    // Total degree truncation.
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v0);
+                } else {
+                    // Partial degree truncation.
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v0.first, v0.second);
+                }
+
+                ps0.tag() = ::std::move(orig_tag);
+            } else if constexpr (::std::is_same_v<type0, detail::no_truncation>) {
+                // ps0 has no truncation, ps1 has truncation. Run the truncated multiplication
+                // and assign ps1's tag to the result.
+                auto orig_tag = ps1.tag();
+
+                if constexpr (::std::is_same_v<type1, deg_t>) {
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v1);
+                } else {
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v1.first, v1.second);
+                }
+
+                ps0.tag() = ::std::move(orig_tag);
+            } else if constexpr (::std::is_same_v<type1, detail::no_truncation>) {
+                // ps0 has truncation, ps1 has no truncation. Run the truncated multiplication
+                // and restore ps0's tag.
+                auto orig_tag = ps0.tag();
+
+                if constexpr (::std::is_same_v<type0, deg_t>) {
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v0);
+                } else {
+                    polynomials::detail::poly_mul_impl_in_place(ps0, ps1, v0.first, v0.second);
+                }
+
+                ps0.tag() = ::std::move(orig_tag);
+            } else {
+                throw ::std::invalid_argument(
+                    "Unable to multiply two power series if their truncation policies do not match");
+            }
+        },
+        ::obake::get_truncation(ps0), ::obake::get_truncation(ps1));
+
+    return ps0;
+}
+
 // Exponentiation: we re-use the poly implementation, ensuring
 // that the output is properly truncated.
 template <typename T, typename U>
@@ -10,12 +10,15 @@
 #define OBAKE_SERIES_HPP
 
 #include <algorithm>
-#include <any>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <iterator>
+#include <list>
+#include <memory>
 #include <mutex>
 #include <numeric>
 #include <ostream>
@@ -44,6 +47,8 @@
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <mp++/integer.hpp>
 
@@ -58,6 +63,7 @@
 #include <obake/detail/not_implemented.hpp>
 #include <obake/detail/priority_tag.hpp>
 #include <obake/detail/safe_integral_arith.hpp>
+#include <obake/detail/sm_pow_table.hpp>
 #include <obake/detail/ss_func_forward.hpp>
 #include <obake/detail/to_string.hpp>
 #include <obake/detail/type_c.hpp>
@@ -77,6 +83,7 @@
 #include <obake/key/key_trim_identify.hpp>
 #include <obake/math/degree.hpp>
 #include <obake/math/evaluate.hpp>
+#include <obake/math/fma3.hpp>
 #include <obake/math/is_zero.hpp>
 #include <obake/math/negate.hpp>
 #include <obake/math/p_degree.hpp>
@@ -540,6 +547,65 @@ namespace detail
         }
     };
 
+    // Cache for the hash of a series. The hash is computed
+    // lazily from const member functions (possibly from
+    // multiple threads at the same time), and it is invalidated
+    // by the member functions which might alter the keys or
+    // the tag of the series. Hence the atomics.
+    class series_hash_cache
+    {
+    public:
+        series_hash_cache() = default;
+        series_hash_cache(const series_hash_cache &other) noexcept
+        {
+            *this = other;
+        }
+        series_hash_cache &operator=(const series_hash_cache &other) noexcept
+        {
+            if (other.m_valid.load(::std::memory_order_acquire)) {
+                set(other.m_value.load(::std::memory_order_relaxed));
+            } else {
+                invalidate();
+            }
+
+            return *this;
+        }
+
+        bool is_valid() const noexcept
+        {
+            return m_valid.load(::std::memory_order_acquire);
+        }
+        // NOTE: this can be called only if is_valid()
+        // returned true.
+        ::std::size_t get() const noexcept
+        {
+            assert(is_valid());
+
+            return m_value.load(::std::memory_order_relaxed);
+        }
+        // NOTE: concurrent invocations of set() are allowed,
+        // as long as they all store the same value.
+        void set(::std::size_t h) const noexcept
+        {
+            m_value.store(h, ::std::memory_order_relaxed);
+            m_valid.store(true, ::std::memory_order_release);
+        }
+        void invalidate() noexcept
+        {
+            // NOTE: avoid the store (and the related cache line traffic)
+            // if the cache is already invalid. This function is invoked
+            // on every mutable access to the tables of a series, which
+            // can happen concurrently from multiple threads.
+            if (m_valid.load(::std::memory_order_relaxed)) {
+                m_valid.store(false, ::std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        mutable ::std::atomic<bool> m_valid = false;
+        mutable ::std::atomic<::std::size_t> m_value = 0;
+    };
+
     // Small helper to clear() a nonconst
     // rvalue reference to a series. This is used in various places
     // where we might end up moving away individual coefficients from an input series,
@@ -698,8 +764,11 @@ public:
     series(const series &) = default;
     series(series &&other) noexcept
         : m_s_table(::std::move(other.m_s_table)), m_log2_size(::std::move(other.m_log2_size)),
-          m_tag(::std::move(other.m_tag)), m_symbol_set(::std::move(other.m_symbol_set))
+          m_tag(::std::move(other.m_tag)), m_symbol_set(::std::move(other.m_symbol_set)),
+          m_hash_cache(other.m_hash_cache)
     {
+        other.m_hash_cache.invalidate();
+
 #if !defined(NDEBUG)
         // In debug mode, clear the other segmented table
         // in order to flag that other was moved from.
@@ -859,6 +928,10 @@ public:
         m_log2_size = ::std::move(other.m_log2_size);
         m_tag = ::std::move(other.m_tag);
         m_symbol_set = ::std::move(other.m_symbol_set);
+        m_hash_cache = other.m_hash_cache;
+        // NOTE: in case of self-assignment, this will
+        // just discard the cached hash.
+        other.m_hash_cache.invalidate();
 
 #if !defined(NDEBUG)
         // NOTE: see above.
@@ -968,6 +1041,10 @@ public:
         swap(m_log2_size, other.m_log2_size);
         swap(m_tag, other.m_tag);
         swap(m_symbol_set, other.m_symbol_set);
+
+        const auto tmp_hc(m_hash_cache);
+        m_hash_cache = other.m_hash_cache;
+        other.m_hash_cache = tmp_hc;
     }
 
     bool empty() const noexcept
@@ -1295,8 +1372,17 @@ public:
     }
 
     // Extract a reference to the internal segmented table.
+    // NOTE: the mutable variant discards the cached hash,
+    // as the keys may be altered through the returned reference.
+    // The invalidation takes place only when this function is invoked,
+    // thus the returned reference must not be used to alter the keys
+    // after the hash has been (re)computed via _get_hash(): the
+    // reference must be re-fetched instead. Read-only accesses
+    // should use the const overload, which preserves the cached hash.
     auto &_get_s_table()
     {
+        m_hash_cache.invalidate();
+
         return m_s_table;
     }
     const auto &_get_s_table() const
@@ -1304,6 +1390,67 @@ public:
         return m_s_table;
     }
 
+    // Hash of the series, computed from the tag (if hashable)
+    // and from the keys (that is, the coefficients and the symbol set
+    // are not taken into account). The hash is cached and it is
+    // recomputed lazily, after the keys or the tag have been altered.
+    ::std::size_t _get_hash() const
+    {
+        if (m_hash_cache.is_valid()) {
+            return m_hash_cache.get();
+        }
+
+        // Init retval with the hash of the tag, if available,
+        // zero otherwise.
+        auto retval = [this]() -> ::std::size_t {
+            if constexpr (is_hashable_v<const Tag &>) {
+                return ::obake::hash(m_tag);
+            } else {
+                return 0;
+            }
+        }();
+
+        // Combine the hashes of all keys
+        // via addition, so that their order
+        // does not matter.
+        // NOTE: use the same hasher used in the implementation
+        // of the tables.
+        auto table_hash = [](const table_type &tab) {
+            ::std::size_t ret = 0;
+            for (const auto &t : tab) {
+                ret += detail::series_key_hasher{}(t.first);
+            }
+
+            return ret;
+        };
+
+        const auto st_size = m_s_table.size();
+        if (st_size > 1u) {
+            // Segmented table, hash the tables in parallel.
+            retval += ::tbb::parallel_reduce(
+                ::tbb::blocked_range(m_s_table.begin(), m_s_table.end()), ::std::size_t(0),
+                [&table_hash](const auto &r, ::std::size_t init) {
+                    for (const auto &tab : r) {
+                        init += table_hash(tab);
+                    }
+
+                    return init;
+                },
+                [](auto n1, auto n2) { return n1 + n2; });
+        } else if (st_size != 0u) {
+            retval += table_hash(m_s_table[0]);
+        }
+
+        m_hash_cache.set(retval);
+
+        return retval;
+    }
+    // Check if the hash of the series is currently cached.
+    bool _hash_is_cached() const noexcept
+    {
+        return m_hash_cache.is_valid();
+    }
+
     // Reserve enough space for n elements.
     void reserve(size_type n)
     {
@@ -1339,6 +1486,7 @@ public:
         // NOTE: construct + move assign for exception safety.
         m_s_table = s_table_type(s_size_type(1) << l);
         m_log2_size = l;
+        m_hash_cache.invalidate();
     }
 
     // Remove all the terms in the series.
@@ -1349,6 +1497,7 @@ public:
         for (auto &t : m_s_table) {
             t.clear();
         }
+        m_hash_cache.invalidate();
     }
 
     // Clear the series.
@@ -1446,8 +1595,11 @@ public:
     }
 
     // Tag access.
+    // NOTE: the mutable variant discards the cached hash.
     Tag &tag() &
     {
+        m_hash_cache.invalidate();
+
         return m_tag;
     }
     const Tag &tag() const &
@@ -1559,6 +1711,7 @@ private:
     unsigned m_log2_size;
     Tag m_tag;
     detail::ss_fw m_symbol_set;
+    detail::series_hash_cache m_hash_cache;
 };
 
 } // namespace obake
@@ -1613,21 +1766,98 @@ inline bool series_cmp_identical_ss(const T &lhs, const U &rhs)
         return false;
     }
 
-    // Cache the end iterator of rhs.
-    const auto rhs_end = rhs.end();
-    // NOTE: this can be parallelised and
-    // improved performance-wise by having specialised
-    // codepaths for single table layout, same
-    // n segments, etc. Keep it in mind for
-    // future optimisations.
-    for (const auto &[k, c] : lhs) {
-        const auto it = rhs.find(k);
-        if (it == rhs_end || c != it->second) {
+    // If the hashes of both series are cached, use them
+    // to quickly detect series which cannot be equal.
+    // NOTE: the hashes account for the tags, thus we can
+    // do this only if the tags have been compared above
+    // (or if they are not hashed at all).
+    if constexpr (::std::disjunction_v<is_equality_comparable<const series_tag_t<T> &>,
+                                       ::std::negation<is_hashable<const series_tag_t<T> &>>>) {
+        if (lhs._hash_is_cached() && rhs._hash_is_cached() && lhs._get_hash() != rhs._get_hash()) {
             return false;
         }
     }
 
-    return true;
+    // Check that all the terms of a are in b. The iteration
+    // is driven by the series with the largest number of tables,
+    // so that segmented series can be compared in parallel.
+    // NOTE: this is enough to establish equality, because
+    // the two series have the same size.
+    auto cmp_impl = [](const auto &a, const auto &b) {
+        using s_size_t = typename remove_cvref_t<decltype(a)>::s_size_type;
+
+        const auto &a_st = a._get_s_table();
+        const auto &b_st = b._get_s_table();
+
+        if (a_st.size() == 1u) {
+            // Single table, compare serially.
+            const auto b_end = b.end();
+            for (const auto &[k, c] : a_st[0]) {
+                const auto it = b.find(k);
+                if (it == b_end || c != it->second) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        // NOTE: if the number of segments is the same,
+        // the terms with the same key are in tables with
+        // the same index, and we can look them up directly
+        // in the tables of b.
+        const auto same_segs = a_st.size() == b_st.size();
+
+        // Flag to signal that a difference was found,
+        // so that the other tasks can exit early.
+        ::std::atomic<bool> differ = false;
+
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, a_st.size()), [&](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                const auto &a_tab = a_st[i];
+
+                if (same_segs) {
+                    const auto &b_tab = b_st[i];
+
+                    if (a_tab.size() != b_tab.size()) {
+                        differ.store(true, ::std::memory_order_relaxed);
+                        return;
+                    }
+
+                    for (const auto &[k, c] : a_tab) {
+                        if (differ.load(::std::memory_order_relaxed)) {
+                            return;
+                        }
+
+                        const auto it = b_tab.find(k);
+                        if (it == b_tab.end() || c != it->second) {
+                            differ.store(true, ::std::memory_order_relaxed);
+                            return;
+                        }
+                    }
+                } else {
+                    const auto b_end = b.end();
+                    for (const auto &[k, c] : a_tab) {
+                        if (differ.load(::std::memory_order_relaxed)) {
+                            return;
+                        }
+
+                        const auto it = b.find(k);
+                        if (it == b_end || c != it->second) {
+                            differ.store(true, ::std::memory_order_relaxed);
+                            return;
+                        }
+                    }
+                }
+            }
+        });
+
+        return !differ.load(::std::memory_order_relaxed);
+    };
+
+    // NOTE: the coefficient types are equality-comparable
+    // in both directions, thus we can swap the roles of lhs and rhs.
+    return lhs.get_s_size() >= rhs.get_s_size() ? cmp_impl(lhs, rhs) : cmp_impl(rhs, lhs);
 }
 
 // Helper to determine if two series of the same type are identical.
@@ -1639,78 +1869,164 @@ inline bool series_are_identical(const S &s1, const S &s2)
     return s1.get_symbol_set_fw() == s2.get_symbol_set_fw() && internal::series_cmp_identical_ss(s1, s2);
 }
 
-// The series pow cache for a specific series type.
-// It maps a series instance x to a vector of natural
-// powers of x. Everything is type-erased as we need
-// to store instances of this type as elements of another map.
-// NOTE: the key in this map is the base, the vectors
-// are the base raised to its natural powers. All these
-// std::any will contain instances of the base type.
-using series_te_pow_map_t = ::std::unordered_map<::std::any, ::std::vector<::std::any>,
-                                                 // Hashing functor.
-                                                 ::std::function<::std::size_t(const ::std::any &)>,
-                                                 // Equality comparator.
-                                                 ::std::function<bool(const ::std::any &, const ::std::any &)>>;
-
-// Series pow cache. It maps a C++ series type, represented
-// as a type_index, to a series_te_pow_map_t map.
-using series_pow_map_t = ::std::unordered_map<::std::type_index, series_te_pow_map_t>;
-
-// Function to fetch the global series pow cache and associated mutex.
-OBAKE_DLL_PUBLIC ::std::tuple<series_pow_map_t &, ::std::mutex &> get_series_pow_map();
-
-// Function to clear the global series pow cache.
+} // namespace customisation::internal
+
+// Statistics of the series pow cache.
+struct series_pow_cache_stats {
+    // Number of lookups which found
+    // the base in the cache.
+    unsigned long long hits = 0;
+    // Number of lookups which did not
+    // find the base in the cache.
+    unsigned long long misses = 0;
+    // Number of bases evicted from the cache.
+    unsigned long long evictions = 0;
+    // Number of bases currently in the cache.
+    ::std::size_t n_entries = 0;
+    // Estimate of the memory currently
+    // used by the cache (in bytes).
+    ::std::size_t n_bytes = 0;
+};
+
+// Fetch the statistics of the series pow cache.
+OBAKE_DLL_PUBLIC series_pow_cache_stats get_series_pow_cache_stats();
+
+// Get/set the maximum amount of memory (in bytes) that
+// can be used by the series pow cache. When the limit is exceeded,
+// the least recently used bases (and their powers) are evicted.
+OBAKE_DLL_PUBLIC ::std::size_t get_series_pow_cache_max_size();
+OBAKE_DLL_PUBLIC void set_series_pow_cache_max_size(::std::size_t);
+
+namespace customisation::internal
+{
+
+struct series_pow_cache_entry_base;
+
+// Base class for the storage of the series pow cache
+// for a specific series type.
+struct OBAKE_DLL_PUBLIC series_pow_cache_base {
+    series_pow_cache_base() = default;
+    series_pow_cache_base(const series_pow_cache_base &) = delete;
+    series_pow_cache_base(series_pow_cache_base &&) = delete;
+    series_pow_cache_base &operator=(const series_pow_cache_base &) = delete;
+    series_pow_cache_base &operator=(series_pow_cache_base &&) = delete;
+    virtual ~series_pow_cache_base();
+
+    // Remove an entry from the storage, returning
+    // the pointer to the entry that was held by the storage.
+    virtual ::std::shared_ptr<series_pow_cache_entry_base> erase(series_pow_cache_entry_base *) = 0;
+};
+
+// Base class for an entry of the series pow cache, that is,
+// a base and its natural powers.
+struct OBAKE_DLL_PUBLIC series_pow_cache_entry_base {
+    series_pow_cache_entry_base() = default;
+    series_pow_cache_entry_base(const series_pow_cache_entry_base &) = delete;
+    series_pow_cache_entry_base(series_pow_cache_entry_base &&) = delete;
+    series_pow_cache_entry_base &operator=(const series_pow_cache_entry_base &) = delete;
+    series_pow_cache_entry_base &operator=(series_pow_cache_entry_base &&) = delete;
+    virtual ~series_pow_cache_entry_base();
+
+    // The storage the entry belongs to. This is null
+    // if the entry is not in the cache (e.g., because
+    // it was evicted).
+    series_pow_cache_base *owner = nullptr;
+    // Position of the entry in the LRU list.
+    ::std::list<series_pow_cache_entry_base *>::iterator lru_it;
+    // Estimate of the memory used by the entry.
+    ::std::size_t n_bytes = 0;
+};
+
+// The global data of the series pow cache.
+struct series_pow_cache_data {
+    // NOTE: the mutex protects all the other data members,
+    // the per-type storages and the entries' members
+    // (including the vectors of powers). It is never held
+    // while the powers are being computed. The lookups, which
+    // may spawn TBB tasks for segmented bases, are performed
+    // in isolated regions (see series_pow_from_cache() and
+    // series_pow_cache::erase()).
+    ::std::mutex mutex;
+    // The per-type storages.
+    ::std::unordered_map<::std::type_index, ::std::unique_ptr<series_pow_cache_base>> caches;
+    // The entries of all the storages, ordered from
+    // the most recently used to the least recently used.
+    ::std::list<series_pow_cache_entry_base *> lru;
+    // Memory usage and limit.
+    // NOTE: by default, allow the cache
+    // to use up to 1GB of memory.
+    ::std::size_t n_bytes = 0;
+    ::std::size_t max_size = ::std::size_t(1) << 30;
+    // Statistics.
+    unsigned long long hits = 0, misses = 0, evictions = 0;
+};
+
+// Function to fetch the global series pow cache.
+OBAKE_DLL_PUBLIC series_pow_cache_data &get_series_pow_cache();
+
+// Evict entries from the LRU end of the series pow cache until
+// the memory limit is satisfied. The evicted entries are appended
+// to the output vector, so that they can be destroyed after
+// the mutex has been released. Must be called with the mutex held.
+OBAKE_DLL_PUBLIC void series_pow_cache_evict(series_pow_cache_data &,
+                                             ::std::vector<::std::shared_ptr<series_pow_cache_entry_base>> &);
+
+// Function to clear the global series pow cache
+// (including the statistics).
 OBAKE_DLL_PUBLIC void clear_series_pow_map();
 
-// Fetch the n-th natural power of the input
-// series 'base' from the global cache. If the
-// power is not present in the cache already,
-// it will be computed on the fly.
+// An entry of the series pow cache: a base
+// and the (possibly not yet computed) natural
+// powers of the base.
 template <typename Base>
-inline Base series_pow_from_cache(const Base &base, unsigned n)
-{
-    // Fetch the global data.
-    auto [map, mutex] = internal::get_series_pow_map();
+struct series_pow_cache_entry final : series_pow_cache_entry_base {
+    explicit series_pow_cache_entry(const Base &b) : base(b)
+    {
+        // Init the powers with base**0 = 1.
+        // NOTE: constructability from 1 is ensured by the
+        // constructability of the return coefficient type from int
+        // (and the return type is guaranteed to be the same as
+        // the Base type in series_pow_from_cache()).
+        ::std::promise<Base> p;
+        p.set_value(Base(1));
+        powers.push_back(p.get_future().share());
+
+        n_bytes = ::obake::byte_size(base) + ::obake::byte_size(powers[0].get());
+    }
 
-    // Turn the type into a type_index.
-    ::std::type_index t_idx(typeid(Base));
+    const Base base;
+    // NOTE: the powers are computed in order by the
+    // threads requesting them. A thread which needs a power
+    // being computed by another thread will wait on the future.
+    ::std::vector<::std::shared_future<Base>> powers;
+};
 
-    // The concrete hasher and equality comparator
-    // functors for use in series_te_pow_map_t.
-    // They will be wrapped in a std::function.
+// The storage of the series pow cache for a specific series type.
+template <typename Base>
+struct series_pow_cache final : series_pow_cache_base {
+    using entry_t = series_pow_cache_entry<Base>;
+
+    // NOTE: the keys are pointers to the bases stored
+    // in the entries, so that the lookups can be done without
+    // copying the input base.
+    // NOTE: the hasher and the comparer are invoked with the
+    // global mutex held. Because computing the hash and comparing
+    // segmented series may spawn TBB tasks, the lookups must be
+    // performed in an isolated region (see series_pow_from_cache()
+    // and erase()):
+    // otherwise, while waiting, the current thread could pick up an
+    // unrelated task which in turn invokes pow() and tries to lock
+    // the (non-recursive) mutex again.
     struct hasher {
-        ::std::size_t operator()(const ::std::any &x) const
+        ::std::size_t operator()(const Base *b) const
         {
-            const auto &bcast = ::std::any_cast<const Base &>(x);
-
-            // Init retval with the hash of the tag, if available,
-            // zero otherwise.
-            auto retval = [&bcast]() -> ::std::size_t {
-                if constexpr (is_hashable_v<const series_tag_t<Base> &>) {
-                    return ::obake::hash(bcast.tag());
-                } else {
-                    detail::ignore(bcast);
-                    return 0;
-                }
-            }();
-
-            // Combine the hashes of all terms
-            // via addition, so that their order
-            // does not matter.
-            for (const auto &t : bcast) {
-                // NOTE: use the same hasher used in the implementation
-                // of series.
-                // NOTE: parallelisation opportunities here for
-                // segmented tables.
-                retval += detail::series_key_hasher{}(t.first);
-            }
-
-            return retval;
+            // NOTE: the hash is cached in the series, thus repeated
+            // lookups of the same base do not need to rehash all the terms.
+            return b->_get_hash();
         }
     };
-
     struct comparer {
-        bool operator()(const ::std::any &x, const ::std::any &y) const
+        bool operator()(const Base *b1, const Base *b2) const
         {
             // NOTE: need to use series_are_identical() (and not the comparison operator)
             // because the comparison operator does symbol merging, and thus it is
@@ -1719,42 +2035,191 @@ inline Base series_pow_from_cache(const Base &base, unsigned n)
             // NOTE: with these choices of hasher/comparer, the requirement that
             // cmp(a, b) == true -> hash(a) == hash(b) is always satisfied (even if, say,
             // the user customises series_equal_to()).
-            return internal::series_are_identical(::std::any_cast<const Base &>(x), ::std::any_cast<const Base &>(y));
+            return b1 == b2 || internal::series_are_identical(*b1, *b2);
         }
     };
 
-    // Lock down before accessing the cache.
-    ::std::lock_guard lock(mutex);
-
-    // Try first to locate the series_te_pow_map_t for the current type,
-    // then, in that map, try to locate 'base'. Use try_emplace() so that
-    // table elements are created as needed.
-    auto it = map.try_emplace(t_idx, 0, hasher{}, comparer{}).first->second.try_emplace(base).first;
+    ::std::shared_ptr<series_pow_cache_entry_base> erase(series_pow_cache_entry_base *e) override
+    {
+        // NOTE: this is invoked with the mutex held during eviction, which
+        // may also happen outside series_pow_from_cache() (e.g., when the
+        // memory limit is changed). Thus, isolate the lookup here as well.
+        const auto it = ::tbb::this_task_arena::isolate(
+            [this, e]() { return m_map.find(&static_cast<entry_t *>(e)->base); });
+        assert(it != m_map.end());
 
-    // Fetch a reference to the base and the corresponding
-    // exponentiation vector.
-    const auto &b = ::std::any_cast<const Base &>(it->first);
-    auto &v = it->second;
+        auto retval = ::std::move(it->second);
+        m_map.erase(it);
 
-    // If the exponentiation vector is empty, init it with
-    // base**0 = 1.
-    if (v.empty()) {
-        // NOTE: constructability from 1 is ensured by the
-        // constructability of the return coefficient type from int
-        // (and the return type is guaranteed to be the same as
-        // the Base type in this function).
-        v.emplace_back(Base(1));
+        return retval;
     }
 
-    // Fill in the missing powers as needed.
-    while (v.size() <= n) {
-        v.emplace_back(::std::any_cast<const Base &>(v.back()) * b);
-    }
+    ::std::unordered_map<const Base *, ::std::shared_ptr<entry_t>, hasher, comparer> m_map;
+};
+
+// Fetch the n-th natural power of the input
+// series 'base' from the global cache. If the
+// power is not present in the cache already,
+// it will be computed on the fly.
+template <typename Base>
+inline Base series_pow_from_cache(const Base &base, unsigned n)
+{
+    using cache_t = series_pow_cache<Base>;
+    using entry_t = typename cache_t::entry_t;
+
+    // Fetch the global data.
+    auto &data = internal::get_series_pow_cache();
+
+    // Compute (and cache) the hash of base before locking down.
+    detail::ignore(base._get_hash());
 
-    // Return a copy of the desired power.
-    // NOTE: returnability is guaranteed because
-    // the return type is a series.
-    return ::std::any_cast<const Base &>(v[static_cast<decltype(v.size())>(n)]);
+    // Helper to fetch the storage for the current type.
+    // Must be called with the mutex held.
+    auto get_map = [&data]() -> auto & {
+        auto &ptr = data.caches[::std::type_index(typeid(Base))];
+        if (!ptr) {
+            ptr = ::std::make_unique<cache_t>();
+        }
+
+        return static_cast<cache_t &>(*ptr);
+    };
+
+    // The powers which will be computed by this thread.
+    ::std::vector<::std::promise<Base>> claimed;
+    // The index of the first power in claimed.
+    typename ::std::vector<::std::shared_future<Base>>::size_type first_claimed = 0;
+    // The power preceding the first claimed one,
+    // and the power to be returned.
+    ::std::shared_future<Base> prev_f, ret_f;
+
+    // Helper to mark the entry e as the most recently used one,
+    // and to claim the powers up to n which are not
+    // available yet. Must be called with the mutex held.
+    auto claim = [&](entry_t &e) {
+        data.lru.splice(data.lru.begin(), data.lru, e.lru_it);
+
+        first_claimed = e.powers.size();
+        try {
+            while (e.powers.size() <= n) {
+                e.powers.push_back(claimed.emplace_back().get_future().share());
+            }
+        } catch (...) {
+            // NOTE: roll back the partially-claimed powers, otherwise
+            // the requests for them would wait on promises which
+            // will never be fulfilled. The futures were not visible
+            // to other threads, as the mutex is held.
+            e.powers.resize(first_claimed);
+            claimed.clear();
+
+            throw;
+        }
+
+        if (!claimed.empty()) {
+            prev_f = e.powers[first_claimed - 1u];
+        }
+        ret_f = e.powers[n];
+    };
+
+    // NOTE: the claimed powers are computed (via multiplications which
+    // may spawn TBB tasks) and waited upon in an isolated region:
+    // otherwise, while waiting, the current thread could pick up an
+    // unrelated task which in turn requests a power of the same base,
+    // and then waits on a power claimed by the outer (suspended) frame.
+    // The isolation also covers the lookups, during which the hasher
+    // and the comparer may spawn TBB tasks with the mutex held.
+    return ::tbb::this_task_arena::isolate([&]() -> Base {
+        ::std::shared_ptr<entry_t> e;
+        // NOTE: the entries evicted from the cache
+        // will be destroyed after the mutex has been released.
+        ::std::vector<::std::shared_ptr<series_pow_cache_entry_base>> evicted;
+
+        {
+            ::std::lock_guard lock(data.mutex);
+
+            auto &map = get_map().m_map;
+            if (const auto it = map.find(&base); it != map.end()) {
+                ++data.hits;
+                e = it->second;
+                claim(*e);
+            }
+        }
+
+        if (!e) {
+            // Cache miss: create a new entry, copying
+            // the base outside the lock.
+            auto new_e = ::std::make_shared<entry_t>(base);
+
+            ::std::lock_guard lock(data.mutex);
+
+            ++data.misses;
+
+            auto &c = get_map();
+            const auto [it, inserted] = c.m_map.try_emplace(&new_e->base, new_e);
+            if (inserted) {
+                new_e->owner = &c;
+                new_e->lru_it = data.lru.insert(data.lru.begin(), new_e.get());
+                data.n_bytes += new_e->n_bytes;
+            }
+            // NOTE: if the entry was not inserted, it means that another
+            // thread inserted the same base in the meantime.
+            e = it->second;
+            claim(*e);
+
+            // NOTE: evict here as well, as the insertion may exceed
+            // the memory limit and the computation of the powers
+            // below may fail before the next eviction.
+            internal::series_pow_cache_evict(data, evicted);
+        }
+
+        if (!claimed.empty()) {
+            // Compute the claimed powers, in order.
+            decltype(claimed.size()) i = 0;
+            ::std::size_t n_bytes = 0;
+
+            try {
+                // NOTE: the preceding power may be in the
+                // process of being computed by another thread.
+                auto cur = prev_f.get();
+                for (; i < claimed.size(); ++i) {
+                    cur = cur * e->base;
+                    n_bytes += ::obake::byte_size(cur);
+                    claimed[i].set_value(cur);
+                }
+            } catch (...) {
+                // Propagate the error to the threads waiting
+                // on the claimed powers.
+                for (; i < claimed.size(); ++i) {
+                    claimed[i].set_exception(::std::current_exception());
+                }
+
+                // Remove the claimed powers from the entry,
+                // so that they will be recomputed by the
+                // next request.
+                ::std::lock_guard lock(data.mutex);
+                if (e->powers.size() > first_claimed) {
+                    e->powers.resize(first_claimed);
+                }
+
+                throw;
+            }
+
+            // Update the memory usage and evict
+            // entries if necessary.
+            ::std::lock_guard lock(data.mutex);
+
+            e->n_bytes += n_bytes;
+            if (e->owner != nullptr) {
+                data.n_bytes += n_bytes;
+            }
+
+            internal::series_pow_cache_evict(data, evicted);
+        }
+
+        // Return a copy of the desired power.
+        // NOTE: returnability is guaranteed because
+        // the return type is a series.
+        return ret_f.get();
+    });
 }
 
 // Metaprogramming to establish the algorithm/return
@@ -1890,22 +2355,42 @@ inline remove_cvref_t<T> operator+(T &&x)
 namespace detail
 {
 
+// Helper to invoke f(i) for each table index i
+// of the series s. If s has multiple tables,
+// the invocations are performed in parallel.
+template <typename S, typename F>
+inline void series_for_each_table(const S &s, const F &f)
+{
+    using s_size_t = typename S::s_size_type;
+
+    const auto n_tables = s._get_s_table().size();
+
+    if (n_tables > 1u) {
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, n_tables), [&f](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                f(i);
+            }
+        });
+    } else {
+        f(s_size_t(0));
+    }
+}
+
 // Default implementation of obake::negate() for series.
 template <typename T>
 inline void series_default_negate_impl(T &&x)
 {
     static_assert(is_cvr_series_v<T>);
-    for (auto &p : x) {
-        // NOTE: the runtime requirements
-        // of negate() ensure that the coefficient
-        // will never become zero after negation.
-        // NOTE: perhaps this can be improved
-        // performance-wise by taking advantage
-        // of the single-table layout, if possible.
-        // NOTE: this could be parallelised,
-        // in case of multiple tables.
-        ::obake::negate(p.second);
-    }
+
+    auto &s_table = x._get_s_table();
+    detail::series_for_each_table(x, [&s_table](const auto &i) {
+        for (auto &p : s_table[i]) {
+            // NOTE: the runtime requirements
+            // of negate() ensure that the coefficient
+            // will never become zero after negation.
+            ::obake::negate(p.second);
+        }
+    });
 }
 
 } // namespace detail
@@ -2363,6 +2848,125 @@ inline constexpr auto series_default_addsub_algorithm = detail::series_default_a
 template <bool Sign, typename T, typename U>
 using series_default_addsub_ret_t = typename decltype(series_default_addsub_algorithm<Sign, T, U>.second)::type;
 
+// Helper to add/sub the terms of the series rhs to/from
+// the segmented series lhs. lhs and rhs must have identical
+// symbol sets and key types. If lhs and rhs have the same
+// segmentation, the terms in the i-th segment of rhs
+// end up in the i-th segment of lhs, thus the segments can
+// be merged independently from each other in parallel.
+// Otherwise, the terms of rhs are first sorted according
+// to their destination segments in lhs, and then merged segment
+// by segment in parallel.
+// NOTE: if rhs is a mutable rvalue, its coefficients will be
+// moved into lhs. It is the caller's responsibility to clear
+// out rhs afterwards.
+template <bool Sign, typename S, typename R>
+inline void series_addsub_segmented(S &lhs, R &&rhs)
+{
+    using s_size_t = typename S::s_size_type;
+
+    assert(lhs._get_s_table().size() > 1u);
+    assert(lhs.get_symbol_set_fw() == rhs.get_symbol_set_fw());
+
+    auto &l_tab = lhs._get_s_table();
+    // NOTE: fetch the table of rhs via the mutable overload only if
+    // the coefficients of rhs are going to be moved, so that
+    // the cached hash of an lvalue rhs is preserved.
+    auto &r_tab = [&rhs]() -> auto & {
+        if constexpr (is_mutable_rvalue_reference_v<R &&>) {
+            return rhs._get_s_table();
+        } else {
+            return ::std::as_const(rhs)._get_s_table();
+        }
+    }();
+
+    const auto log2_nsegs = lhs.get_s_size();
+    const auto nsegs = s_size_t(1) << log2_nsegs;
+
+    // Helper to merge the term t of rhs into the lhs table tab.
+    auto merge_term = [&lhs](auto &tab, auto &t) {
+        if constexpr (is_mutable_rvalue_reference_v<R &&>) {
+            // NOTE: turn on the zero check, as we might end up
+            // annihilating terms during insertion.
+            // Compatibility check is not needed.
+            detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                          sat_check_table_size::on, sat_assume_unique::off>(lhs, tab, t.first,
+                                                                                            ::std::move(t.second));
+        } else {
+            detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                                          sat_check_table_size::on, sat_assume_unique::off>(lhs, tab, t.first,
+                                                                                            ::std::as_const(t.second));
+        }
+    };
+
+    if (rhs.get_s_size() == log2_nsegs) {
+        // Same segmentation: merge segment by segment.
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&l_tab, &r_tab, &merge_term](const auto &range) {
+            for (auto i = range.begin(); i != range.end(); ++i) {
+                auto &tab = l_tab[i];
+
+                for (auto &t : r_tab[i]) {
+                    merge_term(tab, t);
+                }
+            }
+        });
+    } else {
+        // Different segmentations: build a vector of (destination segment, pointer
+        // to term) pairs for the terms of rhs, and sort it according to the
+        // destination segments.
+        using term_ptr_t = decltype(&*r_tab[0].begin());
+        using r_s_size_t = typename remove_cvref_t<R>::s_size_type;
+
+        const auto r_nsegs = r_s_size_t(1) << rhs.get_s_size();
+
+        // NOTE: the total number of terms in rhs
+        // is representable by std::size_t.
+        ::std::vector<::std::size_t> offsets;
+        offsets.reserve(static_cast<decltype(offsets.size())>(r_nsegs + 1u));
+        offsets.push_back(0);
+        for (r_s_size_t i = 0; i < r_nsegs; ++i) {
+            offsets.push_back(offsets.back() + static_cast<::std::size_t>(r_tab[i].size()));
+        }
+
+        ::std::vector<::std::pair<s_size_t, term_ptr_t>> v;
+        v.resize(::obake::safe_cast<decltype(v.size())>(offsets.back()));
+        ::tbb::parallel_for(::tbb::blocked_range<r_s_size_t>(0, r_nsegs),
+                            [&r_tab, &offsets, &v, nsegs](const auto &range) {
+                                for (auto i = range.begin(); i != range.end(); ++i) {
+                                    auto idx = offsets[i];
+
+                                    for (auto &t : r_tab[i]) {
+                                        v[idx++] = ::std::make_pair(
+                                            static_cast<s_size_t>(::obake::hash(t.first) & (nsegs - 1u)), &t);
+                                    }
+                                }
+                            });
+
+        // NOTE: the keys in rhs are unique, thus the
+        // order of the terms within each segment does
+        // not affect the result.
+        ::tbb::parallel_sort(v.begin(), v.end(),
+                             [](const auto &p1, const auto &p2) { return p1.first < p2.first; });
+
+        ::tbb::parallel_for(::tbb::blocked_range<s_size_t>(0, nsegs), [&l_tab, &v, &merge_term](const auto &range) {
+            for (auto seg_idx = range.begin(); seg_idx != range.end(); ++seg_idx) {
+                auto &tab = l_tab[seg_idx];
+
+                // Locate the range of terms which
+                // end up in the current segment.
+                const auto r_begin = ::std::lower_bound(
+                    v.begin(), v.end(), seg_idx, [](const auto &p, const s_size_t &s_idx) { return p.first < s_idx; });
+                const auto r_end = ::std::upper_bound(
+                    r_begin, v.end(), seg_idx, [](const s_size_t &s_idx, const auto &p) { return s_idx < p.first; });
+
+                for (auto it = r_begin; it != r_end; ++it) {
+                    merge_term(tab, *it->second);
+                }
+            }
+        });
+    }
+}
+
 // Default implementation of the add/sub primitive for series.
 template <bool Sign, typename T, typename U>
 inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(T &&x, U &&y)
@@ -2445,25 +3049,7 @@ inline series_default_addsub_ret_t<Sign, T &&, U &&> series_default_addsub_impl(
                 // Distinguish the two cases in which the internal table
                 // is segmented or not.
                 if (retval._get_s_table().size() > 1u) {
-                    for (auto &t : rhs) {
-                        // NOTE: old clang does not like structured
-                        // bindings in the for loop.
-                        auto &k = t.first;
-                        auto &c = t.second;
-
-                        if constexpr (is_mutable_rvalue_reference_v<rhs_t &&>) {
-                            // NOTE: turn on the zero check, as we might end up
-                            // annihilating terms during insertion.
-                            // Compatibility check is not needed.
-                            detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                    sat_check_table_size::on, sat_assume_unique::off>(retval, k,
-                                                                                                      ::std::move(c));
-                        } else {
-                            detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                    sat_check_table_size::on, sat_assume_unique::off>(
-                                retval, k, ::std::as_const(c));
-                        }
-                    }
+                    detail::series_addsub_segmented<Sign>(retval, ::std::forward<rhs_t>(rhs));
                 } else {
                     assert(retval._get_s_table().size() == 1u);
 
@@ -2743,7 +3329,12 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
         // Both T and U are series, same rank, possibly different cf (but same key).
 
         // Implementation for identical symbol sets.
-        auto in_place_with_identical_ss = [](auto &lhs, auto &&rhs) {
+        // NOTE: use a bool_constant parameter for the sign,
+        // as the implementation is re-used below with a sign
+        // which may differ from Sign.
+        auto in_place_merge = [](auto s, auto &lhs, auto &&rhs) {
+            constexpr bool S = decltype(s)::value;
+
             assert(lhs.get_symbol_set_fw() == rhs.get_symbol_set_fw());
 
             // We may end up moving coefficients from rhs.
@@ -2754,25 +3345,7 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
             // Distinguish the two cases in which the lhs table
             // is segmented or not.
             if (lhs._get_s_table().size() > 1u) {
-                for (auto &t : rhs) {
-                    // NOTE: old clang does not like structured
-                    // bindings in the for loop.
-                    auto &k = t.first;
-                    auto &c = t.second;
-
-                    if constexpr (is_mutable_rvalue_reference_v<rhs_t &&>) {
-                        // NOTE: turn on the zero check, as we might end up
-                        // annihilating terms during insertion.
-                        // Compatibility check is not needed.
-                        detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                sat_check_table_size::on, sat_assume_unique::off>(lhs, k,
-                                                                                                  ::std::move(c));
-                    } else {
-                        detail::series_add_term<Sign, sat_check_zero::on, sat_check_compat_key::off,
-                                                sat_check_table_size::on, sat_assume_unique::off>(lhs, k,
-                                                                                                  ::std::as_const(c));
-                    }
-                }
+                detail::series_addsub_segmented<S>(lhs, ::std::forward<rhs_t>(rhs));
             } else {
                 assert(lhs._get_s_table().size() == 1u);
 
@@ -2787,11 +3360,11 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
                     if constexpr (is_mutable_rvalue_reference_v<rhs_t &&>) {
                         // NOTE: disable the table size check, as we are
                         // sure we have a single table.
-                        detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                        detail::series_add_term_table<S, sat_check_zero::on, sat_check_compat_key::off,
                                                       sat_check_table_size::off, sat_assume_unique::off>(
                             lhs, t, k, ::std::move(c));
                     } else {
-                        detail::series_add_term_table<Sign, sat_check_zero::on, sat_check_compat_key::off,
+                        detail::series_add_term_table<S, sat_check_zero::on, sat_check_compat_key::off,
                                                       sat_check_table_size::off, sat_assume_unique::off>(
                             lhs, t, k, ::std::as_const(c));
                     }
@@ -2799,6 +3372,41 @@ inline series_default_in_place_addsub_ret_t<Sign, T &&, U &&> series_default_in_
             }
         };
 
+        auto in_place_with_identical_ss = [&in_place_merge](auto &lhs, auto &&rhs) {
+            using rhs_t = decltype(rhs);
+
+            // NOTE: in subtractions, the adopted terms need to be negated,
+            // thus the adoption requires negatable coefficients.
+            if constexpr (::std::conjunction_v<is_mutable_rvalue_reference<rhs_t &&>,
+                                               ::std::is_same<remove_cvref_t<rhs_t>, rT>,
+                                               ::std::bool_constant<Sign || is_negatable_v<series_cf_t<rT> &>>>) {
+                if (rhs.size() > lhs.size()) {
+                    // rhs is a larger rvalue of the same type as lhs: adopt
+                    // its tables (and its segmentation) wholesale, and then
+                    // merge the original terms of lhs into them.
+                    // NOTE: the tag of lhs is preserved. This covers the
+                    // common case of an empty or unsegmented accumulator
+                    // to which a large segmented product is added.
+                    {
+                        using ::std::swap;
+                        swap(lhs, rhs);
+                        swap(lhs.tag(), rhs.tag());
+                    }
+
+                    if constexpr (!Sign) {
+                        // lhs - rhs == -rhs + lhs.
+                        detail::series_default_negate_impl(lhs);
+                    }
+
+                    in_place_merge(::std::true_type{}, lhs, ::std::forward<rhs_t>(rhs));
+
+                    return;
+                }
+            }
+
+            in_place_merge(::std::bool_constant<Sign>{}, lhs, ::std::forward<rhs_t>(rhs));
+        };
+
         if (x.get_symbol_set_fw() == y.get_symbol_set_fw()) {
             // Same symbol sets, run the implementation
             // directly on x and y.
@@ -3160,17 +3768,16 @@ inline series_default_mul_ret_t<T &&, U &&> series_default_mul_impl(T &&x, U &&y
         // Init the return value from the higher-rank series.
         ret_t retval(::std::forward<decltype(a)>(a));
 
-        // Multiply in-place all coefficients of retval by b.
+        // Multiply in-place all coefficients of retval by b,
+        // table by table (in parallel for a segmented table).
         // Store in a vector the keys of the terms
         // whose coefficients become zero after
         // the multiplication, so that we can remove them.
-        // NOTE: this can be parallelised for a segmented table.
         auto &s_table = retval._get_s_table();
-        ::std::vector<series_key_t<ret_t>> v_keys;
         try {
-            for (auto &t : s_table) {
-                // Reset the vector of keys to be removed.
-                v_keys.clear();
+            detail::series_for_each_table(retval, [&s_table, &b](const auto &i) {
+                auto &t = s_table[i];
+                ::std::vector<series_key_t<ret_t>> v_keys;
 
                 // Perform the multiplications for this table.
                 for (auto &[k, c] : t) {
@@ -3187,7 +3794,7 @@ inline series_default_mul_ret_t<T &&, U &&> series_default_mul_impl(T &&x, U &&y
                     assert(t.find(k) != t.end());
                     t.erase(k);
                 }
-            }
+            });
 
             return retval;
             // LCOV_EXCL_START
@@ -3226,13 +3833,53 @@ requires CvrSeries<T> || CvrSeries<U>
 constexpr auto operator*(T &&x, U &&y)
     OBAKE_SS_FORWARD_FUNCTION(::obake::series_mul(::std::forward<T>(x), ::std::forward<U>(y)));
 
-// NOTE: for now, implement operator*=() in terms of operator*().
-// This can be optimised later performance-wise.
-// NOTE: if this gets optimised for performance, we will probably
-// need to add specialisations for, e.g., power_series.
+namespace customisation
+{
+
+// External customisation point for obake::series_in_place_mul().
+template <typename T, typename U>
+inline constexpr auto series_in_place_mul = not_implemented;
+
+} // namespace customisation
+
+namespace detail
+{
+
+// Highest priority: explicit user override in the external customisation namespace.
+template <typename T, typename U>
+constexpr auto series_in_place_mul_impl(T &&x, U &&y, priority_tag<2>)
+    OBAKE_SS_FORWARD_FUNCTION((customisation::series_in_place_mul<T &&, U &&>)(::std::forward<T>(x),
+                                                                               ::std::forward<U>(y)));
+
+// Unqualified function call implementation.
+template <typename T, typename U>
+constexpr auto series_in_place_mul_impl(T &&x, U &&y, priority_tag<1>)
+    OBAKE_SS_FORWARD_FUNCTION(series_in_place_mul(::std::forward<T>(x), ::std::forward<U>(y)));
+
+// Lowest priority: the default implementation for series, which
+// is implemented in terms of the binary operator.
+template <typename T, typename U>
+constexpr auto series_in_place_mul_impl(T &&x, U &&y, priority_tag<0>)
+    OBAKE_SS_FORWARD_FUNCTION(x = ::std::forward<T>(x) * ::std::forward<U>(y));
+
+} // namespace detail
+
+// NOTE: like in series_in_place_add(), explicitly cast
+// the result of the implementation to an lvalue
+// reference to the type of x.
+inline constexpr auto series_in_place_mul = [](auto &&x, auto &&y) OBAKE_SS_FORWARD_LAMBDA(
+    static_cast<::std::add_lvalue_reference_t<remove_cvref_t<decltype(x)>>>(detail::series_in_place_mul_impl(
+        ::std::forward<decltype(x)>(x), ::std::forward<decltype(y)>(y), detail::priority_tag<2>{})));
+
+// NOTE: the default implementation of series_in_place_mul()
+// is in terms of operator*(). Series types can
+// provide specialised implementations which, e.g., reuse
+// the storage of x (see the polynomial and power series
+// implementations).
 template <typename T, typename U>
 requires CvrSeries<T>
-constexpr auto operator*=(T &&x, U &&y) OBAKE_SS_FORWARD_FUNCTION(x = ::std::forward<T>(x) * ::std::forward<U>(y));
+constexpr auto operator*=(T &&x, U &&y)
+    OBAKE_SS_FORWARD_FUNCTION(::obake::series_in_place_mul(::std::forward<T>(x), ::std::forward<U>(y)));
 
 template <typename T, typename U>
 requires(!CvrSeries<T>)
@@ -3333,11 +3980,13 @@ inline series_default_div_ret_t<T &&, U &&> series_default_div_impl(T &&x, U &&y
     // Init the return value from the higher-rank series.
     ret_t retval(::std::forward<T>(x));
 
-    // Divide in-place all coefficients of retval by y.
-    // NOTE: this can be parallelised for a segmented table.
+    // Divide in-place all coefficients of retval by y,
+    // table by table (in parallel for a segmented table).
     auto &s_table = retval._get_s_table();
     try {
-        for (auto &t : s_table) {
+        detail::series_for_each_table(retval, [&s_table, &y](const auto &i) {
+            auto &t = s_table[i];
+
             // Perform the divisions for this table.
             const auto end = t.end();
             for (auto it = t.begin(); it != end;) {
@@ -3355,7 +4004,7 @@ inline series_default_div_ret_t<T &&, U &&> series_default_div_impl(T &&x, U &&y
                     ++it;
                 }
             }
-        }
+        });
 
         return retval;
     } catch (...) {
@@ -4074,16 +4723,36 @@ struct series_default_evaluate_impl {
         // Thus, si must contain the [0, ss.size()) sequence.
         assert(si.empty() || (si.cend() - 1)->first == (ss.size() - 1u));
 
+        using key_t = series_key_t<remove_cvref_t<T>>;
+
         // NOTE: parallelisation opportunities here.
         ret_t<T &&, U> retval(0);
-        for (const auto &tab : s._get_s_table()) {
-            for (const auto &t : tab) {
-                const auto &k = t.first;
-                const auto &c = t.second;
-
-                // NOTE: there's an opportunity for fma3 here,
-                // but I am not sure it's worth the hassle.
-                retval += ::obake::key_evaluate(k, si, ss) * ::obake::evaluate(c, sm);
+        if constexpr (::std::conjunction_v<
+                          ::std::negation<is_arithmetic<U>>,
+                          ::std::is_same<detected_t<detail::key_evaluate_with_table_t, key_t, U>,
+                                         detail::key_evaluate_t<const key_t &, U>>>) {
+            // The key supports fetching the powers of the
+            // evaluation values from a table shared among all
+            // the terms. This avoids recomputing the same powers
+            // over and over (unless the values are of arithmetic
+            // type, for which the computation is cheaper than the lookup).
+            detail::sm_pow_table<U, typename key_t::value_type> pt(si);
+
+            for (const auto &tab : s._get_s_table()) {
+                for (const auto &t : tab) {
+                    retval += key_evaluate_with_table(t.first, pt, ss) * ::obake::evaluate(t.second, sm);
+                }
+            }
+        } else {
+            for (const auto &tab : s._get_s_table()) {
+                for (const auto &t : tab) {
+                    const auto &k = t.first;
+                    const auto &c = t.second;
+
+                    // NOTE: there's an opportunity for fma3 here,
+                    // but I am not sure it's worth the hassle.
+                    retval += ::obake::key_evaluate(k, si, ss) * ::obake::evaluate(c, sm);
+                }
             }
         }
 
@@ -4097,6 +4766,332 @@ requires(series_default_evaluate_impl::algo<T, U> != 0) inline constexpr auto ev
 
 } // namespace customisation::internal
 
+namespace detail
+{
+
+// A batch of values of type T, used in the batched
+// evaluation of series (see evaluate_batch()). Multiplication
+// and exponentiation act elementwise. A batch constructed
+// from an integer represents the broadcast of a single value
+// to all the elements of the batch.
+// A batch constructed from a vector of values can be given
+// a scratch buffer, which is inherited by its powers. When a
+// broadcast batch is multiplied by a batch with a scratch buffer,
+// the result is written into the buffer (instead of a newly
+// allocated vector), and the broadcast batch becomes a view
+// on the buffer. In this way, the evaluation of a key
+// from the powers of the coordinates does not allocate.
+// NOTE: a view is valid only until the next write into the buffer.
+template <typename T>
+class eval_batch
+{
+public:
+    using size_type = typename ::std::vector<T>::size_type;
+
+    eval_batch() = default;
+    explicit eval_batch(::std::vector<T> v, ::std::vector<T> *buf = nullptr)
+        : m_v(::std::move(v)), m_buf(buf), m_bcast(false)
+    {
+    }
+    eval_batch(int n) : m_scalar(n) {}
+
+    bool is_broadcast() const
+    {
+        return m_bcast;
+    }
+    // Fetch the broadcast value.
+    const T &scalar() const
+    {
+        assert(m_bcast);
+
+        return m_scalar;
+    }
+    // Fetch a pointer to the values of a non-broadcast batch.
+    const T *data() const
+    {
+        assert(!m_bcast);
+
+        return vec().data();
+    }
+
+    // Fetch the value at index i.
+    const T &operator[](size_type i) const
+    {
+        assert(m_bcast || i < vec().size());
+
+        return m_bcast ? m_scalar : vec()[i];
+    }
+
+    eval_batch &operator*=(const eval_batch &other) requires(is_in_place_multipliable_v<T &, const T &>)
+    {
+        if (other.m_bcast) {
+            if (m_bcast) {
+                m_scalar *= other.m_scalar;
+            } else {
+                for (auto &x : vec()) {
+                    x *= other.m_scalar;
+                }
+            }
+        } else if (m_bcast) {
+            const auto &ov = other.vec();
+
+            if (other.m_buf != nullptr && !other.m_view) {
+                // Write the result into the scratch buffer of other.
+                // NOTE: assign() reuses the storage of the buffer
+                // (and of its elements, via copy assignment).
+                auto &buf = *other.m_buf;
+                buf.assign(ov.begin(), ov.end());
+                for (auto &x : buf) {
+                    x *= m_scalar;
+                }
+                m_buf = other.m_buf;
+                m_view = true;
+            } else {
+                auto v = ov;
+                for (auto &x : v) {
+                    x *= m_scalar;
+                }
+                m_v = ::std::move(v);
+            }
+            m_bcast = false;
+        } else {
+            auto &v = vec();
+            const auto &ov = other.vec();
+
+            assert(v.size() == ov.size());
+
+            for (size_type i = 0; i < v.size(); ++i) {
+                v[i] *= ov[i];
+            }
+        }
+
+        return *this;
+    }
+
+    // Elementwise exponentiation.
+    template <typename E>
+    requires(::std::is_same_v<detected_t<pow_t, const T &, const E &>, T>) friend eval_batch
+        pow(const eval_batch &b, const E &n)
+    {
+        eval_batch retval;
+
+        if (b.m_bcast) {
+            retval.m_scalar = ::obake::pow(b.m_scalar, n);
+        } else {
+            const auto &bv = b.vec();
+            retval.m_v.reserve(bv.size());
+            for (const auto &x : bv) {
+                retval.m_v.push_back(::obake::pow(x, n));
+            }
+            retval.m_buf = b.m_buf;
+            retval.m_bcast = false;
+        }
+
+        return retval;
+    }
+
+private:
+    ::std::vector<T> &vec()
+    {
+        return m_view ? *m_buf : m_v;
+    }
+    const ::std::vector<T> &vec() const
+    {
+        return m_view ? *m_buf : m_v;
+    }
+
+    ::std::vector<T> m_v;
+    ::std::vector<T> *m_buf = nullptr;
+    T m_scalar = T{};
+    bool m_bcast = true;
+    bool m_view = false;
+};
+
+// The number of points evaluated together in
+// the batched evaluation of series.
+inline constexpr ::std::size_t series_evaluate_batch_block_size = 512;
+
+// Metaprogramming to establish the algorithm/return
+// type of the batched evaluation of a series of type T
+// at points whose coordinates are of type U.
+template <typename T, typename U>
+constexpr auto series_evaluate_batch_algorithm_impl()
+{
+    [[maybe_unused]] constexpr auto failure = ::std::make_pair(0, detail::type_c<void>{});
+
+    if constexpr (!is_cvr_series_v<T> || !is_semi_regular_v<U>) {
+        return failure;
+    } else {
+        using rT = remove_cvref_t<T>;
+        using key_t = series_key_t<rT>;
+        using cf_t = series_cf_t<rT>;
+
+        // NOTE: the coefficients are evaluated only once
+        // (with an empty evaluation map), thus they cannot
+        // be series themselves. The keys must support
+        // the evaluation via an sm_pow_table, so that
+        // the batches of powers are computed only once.
+        if constexpr (::std::conjunction_v<::std::negation<is_cvr_series<cf_t>>, is_evaluable<const cf_t &, U>,
+                                           ::std::is_same<detected_t<key_evaluate_with_table_t, key_t, eval_batch<U>>,
+                                                          eval_batch<U>>>) {
+            using cf_eval_t = evaluate_t<const cf_t &, U>;
+
+            // The return type is the type of the product of
+            // a key evaluation and a coefficient evaluation.
+            using ret_t = detected_t<mul_t, const U &, const cf_eval_t &>;
+
+            if constexpr (::std::conjunction_v<
+                              // NOTE: these will also verify that ret_t is detected.
+                              is_in_place_addable<::std::add_lvalue_reference_t<ret_t>, ret_t>,
+                              ::std::is_constructible<ret_t, int>, is_semi_regular<ret_t>>) {
+                return ::std::make_pair(1, detail::type_c<ret_t>{});
+            } else {
+                return failure;
+            }
+        } else {
+            return failure;
+        }
+    }
+}
+
+template <typename T, typename U>
+inline constexpr auto series_evaluate_batch_algorithm = detail::series_evaluate_batch_algorithm_impl<T, U>();
+
+template <typename T, typename U>
+inline constexpr int series_evaluate_batch_algo = series_evaluate_batch_algorithm<T, U>.first;
+
+template <typename T, typename U>
+using series_evaluate_batch_ret_t = typename decltype(series_evaluate_batch_algorithm<T, U>.second)::type;
+
+// Batched evaluation of the series s at the points in sm.
+// sm is a structure of arrays, mapping each symbol to the
+// vector of its values at the points. The points are split into
+// blocks which are processed in parallel. For each block, the powers
+// of the coordinates are computed only once (as vectors), each key
+// is evaluated into a scratch buffer reused for all the terms of the
+// block (see eval_batch), and the contribution of each term is
+// accumulated elementwise via fma3() (if available).
+// NOTE: the accumulation loop runs over contiguous arrays, thus
+// it can be vectorised by the compiler only if U and the type of
+// the evaluated coefficients are C++ arithmetic types. For other
+// types (e.g., mp++ classes), the loop is scalar, but it
+// still does not allocate.
+template <typename K, typename C, typename Tag, typename U,
+          ::std::enable_if_t<series_evaluate_batch_algo<const series<K, C, Tag> &, U> != 0, int> = 0>
+inline ::std::vector<series_evaluate_batch_ret_t<const series<K, C, Tag> &, U>>
+evaluate_batch_impl(const series<K, C, Tag> &s, const symbol_map<::std::vector<U>> &sm)
+{
+    using ret_t = series_evaluate_batch_ret_t<const series<K, C, Tag> &, U>;
+    using cf_eval_t = evaluate_t<const C &, U>;
+
+    // Cache the symbol set.
+    const auto &ss = s.get_symbol_set();
+
+    // Determine the number of points.
+    const auto n_points = sm.empty() ? decltype(sm.cbegin()->second.size())(0) : sm.cbegin()->second.size();
+    for (const auto &p : sm) {
+        if (obake_unlikely(p.second.size() != n_points)) {
+            obake_throw(::std::invalid_argument,
+                        "Cannot evaluate a series in batch mode: the number of values for the symbol '" + p.first
+                            + "' (" + detail::to_string(p.second.size())
+                            + ") differs from the number of values for the symbol '" + sm.cbegin()->first + "' ("
+                            + detail::to_string(n_points) + ")");
+        }
+    }
+
+    // Fetch the values of the symbols in ss.
+    ::std::vector<const ::std::vector<U> *> vals;
+    vals.reserve(ss.size());
+    for (const auto &name : ss) {
+        const auto it = sm.find(name);
+
+        if (obake_unlikely(it == sm.cend())) {
+            obake_throw(::std::invalid_argument, "Cannot evaluate a series in batch mode: the symbol '" + name
+                                                     + "' of the series' symbol set, " + detail::to_string(ss)
+                                                     + ", is missing from the evaluation map");
+        }
+
+        vals.push_back(&it->second);
+    }
+
+    // Collect the terms of s, evaluating the coefficients.
+    ::std::vector<::std::pair<const K *, cf_eval_t>> terms;
+    terms.reserve(static_cast<decltype(terms.size())>(s.size()));
+    const symbol_map<U> empty_sm;
+    for (const auto &tab : s._get_s_table()) {
+        for (const auto &t : tab) {
+            terms.emplace_back(&t.first, ::obake::evaluate(t.second, empty_sm));
+        }
+    }
+
+    // Init the return value.
+    ::std::vector<ret_t> retval(n_points, ret_t(0));
+
+    ::tbb::parallel_for(
+        ::tbb::blocked_range<decltype(retval.size())>(0, n_points, series_evaluate_batch_block_size),
+        [&vals, &ss, &terms, &retval](const auto &range) {
+            // The scratch buffer for the evaluation of the keys.
+            ::std::vector<U> scratch;
+
+            for (auto b = range.begin(); b != range.end();) {
+                const auto e = b
+                               + ::std::min(static_cast<decltype(retval.size())>(range.end() - b),
+                                            static_cast<decltype(retval.size())>(series_evaluate_batch_block_size));
+
+                // Fetch the values of the symbols in the current block.
+                symbol_idx_map<eval_batch<U>> bsm;
+                bsm.reserve(vals.size());
+                for (decltype(vals.size()) i = 0; i < vals.size(); ++i) {
+                    bsm.emplace_hint(bsm.cend(), static_cast<symbol_idx>(i),
+                                     eval_batch<U>(::std::vector<U>(vals[i]->cbegin() + static_cast<::std::ptrdiff_t>(b),
+                                                                    vals[i]->cbegin() + static_cast<::std::ptrdiff_t>(e)),
+                                                   &scratch));
+                }
+
+                sm_pow_table<eval_batch<U>, typename K::value_type> pt(bsm);
+
+                auto *rp = retval.data() + b;
+                const auto n = e - b;
+
+                for (const auto &[k, cv] : terms) {
+                    const auto kv = key_evaluate_with_table(*k, pt, ss);
+
+                    if (kv.is_broadcast()) {
+                        // NOTE: this happens only if the
+                        // symbol set is empty.
+                        for (decltype(retval.size()) j = 0; j < n; ++j) {
+                            if constexpr (is_mult_addable_v<ret_t &, const U &, const cf_eval_t &>) {
+                                ::obake::fma3(rp[j], kv.scalar(), cv);
+                            } else {
+                                rp[j] += kv.scalar() * cv;
+                            }
+                        }
+                    } else {
+                        const auto *kp = kv.data();
+
+                        for (decltype(retval.size()) j = 0; j < n; ++j) {
+                            if constexpr (is_mult_addable_v<ret_t &, const U &, const cf_eval_t &>) {
+                                ::obake::fma3(rp[j], kp[j], cv);
+                            } else {
+                                rp[j] += kp[j] * cv;
+                            }
+                        }
+                    }
+                }
+
+                b = e;
+            }
+        });
+
+    return retval;
+}
+
+} // namespace detail
+
+// Batched evaluation of a series (see detail::evaluate_batch_impl()).
+inline constexpr auto evaluate_batch =
+    [](const auto &s, const auto &sm) OBAKE_SS_FORWARD_LAMBDA(detail::evaluate_batch_impl(s, sm));
+
 namespace customisation::internal
 {
 
@@ -4243,10 +5238,9 @@ inline series<K, C, Tag> filtered_impl(const series<K, C, Tag> &s, const F &f)
     retval.tag() = s.tag();
     retval.set_n_segments(s.get_s_size());
 
-    // Do the filtering table by table.
-    // NOTE: this can easily be parallelised.
-    const auto n_tables = s._get_s_table().size();
-    for (decltype(s._get_s_table().size()) table_idx = 0; table_idx < n_tables; ++table_idx) {
+    // Do the filtering table by table
+    // (in parallel for a segmented table).
+    detail::series_for_each_table(s, [&s, &retval, &f](const auto &table_idx) {
         // Fetch references to the input/output tables.
         const auto &in_table = s._get_s_table()[table_idx];
         auto &out_table = retval._get_s_table()[table_idx];
@@ -4259,7 +5253,7 @@ inline series<K, C, Tag> filtered_impl(const series<K, C, Tag> &s, const F &f)
                 assert(res.second);
             }
         }
-    }
+    });
 
     return retval;
 }
@@ -4269,6 +5263,9 @@ inline series<K, C, Tag> filtered_impl(const series<K, C, Tag> &s, const F &f)
 // NOTE: do we need a concept/type trait for this? See also the testing.
 // NOTE: force const reference passing for f as a hint
 // that the implementation may be parallel.
+// NOTE: for segmented series, f is invoked concurrently
+// from multiple threads (on different terms), thus it must
+// be safe to call f concurrently.
 inline constexpr auto filtered =
     [](auto &&s, const auto &f) OBAKE_SS_FORWARD_LAMBDA(detail::filtered_impl(::std::forward<decltype(s)>(s), f));
 
@@ -4279,9 +5276,11 @@ template <typename K, typename C, typename Tag, typename F,
           ::std::enable_if_t<::std::is_convertible_v<detected_t<term_filter_return_t, F, K, C, Tag>, bool>, int> = 0>
 inline void filter_impl(series<K, C, Tag> &s, const F &f)
 {
-    // Do the filtering table by table.
-    // NOTE: this can easily be parallelised.
-    for (auto &table : s._get_s_table()) {
+    // Do the filtering table by table
+    // (in parallel for a segmented table).
+    auto &s_table = s._get_s_table();
+    detail::series_for_each_table(s, [&s_table, &f](const auto &table_idx) {
+        auto &table = s_table[table_idx];
         const auto it_f = table.end();
 
         for (auto it = table.begin(); it != it_f;) {
@@ -4295,7 +5294,7 @@ inline void filter_impl(series<K, C, Tag> &s, const F &f)
                 table.erase(it++);
             }
         }
-    }
+    });
 }
 
 } // namespace detail
@@ -4303,6 +5302,9 @@ inline void filter_impl(series<K, C, Tag> &s, const F &f)
 // NOTE: do we need a concept/type trait for this? See also the testing.
 // NOTE: force const reference passing for f as a hint
 // that the implementation may be parallel.
+// NOTE: as in filtered(), f must be safe to call
+// concurrently, as it is invoked from multiple threads
+// for segmented series.
 // NOTE: perhaps we could eventually change the implementation
 // to return a reference to s.
 inline constexpr auto filter =
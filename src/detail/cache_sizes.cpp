@@ -0,0 +1,152 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstddef>
+#include <limits>
+
+#if defined(__linux__)
+
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+#endif
+
+#include <obake/detail/cache_sizes.hpp>
+
+namespace obake::detail
+{
+
+namespace
+{
+
+#if defined(__linux__)
+
+// Parse a cache size in the format used by sysfs
+// (e.g., "32K", "1024K", "16M"). Returns zero on failure.
+::std::size_t cache_size_from_string(const ::std::string &s)
+{
+    ::std::size_t retval = 0, i = 0;
+
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        const auto digit = static_cast<::std::size_t>(s[i] - '0');
+        if (retval > (::std::numeric_limits<::std::size_t>::max() - digit) / 10u) {
+            return 0;
+        }
+        retval = retval * 10u + digit;
+    }
+
+    if (i == 0u) {
+        // No digits.
+        return 0;
+    }
+
+    ::std::size_t mult = 1;
+    if (i < s.size()) {
+        switch (s[i]) {
+            case 'K':
+                mult = ::std::size_t(1) << 10;
+                break;
+            case 'M':
+                mult = ::std::size_t(1) << 20;
+                break;
+            case 'G':
+                mult = ::std::size_t(1) << 30;
+                break;
+            default:
+                return 0;
+        }
+    }
+
+    if (retval > ::std::numeric_limits<::std::size_t>::max() / mult) {
+        return 0;
+    }
+
+    return retval * mult;
+}
+
+// Detect the cache sizes from the cache descriptions
+// of the first CPU in sysfs.
+void cache_sizes_from_sysfs(cache_sizes &cs)
+{
+    // NOTE: the number of cache descriptions varies
+    // from system to system. Stop at the first
+    // index which cannot be read.
+    for (unsigned idx = 0;; ++idx) {
+        const auto base = "/sys/devices/system/cpu/cpu0/cache/index" + ::std::to_string(idx) + "/";
+
+        ::std::ifstream f_level(base + "level"), f_type(base + "type"), f_size(base + "size");
+        unsigned level = 0;
+        ::std::string type, size;
+        if (!(f_level >> level) || !(f_type >> type) || !(f_size >> size)) {
+            break;
+        }
+
+        const auto sz = detail::cache_size_from_string(size);
+
+        // NOTE: skip instruction caches.
+        if (level == 1u && type != "Instruction") {
+            cs.l1d = sz;
+        } else if (level == 2u && type != "Instruction") {
+            cs.l2 = sz;
+        } else if (level == 3u && type != "Instruction") {
+            cs.l3 = sz;
+        }
+    }
+}
+
+// Fill in the sizes that could not be determined
+// via sysfs using sysconf(), if available.
+// NOTE: on x86, glibc fetches these values via cpuid.
+void cache_sizes_from_sysconf([[maybe_unused]] cache_sizes &cs)
+{
+    [[maybe_unused]] auto fetch = [](::std::size_t &out, int name) {
+        if (out == 0u) {
+            const auto ret = ::sysconf(name);
+            out = ret > 0 ? static_cast<::std::size_t>(ret) : 0u;
+        }
+    };
+
+#if defined(_SC_LEVEL1_DCACHE_SIZE)
+    fetch(cs.l1d, _SC_LEVEL1_DCACHE_SIZE);
+#endif
+
+#if defined(_SC_LEVEL2_CACHE_SIZE)
+    fetch(cs.l2, _SC_LEVEL2_CACHE_SIZE);
+#endif
+
+#if defined(_SC_LEVEL3_CACHE_SIZE)
+    fetch(cs.l3, _SC_LEVEL3_CACHE_SIZE);
+#endif
+}
+
+#endif
+
+} // namespace
+
+// Return the cache sizes of the system.
+// The detection is run only once, on the first
+// invocation of this function.
+const cache_sizes &get_cache_sizes()
+{
+    static const cache_sizes retval = []() {
+        cache_sizes cs;
+
+#if defined(__linux__)
+        detail::cache_sizes_from_sysfs(cs);
+        detail::cache_sizes_from_sysconf(cs);
+#endif
+
+        return cs;
+    }();
+
+    return retval;
+}
+
+} // namespace obake::detail
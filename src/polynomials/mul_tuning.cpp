@@ -0,0 +1,127 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cmath>
+#include <cstddef>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include <obake/detail/cache_sizes.hpp>
+#include <obake/exceptions.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+
+namespace obake::polynomials
+{
+
+namespace detail
+{
+
+namespace
+{
+
+// Check the validity of a set of tuning parameters.
+void check_mul_tuning(const mul_tuning &t)
+{
+    if (t.sparse_seg_size == 0u || t.dense_seg_size == 0u) {
+        obake_throw(::std::invalid_argument, "The target segment sizes in the polynomial multiplication tuning "
+                                             "parameters must be nonzero");
+    }
+
+    if (!::std::isfinite(t.sparse_threshold) || !::std::isfinite(t.dense_engine_max_sp)
+        || !::std::isfinite(t.heap_min_sp)) {
+        obake_throw(::std::invalid_argument, "The sparsity thresholds in the polynomial multiplication tuning "
+                                             "parameters must be finite");
+    }
+
+    if (t.sparse_threshold < 0 || t.dense_engine_max_sp < 0 || t.heap_min_sp < 0) {
+        obake_throw(::std::invalid_argument, "The sparsity thresholds in the polynomial multiplication tuning "
+                                             "parameters must be non-negative");
+    }
+
+    if (!::std::isfinite(t.primitive_max_growth) || t.primitive_max_growth < 0) {
+        obake_throw(::std::invalid_argument, "The maximum coefficient growth in the polynomial multiplication "
+                                             "tuning parameters must be finite and non-negative");
+    }
+}
+
+// On-demand instantiation of the global
+// tuning parameters and associated mutex.
+::std::pair<mul_tuning &, ::std::mutex &> get_global_mul_tuning()
+{
+    static mul_tuning retval = mul_tuning::get_default();
+    static ::std::mutex mutex;
+    return {retval, mutex};
+}
+
+} // namespace
+
+} // namespace detail
+
+namespace detail
+{
+
+::std::size_t mul_tuning_default_sparse_seg_size()
+{
+    const auto &cs = ::obake::detail::get_cache_sizes();
+
+    // NOTE: we aim to fill most of L2 in sparse
+    // products, leaving room for the input terms
+    // and the temporaries. If the cache size could
+    // not be detected, fall back to a value
+    // typical of L2 on current hardware.
+    const auto retval = cs.l2 ? (cs.l2 / 4u) * 3u : ::std::size_t(200) * 1024u;
+
+    // NOTE: guard against tiny/nonsensical cache sizes.
+    return retval == 0u ? 1 : retval;
+}
+
+::std::size_t mul_tuning_default_dense_seg_size()
+{
+    const auto &cs = ::obake::detail::get_cache_sizes();
+
+    // NOTE: we aim to fill a bit more than half of L1
+    // in dense products (see above).
+    const auto retval = cs.l1d ? (cs.l1d / 8u) * 5u : ::std::size_t(20) * 1024u;
+
+    return retval == 0u ? 1 : retval;
+}
+
+} // namespace detail
+
+mul_tuning mul_tuning::get_default()
+{
+    return mul_tuning{};
+}
+
+mul_tuning get_mul_tuning()
+{
+    auto [t, mutex] = detail::get_global_mul_tuning();
+
+    ::std::lock_guard lock(mutex);
+
+    return t;
+}
+
+void set_mul_tuning(const mul_tuning &t)
+{
+    detail::check_mul_tuning(t);
+
+    auto [gt, mutex] = detail::get_global_mul_tuning();
+
+    ::std::lock_guard lock(mutex);
+
+    gt = t;
+}
+
+void reset_mul_tuning()
+{
+    polynomials::set_mul_tuning(mul_tuning::get_default());
+}
+
+} // namespace obake::polynomials
@@ -6,10 +6,12 @@
 // Public License v. 2.0. If a copy of the MPL was not distributed
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
-#include <functional>
+#include <cassert>
+#include <cstddef>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <tuple>
+#include <vector>
 
 #include <obake/series.hpp>
 
@@ -60,26 +62,106 @@ void series_stream_single_term(::std::string &ret, ::std::string &str_cf, const
 namespace customisation::internal
 {
 
+series_pow_cache_base::~series_pow_cache_base() = default;
+
+series_pow_cache_entry_base::~series_pow_cache_entry_base() = default;
+
 // On-demand instantiation of the global
-// objects used to implement the pow map.
-::std::tuple<series_pow_map_t &, ::std::mutex &> get_series_pow_map()
+// series pow cache.
+series_pow_cache_data &get_series_pow_cache()
+{
+    static series_pow_cache_data retval;
+
+    return retval;
+}
+
+void series_pow_cache_evict(series_pow_cache_data &data,
+                            ::std::vector<::std::shared_ptr<series_pow_cache_entry_base>> &evicted)
 {
-    static series_pow_map_t retval;
-    static ::std::mutex mutex;
-    return ::std::make_tuple(::std::ref(retval), ::std::ref(mutex));
+    while (data.n_bytes > data.max_size && !data.lru.empty()) {
+        auto *e = data.lru.back();
+        data.lru.pop_back();
+
+        assert(e->owner != nullptr);
+        assert(data.n_bytes >= e->n_bytes);
+
+        data.n_bytes -= e->n_bytes;
+        ++data.evictions;
+
+        auto *owner = e->owner;
+        e->owner = nullptr;
+        evicted.push_back(owner->erase(e));
+    }
 }
 
 void clear_series_pow_map()
 {
     // Fetch the global data.
-    auto [map, mutex] = internal::get_series_pow_map();
+    auto &data = internal::get_series_pow_cache();
+
+    // NOTE: destroy the storages after
+    // the mutex has been released.
+    decltype(data.caches) caches;
+
+    {
+        // Lock down before accessing the cache.
+        ::std::lock_guard lock(data.mutex);
 
-    // Lock down before accessing the cache.
-    ::std::lock_guard lock(mutex);
+        // NOTE: the entries which are still in use
+        // by other threads will be removed from the
+        // memory accounting when they are done.
+        for (auto *e : data.lru) {
+            e->owner = nullptr;
+        }
 
-    map.clear();
+        caches.swap(data.caches);
+        data.lru.clear();
+        data.n_bytes = 0;
+        data.hits = 0;
+        data.misses = 0;
+        data.evictions = 0;
+    }
 }
 
 } // namespace customisation::internal
 
+series_pow_cache_stats get_series_pow_cache_stats()
+{
+    auto &data = customisation::internal::get_series_pow_cache();
+
+    ::std::lock_guard lock(data.mutex);
+
+    series_pow_cache_stats retval;
+    retval.hits = data.hits;
+    retval.misses = data.misses;
+    retval.evictions = data.evictions;
+    retval.n_entries = data.lru.size();
+    retval.n_bytes = data.n_bytes;
+
+    return retval;
+}
+
+::std::size_t get_series_pow_cache_max_size()
+{
+    auto &data = customisation::internal::get_series_pow_cache();
+
+    ::std::lock_guard lock(data.mutex);
+
+    return data.max_size;
+}
+
+void set_series_pow_cache_max_size(::std::size_t s)
+{
+    auto &data = customisation::internal::get_series_pow_cache();
+
+    ::std::vector<::std::shared_ptr<customisation::internal::series_pow_cache_entry_base>> evicted;
+
+    {
+        ::std::lock_guard lock(data.mutex);
+
+        data.max_size = s;
+        customisation::internal::series_pow_cache_evict(data, evicted);
+    }
+}
+
 } // namespace obake
@@ -0,0 +1,106 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/accumulation_table.hpp>
+#include <obake/series.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+using int_t = mppp::integer<1>;
+
+template <typename V>
+using acc_table_t = detail::accumulation_table<long, V, detail::series_key_hasher, detail::series_key_comparer>;
+
+TEST_CASE("accumulation_table_basic")
+{
+    acc_table_t<int_t> t;
+    REQUIRE(t.size() == 0u);
+
+    // Consume an empty table.
+    std::size_t count = 0;
+    t.consume([&count](long &&, int_t &&) { ++count; });
+    REQUIRE(count == 0u);
+
+    // Insert/accumulate, making sure to trigger a few rehashes.
+    std::map<long, int_t> cmp;
+    std::size_t n_ctor = 0;
+    for (long i = 0; i < 1000; ++i) {
+        for (long j = 0; j < 3; ++j) {
+            const auto k = i * 64;
+            t.insert_or_accumulate(
+                k,
+                [&n_ctor, i]() {
+                    ++n_ctor;
+                    return int_t{i};
+                },
+                [i](int_t &c) { c += i; });
+            cmp[k] += i;
+        }
+    }
+    REQUIRE(t.size() == 1000u);
+    // The values were constructed only
+    // once per key.
+    REQUIRE(n_ctor == 1000u);
+
+    std::map<long, int_t> res;
+    t.consume([&res](long &&k, int_t &&c) { REQUIRE(res.emplace(k, std::move(c)).second); });
+    REQUIRE(res == cmp);
+    REQUIRE(t.size() == 0u);
+
+    // Reuse after consume().
+    t.reserve(5000);
+    for (long i = 0; i < 10; ++i) {
+        t.insert_or_accumulate(
+            i, [] { return int_t{1}; }, [](int_t &c) { ++c; });
+    }
+    REQUIRE(t.size() == 10u);
+    t.clear();
+    REQUIRE(t.size() == 0u);
+}
+
+TEST_CASE("accumulation_table_exceptions")
+{
+    acc_table_t<std::string> t;
+
+    t.insert_or_accumulate(
+        1, [] { return std::string("a"); }, [](std::string &s) { s += "a"; });
+
+    // Throw in the construction of a new value.
+    REQUIRE_THROWS_AS(t.insert_or_accumulate(
+                          2, []() -> std::string { throw std::invalid_argument(""); },
+                          [](std::string &s) { s += "b"; }),
+                      std::invalid_argument);
+    REQUIRE(t.size() == 1u);
+
+    // Throw in the accumulation.
+    REQUIRE_THROWS_AS(t.insert_or_accumulate(
+                          1, [] { return std::string("a"); },
+                          [](std::string &) { throw std::invalid_argument(""); }),
+                      std::invalid_argument);
+    REQUIRE(t.size() == 1u);
+
+    // The table is still usable.
+    t.insert_or_accumulate(
+        2, [] { return std::string("b"); }, [](std::string &s) { s += "b"; });
+    t.insert_or_accumulate(
+        1, [] { return std::string("a"); }, [](std::string &s) { s += "a"; });
+
+    std::map<long, std::string> res;
+    t.consume([&res](long &&k, std::string &&s) { res.emplace(k, std::move(s)); });
+    REQUIRE(res == std::map<long, std::string>{{1, "aa"}, {2, "b"}});
+}
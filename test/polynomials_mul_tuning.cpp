@@ -0,0 +1,204 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+#include <mp++/integer.hpp>
+
+#include <obake/config.hpp>
+#include <obake/detail/cache_sizes.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+TEST_CASE("cache_sizes_test")
+{
+    const auto &cs = detail::get_cache_sizes();
+
+    // Repeated invocations return the same object.
+    REQUIRE(&cs == &detail::get_cache_sizes());
+
+    std::cout << "The detected cache sizes are: L1d=" << cs.l1d << ", L2=" << cs.l2 << ", L3=" << cs.l3 << '\n';
+}
+
+TEST_CASE("mul_tuning_test")
+{
+    obake_test::disable_slow_stack_traces();
+
+    const auto def = mul_tuning::get_default();
+
+    REQUIRE(def.sparse_seg_size > 0u);
+    REQUIRE(def.dense_seg_size > 0u);
+    REQUIRE(std::isfinite(def.sparse_threshold));
+    REQUIRE(def.mt_min_bytes == 30000u);
+    REQUIRE(std::isfinite(def.dense_engine_max_sp));
+    REQUIRE(std::isfinite(def.heap_min_sp));
+    REQUIRE(def.crt_min_nbits > 0u);
+    REQUIRE(std::isfinite(def.primitive_max_growth));
+
+    // A default-constructed mul_tuning contains
+    // the default parameters.
+    {
+        const mul_tuning t;
+        REQUIRE(t.sparse_seg_size == def.sparse_seg_size);
+        REQUIRE(t.dense_seg_size == def.dense_seg_size);
+        REQUIRE(t.sparse_threshold == def.sparse_threshold);
+        REQUIRE(t.mt_min_bytes == def.mt_min_bytes);
+        REQUIRE(t.dense_engine_max_sp == def.dense_engine_max_sp);
+        REQUIRE(t.heap_min_sp == def.heap_min_sp);
+        REQUIRE(t.heap_min_bytes == def.heap_min_bytes);
+        REQUIRE(t.crt_min_nbits == def.crt_min_nbits);
+        REQUIRE(t.primitive_max_growth == def.primitive_max_growth);
+    }
+
+    // The initial global parameters are the default ones.
+    REQUIRE(get_mul_tuning().sparse_seg_size == def.sparse_seg_size);
+    REQUIRE(get_mul_tuning().dense_seg_size == def.dense_seg_size);
+
+    // Set/reset the global parameters.
+    auto t = def;
+    t.sparse_seg_size = 123;
+    t.heap_min_bytes = 456;
+    t.mt_min_bytes = 1000;
+    t.crt_min_nbits = 789;
+    t.primitive_max_growth = 1.5;
+    set_mul_tuning(t);
+    REQUIRE(get_mul_tuning().sparse_seg_size == 123u);
+    REQUIRE(get_mul_tuning().heap_min_bytes == 456u);
+    REQUIRE(get_mul_tuning().mt_min_bytes == 1000u);
+    REQUIRE(get_mul_tuning().crt_min_nbits == 789u);
+    REQUIRE(get_mul_tuning().primitive_max_growth == 1.5);
+
+    // The global parameters are visible from other threads.
+    std::thread([]() { REQUIRE(get_mul_tuning().sparse_seg_size == 123u); }).join();
+
+    reset_mul_tuning();
+    REQUIRE(get_mul_tuning().sparse_seg_size == def.sparse_seg_size);
+    REQUIRE(get_mul_tuning().heap_min_bytes == def.heap_min_bytes);
+    REQUIRE(get_mul_tuning().mt_min_bytes == def.mt_min_bytes);
+    REQUIRE(get_mul_tuning().crt_min_nbits == def.crt_min_nbits);
+    REQUIRE(get_mul_tuning().primitive_max_growth == def.primitive_max_growth);
+
+    // Invalid parameters.
+    auto bad = def;
+    bad.sparse_seg_size = 0;
+    OBAKE_REQUIRES_THROWS_CONTAINS(set_mul_tuning(bad), std::invalid_argument,
+                                   "The target segment sizes in the polynomial multiplication tuning "
+                                   "parameters must be nonzero");
+    bad = def;
+    bad.dense_engine_max_sp = std::numeric_limits<double>::quiet_NaN();
+    OBAKE_REQUIRES_THROWS_CONTAINS(set_mul_tuning(bad), std::invalid_argument,
+                                   "The sparsity thresholds in the polynomial multiplication tuning "
+                                   "parameters must be finite");
+    bad = def;
+    bad.heap_min_sp = -1;
+    OBAKE_REQUIRES_THROWS_CONTAINS(set_mul_tuning(bad), std::invalid_argument,
+                                   "The sparsity thresholds in the polynomial multiplication tuning "
+                                   "parameters must be non-negative");
+    REQUIRE(get_mul_tuning().heap_min_sp == def.heap_min_sp);
+    bad = def;
+    bad.primitive_max_growth = std::numeric_limits<double>::infinity();
+    OBAKE_REQUIRES_THROWS_CONTAINS(set_mul_tuning(bad), std::invalid_argument,
+                                   "The maximum coefficient growth in the polynomial multiplication "
+                                   "tuning parameters must be finite and non-negative");
+    bad.primitive_max_growth = -1;
+    OBAKE_REQUIRES_THROWS_CONTAINS(set_mul_tuning(bad), std::invalid_argument,
+                                   "The maximum coefficient growth in the polynomial multiplication "
+                                   "tuning parameters must be finite and non-negative");
+    REQUIRE(get_mul_tuning().primitive_max_growth == def.primitive_max_growth);
+}
+
+// Check that the tuning parameters do not
+// alter the result of a multiplication.
+TEST_CASE("mul_tuning_mul_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = (x + y + z * z * 2 + t * t * t * 3 + 1), g = (t + z + y * y * 2 + x * x * x * 3 + 1);
+    for (auto i = 0; i < 3; ++i) {
+        f *= f;
+        g *= g;
+    }
+
+    // NOTE: invoke directly the multithreaded implementation,
+    // as the operands may be small enough to trigger
+    // the simple implementation.
+    auto mt_mul = [&f, &g]() {
+        poly_t retval;
+        retval.set_symbol_set(f.get_symbol_set());
+        polynomials::detail::poly_mul_impl_mt_hm(retval, f, g);
+        return retval;
+    };
+
+    const auto ref = f * g;
+
+    const auto def = mul_tuning::get_default();
+
+    // Tiny segments.
+    {
+        auto tn = def;
+        tn.sparse_seg_size = 1;
+        tn.dense_seg_size = 1;
+        set_mul_tuning(tn);
+        REQUIRE(mt_mul() == ref);
+        reset_mul_tuning();
+    }
+
+    // Huge segments.
+    {
+        auto tn = def;
+        tn.sparse_seg_size = std::numeric_limits<std::size_t>::max();
+        tn.dense_seg_size = std::numeric_limits<std::size_t>::max();
+        set_mul_tuning(tn);
+        const auto ret = mt_mul();
+        REQUIRE(ret == ref);
+        REQUIRE(ret.get_s_size() == 0u);
+        reset_mul_tuning();
+    }
+
+    // Disable the dense engine.
+    {
+        auto tn = def;
+        tn.dense_engine_max_sp = 0;
+        set_mul_tuning(tn);
+        REQUIRE(mt_mul() == ref);
+        reset_mul_tuning();
+    }
+
+    // Force the heap-based multiplication.
+    {
+        auto tn = def;
+        tn.heap_min_sp = 0;
+        tn.heap_min_bytes = 0;
+        set_mul_tuning(tn);
+        REQUIRE(mt_mul() == ref);
+        reset_mul_tuning();
+    }
+}
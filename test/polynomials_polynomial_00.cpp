@@ -8,6 +8,7 @@
 
 #include <obake/config.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <initializer_list>
 #include <stdexcept>
@@ -19,6 +20,7 @@
 #include <mp++/integer.hpp>
 
 #include <obake/detail/tuple_for_each.hpp>
+#include <obake/hash.hpp>
 #include <obake/kpack.hpp>
 #include <obake/polynomials/packed_monomial.hpp>
 #include <obake/polynomials/polynomial.hpp>
@@ -422,3 +424,57 @@ TEST_CASE("polynomial_mul_larger_mt_hm_test")
         REQUIRE(ret.size() == 2096600ull);
     });
 }
+
+TEST_CASE("polynomial_mul_copy_terms_test")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        auto f = x + y + z * z * 2 + 1, g = x - y * y * y - z * 3 + 1;
+        f = f * f * f * f * f * f * f * f * f * f;
+        g = g * g * g * g * g * g * g * g * g * g;
+
+        // Helper to re-create a series with
+        // a specific segmentation.
+        auto resegment = [](const poly_t &p, unsigned log2_nsegs) {
+            poly_t retval;
+            retval.set_symbol_set(p.get_symbol_set());
+            retval.set_n_segments(log2_nsegs);
+            for (const auto &[k, c] : p) {
+                retval.add_term(k, c);
+            }
+
+            return retval;
+        };
+
+        for (auto log2_nsegs : {0u, 1u, 4u, 7u}) {
+            const auto f_seg = resegment(f, log2_nsegs), g_seg = resegment(g, log2_nsegs);
+
+            // Check the copy of the terms.
+            const auto v = polynomials::detail::poly_mul_impl_copy_terms(f_seg);
+            REQUIRE(v.size() == f_seg.size());
+            REQUIRE(std::is_sorted(v.begin(), v.end(), [log2_nsegs](const auto &p1, const auto &p2) {
+                return hash(p1.first) % (1u << log2_nsegs) < hash(p2.first) % (1u << log2_nsegs);
+            }));
+            for (const auto &[k, c] : v) {
+                const auto it = f_seg.find(k);
+                REQUIRE(it != f_seg.end());
+                REQUIRE(it->second == c);
+            }
+
+            // Check the multiplication with the segmented operands.
+            poly_t r1, r2;
+            r1.set_symbol_set(f.get_symbol_set());
+            r2.set_symbol_set(f.get_symbol_set());
+            polynomials::detail::poly_mul_impl_mt_hm(r1, f_seg, g_seg);
+            polynomials::detail::poly_mul_impl_simple(r2, f, g);
+            REQUIRE(r1 == r2);
+        }
+    });
+}
@@ -97,4 +97,45 @@ TEST_CASE("polynomial_subs_test")
             == 3 * x * -y * z - 3 * 3 * x + 4 * -y + 5 * 3 * x * -y + -y * -y);
     REQUIRE(subs(p, symbol_map<poly_t>{{"x", 3 * x}, {"y", -y}, {"z", x * y}})
             == 3 * x * -y * x * y - 3 * 3 * x + 4 * -y + 5 * 3 * x * -y + -y * -y);
+
+    // Segmented polynomials.
+    {
+        auto f = 1 + x - 2 * y + z * z;
+        f = f * f * f * f * f * f * f * f * f * f;
+
+        // Term-by-term substitution, used as a reference.
+        auto ref_subs = [](const poly_t &q, const auto &sm) {
+            using ret_t = decltype(subs(q, sm));
+            ret_t retval;
+            for (const auto &t : q) {
+                poly_t tmp;
+                tmp.set_symbol_set(q.get_symbol_set());
+                tmp.add_term(t.first, t.second);
+                retval += subs(tmp, sm);
+            }
+            return retval;
+        };
+
+        for (auto log2_nsegs : {0u, 1u, 3u, 6u}) {
+            poly_t g;
+            g.set_symbol_set(f.get_symbol_set());
+            g.set_n_segments(log2_nsegs);
+            for (const auto &t : f) {
+                g.add_term(t.first, t.second);
+            }
+
+            const symbol_map<int1_t> sm1{{"x", int1_t{3}}};
+            REQUIRE(subs(g, sm1) == ref_subs(f, sm1));
+            REQUIRE(subs(g, sm1) == subs(f, sm1));
+
+            const symbol_map<int1_t> sm2{{"x", int1_t{3}}, {"y", int1_t{-4}}, {"z", int1_t{2}}};
+            REQUIRE(subs(g, sm2) == ref_subs(f, sm2));
+
+            const symbol_map<rat1_t> sm3{{"y", rat1_t{1, 2}}, {"z", rat1_t{-3}}};
+            REQUIRE(subs(g, sm3) == ref_subs(f, sm3));
+
+            const symbol_map<poly_t> sm4{{"x", y - z}, {"z", x + 1}};
+            REQUIRE(subs(g, sm4) == ref_subs(f, sm4));
+        }
+    }
 }
@@ -23,6 +23,7 @@
 #include <obake/math/truncate_degree.hpp>
 #include <obake/polynomials/packed_monomial.hpp>
 #include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
 
 #include "catch.hpp"
 #include "test_utils.hpp"
@@ -283,3 +284,83 @@ TEST_CASE("polynomial_hm_mt_rectangular_large")
 
     REQUIRE(f.size() == 53130u);
 }
+
+// Test diff/integrate on segmented polynomials,
+// which are processed in parallel.
+TEST_CASE("polynomial_diff_integrate_segmented")
+{
+    using pm_t = packed_monomial<exp_t>;
+
+    detail::tuple_for_each(std::make_tuple(mppp::integer<1>{}, mppp::rational<1>{}), [](auto n) {
+        using cf_t = decltype(n);
+        using poly_t = polynomial<pm_t, cf_t>;
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        auto f = 1 + x + y * y - 3 * z + obake::pow(x, -2) * z;
+        f = f * f * f * f * f;
+
+        // Copy f into a polynomial with 2**l segments.
+        auto resegment = [](const poly_t &p, unsigned l) {
+            poly_t retval;
+            retval.set_symbol_set(p.get_symbol_set());
+            retval.set_n_segments(l);
+            for (const auto &t : p) {
+                retval.add_term(t.first, t.second);
+            }
+            return retval;
+        };
+
+        for (auto l : {1u, 3u, 6u}) {
+            const auto g = resegment(f, l);
+
+            for (const auto *s : {"x", "y", "z", "a"}) {
+                const auto d = diff(g, s);
+                REQUIRE(d.get_s_size() == l);
+                REQUIRE(d == diff(f, s));
+                REQUIRE(d.get_symbol_set() == f.get_symbol_set());
+            }
+
+            if constexpr (std::is_same_v<mppp::rational<1>, cf_t>) {
+                for (const auto *s : {"y", "z"}) {
+                    const auto i = integrate(g, s);
+                    REQUIRE(i.get_s_size() == l);
+                    REQUIRE(i == integrate(f, s));
+                }
+
+                // Integration with respect to a new symbol.
+                const auto i = integrate(g, "b");
+                REQUIRE(i.get_s_size() == l);
+                REQUIRE(i == integrate(f, "b"));
+                REQUIRE(i.get_symbol_set() == symbol_set{"b", "x", "y", "z"});
+            }
+
+            // Terms which vanish after differentiation.
+            const auto h = resegment(f + 5 * y + 7 - x * x, l);
+            REQUIRE(diff(h, "y") == diff(f, "y") + 5);
+            REQUIRE(diff(h, "x") == diff(f, "x") - 2 * x);
+        }
+    });
+
+    // Recursive polynomial, in which the derivative
+    // of the coefficients is nonzero.
+    using p1_t = polynomial<pm_t, mppp::integer<1>>;
+    using p11_t = polynomial<pm_t, p1_t>;
+
+    auto [x, y] = make_polynomials<p1_t>("x", "y");
+    auto [z] = make_polynomials<p11_t>("z");
+
+    auto p = 3 * x * x * y - 2 * z * y + 4 * x * z * z * z + z * x;
+    p = p * p * p;
+
+    p11_t q;
+    q.set_symbol_set(p.get_symbol_set());
+    q.set_n_segments(2);
+    for (const auto &t : p) {
+        q.add_term(t.first, t.second);
+    }
+
+    for (const auto *s : {"x", "y", "z"}) {
+        REQUIRE(diff(q, s) == diff(p, s));
+    }
+}
@@ -0,0 +1,145 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the dense multiplication engine.
+TEST_CASE("polynomial_mul_dense_layout")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+    using vec_t = std::vector<std::pair<pm_t, mppp::integer<1>>>;
+
+    const auto ss = symbol_set{"x", "y", "z"};
+    auto [x, y, z] = make_polynomials<poly_t>(ss, "x", "y", "z");
+
+    // A product whose exponents span
+    // the box [0, 4] x [1, 3] x [0, 2].
+    const auto a = (1 + x + x * x) * (y + y * y) * (1 + z);
+    const auto b = (1 + x * x) * (1 + y) * (1 + z);
+    const vec_t v1(a.begin(), a.end()), v2(b.begin(), b.end());
+
+    // Low sparsity, array size within the limits.
+    auto dl = polynomials::detail::poly_mul_impl_dense_layout(v1, v2, ss, mppp::integer<1>{45}, 1E-3, 1E-2);
+    REQUIRE(dl.n_slots == 45u);
+    REQUIRE(dl.min1 == std::vector<exp_t>{0, 1, 0});
+    REQUIRE(dl.min2 == std::vector<exp_t>{0, 0, 0});
+    REQUIRE(dl.exts == std::vector<std::size_t>{5, 3, 3});
+    REQUIRE(dl.strides == std::vector<std::size_t>{1, 5, 15});
+
+    // Sparsity too high.
+    dl = polynomials::detail::poly_mul_impl_dense_layout(v1, v2, ss, mppp::integer<1>{45}, .5, 1E-2);
+    REQUIRE(dl.n_slots == 0u);
+    dl = polynomials::detail::poly_mul_impl_dense_layout(v1, v2, ss, mppp::integer<1>{45},
+                                                         std::numeric_limits<double>::infinity(), 1E-2);
+    REQUIRE(dl.n_slots == 0u);
+
+    // The array would be too large with respect
+    // to the estimated number of terms.
+    dl = polynomials::detail::poly_mul_impl_dense_layout(v1, v2, ss, mppp::integer<1>{1}, 1E-3, 1E-2);
+    REQUIRE(dl.n_slots == 0u);
+
+    // Zero variables.
+    const vec_t v3{{pm_t{}, mppp::integer<1>{2}}}, v4{{pm_t{}, mppp::integer<1>{3}}};
+    dl = polynomials::detail::poly_mul_impl_dense_layout(v3, v4, symbol_set{}, mppp::integer<1>{1}, 1E-3, 1E-2);
+    REQUIRE(dl.n_slots == 1u);
+    REQUIRE(dl.exts.empty());
+}
+
+TEST_CASE("polynomial_mul_mt_dense")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        const auto ss = symbol_set{"x", "y", "z"};
+        auto [x, y, z] = make_polynomials<poly_t>(ss, "x", "y", "z");
+
+        // Dense polynomials with unitary coefficients, so that the
+        // coefficients of the products are small integral values
+        // which can be represented exactly also in floating-point.
+        poly_t px{1}, py{1}, pz{1};
+        for (auto i = 0; i < 10; ++i) {
+            px = px * x + 1;
+            py = py * y + 1;
+            pz = pz * z + 1;
+        }
+        const auto f = px * py * pz, g = px * py * pz * (1 + x);
+
+        auto check_product = [&ss](const poly_t &a, const poly_t &b) {
+            poly_t r1, r2;
+            r1.set_symbol_set(ss);
+            r2.set_symbol_set(ss);
+
+            // NOTE: the implementations require
+            // the first operand not to be larger than the second.
+            const auto &[p1, p2] = a.size() <= b.size() ? std::tie(a, b) : std::tie(b, a);
+
+            polynomials::detail::poly_mul_impl_mt_hm(r1, p1, p2);
+            polynomials::detail::poly_mul_impl_simple(r2, p1, p2);
+
+            REQUIRE(r1 == r2);
+            REQUIRE(r1.get_symbol_set() == ss);
+        };
+
+        check_product(f, f);
+        check_product(f, g);
+        check_product(g, f);
+
+        // Products with cancellations.
+        check_product(f, f * (1 - x));
+        check_product(f * (1 + y), f * (1 - y));
+
+        if constexpr (std::is_signed_v<exp_t>) {
+            // Negative exponents.
+            poly_t m1, m2;
+            m1.set_symbol_set(ss);
+            m2.set_symbol_set(ss);
+            m1.add_term(pm_t{-7, 0, -3}, 1);
+            m2.add_term(pm_t{2, -11, -1}, 1);
+
+            check_product(f * m1, f * m2);
+            check_product(f * m2, g * m1);
+        }
+    });
+}
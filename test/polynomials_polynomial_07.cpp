@@ -0,0 +1,119 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the lock-based multithreaded multiplication.
+TEST_CASE("polynomial_mul_mt_lock")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        detail::tuple_for_each(cf_types{}, [](auto xs) {
+            using poly_t = polynomial<decltype(pm), decltype(xs)>;
+
+            const auto ss = symbol_set{"x", "y", "z"};
+            auto [x, y, z] = make_polynomials<poly_t>(ss, "x", "y", "z");
+
+            auto check_product = [](const poly_t &a, const poly_t &b) {
+                poly_t r1, r2;
+                r1.set_symbol_set(a.get_symbol_set());
+                r2.set_symbol_set(a.get_symbol_set());
+
+                // NOTE: the implementations require
+                // the first operand not to be larger than the second.
+                const auto &[p1, p2] = a.size() <= b.size() ? std::tie(a, b) : std::tie(b, a);
+
+                polynomials::detail::poly_mul_impl_mt_lock(r1, p1, p2);
+                polynomials::detail::poly_mul_impl_simple(r2, p1, p2);
+
+                REQUIRE(r1 == r2);
+                REQUIRE(r1.get_symbol_set() == a.get_symbol_set());
+            };
+
+            // Single terms.
+            check_product(poly_t{3}, poly_t{4});
+            check_product(x, y * z);
+
+            // Sparse and dense products.
+            auto f = 1 + x + y + z, g = 1 - x * x - y * y * y - z * z;
+            f = f * f * f * f * f * f * f * f;
+            g = g * g * g * g * g * g * g * g;
+            check_product(f, g);
+            check_product(f, f);
+            check_product(f * (1 + x), g * (1 + y));
+
+            // Products with cancellations.
+            check_product(f * (1 + x), f * (1 - x));
+            check_product(f * (x + y), f * (x - y));
+
+            // Highly rectangular products, which are split
+            // over the terms of the longer operand as well.
+            auto u = f * f;
+            u = u * u * f;
+            check_product(1 + x, u);
+            check_product(x - 2 * y * z, u);
+
+            // Check that the result does not depend on the scheduling
+            // of the tasks, also for non-associative coefficient types.
+            if constexpr (std::is_same_v<decltype(xs), double>) {
+                const auto a = x * (1. / 3) + y * .7 - z * 1.3 + 1.1, b = u * .1 - f * (x / 7.);
+
+                poly_t r0;
+                r0.set_symbol_set(ss);
+                polynomials::detail::poly_mul_impl_mt_lock(r0, a, b);
+
+                for (auto i = 0; i < 10; ++i) {
+                    poly_t r;
+                    r.set_symbol_set(ss);
+                    polynomials::detail::poly_mul_impl_mt_lock(r, a, b);
+                    REQUIRE(r == r0);
+                }
+            }
+
+            // Check that the result has been
+            // segmented and contains no zeroes.
+            poly_t r;
+            r.set_symbol_set(ss);
+            polynomials::detail::poly_mul_impl_mt_lock(r, f * (x - y), f * (x + y));
+            REQUIRE(r._get_s_table().size() > 1u);
+            for (const auto &[_, c] : r) {
+                REQUIRE(!is_zero(c));
+            }
+        });
+    });
+}
@@ -0,0 +1,133 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the heap-based multiplication.
+TEST_CASE("polynomial_mul_use_heap")
+{
+    using int_t = mppp::integer<1>;
+
+    const auto t = mul_tuning::get_default();
+    const auto min_sp = t.heap_min_sp;
+    const auto min_bytes = t.heap_min_bytes;
+
+    REQUIRE(polynomials::detail::poly_mul_impl_use_heap(int_t{1} << 30, .9, 16, min_sp, min_bytes));
+    REQUIRE(polynomials::detail::poly_mul_impl_use_heap(int_t{1} << 30, .5, 1, min_sp, min_bytes));
+    // Not sparse enough.
+    REQUIRE(!polynomials::detail::poly_mul_impl_use_heap(int_t{1} << 30, .1, 16, min_sp, min_bytes));
+    REQUIRE(!polynomials::detail::poly_mul_impl_use_heap(int_t{1} << 30, std::numeric_limits<double>::infinity(), 16,
+                                                         min_sp, min_bytes));
+    // Not large enough.
+    REQUIRE(!polynomials::detail::poly_mul_impl_use_heap(int_t{1000}, .9, 16, min_sp, min_bytes));
+    // Custom thresholds.
+    REQUIRE(polynomials::detail::poly_mul_impl_use_heap(int_t{1000}, .1, 16, .1, 1000));
+    REQUIRE(!polynomials::detail::poly_mul_impl_use_heap(int_t{1000}, .1, 16, .2, 1000));
+}
+
+TEST_CASE("polynomial_mul_heap")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+
+    using cf_types = std::tuple<double, mppp::integer<1>>;
+
+    detail::tuple_for_each(cf_types{}, [](auto xs) {
+        using poly_t = polynomial<pm_t, decltype(xs)>;
+
+        const auto ss = symbol_set{"x", "y", "z"};
+        auto [x, y, z] = make_polynomials<poly_t>(ss, "x", "y", "z");
+
+        auto check_product = [](const poly_t &a, const poly_t &b, unsigned log2_nsegs) {
+            poly_t r1, r2;
+            r1.set_symbol_set(a.get_symbol_set());
+            r1.set_n_segments(log2_nsegs);
+            r2.set_symbol_set(a.get_symbol_set());
+
+            // NOTE: the implementations require
+            // the first operand not to be larger than the second.
+            const auto &[p1, p2] = a.size() <= b.size() ? std::tie(a, b) : std::tie(b, a);
+
+            polynomials::detail::poly_mul_impl_simple(r2, p1, p2);
+
+            const std::vector<std::pair<pm_t, series_cf_t<poly_t>>> v1(p1.begin(), p1.end()), v2(p2.begin(), p2.end());
+
+            // Try various numbers of chunks, including
+            // more chunks than terms in the product.
+            for (auto n_chunks : {1u, 3u, 16u, 100u}) {
+                r1.clear_terms();
+                polynomials::detail::poly_mul_impl_heap(r1, v1, v2, n_chunks);
+
+                REQUIRE(r1 == r2);
+                REQUIRE(r1._get_s_table().size() == 1u << log2_nsegs);
+                for (const auto &[_, c] : r1) {
+                    REQUIRE(!is_zero(c));
+                }
+            }
+        };
+
+        for (auto log2_nsegs : {0u, 3u}) {
+            // Single terms.
+            check_product(poly_t{3}, poly_t{4}, log2_nsegs);
+            check_product(x, y * z, log2_nsegs);
+
+            // Sparse products.
+            auto f = 1 + x + y * y * y + z * z * z * z * z, g = 1 - x * x * x * x * x * x * x - y * y - z * z * z;
+            f = f * f * f * f * f * f;
+            g = g * g * g * g * g * g;
+            check_product(f, g, log2_nsegs);
+            check_product(f * (1 + x), g * (1 + y), log2_nsegs);
+
+            // Products with cancellations.
+            check_product(f * (1 + x), f * (1 - x), log2_nsegs);
+            check_product(f * (x + y), f * (x - y), log2_nsegs);
+            check_product(x - y, x + y, log2_nsegs);
+
+            if constexpr (std::is_signed_v<exp_t>) {
+                // Negative exponents.
+                poly_t m1, m2;
+                m1.set_symbol_set(ss);
+                m2.set_symbol_set(ss);
+                m1.add_term(pm_t{-7, 0, -3}, 1);
+                m2.add_term(pm_t{2, -11, -1}, 1);
+
+                check_product(f * m1, g * m2, log2_nsegs);
+                check_product(f * m2 + 1, f * m1 - 1, log2_nsegs);
+            }
+        }
+    });
+}
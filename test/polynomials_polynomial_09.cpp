@@ -0,0 +1,151 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/xoroshiro128_plus.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the estimation of the product size.
+TEST_CASE("polynomial_mul_idx_permutation")
+{
+    for (std::uint64_t n : {1ull, 2ull, 3ull, 4ull, 5ull, 7ull, 8ull, 9ull, 100ull, 1023ull, 1024ull, 1025ull}) {
+        for (std::uint64_t s = 0; s < 10u; ++s) {
+            detail::xoroshiro128_plus rng{s, s + 42u};
+            polynomials::detail::poly_mul_idx_permutation perm(n, rng);
+
+            // Check that the first n values are a permutation of [0, n).
+            std::vector<bool> seen(n);
+            for (std::uint64_t i = 0; i < n; ++i) {
+                const auto v = perm.next();
+                REQUIRE(v < n);
+                REQUIRE(!seen[v]);
+                seen[v] = true;
+            }
+        }
+    }
+}
+
+TEST_CASE("polynomial_mul_estimate_product_size")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+    using vec_t = std::vector<std::pair<pm_t, mppp::integer<1>>>;
+
+    auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+    const auto ss = (x + y + z).get_symbol_set();
+
+    // Helper to set to 1 all the coefficients of a polynomial.
+    // The product of two such polynomials has no cancellations,
+    // and thus its size is the quantity being estimated.
+    auto ones = [](const poly_t &p) {
+        poly_t retval;
+        retval.set_symbol_set(p.get_symbol_set());
+        for (const auto &t : p) {
+            retval.add_term(t.first, 1);
+        }
+        return retval;
+    };
+
+    // Small product: the whole joint index space
+    // is sampled and the estimate is exact.
+    {
+        auto a = (x + y + z + 1) * (x + y + 1), b = (x - y + z * z + 2) * (y - z);
+        if (a.size() > b.size()) {
+            std::swap(a, b);
+        }
+        const vec_t v1(a.begin(), a.end()), v2(b.begin(), b.end());
+
+        const auto [est, tot, stats]
+            = polynomials::detail::poly_mul_estimate_product_size<poly_t, poly_t>(v1, v2, ss);
+        REQUIRE(tot == mppp::integer<1>{a.size()} * b.size());
+        REQUIRE(stats.exact);
+        REQUIRE(stats.n_trials > 0u);
+        REQUIRE(stats.rel_std_err == 0.);
+        REQUIRE(est == (ones(a) * ones(b)).size());
+
+        // The exact estimate is used as-is for the segmentation.
+        REQUIRE(polynomials::detail::poly_mul_seg_nterms(est, stats) == est);
+    }
+
+    // Small truncated product.
+    {
+        auto a = (x + y + z + 1) * (x + y + 1), b = (x - y + z * z + 2) * (y - z);
+        if (a.size() > b.size()) {
+            std::swap(a, b);
+        }
+        const vec_t v1(a.begin(), a.end()), v2(b.begin(), b.end());
+
+        const auto [est, tot, stats]
+            = polynomials::detail::poly_mul_estimate_product_size<poly_t, poly_t>(v1, v2, ss, 3);
+        REQUIRE(tot < mppp::integer<1>{a.size()} * b.size());
+        REQUIRE(stats.exact);
+        REQUIRE(est == truncated_mul(ones(a), ones(b), 3).size());
+
+        // Truncation limit excluding all terms.
+        const auto [est2, tot2, stats2]
+            = polynomials::detail::poly_mul_estimate_product_size<poly_t, poly_t>(v1, v2, ss, -1);
+        REQUIRE(est2 == 1);
+        REQUIRE(tot2 == 0);
+        REQUIRE(stats2.n_trials == 0u);
+    }
+
+    // Highly rectangular product: the estimate used to be
+    // off by an order of magnitude.
+    {
+        auto f = x * y * y * y * z * z + x * x * y * y * z + x * y * y * y * z + x * y * y * z * z + y * y * y * z * z
+                 + y * y * y * z + 2 * y * y * z * z + 2 * x * y * z + y * y * z + y * z * z + y * y + 2 * y * z + z;
+        poly_t g{1};
+        for (auto i = 0; i < 30; ++i) {
+            g *= f;
+        }
+
+        const vec_t v1(f.begin(), f.end()), v2(g.begin(), g.end());
+
+        const auto [est, tot, stats]
+            = polynomials::detail::poly_mul_estimate_product_size<poly_t, poly_t>(v1, v2, ss);
+        REQUIRE(tot == mppp::integer<1>{f.size()} * g.size());
+        REQUIRE(!stats.exact);
+        REQUIRE(stats.n_samples > f.size());
+        REQUIRE(stats.rel_std_err > 0.);
+
+        const auto actual = (ones(f) * ones(g)).size();
+        REQUIRE(est <= 3 * actual);
+        REQUIRE(3 * est >= actual);
+
+        // The segmentation is sized on the lower end
+        // of the confidence interval.
+        const auto seg_nterms = polynomials::detail::poly_mul_seg_nterms(est, stats);
+        REQUIRE(seg_nterms <= est);
+        REQUIRE(2 * seg_nterms >= est - 1);
+    }
+}
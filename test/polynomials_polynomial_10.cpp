@@ -0,0 +1,204 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/byte_size.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+using pm_t = packed_monomial<exp_t>;
+using poly_t = polynomial<pm_t, mppp::rational<1>>;
+using q_t = mppp::rational<1>;
+
+// Tests for the multiplication of rational polynomials
+// via primitive parts.
+TEST_CASE("polynomial_mul_primitive_algo")
+{
+    REQUIRE(polynomials::detail::poly_mul_primitive_algo<poly_t, poly_t>);
+    REQUIRE(!polynomials::detail::poly_mul_primitive_algo<polynomial<pm_t, mppp::integer<1>>,
+                                                          polynomial<pm_t, mppp::integer<1>>>);
+    REQUIRE(!polynomials::detail::poly_mul_primitive_algo<poly_t, polynomial<pm_t, mppp::integer<1>>>);
+    REQUIRE(!polynomials::detail::poly_mul_primitive_algo<polynomial<pm_t, double>, polynomial<pm_t, double>>);
+}
+
+TEST_CASE("polynomial_mul_rat_content")
+{
+    auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+    {
+        const auto cont = polynomials::detail::poly_mul_impl_rat_content(poly_t{q_t{-3, 4}});
+        REQUIRE(cont.g == 3);
+        REQUIRE(cont.l == 4);
+        REQUIRE(cont.avg_num_nbits == 2);
+        REQUIRE(cont.avg_den_nbits == 3);
+    }
+
+    {
+        const auto p = q_t{4, 3} * x - q_t{6, 5} * y + q_t{8, 9} * z;
+        const auto cont = polynomials::detail::poly_mul_impl_rat_content(p);
+        REQUIRE(cont.g == 2);
+        REQUIRE(cont.l == 45);
+        REQUIRE(cont.avg_num_nbits > 3);
+        REQUIRE(cont.avg_num_nbits < 4);
+        REQUIRE(cont.avg_den_nbits == 3);
+
+        const auto pp = polynomials::detail::poly_mul_impl_rat_primitive_part(p, cont);
+        REQUIRE(pp.get_symbol_set() == p.get_symbol_set());
+        REQUIRE(pp.size() == 3u);
+        REQUIRE(q_t{2, 45} * poly_t{pp} == p);
+    }
+
+    // Segmented polynomial.
+    {
+        auto p = x * 0;
+        p.set_n_segments(4);
+        p += q_t{10, 7} * x * y + q_t{-15, 14} * y * z + q_t{5, 21} * x * z + q_t{20, 3} * z * z + 5 * x;
+        REQUIRE(p.get_s_size() == 4u);
+
+        const auto cont = polynomials::detail::poly_mul_impl_rat_content(p);
+        REQUIRE(cont.g == 5);
+        REQUIRE(cont.l == 42);
+
+        const auto pp = polynomials::detail::poly_mul_impl_rat_primitive_part(p, cont);
+        REQUIRE(pp.get_s_size() == 4u);
+        REQUIRE(q_t{5, 42} * poly_t{pp} == p);
+    }
+}
+
+TEST_CASE("polynomial_mul_primitive")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = q_t{1, 2} * x + q_t{2, 3} * y - q_t{3, 5} * z + q_t{5, 7} * t + q_t{1, 11};
+    auto g = q_t{-3, 2} * x + q_t{4, 9} * y + q_t{2, 5} * z - t + 3;
+    auto f0 = f, g0 = g;
+    for (auto i = 0; i < 9; ++i) {
+        f *= f0;
+        g *= g0;
+    }
+
+    // Make sure the operands are large enough
+    // to trigger the multiplication via primitive parts.
+    REQUIRE(byte_size(f) >= 30000u);
+
+    // Compute the reference result with
+    // the simple implementation.
+    auto simple_mul = [](const poly_t &a, const poly_t &b, const auto &...args) {
+        poly_t retval;
+        retval.set_symbol_set(a.get_symbol_set());
+        polynomials::detail::poly_mul_impl_simple(retval, a, b, args...);
+        return retval;
+    };
+
+    REQUIRE(f * g == simple_mul(f, g));
+    REQUIRE(f * f == simple_mul(f, f));
+    REQUIRE(f * (f * 0 + 1) == f);
+
+    // Cancellations.
+    REQUIRE((f + g) * (f - g) == simple_mul(f + g, f - g));
+    REQUIRE(f * (g * 0) == 0);
+
+    // Truncated multiplication.
+    REQUIRE(truncated_mul(f, g, 12) == simple_mul(f, g, 12));
+    REQUIRE(truncated_mul(f, g, 6, symbol_set{"x", "y"}) == simple_mul(f, g, 6, symbol_set{"x", "y"}));
+    REQUIRE(truncated_mul(f, g, -1).empty());
+
+    // Integral coefficients.
+    auto h = 2 * x - 3 * y + 4 * z - t + 5, h0 = h;
+    for (auto i = 0; i < 9; ++i) {
+        h *= h0;
+    }
+    REQUIRE(h * g == simple_mul(h, g));
+    REQUIRE(h * h == simple_mul(h, h));
+}
+
+// The multiplication via primitive parts is not used
+// when the rescaling inflates the coefficients.
+TEST_CASE("polynomial_mul_primitive_growth")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    const auto max_growth = get_mul_tuning().primitive_max_growth;
+
+    // Denominators with many common factors.
+    auto f = q_t{1, 2} * x + q_t{3, 4} * y - q_t{5, 8} * z + q_t{1, 6} * t + q_t{1, 12}, f0 = f;
+    for (auto i = 0; i < 9; ++i) {
+        f *= f0;
+    }
+    REQUIRE(byte_size(f) >= 30000u);
+    REQUIRE(polynomials::detail::poly_mul_impl_primitive_is_convenient(
+        polynomials::detail::poly_mul_impl_rat_content(f), max_growth));
+
+    // Pairwise coprime denominators: the LCM of the denominators
+    // is much larger than each denominator.
+    poly_t g;
+    g.set_symbol_set(f.get_symbol_set());
+    std::int32_t n = 0;
+    for (mppp::integer<1> p{2}; g.size() < f.size(); p = mppp::nextprime(p)) {
+        g.add_term(pm_t{n % 7, n / 7 % 7, n / 49 % 7, n / 343}, q_t{1, static_cast<long long>(p)});
+        ++n;
+    }
+    REQUIRE(byte_size(g) >= 30000u);
+
+    const auto cont_g = polynomials::detail::poly_mul_impl_rat_content(g);
+    REQUIRE(cont_g.g == 1);
+    REQUIRE(cont_g.l.nbits() > 1000u);
+    REQUIRE(!polynomials::detail::poly_mul_impl_primitive_is_convenient(cont_g, max_growth));
+
+    // The rescaling can be allowed via the tuning parameters.
+    REQUIRE(polynomials::detail::poly_mul_impl_primitive_is_convenient(cont_g, 1E9));
+
+    // Check the algorithm selection.
+    const auto cont_f = polynomials::detail::poly_mul_impl_rat_content(f);
+    auto select = [](const poly_t &a, const auto &cont_a, const poly_t &b, const auto &cont_b, const mul_tuning &tn) {
+        return polynomials::detail::poly_mul_impl_select<false>(
+            a, b, byte_size(a), byte_size(b), [&cont_a]() -> const auto & { return cont_a; },
+            [&cont_b]() -> const auto & { return cont_b; }, tn);
+    };
+    REQUIRE(select(f, cont_f, f, cont_f, get_mul_tuning()) == polynomials::detail::poly_mul_impl_algo::primitive);
+    REQUIRE(select(f, cont_f, g, cont_g, get_mul_tuning()) != polynomials::detail::poly_mul_impl_algo::primitive);
+    REQUIRE(select(g, cont_g, g, cont_g, get_mul_tuning()) != polynomials::detail::poly_mul_impl_algo::primitive);
+    auto tn = get_mul_tuning();
+    tn.primitive_max_growth = 1E9;
+    REQUIRE(select(f, cont_f, g, cont_g, tn) == polynomials::detail::poly_mul_impl_algo::primitive);
+
+    // Check the product via the rational arithmetic.
+    poly_t ref;
+    ref.set_symbol_set(f.get_symbol_set());
+    polynomials::detail::poly_mul_impl_simple(ref, g, f);
+    REQUIRE(f * g == ref);
+
+    ref.clear_terms();
+    polynomials::detail::poly_mul_impl_simple(ref, g, g);
+    REQUIRE(g * g == ref);
+}
@@ -0,0 +1,169 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+
+#include <mp++/integer.hpp>
+
+#include <obake/byte_size.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+using pm_t = packed_monomial<exp_t>;
+using int_t = mppp::integer<1>;
+using poly_t = polynomial<pm_t, int_t>;
+
+// Tests for the multi-modular multiplication.
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+TEST_CASE("polynomial_mul_crt_algo")
+{
+    REQUIRE(polynomials::detail::poly_mul_crt_algo<poly_t, poly_t>);
+    REQUIRE(!polynomials::detail::poly_mul_crt_algo<poly_t, polynomial<pm_t, mppp::integer<2>>>);
+    REQUIRE(!polynomials::detail::poly_mul_crt_algo<polynomial<pm_t, double>, polynomial<pm_t, double>>);
+    REQUIRE(!polynomials::detail::poly_mul_crt_algo<polynomial<pm_t, long>, polynomial<pm_t, long>>);
+}
+
+TEST_CASE("polynomial_mul_crt_primes")
+{
+    using polynomials::detail::poly_mul_crt_is_prime;
+
+    REQUIRE(!poly_mul_crt_is_prime(0));
+    REQUIRE(!poly_mul_crt_is_prime(1));
+    REQUIRE(poly_mul_crt_is_prime(2));
+    REQUIRE(poly_mul_crt_is_prime(3));
+    REQUIRE(!poly_mul_crt_is_prime(4));
+    REQUIRE(poly_mul_crt_is_prime(37));
+    REQUIRE(!poly_mul_crt_is_prime(1369));
+    REQUIRE(poly_mul_crt_is_prime(1000000007ull));
+    // Strong pseudoprime to bases 2, 3, 5 and 7.
+    REQUIRE(!poly_mul_crt_is_prime(3215031751ull));
+    REQUIRE(poly_mul_crt_is_prime(2305843009213693951ull));
+    REQUIRE(poly_mul_crt_is_prime(18446744073709551557ull));
+    REQUIRE(!poly_mul_crt_is_prime(18446744073709551615ull));
+
+    for (unsigned nbits : {3u, 10u, 40u, 62u}) {
+        const auto primes = polynomials::detail::poly_mul_crt_make_primes(nbits, 2);
+        REQUIRE(primes.size() == 2u);
+        REQUIRE(primes[0] > primes[1]);
+        for (auto p : primes) {
+            REQUIRE(poly_mul_crt_is_prime(p));
+            REQUIRE(p > (std::uint64_t(1) << (nbits - 1u)));
+            REQUIRE(p < (std::uint64_t(1) << nbits));
+        }
+    }
+
+    REQUIRE_THROWS_AS(polynomials::detail::poly_mul_crt_make_primes(3, 3), std::overflow_error);
+}
+
+TEST_CASE("polynomial_mul_crt")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    // Coefficients of a few hundred bits.
+    const auto big = int_t{1} << 300;
+
+    auto f = (big + 1) * x - 3 * y + (big - 5) * z + 7 * t - big;
+    auto g = (-big + 11) * x + big * y - 2 * z + t + 13;
+    auto f0 = f, g0 = g;
+    for (auto i = 0; i < 5; ++i) {
+        f *= f0;
+        g *= g0;
+    }
+
+    REQUIRE(byte_size(f) >= 30000u);
+
+    // Compute the reference result with
+    // the simple implementation.
+    auto simple_mul = [](const poly_t &a, const poly_t &b, const auto &...args) {
+        poly_t retval;
+        retval.set_symbol_set(a.get_symbol_set());
+        if (a.size() <= b.size()) {
+            polynomials::detail::poly_mul_impl_simple(retval, a, b, args...);
+        } else {
+            polynomials::detail::poly_mul_impl_simple(retval, b, a, args...);
+        }
+        return retval;
+    };
+
+    // Direct invocation.
+    {
+        const auto nbits_f = polynomials::detail::poly_mul_crt_max_nbits(f);
+        const auto nbits_g = polynomials::detail::poly_mul_crt_max_nbits(g);
+        REQUIRE(nbits_f > 300u * 6u);
+        REQUIRE(nbits_g > 300u * 6u);
+
+        REQUIRE(polynomials::detail::poly_mul_impl_crt(f, g, nbits_f, nbits_g) == simple_mul(f, g));
+        REQUIRE(polynomials::detail::poly_mul_impl_crt(f, g, nbits_f, nbits_g, 20) == simple_mul(f, g, 20));
+        REQUIRE(polynomials::detail::poly_mul_impl_crt(f, g, nbits_f, nbits_g, 10, symbol_set{"x", "z"})
+                == simple_mul(f, g, 10, symbol_set{"x", "z"}));
+    }
+
+    // Residues of a segmented polynomial.
+    {
+        auto p = x * 0;
+        p.set_n_segments(2);
+        p += (big * 7 + 14) * x - 14 * y + 28 * z;
+        const auto r = polynomials::detail::poly_mul_crt_reduce(p, 7);
+        REQUIRE(r.get_s_size() == 2u);
+        REQUIRE(r.size() == 3u);
+        for (const auto &[k, c] : r) {
+            // NOTE: multiples of p are represented by p.
+            REQUIRE(c == 7u);
+        }
+    }
+
+    // Via the dispatch machinery.
+    {
+        auto mt = polynomials::get_mul_tuning();
+        mt.crt_min_nbits = 0;
+        polynomials::set_mul_tuning(mt);
+
+        REQUIRE(f * g == simple_mul(f, g));
+        REQUIRE(f * f == simple_mul(f, f));
+
+        // Cancellations.
+        REQUIRE((f + g) * (f - g) == simple_mul(f + g, f - g));
+        REQUIRE((f - g) * (f - g) - (f + g) * (f + g) == -4 * simple_mul(f, g));
+
+        // Truncated multiplication.
+        REQUIRE(truncated_mul(f, g, 15) == simple_mul(f, g, 15));
+        REQUIRE(truncated_mul(f, g, -1).empty());
+
+        // Small coefficients.
+        auto h = 2 * x - 3 * y + 4 * z - t + 5, h0 = h;
+        for (auto i = 0; i < 9; ++i) {
+            h *= h0;
+        }
+        REQUIRE(h * f == simple_mul(h, f));
+        REQUIRE(h * h == simple_mul(h, h));
+
+        polynomials::reset_mul_tuning();
+    }
+}
+
+#endif
@@ -0,0 +1,224 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+using pm_t = packed_monomial<exp_t>;
+using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+// Reference multiplication via the simple implementation,
+// on distinct objects (so that the squaring algorithm
+// is never used).
+template <typename P, typename... Args>
+P ref_mul(const P &a, const P &b, const Args &...args)
+{
+    const auto a_copy(a), b_copy(b);
+
+    P retval;
+    retval.set_symbol_set(a.get_symbol_set());
+    if (a.size() <= b.size()) {
+        polynomials::detail::poly_mul_impl_simple(retval, a_copy, b_copy, args...);
+    } else {
+        polynomials::detail::poly_mul_impl_simple(retval, b_copy, a_copy, args...);
+    }
+    return retval;
+}
+
+// Tests for the squaring algorithm.
+TEST_CASE("polynomial_mul_sqr_algo")
+{
+    REQUIRE(polynomials::detail::poly_mul_sqr_algo<poly_t, poly_t>);
+    REQUIRE(polynomials::detail::poly_mul_sqr_algo<polynomial<pm_t, double>, polynomial<pm_t, double>>);
+    REQUIRE(!polynomials::detail::poly_mul_sqr_algo<poly_t, polynomial<pm_t, double>>);
+    // NOTE: the sum of two shorts is an int.
+    REQUIRE(!polynomials::detail::poly_mul_sqr_algo<polynomial<pm_t, short>, polynomial<pm_t, short>>);
+
+    auto [x, y] = make_polynomials<poly_t>("x", "y");
+    const auto x_copy = x;
+
+    REQUIRE(polynomials::detail::poly_mul_impl_is_sqr(x, x));
+    REQUIRE(!polynomials::detail::poly_mul_impl_is_sqr(x, x_copy));
+    REQUIRE(!polynomials::detail::poly_mul_impl_is_sqr(x, y));
+}
+
+TEST_CASE("polynomial_mul_sqr_simple")
+{
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    REQUIRE(x * x == ref_mul(x, x));
+
+    auto f = x + 2 * y - 3 * z + t * t - 1;
+    for (auto i = 0; i < 3; ++i) {
+        REQUIRE(f * f == ref_mul(f, f));
+        f *= f;
+    }
+
+    // Cancellations.
+    auto g = (x - y) * (x + y) + z;
+    REQUIRE(g * g == ref_mul(g, g));
+
+    // Truncated multiplication.
+    for (auto d : {-1, 0, 1, 3, 5, 8, 100}) {
+        REQUIRE(truncated_mul(f, f, d) == ref_mul(f, f, d));
+        REQUIRE(truncated_mul(f, f, d, symbol_set{"x", "t"}) == ref_mul(f, f, d, symbol_set{"x", "t"}));
+    }
+
+    // Floating-point coefficients.
+    auto [a, b] = make_polynomials<polynomial<pm_t, double>>("a", "b");
+    auto h = 0.5 * a - 1.5 * b + 3;
+    REQUIRE(h * h == ref_mul(h, h));
+}
+
+TEST_CASE("polynomial_mul_sqr_mt_hm")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = (x + y + z * z * 2 + t * t * t * 3 + 1);
+    for (auto i = 0; i < 3; ++i) {
+        f *= f;
+    }
+    f += x * y * z * t;
+
+    // NOTE: invoke directly the multithreaded implementation,
+    // as the operands may be small enough to trigger
+    // the simple implementation.
+    auto mt_sqr = [&f](const auto &...args) {
+        poly_t retval;
+        retval.set_symbol_set(f.get_symbol_set());
+        polynomials::detail::poly_mul_impl_mt_hm(retval, f, f, args...);
+        return retval;
+    };
+
+    const auto ref = ref_mul(f, f);
+
+    // Disable the dense engine, so that the
+    // hash-based multiplication is used.
+    auto tn = mul_tuning::get_default();
+    tn.dense_engine_max_sp = 0;
+
+    // Default segments.
+    {
+        set_mul_tuning(tn);
+        REQUIRE(mt_sqr() == ref);
+        REQUIRE(mt_sqr(20) == ref_mul(f, f, 20));
+        REQUIRE(mt_sqr(10, symbol_set{"y", "z"}) == ref_mul(f, f, 10, symbol_set{"y", "z"}));
+        REQUIRE(mt_sqr(-1).empty());
+        reset_mul_tuning();
+    }
+
+    // Tiny segments.
+    {
+        auto tn2 = tn;
+        tn2.sparse_seg_size = 1;
+        tn2.dense_seg_size = 1;
+        set_mul_tuning(tn2);
+        REQUIRE(mt_sqr() == ref);
+        REQUIRE(mt_sqr(20) == ref_mul(f, f, 20));
+        REQUIRE(mt_sqr(10, symbol_set{"y", "z"}) == ref_mul(f, f, 10, symbol_set{"y", "z"}));
+        reset_mul_tuning();
+    }
+
+    // Huge segments.
+    {
+        auto tn2 = tn;
+        tn2.sparse_seg_size = std::numeric_limits<std::size_t>::max();
+        tn2.dense_seg_size = std::numeric_limits<std::size_t>::max();
+        set_mul_tuning(tn2);
+        REQUIRE(mt_sqr() == ref);
+        REQUIRE(mt_sqr(20) == ref_mul(f, f, 20));
+        reset_mul_tuning();
+    }
+
+    // Sparse operand.
+    {
+        auto g = x * x * x * x * x * x * x + y * y * y * y * y * z + t * t * t * t * t * t * x + 1;
+        auto g0 = g;
+        for (auto i = 0; i < 5; ++i) {
+            g *= g0;
+        }
+
+        poly_t retval;
+        retval.set_symbol_set(g.get_symbol_set());
+        polynomials::detail::poly_mul_impl_mt_hm(retval, g, g);
+        REQUIRE(retval == ref_mul(g, g));
+    }
+}
+
+TEST_CASE("polynomial_mul_sqr_rational")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using q_t = mppp::rational<1>;
+    using qpoly_t = polynomial<pm_t, q_t>;
+
+    auto [x, y, z, t] = make_polynomials<qpoly_t>("x", "y", "z", "t");
+
+    auto f = q_t{1, 2} * x + q_t{2, 3} * y - q_t{3, 5} * z + q_t{5, 7} * t + q_t{1, 11}, f0 = f;
+    for (auto i = 0; i < 9; ++i) {
+        f *= f0;
+    }
+
+    // Squaring via the primitive parts.
+    REQUIRE(f * f == ref_mul(f, f));
+    REQUIRE(truncated_mul(f, f, 12) == ref_mul(f, f, 12));
+}
+
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+TEST_CASE("polynomial_mul_sqr_crt")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    const auto big = mppp::integer<1>{1} << 300;
+
+    auto f = (big + 1) * x - 3 * y + (big - 5) * z + 7 * t - big, f0 = f;
+    for (auto i = 0; i < 5; ++i) {
+        f *= f0;
+    }
+
+    // Squaring via the multi-modular multiplication.
+    auto mt = get_mul_tuning();
+    mt.crt_min_nbits = 0;
+    set_mul_tuning(mt);
+
+    REQUIRE(f * f == ref_mul(f, f));
+    REQUIRE(truncated_mul(f, f, 15) == ref_mul(f, f, 15));
+
+    reset_mul_tuning();
+}
+
+#endif
@@ -0,0 +1,169 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <type_traits>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/series.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+using pm_t = packed_monomial<exp_t>;
+using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+// Tests for the in-place multiplication.
+TEST_CASE("polynomial_in_place_mul")
+{
+    obake_test::disable_slow_stack_traces();
+
+    REQUIRE(is_in_place_multipliable_v<poly_t &, const poly_t &>);
+    REQUIRE(std::is_same_v<decltype(series_in_place_mul(std::declval<poly_t &>(), std::declval<const poly_t &>())),
+                           poly_t &>);
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = x + 2 * y - 3 * z + t * t - 1, g = x * y - z + 3;
+
+    {
+        const auto ref = f * g;
+        auto h = f;
+        h *= g;
+        REQUIRE(h == ref);
+
+        // Longer operand on the left.
+        h = f * f;
+        const auto ref2 = h * g;
+        h *= g;
+        REQUIRE(h == ref2);
+    }
+
+    // Squaring.
+    {
+        const auto ref = f * poly_t(f);
+        auto h = f;
+        h *= h;
+        REQUIRE(h == ref);
+    }
+
+    // Different symbol sets.
+    {
+        auto [a] = make_polynomials<poly_t>("a");
+        const auto ref = f * (a + 1);
+        auto h = f;
+        h *= a + 1;
+        REQUIRE(h == ref);
+        REQUIRE(h.get_symbol_set() == symbol_set{"a", "t", "x", "y", "z"});
+    }
+
+    // Empty operands.
+    {
+        auto h = f;
+        h *= poly_t{};
+        REQUIRE(h.empty());
+
+        h = poly_t{};
+        h *= f;
+        REQUIRE(h.empty());
+    }
+
+    // Rational coefficients.
+    {
+        using q_t = mppp::rational<1>;
+        using qpoly_t = polynomial<pm_t, q_t>;
+
+        auto [a, b, c] = make_polynomials<qpoly_t>("a", "b", "c");
+
+        auto p = q_t{1, 2} * a + q_t{2, 3} * b - q_t{3, 5} * c + q_t{1, 7}, p0 = p;
+        for (auto i = 0; i < 8; ++i) {
+            const auto ref = p * p0;
+            p *= p0;
+            REQUIRE(p == ref);
+        }
+
+        const auto ref = p * qpoly_t(p);
+        p *= p;
+        REQUIRE(p == ref);
+    }
+}
+
+TEST_CASE("polynomial_in_place_mul_mt_hm")
+{
+    obake_test::disable_slow_stack_traces();
+
+    auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+    auto f = x + y + z * z * 2 + t * t * t * 3 + 1, g = x - y + z * t - 2;
+    const auto f0 = f, g0 = g;
+    for (auto i = 0; i < 5; ++i) {
+        f *= f0;
+        g *= g0;
+    }
+
+    // Check that the releaser is invoked exactly once,
+    // and that the result does not depend on
+    // the state of the operands after the release.
+    auto mt_mul = [](const poly_t &a, const poly_t &b, const auto &...args) {
+        auto a_copy(a.size() <= b.size() ? a : b), b_copy(a.size() <= b.size() ? b : a);
+
+        int n_rel = 0;
+        poly_t retval;
+        retval.set_symbol_set(a.get_symbol_set());
+        polynomials::detail::poly_mul_impl_mt_hm_rel(
+            [&]() {
+                ++n_rel;
+                a_copy.clear_terms();
+                b_copy.clear_terms();
+            },
+            retval, a_copy, b_copy, args...);
+        REQUIRE(n_rel == 1);
+
+        return retval;
+    };
+
+    const auto ref = f * g;
+    REQUIRE(mt_mul(f, g) == ref);
+    REQUIRE(mt_mul(f, g, 10) == truncated_mul(f, g, 10));
+    REQUIRE(mt_mul(f, g, 5, symbol_set{"x", "t"}) == truncated_mul(f, g, 5, symbol_set{"x", "t"}));
+
+    // Sparse and dense engines.
+    for (auto sp : {0., 1e9}) {
+        auto tn = mul_tuning::get_default();
+        tn.dense_engine_max_sp = sp;
+        set_mul_tuning(tn);
+
+        REQUIRE(mt_mul(f, g) == ref);
+        REQUIRE(mt_mul(f, f) == f * poly_t(f));
+
+        reset_mul_tuning();
+    }
+
+    // In-place multiplication via the top-level function.
+    auto h = f;
+    h *= g;
+    REQUIRE(h == ref);
+}
@@ -0,0 +1,204 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/kpack.hpp>
+#include <obake/math/fma3.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the fused multiply-accumulate.
+TEST_CASE("polynomial_fma3")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+    using cf_types = std::tuple<double, mppp::integer<1>, mppp::rational<1>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        detail::tuple_for_each(cf_types{}, [](auto xs) {
+            using poly_t = polynomial<decltype(pm), decltype(xs)>;
+
+            REQUIRE(is_mult_addable_v<poly_t &, const poly_t &, const poly_t &>);
+            REQUIRE(!is_mult_addable_v<const poly_t &, const poly_t &, const poly_t &>);
+            REQUIRE(!is_mult_addable_v<poly_t &, const polynomial<decltype(pm), float> &,
+                                       const polynomial<decltype(pm), float> &>);
+
+            const auto ss = symbol_set{"x", "y", "z"};
+            auto [x, y, z] = make_polynomials<poly_t>(ss, "x", "y", "z");
+
+            auto f = 1 + x + y + z, g = 1 - x * x - y * y * y - z * z;
+            f = f * f * f * f * f * f;
+            g = g * g * g * g * g * g;
+
+            // Check that fma3(r, a, b) matches r + a * b.
+            auto check_fma3 = [](poly_t r, const poly_t &a, const poly_t &b) {
+                const auto ref = r + a * b;
+                fma3(r, a, b);
+                REQUIRE(r == ref);
+                REQUIRE(r.get_symbol_set() == ref.get_symbol_set());
+            };
+
+            // Empty accumulator and empty operands.
+            check_fma3(poly_t{}, f, g);
+            check_fma3(poly_t{}, poly_t{}, g);
+            check_fma3(f, poly_t{}, g);
+
+            // Identical symbol sets.
+            check_fma3(f, f, g);
+            check_fma3(f, g, f);
+            check_fma3(g * 3, f, f * (1 + x));
+
+            // Total cancellation, partial cancellation.
+            check_fma3(-f * g, f, g);
+            check_fma3(-f * g + x * y * z, f, g);
+
+            // Different symbol sets.
+            auto [a] = make_polynomials<poly_t>("a");
+            check_fma3(f, f, a + 1);
+            check_fma3(a, f, g);
+
+            // Aliasing.
+            auto h = f;
+            fma3(h, h, g);
+            REQUIRE(h == f + f * g);
+            h = f;
+            fma3(h, g, h);
+            REQUIRE(h == f + g * f);
+            h = f;
+            fma3(h, h, h);
+            REQUIRE(h == f + f * f);
+
+            // Accumulation loop with segmented accumulator.
+            poly_t r, ref;
+            r.set_symbol_set(ss);
+            r.set_n_segments(4);
+            ref.set_symbol_set(ss);
+            for (auto i = 0; i < 4; ++i) {
+                const auto fi = f * (x + i), gi = g * (y - i);
+                fma3(r, fi, gi);
+                ref += fi * gi;
+                REQUIRE(r == ref);
+            }
+            REQUIRE(r.get_s_size() == 4u);
+
+            // Non-homomorphic implementation.
+            r = f;
+            polynomials::detail::poly_fma3_impl_simple(r, f, g);
+            REQUIRE(r == f + f * g);
+            r = -f * g;
+            polynomials::detail::poly_fma3_impl_simple(r, f, g);
+            REQUIRE(r.empty());
+
+            // Re-segmentation.
+            r = f * g;
+            polynomials::detail::poly_fma3_impl_resegment(r, 3);
+            REQUIRE(r.get_s_size() == 3u);
+            REQUIRE(r == f * g);
+            polynomials::detail::poly_fma3_impl_resegment(r, 0);
+            REQUIRE(r.get_s_size() == 0u);
+            REQUIRE(r == f * g);
+        });
+    });
+}
+
+// An overflow in the exponents must leave
+// the accumulator unchanged.
+TEST_CASE("polynomial_fma3_overflow")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+    const auto lims = detail::kpack_get_lims<exp_t>(1);
+
+    for (const auto l : {lims.first, lims.second}) {
+        auto [a] = make_polynomials<poly_t>("a");
+
+        poly_t x, y;
+        x.set_symbol_set(symbol_set{"a"});
+        y.set_symbol_set(symbol_set{"a"});
+        x.add_term(pm_t{l}, 1);
+        y.add_term(pm_t{l}, 1);
+        y.add_term(pm_t{exp_t(0)}, 2);
+
+        auto r = 3 * a + 1;
+        const auto orig = r;
+
+        OBAKE_REQUIRES_THROWS_CONTAINS(
+            fma3(r, x, y), std::overflow_error,
+            "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        REQUIRE(r == orig);
+
+        OBAKE_REQUIRES_THROWS_CONTAINS(
+            polynomials::detail::poly_fma3_impl_simple(r, x, y), std::overflow_error,
+            "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        REQUIRE(r == orig);
+
+        // Segmented accumulator.
+        poly_t rs;
+        rs.set_symbol_set(symbol_set{"a"});
+        rs.set_n_segments(2);
+        for (const auto &[k, c] : orig) {
+            rs.add_term(k, c);
+        }
+        OBAKE_REQUIRES_THROWS_CONTAINS(
+            polynomials::detail::poly_fma3_impl_mt_hm(rs, x, y), std::overflow_error,
+            "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+        REQUIRE(rs == orig);
+        REQUIRE(rs.get_s_size() == 2u);
+    }
+}
+
+// Nested polynomials: the fused multiply-accumulate
+// is used in the multiplication of the coefficients.
+TEST_CASE("polynomial_fma3_nested")
+{
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+    using ppoly_t = polynomial<pm_t, poly_t>;
+
+    REQUIRE(is_mult_addable_v<poly_t &, const poly_t &, const poly_t &>);
+
+    auto [x, y] = make_polynomials<poly_t>("x", "y");
+    auto [a, b] = make_polynomials<ppoly_t>("a", "b");
+
+    auto f = (a * x + b * y + 1) * (a - b * x + y), g = (a * y - b + x) * (b + x * y);
+    f = f * f;
+    g = g * g;
+
+    ppoly_t r = a * b;
+    const auto ref = r + f * g;
+    fma3(r, f, g);
+    REQUIRE(r == ref);
+}
@@ -0,0 +1,282 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <list>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/byte_size.hpp>
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/kpack.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/mul_tuning.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the batched multiplication.
+TEST_CASE("polynomial_mul_many")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+    using cf_types = std::tuple<double, mppp::integer<1>, mppp::rational<1>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        detail::tuple_for_each(cf_types{}, [](auto xs) {
+            using poly_t = polynomial<decltype(pm), decltype(xs)>;
+            using vec_t = std::vector<poly_t>;
+
+            REQUIRE(polynomials::detail::poly_mul_many_algo<poly_t, vec_t &>);
+            REQUIRE(polynomials::detail::poly_mul_many_algo<poly_t, const std::list<poly_t> &>);
+            REQUIRE(!polynomials::detail::poly_mul_many_algo<poly_t, int>);
+            REQUIRE(!polynomials::detail::poly_mul_many_algo<poly_t, std::vector<int> &>);
+            REQUIRE(std::is_same_v<decltype(mul_many(poly_t{}, vec_t{})), vec_t>);
+
+            auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+            auto f = 1 + x + y + z, g = 1 - x * x - y * y * y - z * z;
+            f = f * f * f * f * f * f * f * f;
+            g = g * g * g * g;
+
+            // Small and large polynomials, empty polynomials,
+            // polynomials with different symbol sets.
+            auto [a] = make_polynomials<poly_t>("a");
+            const vec_t ys{x, g, poly_t{}, f, 3 * y - z + 1, a + x, f * (1 - x), poly_t{2}, f - x * y};
+
+            auto check = [&ys](const poly_t &s, const auto &res, auto op) {
+                REQUIRE(res.size() == ys.size());
+                for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+                    const auto ref = op(s, ys[i]);
+                    REQUIRE(res[i] == ref);
+                    REQUIRE(res[i].get_symbol_set() == ref.get_symbol_set());
+                }
+            };
+
+            for (const auto &s : {poly_t{}, poly_t{-2}, x, f, g * (z - 2)}) {
+                check(s, mul_many(s, ys), [](const auto &p, const auto &q) { return p * q; });
+
+                for (auto d : {-1, 0, 3, 7, 100}) {
+                    check(s, truncated_mul_many(s, ys, d),
+                          [d](const auto &p, const auto &q) { return truncated_mul(p, q, d); });
+                    check(s, truncated_mul_many(s, ys, d, symbol_set{"x", "z"}),
+                          [d](const auto &p, const auto &q) { return truncated_mul(p, q, d, symbol_set{"x", "z"}); });
+                }
+            }
+
+            // Empty range, non-random-access range.
+            REQUIRE(mul_many(f, vec_t{}).empty());
+            const std::list<poly_t> l(ys.begin(), ys.end());
+            check(f, mul_many(f, l), [](const auto &p, const auto &q) { return p * q; });
+
+            // Shared operand in the range.
+            const vec_t fs{f, g, f};
+            const auto res = mul_many(fs[0], fs);
+            REQUIRE(res[0] == f * f);
+            REQUIRE(res[1] == f * g);
+            REQUIRE(res[2] == f * f);
+        });
+    });
+}
+
+// The multi-threaded homomorphic implementation
+// with a shared operand.
+TEST_CASE("polynomial_mul_many_mt_hm_shared")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+    using sh_t = polynomials::detail::poly_mul_impl_mt_hm_shared<poly_t>;
+
+    auto [x, y, z] = make_polynomials<poly_t>(symbol_set{"x", "y", "z"}, "x", "y", "z");
+
+    auto f = 1 + x + y + z, g = 1 - x * x - y * y * y - z * z;
+    f = f * f * f * f * f * f * f * f;
+    g = g * g * g * g;
+
+    // Multiply via the shared data of f, which is either
+    // the first or the second operand.
+    auto mul_sh = [&f](const sh_t &sh, const poly_t &h) {
+        poly_t retval;
+        retval.set_symbol_set_fw(f.get_symbol_set_fw());
+
+        if (f.size() <= h.size()) {
+            polynomials::detail::poly_mul_impl_mt_hm_sh_rel(polynomials::detail::poly_mul_impl_no_release{}, retval, f,
+                                                            &sh, h, static_cast<const sh_t *>(nullptr));
+        } else {
+            polynomials::detail::poly_mul_impl_mt_hm_sh_rel(polynomials::detail::poly_mul_impl_no_release{}, retval, h,
+                                                            static_cast<const sh_t *>(nullptr), f, &sh);
+        }
+
+        return retval;
+    };
+
+    for (auto ovf_checked : {false, true}) {
+        const sh_t sh(f, ovf_checked);
+
+        // Products of different sizes, so that
+        // different segmentations are used.
+        for (const auto &h : {g, x - 1, f * (z + 3), g * g, f}) {
+            REQUIRE(mul_sh(sh, h) == f * h);
+            // Re-use the cached segmentation.
+            REQUIRE(mul_sh(sh, h) == f * h);
+        }
+
+        // Squaring.
+        poly_t retval;
+        retval.set_symbol_set_fw(f.get_symbol_set_fw());
+        polynomials::detail::poly_mul_impl_mt_hm_sh_rel(polynomials::detail::poly_mul_impl_no_release{}, retval, f,
+                                                        &sh, f, static_cast<const sh_t *>(nullptr));
+        REQUIRE(retval == f * f);
+    }
+
+    // Truncated multiplication.
+    using sht_t = polynomials::detail::poly_mul_impl_mt_hm_shared<poly_t, int>;
+    const sht_t sht(f, false);
+    for (const auto &h : {g, x - 1, g * g}) {
+        for (auto d : {2, 7, 15}) {
+            poly_t retval;
+            retval.set_symbol_set_fw(f.get_symbol_set_fw());
+            polynomials::detail::poly_mul_impl_mt_hm_sh_rel(polynomials::detail::poly_mul_impl_no_release{}, retval,
+                                                            h, static_cast<const sht_t *>(nullptr), f, &sht, d);
+            REQUIRE(retval == truncated_mul(f, h, d));
+        }
+    }
+}
+
+// Overflow detection in the batched multiplication.
+TEST_CASE("polynomial_mul_many_overflow")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+    using poly_t = polynomial<pm_t, mppp::integer<1>>;
+    using vec_t = std::vector<poly_t>;
+
+    auto [a] = make_polynomials<poly_t>("a");
+
+    poly_t x;
+    x.set_symbol_set(symbol_set{"a"});
+    x.add_term(pm_t{detail::kpack_get_lims<exp_t>(1).second}, 1);
+
+    const auto res = mul_many(x, vec_t{poly_t{2}, -a + a, x - x});
+    REQUIRE(res[0] == 2 * x);
+    REQUIRE(res[1].empty());
+    REQUIRE(res[2].empty());
+
+    OBAKE_REQUIRES_THROWS_CONTAINS(
+        mul_many(x, vec_t{poly_t{2}, a + 1}), std::overflow_error,
+        "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+    OBAKE_REQUIRES_THROWS_CONTAINS(
+        mul_many(x, vec_t{x}), std::overflow_error,
+        "An overflow in the monomial exponents was detected while attempting to multiply two polynomials");
+}
+
+// The batched multiplication via the primitive
+// parts and the multi-modular multiplication.
+TEST_CASE("polynomial_mul_many_primitive_crt")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<exp_t>;
+
+    {
+        using q_t = mppp::rational<1>;
+        using poly_t = polynomial<pm_t, q_t>;
+        using vec_t = std::vector<poly_t>;
+
+        auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+        auto f = q_t{1, 2} * x + q_t{3, 4} * y - q_t{5, 8} * z + q_t{1, 6} * t + q_t{1, 12}, f0 = f;
+        for (auto i = 0; i < 9; ++i) {
+            f *= f0;
+        }
+        REQUIRE(byte_size(f) >= get_mul_tuning().mt_min_bytes);
+
+        // Pairwise coprime denominators: the product is
+        // computed via the rational arithmetic.
+        poly_t g;
+        g.set_symbol_set(f.get_symbol_set());
+        std::int32_t n = 0;
+        for (mppp::integer<1> p{2}; g.size() < f.size(); p = mppp::nextprime(p)) {
+            g.add_term(pm_t{n % 7, n / 7 % 7, n / 49 % 7, n / 343}, q_t{1, static_cast<long long>(p)});
+            ++n;
+        }
+
+        const vec_t ys{f, g, f * q_t{2, 3} - x, poly_t{}, x / 3, q_t{1, 5} * f + y};
+
+        const auto res = mul_many(f, ys);
+        const auto tres = truncated_mul_many(f, ys, 5);
+        REQUIRE(res.size() == ys.size());
+        REQUIRE(tres.size() == ys.size());
+        for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+            REQUIRE(res[i] == f * ys[i]);
+            REQUIRE(tres[i] == truncated_mul(f, ys[i], 5));
+        }
+    }
+
+#if defined(OBAKE_HAVE_GCC_INT128)
+
+    {
+        using poly_t = polynomial<pm_t, mppp::integer<1>>;
+        using vec_t = std::vector<poly_t>;
+
+        auto [x, y, z, t] = make_polynomials<poly_t>("x", "y", "z", "t");
+
+        const auto big = mppp::integer<1>{1} << 300;
+
+        auto f = (big + 1) * x - 3 * y + (big - 5) * z + 7 * t - big, f0 = f;
+        for (auto i = 0; i < 5; ++i) {
+            f *= f0;
+        }
+
+        auto mt = get_mul_tuning();
+        mt.crt_min_nbits = 0;
+        set_mul_tuning(mt);
+
+        // Factors of different sizes, so that the
+        // products need different numbers of primes.
+        const vec_t ys{f, f * f0 * f0 - big * f, poly_t{}, x - 1, big * big * f + y, 2 * f - 1};
+
+        const auto res = mul_many(f, ys);
+        const auto tres = truncated_mul_many(f, ys, 9);
+        REQUIRE(res.size() == ys.size());
+        REQUIRE(tres.size() == ys.size());
+        for (decltype(ys.size()) i = 0; i < ys.size(); ++i) {
+            REQUIRE(res[i] == f * ys[i]);
+            REQUIRE(tres[i] == truncated_mul(f, ys[i], 9));
+        }
+
+        reset_mul_tuning();
+    }
+
+#endif
+}
@@ -0,0 +1,119 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <list>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+// Tests for the product of a range of polynomials.
+TEST_CASE("polynomial_prod")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+    using cf_types = std::tuple<mppp::integer<1>, mppp::rational<1>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        detail::tuple_for_each(cf_types{}, [](auto xs) {
+            using poly_t = polynomial<decltype(pm), decltype(xs)>;
+            using vec_t = std::vector<poly_t>;
+
+            REQUIRE(polynomials::detail::poly_prod_algo<vec_t &>);
+            REQUIRE(polynomials::detail::poly_prod_algo<const std::list<poly_t> &>);
+            REQUIRE(!polynomials::detail::poly_prod_algo<int>);
+            REQUIRE(!polynomials::detail::poly_prod_algo<std::vector<int> &>);
+            REQUIRE(std::is_same_v<decltype(prod(vec_t{})), poly_t>);
+
+            auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+            // Left fold, used as a reference.
+            auto fold = [](const auto &v) {
+                poly_t retval{1};
+                for (const auto &p : v) {
+                    retval = retval * p;
+                }
+                return retval;
+            };
+
+            // Empty product.
+            REQUIRE(prod(vec_t{}) == 1);
+
+            // Single factor.
+            REQUIRE(prod(vec_t{x + y}) == x + y);
+            REQUIRE(prod(vec_t{poly_t{}}) == 0);
+
+            // Factors of different sizes and with different symbol sets.
+            auto [a] = make_polynomials<poly_t>("a");
+            auto f = 1 + x + y + z, g = 1 - x * x - y * y * y - z * z;
+            const vec_t v{f, g, x - 2, f * f * f, 3 * y - z + 1, a + x, g * g, poly_t{2}, 1 + x + y + z + a};
+
+            const auto ref = fold(v);
+            const auto res = prod(v);
+            REQUIRE(res == ref);
+            REQUIRE(res.get_symbol_set() == ref.get_symbol_set());
+
+            // Various numbers of factors.
+            for (decltype(v.size()) n = 0; n <= v.size(); ++n) {
+                const vec_t w(v.begin(), v.begin() + static_cast<decltype(v.begin() - v.begin())>(n));
+                REQUIRE(prod(w) == fold(w));
+            }
+
+            // Zero factor.
+            REQUIRE(prod(vec_t{f, g, poly_t{}, x}) == 0);
+
+            // Repeated factors.
+            REQUIRE(prod(vec_t{f, f, f, f, f}) == f * f * f * f * f);
+
+            // Many small factors.
+            vec_t m;
+            for (int i = 0; i < 20; ++i) {
+                m.push_back(i % 2 == 0 ? x - i : y + i * z);
+            }
+            REQUIRE(prod(m) == fold(m));
+
+            // Other range types.
+            const std::list<poly_t> l(v.begin(), v.end());
+            REQUIRE(prod(l) == ref);
+
+            // The size estimation on the pointers to the terms
+            // matches the estimation on the copies of the terms.
+            const auto ff = f * f * f, gg = g * g;
+            REQUIRE(polynomials::detail::poly_prod_estimate_size(ff, gg)
+                    == std::get<0>(polynomials::detail::poly_mul_estimate_product_size<poly_t, poly_t>(
+                        polynomials::detail::poly_mul_impl_copy_terms(gg),
+                        polynomials::detail::poly_mul_impl_copy_terms(ff), gg.get_symbol_set())));
+            REQUIRE(polynomials::detail::poly_prod_estimate_size(ff, a + x) == ff.size() * 2u);
+        });
+    });
+}
@@ -0,0 +1,182 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/detail/xoroshiro128_plus.hpp>
+#include <obake/math/evaluate.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+template <typename S, typename U>
+using eval_batch_t = decltype(evaluate_batch(std::declval<const S &>(), std::declval<const symbol_map<U> &>()));
+
+// Tests for the batched evaluation.
+TEST_CASE("polynomial_evaluate_batch")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        using pm_t = decltype(pm);
+        using poly_t = polynomial<pm_t, mppp::integer<1>>;
+
+        REQUIRE(std::is_same_v<eval_batch_t<poly_t, std::vector<mppp::integer<1>>>, std::vector<mppp::integer<1>>>);
+        REQUIRE(std::is_same_v<eval_batch_t<poly_t, std::vector<double>>, std::vector<double>>);
+        REQUIRE(!is_detected_v<eval_batch_t, poly_t, int>);
+        REQUIRE(!is_detected_v<eval_batch_t, poly_t, std::vector<std::string>>);
+        REQUIRE(!is_detected_v<eval_batch_t, int, std::vector<double>>);
+        // Series coefficients are not supported.
+        REQUIRE(!is_detected_v<eval_batch_t, polynomial<pm_t, poly_t>, std::vector<mppp::integer<1>>>);
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        auto f = 1 - 2 * x + y * y * z - 3 * z * x * x + 4;
+        f = f * f * f * f * f;
+
+        detail::xoroshiro128_plus rng{12, 34};
+
+        for (auto log2_nsegs : {0u, 2u, 5u}) {
+            poly_t g;
+            g.set_symbol_set(f.get_symbol_set());
+            g.set_n_segments(log2_nsegs);
+            for (const auto &t : f) {
+                g.add_term(t.first, t.second);
+            }
+
+            for (std::size_t n_points : {0u, 1u, 7u, 600u, 1500u}) {
+                symbol_map<std::vector<mppp::integer<1>>> pi;
+                symbol_map<std::vector<double>> pd;
+                for (const auto *s : {"x", "y", "z"}) {
+                    auto &vi = pi[s];
+                    auto &vd = pd[s];
+
+                    for (std::size_t i = 0; i < n_points; ++i) {
+                        vi.emplace_back(static_cast<int>(rng.next() % 21u) - 10);
+                        vd.emplace_back(static_cast<double>(rng.next() % 2001u) / 1000. - 1);
+                    }
+                }
+
+                // Integral evaluation: exact.
+                const auto ri = evaluate_batch(g, pi);
+                REQUIRE(ri.size() == n_points);
+                for (std::size_t i = 0; i < n_points; ++i) {
+                    REQUIRE(ri[i]
+                            == evaluate(f, symbol_map<mppp::integer<1>>{
+                                               {"x", pi["x"][i]}, {"y", pi["y"][i]}, {"z", pi["z"][i]}}));
+                }
+
+                // Floating-point evaluation.
+                const auto rd = evaluate_batch(g, pd);
+                REQUIRE(rd.size() == n_points);
+                for (std::size_t i = 0; i < n_points; ++i) {
+                    const auto ref
+                        = evaluate(f, symbol_map<double>{{"x", pd["x"][i]}, {"y", pd["y"][i]}, {"z", pd["z"][i]}});
+                    REQUIRE(std::abs(rd[i] - ref) <= 1E-10 * (1 + std::abs(ref)));
+                }
+            }
+        }
+
+        // Rational coefficients.
+        using rpoly_t = polynomial<pm_t, mppp::rational<1>>;
+        auto [a, b] = make_polynomials<rpoly_t>("a", "b");
+        const auto h = mppp::rational<1>{1, 3} * a * a - mppp::rational<1>{5, 7} * a * b + 2;
+        const auto rh
+            = evaluate_batch(h, symbol_map<std::vector<mppp::integer<1>>>{{"a", {1, 2, 3}}, {"b", {4, 5, 6}}});
+        REQUIRE(std::is_same_v<decltype(rh), const std::vector<mppp::rational<1>>>);
+        REQUIRE(rh.size() == 3u);
+        REQUIRE(rh[0] == evaluate(h, symbol_map<mppp::integer<1>>{{"a", 1}, {"b", 4}}));
+        REQUIRE(rh[1] == evaluate(h, symbol_map<mppp::integer<1>>{{"a", 2}, {"b", 5}}));
+        REQUIRE(rh[2] == evaluate(h, symbol_map<mppp::integer<1>>{{"a", 3}, {"b", 6}}));
+
+        // Extra symbols in the map are allowed.
+        REQUIRE(evaluate_batch(x + 1, symbol_map<std::vector<double>>{{"x", {1., 2.}}, {"w", {3., 4.}}})
+                == std::vector<double>{2., 3.});
+
+        // Empty series and constant series.
+        REQUIRE(evaluate_batch(poly_t{}, symbol_map<std::vector<double>>{{"x", {1., 2.}}})
+                == std::vector<double>{0., 0.});
+        REQUIRE(evaluate_batch(poly_t{3}, symbol_map<std::vector<double>>{{"x", {1., 2.}}})
+                == std::vector<double>{3., 3.});
+        REQUIRE(evaluate_batch(poly_t{3}, symbol_map<std::vector<double>>{}).empty());
+
+        // Error checking.
+        OBAKE_REQUIRES_THROWS_CONTAINS(
+            evaluate_batch(x + y, symbol_map<std::vector<double>>{{"x", {1., 2.}}}), std::invalid_argument,
+            "Cannot evaluate a series in batch mode: the symbol 'y' of the series' symbol set");
+        OBAKE_REQUIRES_THROWS_CONTAINS(
+            evaluate_batch(x + y, symbol_map<std::vector<double>>{{"x", {1., 2.}}, {"y", {1.}}}),
+            std::invalid_argument,
+            "Cannot evaluate a series in batch mode: the number of values for the symbol 'y' (1) differs from the "
+            "number of values for the symbol 'x' (2)");
+    });
+}
+
+// Tests for the scratch buffer of the batches.
+TEST_CASE("polynomial_eval_batch_scratch")
+{
+    using b_t = detail::eval_batch<double>;
+
+    std::vector<double> scratch;
+    const b_t x(std::vector<double>{1., 2., 3.}, &scratch);
+    const auto x2 = pow(x, 2);
+
+    // The first multiplication of a broadcast batch
+    // writes into the scratch buffer.
+    b_t r(2);
+    REQUIRE(r.is_broadcast());
+    r *= x2;
+    REQUIRE(!r.is_broadcast());
+    REQUIRE(r.data() == scratch.data());
+    r *= x;
+    REQUIRE(scratch == std::vector<double>{2., 16., 54.});
+
+    // The buffer is reused.
+    const auto old_data = scratch.data();
+    b_t r2(1);
+    r2 *= x;
+    REQUIRE(r2.data() == old_data);
+    REQUIRE(scratch == std::vector<double>{1., 2., 3.});
+
+    // Without a scratch buffer, a new vector is allocated.
+    const b_t y(std::vector<double>{4., 5., 6.});
+    b_t r3(3);
+    r3 *= y;
+    REQUIRE(r3.data() != scratch.data());
+    REQUIRE(r3[0] == 12.);
+    REQUIRE(r3[2] == 18.);
+}
@@ -0,0 +1,131 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/detail/xoroshiro128_plus.hpp>
+#include <obake/math/evaluate.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+template <typename P, typename U>
+using eval_prog_t = decltype(std::declval<const P &>()(std::declval<const std::vector<U> &>()));
+
+// Tests for the compiled evaluation programs.
+TEST_CASE("polynomial_eval_program")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        using pm_t = decltype(pm);
+        using poly_t = polynomial<pm_t, mppp::integer<1>>;
+        using prog_t = eval_program<pm_t, mppp::integer<1>>;
+
+        REQUIRE(std::is_same_v<eval_prog_t<prog_t, mppp::integer<1>>, mppp::integer<1>>);
+        REQUIRE(std::is_same_v<eval_prog_t<prog_t, double>, double>);
+        REQUIRE(std::is_same_v<eval_prog_t<prog_t, mppp::rational<1>>, mppp::rational<1>>);
+        REQUIRE(!is_detected_v<eval_prog_t, prog_t, std::string>);
+        // Series coefficients are not supported.
+        REQUIRE(!is_detected_v<eval_prog_t, eval_program<pm_t, poly_t>, mppp::integer<1>>);
+
+        auto [x, y, z] = make_polynomials<poly_t>("x", "y", "z");
+
+        auto f = 1 - 2 * x + y * y * z - 3 * z * x * x + 4;
+        f = f * f * f * f;
+
+        const eval_program prog(f);
+        REQUIRE(std::is_same_v<decltype(prog), const prog_t>);
+        REQUIRE(prog.get_symbol_set() == f.get_symbol_set());
+        REQUIRE(prog.size() == f.size());
+        // The powers of each symbol are computed only once.
+        REQUIRE(prog.get_n_powers() < f.size());
+
+        detail::xoroshiro128_plus rng{56, 78};
+
+        for (int i = 0; i < 100; ++i) {
+            const auto xi = static_cast<int>(rng.next() % 21u) - 10, yi = static_cast<int>(rng.next() % 21u) - 10,
+                       zi = static_cast<int>(rng.next() % 21u) - 10;
+
+            // Integral evaluation.
+            REQUIRE(prog(std::vector<mppp::integer<1>>{xi, yi, zi})
+                    == evaluate(f, symbol_map<mppp::integer<1>>{{"x", xi}, {"y", yi}, {"z", zi}}));
+
+            // Floating-point evaluation: the operations are performed
+            // in the same order as in evaluate(), thus the results
+            // are identical.
+            const auto xd = xi / 7., yd = yi / 5., zd = zi / 3.;
+            REQUIRE(prog(std::vector<double>{xd, yd, zd})
+                    == evaluate(f, symbol_map<double>{{"x", xd}, {"y", yd}, {"z", zd}}));
+
+            // Rational evaluation.
+            const auto xq = mppp::rational<1>{xi, 7}, yq = mppp::rational<1>{yi, 5}, zq = mppp::rational<1>{zi, 3};
+            REQUIRE(prog(std::vector<mppp::rational<1>>{xq, yq, zq})
+                    == evaluate(f, symbol_map<mppp::rational<1>>{{"x", xq}, {"y", yq}, {"z", zq}}));
+        }
+
+        // Rational coefficients.
+        using rpoly_t = polynomial<pm_t, mppp::rational<1>>;
+        auto [a, b] = make_polynomials<rpoly_t>("a", "b");
+        const auto h = mppp::rational<1>{1, 3} * a * a - mppp::rational<1>{5, 7} * a * b + 2;
+        const eval_program hprog(h);
+        REQUIRE(std::is_same_v<decltype(hprog(std::vector<mppp::integer<1>>{})), mppp::rational<1>>);
+        REQUIRE(hprog(std::vector<mppp::integer<1>>{3, 4})
+                == evaluate(h, symbol_map<mppp::integer<1>>{{"a", 3}, {"b", 4}}));
+
+        // Negative exponents.
+        if constexpr (std::is_signed_v<exp_t>) {
+            auto g = poly_t{};
+            g.set_symbol_set(symbol_set{"x", "y"});
+            g.add_term(pm_t{-1, 2}, 3);
+            g.add_term(pm_t{0, -2}, -1);
+            const eval_program gprog(g);
+            REQUIRE(gprog(std::vector<mppp::rational<1>>{2, 3})
+                    == evaluate(g, symbol_map<mppp::rational<1>>{{"x", 2}, {"y", 3}}));
+        }
+
+        // Empty and constant polynomials.
+        REQUIRE(eval_program(poly_t{})(std::vector<double>{}) == 0.);
+        REQUIRE(eval_program(poly_t{3})(std::vector<double>{}) == 3.);
+        REQUIRE(eval_program(poly_t{3}).get_n_powers() == 0u);
+        REQUIRE(eval_program(x - x)(std::vector<double>{1.}) == 0.);
+
+        // Error checking.
+        OBAKE_REQUIRES_THROWS_CONTAINS(prog(std::vector<double>{1., 2.}), std::invalid_argument,
+                                       "Cannot evaluate a compiled polynomial: the number of values (2) differs from "
+                                       "the number of symbols (3)");
+    });
+}
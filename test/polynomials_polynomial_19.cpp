@@ -0,0 +1,196 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <cstdint>
+#include <list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mp++/integer.hpp>
+#include <mp++/rational.hpp>
+
+#include <obake/detail/tuple_for_each.hpp>
+#include <obake/math/diff.hpp>
+#include <obake/math/pow.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/polynomials/polynomial.hpp>
+#include <obake/symbols.hpp>
+
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+using namespace obake;
+
+using exp_t =
+#if defined(OBAKE_PACKABLE_INT64)
+    std::int64_t
+#else
+    std::int32_t
+#endif
+    ;
+
+template <typename T>
+using gradient_t = decltype(gradient(std::declval<const T &>()));
+
+template <typename R>
+using jacobian_t = decltype(jacobian(std::declval<R>()));
+
+TEST_CASE("monomial_gradient")
+{
+    using pm_types = std::tuple<packed_monomial<std::int32_t>, packed_monomial<std::uint32_t>,
+                                d_packed_monomial<std::int32_t, 2>, d_packed_monomial<std::uint32_t, 3>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        using pm_t = decltype(pm);
+        using value_t = typename pm_t::value_type;
+
+        REQUIRE(is_detected_v<polynomials::detail::poly_monomial_gradient_t, pm_t>);
+
+        std::vector<std::pair<value_t, pm_t>> out;
+
+        // Empty symbol set.
+        monomial_gradient(out, pm_t{}, symbol_set{});
+        REQUIRE(out.empty());
+
+        const symbol_set ss{"a", "b", "c", "d", "e"};
+        for (const auto &p : {pm_t{0, 0, 0, 0, 0}, pm_t{1, 2, 3, 4, 5}, pm_t{0, 7, 0, 1, 0}, pm_t{9, 0, 0, 0, 2}}) {
+            monomial_gradient(out, p, ss);
+            REQUIRE(out.size() == ss.size());
+
+            for (symbol_idx i = 0; i < ss.size(); ++i) {
+                REQUIRE(out[i] == monomial_diff(p, i, ss));
+            }
+        }
+
+        if constexpr (std::is_signed_v<value_t>) {
+            const auto p = pm_t{-1, 2, -3, 0, 5};
+            monomial_gradient(out, p, ss);
+            for (symbol_idx i = 0; i < ss.size(); ++i) {
+                REQUIRE(out[i] == monomial_diff(p, i, ss));
+            }
+        }
+    });
+}
+
+TEST_CASE("polynomial_gradient")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_types = std::tuple<packed_monomial<exp_t>, d_packed_monomial<exp_t, 8>>;
+
+    detail::tuple_for_each(pm_types{}, [](auto pm) {
+        using pm_t = decltype(pm);
+
+        detail::tuple_for_each(std::make_tuple(mppp::integer<1>{}, mppp::rational<1>{}), [](auto n) {
+            using cf_t = decltype(n);
+            using poly_t = polynomial<pm_t, cf_t>;
+
+            REQUIRE(std::is_same_v<gradient_t<poly_t>, std::vector<poly_t>>);
+            REQUIRE(std::is_same_v<jacobian_t<std::vector<poly_t> &>, std::vector<std::vector<poly_t>>>);
+            REQUIRE(std::is_same_v<jacobian_t<const std::list<poly_t> &>, std::vector<std::vector<poly_t>>>);
+            REQUIRE(!is_detected_v<gradient_t, int>);
+            REQUIRE(!is_detected_v<jacobian_t, std::vector<int> &>);
+            REQUIRE(!is_detected_v<jacobian_t, int>);
+
+            auto [x, y, z, w] = make_polynomials<poly_t>("x", "y", "z", "w");
+
+            // Empty polynomial.
+            REQUIRE(gradient(poly_t{}).empty());
+            REQUIRE(gradient(poly_t{5}).empty());
+
+            auto f = 1 + x + y * y - 3 * z + x * x * z + w * x * y * z;
+            f = f * f * f;
+            if constexpr (std::is_signed_v<exp_t>) {
+                f += obake::pow(x, -3) * w;
+            }
+
+            const auto g = gradient(f);
+            REQUIRE(g.size() == 4u);
+            const auto &ss = f.get_symbol_set();
+            auto it = ss.begin();
+            for (const auto &d : g) {
+                REQUIRE(d == diff(f, *it));
+                REQUIRE(d.get_symbol_set() == ss);
+                ++it;
+            }
+
+            // Segmented polynomial.
+            poly_t h;
+            h.set_symbol_set(ss);
+            h.set_n_segments(3);
+            for (const auto &t : f) {
+                h.add_term(t.first, t.second);
+            }
+            const auto gh = gradient(h);
+            REQUIRE(gh == g);
+            REQUIRE(gh[0].get_s_size() == 3u);
+
+            // Jacobian.
+            auto [a] = make_polynomials<poly_t>("a");
+            const std::vector<poly_t> v{f, x + a, poly_t{3}, y * z - a * a};
+            const auto jac = jacobian(v);
+            const symbol_set vars{"a", "w", "x", "y", "z"};
+            REQUIRE(jac.size() == v.size());
+            for (decltype(v.size()) i = 0; i < v.size(); ++i) {
+                REQUIRE(jac[i].size() == vars.size());
+
+                auto jt = vars.begin();
+                for (const auto &d : jac[i]) {
+                    REQUIRE(d == diff(v[i], *jt));
+                    ++jt;
+                }
+            }
+
+            REQUIRE(jacobian(std::vector<poly_t>{}).empty());
+            REQUIRE(jacobian(std::list<poly_t>(v.begin(), v.end())) == jac);
+        });
+    });
+
+    // Recursive polynomials, in which the derivatives
+    // of the coefficients are not zero.
+    using pm_t = packed_monomial<exp_t>;
+    using p1_t = polynomial<pm_t, mppp::integer<1>>;
+    using p11_t = polynomial<pm_t, p1_t>;
+
+    REQUIRE(std::is_same_v<gradient_t<p11_t>, std::vector<p11_t>>);
+
+    auto [x, y] = make_polynomials<p1_t>("x", "y");
+    auto [z] = make_polynomials<p11_t>("z");
+
+    auto p = 3 * x * x * y - 2 * z * y + 4 * x * z * z * z;
+    p = p * p;
+
+    // NOTE: the gradient is computed only with respect
+    // to the symbols of the outer polynomial.
+    const auto gp = gradient(p);
+    REQUIRE(gp.size() == 1u);
+    REQUIRE(gp[0] == diff(p, "z"));
+
+    const auto jp = jacobian(std::vector<p11_t>{p, p * z});
+    REQUIRE(jp.size() == 2u);
+    REQUIRE(jp[0].size() == 1u);
+    REQUIRE(jp[1][0] == diff(p * z, "z"));
+
+    // Polynomials with int coefficients, for which
+    // the differentiation changes the coefficient type.
+    using pi_t = polynomial<pm_t, int>;
+
+    REQUIRE(std::is_same_v<gradient_t<pi_t>, std::vector<polynomial<pm_t, exp_t>>>);
+
+    auto [xi, yi] = make_polynomials<pi_t>("x", "y");
+    const auto q = 2 * xi * xi * yi - 3 * yi + 1;
+    const auto gq = gradient(q);
+    REQUIRE(gq.size() == 2u);
+    REQUIRE(gq[0] == diff(q, "x"));
+    REQUIRE(gq[1] == diff(q, "y"));
+}
@@ -760,6 +760,41 @@ TEST_CASE("in-place multiplication")
         REQUIRE(std::get<2>(get_truncation(x)) == std::pair{std::int32_t(1), symbol_set{"x", "y", "z"}});
     }
 
+    // Identical symbol sets and squaring.
+    {
+        auto [x, y] = make_p_series_t<ps_t>(4, "x", "y");
+
+        auto f = x + y + 1, g = x - y + 2;
+        const auto ref = f * g;
+        f *= g;
+
+        REQUIRE(f == ref);
+        REQUIRE(get_truncation(f).index() == 1u);
+        REQUIRE(std::get<1>(get_truncation(f)) == 4);
+
+        const auto ref2 = f * ps_t(f);
+        f *= f;
+
+        REQUIRE(f == ref2);
+        REQUIRE(get_truncation(f).index() == 1u);
+        REQUIRE(std::get<1>(get_truncation(f)) == 4);
+        REQUIRE(obake::degree(f) <= 4);
+    }
+
+    {
+        auto [x, y] = make_p_series_p<ps_t>(2, symbol_set{"x"}, "x", "y");
+        auto f = x + y + 1;
+        obake::unset_truncation(f);
+
+        auto g = x * y + x + 1;
+        const auto ref = f * g;
+        f *= g;
+
+        REQUIRE(f == ref);
+        REQUIRE(get_truncation(f).index() == 2u);
+        REQUIRE(std::get<2>(get_truncation(f)) == std::pair{std::int32_t(2), symbol_set{"x"}});
+    }
+
     // Test with different-rank operands.
     {
         auto [x] = make_p_series<ps_t>("x");
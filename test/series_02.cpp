@@ -15,6 +15,7 @@
 #include <utility>
 #include <vector>
 
+#include <mp++/integer.hpp>
 #include <mp++/rational.hpp>
 
 #include <obake/polynomials/packed_monomial.hpp>
@@ -306,6 +307,142 @@ TEST_CASE("series_comparison")
     }
 }
 
+// Comparison of large segmented series, and
+// caching of the hash.
+TEST_CASE("series_comparison_segmented")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+    using s2_t = polynomial<pm_t, mppp::integer<1>>;
+
+    // Copy of p with 2**l segments.
+    auto resegment = [](const auto &p, unsigned l) {
+        remove_cvref_t<decltype(p)> retval;
+        retval.set_symbol_set(p.get_symbol_set());
+        retval.set_n_segments(l);
+        for (const auto &t : p) {
+            retval.add_term(t.first, t.second);
+        }
+
+        return retval;
+    };
+
+    auto [x, y, z] = make_polynomials<s2_t>("x", "y", "z");
+    auto f = 1 + x - 2 * y + z * x;
+    f = f * f * f * f * f * f;
+
+    const auto f1 = s1_t(f);
+
+    for (auto l1 : {0u, 1u, 3u, 5u}) {
+        for (auto l2 : {0u, 2u, 5u}) {
+            const auto a = resegment(f, l1);
+            const auto b = resegment(f1, l2);
+
+            REQUIRE(a == b);
+            REQUIRE(b == a);
+            REQUIRE(a == resegment(f, l2));
+
+            // Different coefficient.
+            auto c = resegment(f, l2);
+            c += 2 * x * y * z;
+            c -= x * y * z;
+            REQUIRE(a.size() == c.size());
+            REQUIRE(a != c);
+            REQUIRE(c != a);
+            REQUIRE(c != b);
+
+            // Different key.
+            auto d = resegment(f, l2);
+            d.add_term(pm_t{100, 0, 0}, 1);
+            d.add_term(pm_t{0, 0, 0}, -1);
+            REQUIRE(a.size() == d.size());
+            REQUIRE(a != d);
+            REQUIRE(d != a);
+            REQUIRE(d != b);
+
+            // The hash depends only on the keys
+            // (and the tag).
+            REQUIRE(a._get_hash() == b._get_hash());
+            REQUIRE(a._get_hash() == c._get_hash());
+            REQUIRE(a._get_hash() != d._get_hash());
+
+            // The cached hashes are used to detect unequal series.
+            REQUIRE(a._hash_is_cached());
+            REQUIRE(d._hash_is_cached());
+            REQUIRE(a != d);
+            REQUIRE(a == b);
+        }
+    }
+
+    // Invalidation of the cached hash.
+    auto g = s2_t(f);
+    REQUIRE(!g._hash_is_cached());
+    const auto h = g._get_hash();
+    REQUIRE(g._hash_is_cached());
+    REQUIRE(g._get_hash() == h);
+
+    // Copy/move operations.
+    auto g2 = g;
+    REQUIRE(g2._hash_is_cached());
+    REQUIRE(g2._get_hash() == h);
+    auto g3 = std::move(g2);
+    REQUIRE(g3._hash_is_cached());
+    REQUIRE(g3._get_hash() == h);
+    REQUIRE(!g2._hash_is_cached());
+    g2 = std::move(g3);
+    REQUIRE(g2._hash_is_cached());
+    REQUIRE(!g3._hash_is_cached());
+    g3 = g2;
+    REQUIRE(g3._hash_is_cached());
+    REQUIRE(g3._get_hash() == h);
+    g3 = s2_t{};
+    REQUIRE(!g3._hash_is_cached());
+    swap(g2, g3);
+    REQUIRE(!g2._hash_is_cached());
+    REQUIRE(g3._hash_is_cached());
+    REQUIRE(g3._get_hash() == h);
+
+    // Mutations.
+    g.add_term(pm_t{100, 0, 0}, 1);
+    REQUIRE(!g._hash_is_cached());
+    REQUIRE(g._get_hash() != h);
+    REQUIRE(g._hash_is_cached());
+    g.clear_terms();
+    REQUIRE(!g._hash_is_cached());
+    REQUIRE(g._get_hash() == s2_t{}._get_hash());
+    g._get_s_table();
+    REQUIRE(!g._hash_is_cached());
+    g._get_hash();
+    g.set_n_segments(2);
+    REQUIRE(!g._hash_is_cached());
+    g._get_hash();
+    g.tag();
+    REQUIRE(!g._hash_is_cached());
+    g._get_hash();
+    g.clear();
+    REQUIRE(!g._hash_is_cached());
+
+    // Const access does not invalidate.
+    g = f;
+    g._get_hash();
+    std::as_const(g)._get_s_table();
+    std::as_const(g).tag();
+    REQUIRE(g == f);
+    REQUIRE(g._hash_is_cached());
+
+    // Adding an lvalue to a segmented series
+    // does not invalidate the hash of the lvalue.
+    for (auto l : {2u, 3u}) {
+        auto acc = resegment(f, 2);
+        const auto rhs = resegment(f, l);
+        auto rhs_copy = rhs;
+        rhs_copy._get_hash();
+        acc += rhs_copy;
+        REQUIRE(rhs_copy._hash_is_cached());
+        REQUIRE(acc == 2 * f);
+    }
+}
+
 // Simple testing for in-place add/sub, which are
 // currently implemented in terms of the binary
 // operators.
@@ -580,6 +717,267 @@ TEST_CASE("series_in_place_add_sub")
     }
 }
 
+// Test the addition/subtraction of segmented series,
+// which is performed in parallel.
+TEST_CASE("series_add_sub_segmented")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+    using s2_t = polynomial<pm_t, int>;
+
+    std::uniform_int_distribution<int> edist(0, 6), cdist(-5, 5);
+
+    // Random polynomial with n terms and 2**l segments.
+    auto make_poly = [&](auto p, unsigned n, unsigned l) {
+        using p_t = decltype(p);
+
+        p_t retval;
+        retval.set_symbol_set(symbol_set{"x", "y", "z"});
+        retval.set_n_segments(l);
+        for (auto i = 0u; i < n; ++i) {
+            retval.add_term(pm_t{edist(rng), edist(rng), edist(rng)}, cdist(rng));
+        }
+
+        return retval;
+    };
+
+    // Copy of p with a single segment.
+    auto flatten = [](const auto &p) {
+        remove_cvref_t<decltype(p)> retval;
+        retval.set_symbol_set(p.get_symbol_set());
+        for (const auto &t : p) {
+            retval.add_term(t.first, t.second);
+        }
+
+        return retval;
+    };
+
+    for (auto l1 : {0u, 1u, 3u, 5u}) {
+        for (auto l2 : {0u, 1u, 3u, 5u}) {
+            const auto a = make_poly(s1_t{}, 200, l1), b = make_poly(s1_t{}, 100, l2);
+            const auto c = make_poly(s2_t{}, 150, l2);
+
+            const auto fa = flatten(a), fb = flatten(b);
+            const auto fc = flatten(c);
+
+            // Binary operators.
+            REQUIRE(a + b == fa + fb);
+            REQUIRE(b + a == fa + fb);
+            REQUIRE(a - b == fa - fb);
+            REQUIRE(b - a == fb - fa);
+            REQUIRE(a + c == fa + fc);
+            REQUIRE(c - a == fc - fa);
+            REQUIRE(s1_t(a) + s1_t(b) == fa + fb);
+            REQUIRE(s1_t(a) - s1_t(b) == fa - fb);
+
+            // The segmentation of the larger operand is preserved.
+            REQUIRE((a + b).get_s_size() == l1);
+
+            // Cancellations.
+            REQUIRE((a - a).empty());
+            REQUIRE((a + (-a)).empty());
+            REQUIRE((a + b - a - b).empty());
+
+            // In-place operators.
+            auto d = a;
+            d += b;
+            REQUIRE(d == fa + fb);
+            REQUIRE(d.get_s_size() == l1);
+            d -= s1_t(b);
+            REQUIRE(d == fa);
+            d += c;
+            REQUIRE(d == fa + fc);
+            d -= d;
+            REQUIRE(d.empty());
+
+            d = b;
+            d -= a;
+            REQUIRE(d == fb - fa);
+            REQUIRE(d.get_s_size() == l2);
+            d += a;
+            REQUIRE(d == fb);
+        }
+    }
+}
+
+// Test that the in-place addition/subtraction with
+// a larger rvalue adopts the tables (and the
+// segmentation) of the rvalue.
+TEST_CASE("series_in_place_add_sub_steal")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+    using s2_t = polynomial<pm_t, int>;
+
+    auto [x, y, z] = make_polynomials<s1_t>("x", "y", "z");
+
+    const auto small = 1 + 2 * x - y * z;
+    auto big = (x + y + z + 1) * (x - y + z - 2);
+    big = big * big * big;
+    REQUIRE(big.size() > small.size());
+
+    for (auto l1 : {0u, 2u}) {
+        for (auto l2 : {0u, 1u, 3u}) {
+            s1_t a, b;
+            a.set_symbol_set(small.get_symbol_set());
+            a.set_n_segments(l1);
+            for (const auto &t : small) {
+                a.add_term(t.first, t.second);
+            }
+            b.set_symbol_set(big.get_symbol_set());
+            b.set_n_segments(l2);
+            for (const auto &t : big) {
+                b.add_term(t.first, t.second);
+            }
+
+            // Addition.
+            auto c = a;
+            auto d = b;
+            c += std::move(d);
+            REQUIRE(c == small + big);
+            REQUIRE(c.get_s_size() == l2);
+            REQUIRE(d.empty());
+
+            // Subtraction.
+            c = a;
+            d = b;
+            c -= std::move(d);
+            REQUIRE(c == small - big);
+            REQUIRE(c.get_s_size() == l2);
+            REQUIRE(d.empty());
+
+            // Cancellation.
+            c = b;
+            d = b;
+            c -= std::move(d);
+            REQUIRE(c.empty());
+
+            // Empty lhs.
+            c = s1_t{};
+            d = b;
+            c -= std::move(d);
+            REQUIRE(c == -big);
+            REQUIRE(c.get_s_size() == l2);
+
+            // Empty accumulator with the same symbol set.
+            c = s1_t{};
+            c.set_symbol_set(big.get_symbol_set());
+            d = b;
+            c += std::move(d);
+            REQUIRE(c == big);
+            REQUIRE(c.get_s_size() == l2);
+
+            // Different symbol sets.
+            auto [w] = make_polynomials<s1_t>("w");
+            c = w;
+            d = b;
+            c += std::move(d);
+            REQUIRE(c == w + big);
+
+            // Lvalue and rvalue of a different type: no stealing.
+            c = a;
+            c += b;
+            REQUIRE(c == small + big);
+            REQUIRE(c.get_s_size() == l1);
+            s2_t e = 2 * make_polynomials<s2_t>("x")[0];
+            c = a;
+            c += std::move(e);
+            REQUIRE(c == small + 2 * x);
+        }
+    }
+}
+
+// Test the scalar multiplication/division, the negation
+// and the filtering of segmented series, which are
+// performed in parallel.
+TEST_CASE("series_scalar_ops_segmented")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using s1_t = polynomial<pm_t, rat_t>;
+    using s2_t = polynomial<pm_t, mppp::integer<1>>;
+    using s3_t = polynomial<pm_t, double>;
+
+    // Copy of p with 2**l segments.
+    auto resegment = [](const auto &p, unsigned l) {
+        remove_cvref_t<decltype(p)> retval;
+        retval.set_symbol_set(p.get_symbol_set());
+        retval.set_n_segments(l);
+        for (const auto &t : p) {
+            retval.add_term(t.first, t.second);
+        }
+
+        return retval;
+    };
+
+    auto [x, y, z] = make_polynomials<s1_t>("x", "y", "z");
+    auto f = 1 + x / 2 - y * 3 + z * x / 5;
+    f = f * f * f * f;
+
+    auto [a, b] = make_polynomials<s2_t>("a", "b");
+    auto g = 1 + a + b;
+    g = g * g * g * g * g * g;
+
+    for (auto l : {0u, 1u, 3u, 6u}) {
+        const auto fs = resegment(f, l);
+        const auto gs = resegment(g, l);
+
+        // Multiplication.
+        REQUIRE(fs * rat_t{3, 7} == f * rat_t{3, 7});
+        REQUIRE(rat_t{3, 7} * fs == f * rat_t{3, 7});
+        REQUIRE((fs * rat_t{3, 7}).get_s_size() == l);
+        REQUIRE((fs * 0).empty());
+        auto fm = fs;
+        fm *= -2;
+        REQUIRE(fm == f * -2);
+
+        // Division.
+        REQUIRE(fs / rat_t{3, 7} == f / rat_t{3, 7});
+        REQUIRE((fs / rat_t{3, 7}).get_s_size() == l);
+        auto fd = fs;
+        fd /= 5;
+        REQUIRE(fd == f / 5);
+
+        // Division with removal of the terms
+        // which become zero.
+        const auto gd = gs / 7;
+        REQUIRE(gd == g / 7);
+        REQUIRE(gd.size() < g.size());
+
+        // Multiplication with removal of the terms
+        // which become zero.
+        s3_t h;
+        h.set_symbol_set(symbol_set{"x", "y"});
+        h.set_n_segments(l);
+        for (std::int32_t i = 0; i < 100; ++i) {
+            h.add_term(pm_t{i, i % 3}, i % 2 == 0 ? 1e-200 : 1.);
+        }
+        const auto hm = h * 1e-200;
+        REQUIRE(hm.size() == 50u);
+        for (const auto &t : hm) {
+            REQUIRE(t.second == 1e-200);
+        }
+
+        // Negation.
+        REQUIRE(-fs == -f);
+        auto fn = fs;
+        negate(fn);
+        REQUIRE(fn == -f);
+        REQUIRE(fn.get_s_size() == l);
+        REQUIRE(-std::move(fn) == f);
+
+        // Filtering.
+        auto pred = [](const auto &t) { return t.first.get_value() % 3 == 0; };
+        const auto ff = filtered(fs, pred);
+        REQUIRE(ff == filtered(f, pred));
+        REQUIRE(ff.get_s_size() == l);
+        REQUIRE(ff.size() < f.size());
+        auto ff2 = fs;
+        filter(ff2, pred);
+        REQUIRE(ff2 == ff);
+        REQUIRE(ff2.get_s_size() == l);
+    }
+}
+
 struct foo {
 };
 
@@ -6,20 +6,25 @@
 // Public License v. 2.0. If a copy of the MPL was not distributed
 // with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
 
+#include <atomic>
 #include <cmath>
 #include <cstdint>
 #include <initializer_list>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 #include <mp++/integer.hpp>
 #include <mp++/rational.hpp>
 
-#include <obake/detail/ignore.hpp>
 #include <obake/math/evaluate.hpp>
 #include <obake/math/pow.hpp>
 #include <obake/math/trim.hpp>
+#include <obake/polynomials/monomial_mul.hpp>
 #include <obake/polynomials/packed_monomial.hpp>
 #include <obake/polynomials/polynomial.hpp>
 #include <obake/series.hpp>
@@ -36,6 +41,47 @@ using namespace obake;
 struct tag {
 };
 
+namespace ns
+{
+
+using pm_t = packed_monomial<std::int32_t>;
+
+// A series type whose multiplication
+// can be made to throw.
+struct tag_throw {
+};
+
+using ts_t = series<pm_t, rat_t, tag_throw>;
+
+std::atomic<bool> ts_mul_throw = false;
+
+// NOTE: naive multiplication, requires the operands to have
+// the same symbol set (unless the first one is a single coefficient).
+inline ts_t series_mul(const ts_t &a, const ts_t &b)
+{
+    if (ts_mul_throw.load()) {
+        throw std::runtime_error("ts_t multiplication failure");
+    }
+
+    ts_t ret;
+    ret.set_symbol_set(b.get_symbol_set());
+    for (const auto &[k1, c1] : a) {
+        for (const auto &[k2, c2] : b) {
+            if (a.is_single_cf()) {
+                ret.add_term(k2, c1 * c2);
+            } else {
+                pm_t k;
+                obake::monomial_mul(k, k1, k2, b.get_symbol_set());
+                ret.add_term(k, c1 * c2);
+            }
+        }
+    }
+
+    return ret;
+}
+
+} // namespace ns
+
 TEST_CASE("series_pow_test")
 {
     obake_test::disable_slow_stack_traces();
@@ -107,14 +153,222 @@ TEST_CASE("series_pow_test")
               "series/coefficient types do not support the necessary operations)");
 
     // Test clearing of the cache.
-    auto [map, _] = customisation::internal::get_series_pow_map();
-    detail::ignore(_);
+    REQUIRE(get_series_pow_cache_stats().n_entries != 0u);
+
+    customisation::internal::clear_series_pow_map();
 
-    REQUIRE(!map.empty());
+    REQUIRE(get_series_pow_cache_stats().n_entries == 0u);
+}
+
+TEST_CASE("series_pow_cache_test")
+{
+    obake_test::disable_slow_stack_traces();
+
+    using pm_t = packed_monomial<std::int32_t>;
+    using p1_t = polynomial<pm_t, rat_t>;
+    using p2_t = polynomial<pm_t, mppp::integer<1>>;
 
     customisation::internal::clear_series_pow_map();
 
-    REQUIRE(map.empty());
+    auto stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 0u);
+    REQUIRE(stats.misses == 0u);
+    REQUIRE(stats.evictions == 0u);
+    REQUIRE(stats.n_entries == 0u);
+    REQUIRE(stats.n_bytes == 0u);
+
+    const auto orig_max_size = get_series_pow_cache_max_size();
+    REQUIRE(orig_max_size > 0u);
+
+    auto [x, y] = make_polynomials<p1_t>("x", "y");
+    auto [a, b] = make_polynomials<p2_t>("a", "b");
+
+    // Hits and misses.
+    REQUIRE(obake::pow(x + y, 3) == (x + y) * (x + y) * (x + y));
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 0u);
+    REQUIRE(stats.misses == 1u);
+    REQUIRE(stats.n_entries == 1u);
+    REQUIRE(stats.n_bytes > 0u);
+    const auto n_bytes_3 = stats.n_bytes;
+
+    REQUIRE(obake::pow(x + y, 2) == (x + y) * (x + y));
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 1u);
+    REQUIRE(stats.misses == 1u);
+    REQUIRE(stats.n_entries == 1u);
+    // No new powers were computed.
+    REQUIRE(stats.n_bytes == n_bytes_3);
+
+    REQUIRE(obake::pow(x + y, 5) == (x + y) * (x + y) * (x + y) * (x + y) * (x + y));
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 2u);
+    REQUIRE(stats.n_bytes > n_bytes_3);
+
+    // Different series type, and different base.
+    REQUIRE(obake::pow(a - b, 4) == (a - b) * (a - b) * (a - b) * (a - b));
+    REQUIRE(obake::pow(x - y, 2) == (x - y) * (x - y));
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 2u);
+    REQUIRE(stats.misses == 3u);
+    REQUIRE(stats.n_entries == 3u);
+    REQUIRE(stats.evictions == 0u);
+
+    // Eviction: (x + y) is the least recently used base.
+    set_series_pow_cache_max_size(stats.n_bytes - 1u);
+    REQUIRE(get_series_pow_cache_max_size() == stats.n_bytes - 1u);
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.evictions == 1u);
+    REQUIRE(stats.n_entries == 2u);
+    REQUIRE(stats.n_bytes <= get_series_pow_cache_max_size());
+    REQUIRE(obake::pow(a - b, 1) == a - b);
+    REQUIRE(obake::pow(x - y, 1) == x - y);
+    REQUIRE(get_series_pow_cache_stats().hits == 4u);
+    REQUIRE(obake::pow(x + y, 1) == x + y);
+    REQUIRE(get_series_pow_cache_stats().misses == 4u);
+
+    // A zero limit disables the cache.
+    set_series_pow_cache_max_size(0);
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.n_entries == 0u);
+    REQUIRE(stats.n_bytes == 0u);
+    REQUIRE(obake::pow(x + y, 4) == (x + y) * (x + y) * (x + y) * (x + y));
+    REQUIRE(get_series_pow_cache_stats().n_entries == 0u);
+
+    set_series_pow_cache_max_size(orig_max_size);
+
+    // Failures in the computation of the powers: the claimed
+    // powers are discarded, and recomputed by the next request.
+    customisation::internal::clear_series_pow_map();
+
+    ns::ts_t c;
+    c.set_symbol_set(symbol_set{"x", "y"});
+    c.add_term(pm_t{1, 0}, 1);
+    c.add_term(pm_t{0, 1}, 1);
+    const auto c3 = c * c * c;
+
+    ns::ts_mul_throw.store(true);
+    OBAKE_REQUIRES_THROWS_CONTAINS(obake::pow(c, 3), std::runtime_error, "ts_t multiplication failure");
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.misses == 1u);
+    REQUIRE(stats.n_entries == 1u);
+
+    ns::ts_mul_throw.store(false);
+    REQUIRE(obake::pow(c, 3) == c3);
+    REQUIRE(obake::pow(c, 2) == c * c);
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.hits == 2u);
+    REQUIRE(stats.misses == 1u);
+
+    // The memory limit must be enforced also
+    // if the computation of the powers fails.
+    customisation::internal::clear_series_pow_map();
+    set_series_pow_cache_max_size(0);
+
+    ns::ts_mul_throw.store(true);
+    OBAKE_REQUIRES_THROWS_CONTAINS(obake::pow(c, 3), std::runtime_error, "ts_t multiplication failure");
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.n_entries == 0u);
+    REQUIRE(stats.n_bytes == 0u);
+
+    ns::ts_mul_throw.store(false);
+    REQUIRE(obake::pow(c, 3) == c3);
+    REQUIRE(get_series_pow_cache_stats().n_entries == 0u);
+
+    set_series_pow_cache_max_size(orig_max_size);
+
+    // Concurrent requests for the same bases.
+    customisation::internal::clear_series_pow_map();
+
+    const auto f = x + y - 1, g = x * y + 2;
+    std::vector<p1_t> ref_f{p1_t{1}}, ref_g{p1_t{1}};
+    for (auto i = 0; i < 20; ++i) {
+        ref_f.push_back(ref_f.back() * f);
+        ref_g.push_back(ref_g.back() * g);
+    }
+
+    std::atomic<bool> mismatch = false;
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, 400), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            const auto n = 1u + (i * 7u) % 20u;
+            if (obake::pow(i % 2u == 0u ? f : g, n) != (i % 2u == 0u ? ref_f : ref_g)[n]) {
+                mismatch.store(true);
+            }
+        }
+    });
+    REQUIRE(!mismatch.load());
+
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.n_entries == 2u);
+    REQUIRE(stats.hits + stats.misses == 400u);
+    REQUIRE(stats.misses >= 2u);
+
+    // Concurrent requests for segmented bases: the lookups
+    // in the cache spawn TBB tasks while the cache is locked.
+    customisation::internal::clear_series_pow_map();
+
+    std::vector<p1_t> seg_bases;
+    for (auto i = 0; i < 4; ++i) {
+        auto tmp = (x + y + i) * (x - y - 1) * (x * y + 2);
+        tmp = tmp * tmp * tmp;
+
+        p1_t sb;
+        sb.set_symbol_set(tmp.get_symbol_set());
+        sb.set_n_segments(4);
+        for (const auto &t : tmp) {
+            sb.add_term(t.first, t.second);
+        }
+        seg_bases.push_back(std::move(sb));
+    }
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, 200), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            // NOTE: use a copy of the base and discard its
+            // cached hash (via the mutable tag() getter),
+            // so that the hash needs to be recomputed.
+            auto b = seg_bases[i % 4u];
+            static_cast<void>(b.tag());
+            if (b._hash_is_cached()) {
+                mismatch.store(true);
+            }
+            if (obake::pow(b, 1u + i % 3u) != obake::pow(seg_bases[i % 4u], 1u + i % 3u)) {
+                mismatch.store(true);
+            }
+        }
+    });
+    REQUIRE(!mismatch.load());
+    REQUIRE(get_series_pow_cache_stats().n_entries == 4u);
+
+    // Concurrent requests for large powers, whose computation
+    // uses the parallel multiplication algorithms: the threads
+    // waiting for the powers must not steal the tasks
+    // requesting the powers of the same base.
+    customisation::internal::clear_series_pow_map();
+
+    auto [z, t] = make_polynomials<p1_t>("z", "t");
+    const auto h = obake::pow(x + y + 2 * z - t + 1, 6), k = obake::pow(x - 3 * y + z + t - 2, 6);
+    customisation::internal::clear_series_pow_map();
+    const std::vector<p1_t> ref_h{h, h * h, h * h * h}, ref_k{k, k * k, k * k * k};
+
+    tbb::parallel_for(tbb::blocked_range<unsigned>(0, 24), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            const auto n = 1u + (i / 2u) % 3u;
+            if (obake::pow(i % 2u == 0u ? h : k, n) != (i % 2u == 0u ? ref_h : ref_k)[n - 1u]) {
+                mismatch.store(true);
+            }
+        }
+    });
+    REQUIRE(!mismatch.load());
+    REQUIRE(get_series_pow_cache_stats().n_entries == 2u);
+
+    // Test clearing of the cache.
+    customisation::internal::clear_series_pow_map();
+
+    stats = get_series_pow_cache_stats();
+    REQUIRE(stats.n_entries == 0u);
+    REQUIRE(stats.n_bytes == 0u);
+    REQUIRE(stats.hits == 0u);
+    REQUIRE(stats.misses == 0u);
 }
 
 TEST_CASE("series_evaluate_test")
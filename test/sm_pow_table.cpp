@@ -0,0 +1,169 @@
+// Copyright 2019-2020 Francesco Biscani (bluescarni@gmail.com)
+//
+// This file is part of the obake library.
+//
+// This Source Code Form is subject to the terms of the Mozilla
+// Public License v. 2.0. If a copy of the MPL was not distributed
+// with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+
+#include <obake/config.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <mp++/integer.hpp>
+
+#include <obake/detail/sm_pow_table.hpp>
+#include <obake/key/key_evaluate.hpp>
+#include <obake/math/pow.hpp>
+#include <obake/polynomials/d_packed_monomial.hpp>
+#include <obake/polynomials/monomial_subs.hpp>
+#include <obake/polynomials/packed_monomial.hpp>
+#include <obake/symbols.hpp>
+#include <obake/type_traits.hpp>
+
+#include "catch.hpp"
+
+using namespace obake;
+
+using int_t = mppp::integer<1>;
+
+// A type which counts the number of
+// exponentiations.
+std::atomic<int> n_pow{0};
+
+struct cpow_t {
+    cpow_t() = default;
+    cpow_t(int n) : value(n) {}
+
+    cpow_t &operator*=(const cpow_t &other)
+    {
+        value *= other.value;
+        return *this;
+    }
+
+    friend bool operator==(const cpow_t &a, const cpow_t &b)
+    {
+        return a.value == b.value;
+    }
+
+    friend cpow_t pow(const cpow_t &b, const std::int32_t &n)
+    {
+        ++n_pow;
+
+        return cpow_t{static_cast<int>(obake::pow(int_t{b.value}, n))};
+    }
+
+    int value = 0;
+};
+
+TEST_CASE("sm_pow_table_basic")
+{
+    using table_t = detail::sm_pow_table<int_t, std::int32_t>;
+
+    REQUIRE(std::is_same_v<table_t::value_type, int_t>);
+
+    const symbol_idx_map<int_t> sm{{0, int_t{2}}, {2, int_t{-3}}};
+    table_t pt(sm);
+
+    REQUIRE(&pt.get_map() == &sm);
+    REQUIRE(pt(0, 0) == 1);
+    REQUIRE(pt(0, 10) == 1024);
+    REQUIRE(pt(1, 3) == -27);
+    REQUIRE(pt(1, 3) == -27);
+
+    // The references to the stored powers are stable.
+    const auto &r = pt(0, 5);
+    for (std::int32_t i = 0; i < 100; ++i) {
+        REQUIRE(pt(0, i) == obake::pow(int_t{2}, i));
+    }
+    REQUIRE(r == 32);
+
+    // The powers are computed only once.
+    const symbol_idx_map<cpow_t> csm{{0, cpow_t{2}}, {1, cpow_t{3}}};
+    detail::sm_pow_table<cpow_t, std::int32_t> cpt(csm);
+
+    n_pow = 0;
+    REQUIRE(cpt(0, 4) == cpow_t{16});
+    REQUIRE(cpt(0, 4) == cpow_t{16});
+    REQUIRE(cpt(1, 2) == cpow_t{9});
+    REQUIRE(n_pow.load() == 2);
+}
+
+TEST_CASE("sm_pow_table_concurrent")
+{
+    const symbol_idx_map<int_t> sm{{0, int_t{2}}, {1, int_t{-3}}, {2, int_t{5}}};
+    detail::sm_pow_table<int_t, std::int32_t> pt(sm);
+
+    std::atomic<bool> ok{true};
+
+    ::tbb::parallel_for(::tbb::blocked_range<int>(0, 10000), [&](const auto &range) {
+        for (auto i = range.begin(); i != range.end(); ++i) {
+            const auto idx = static_cast<unsigned>(i % 3);
+            const auto n = static_cast<std::int32_t>(i % 50);
+
+            if (pt(idx, n) != obake::pow((sm.cbegin() + idx)->second, n)) {
+                ok = false;
+            }
+        }
+    });
+
+    REQUIRE(ok.load());
+}
+
+TEST_CASE("sm_pow_table_monomials")
+{
+    using pm_t = packed_monomial<std::int32_t>;
+    using dpm_t = d_packed_monomial<std::int32_t, 2>;
+
+    REQUIRE(is_detected_v<detail::key_evaluate_with_table_t, pm_t, int_t>);
+    REQUIRE(is_detected_v<detail::key_evaluate_with_table_t, dpm_t, int_t>);
+    REQUIRE(is_detected_v<detail::monomial_subs_with_table_t, pm_t, int_t>);
+    REQUIRE(is_detected_v<detail::monomial_subs_with_table_t, dpm_t, int_t>);
+    REQUIRE(!is_detected_v<detail::key_evaluate_with_table_t, int, int_t>);
+    REQUIRE(!is_detected_v<detail::monomial_subs_with_table_t, int, int_t>);
+
+    const symbol_set ss{"x", "y", "z"};
+
+    // Evaluation.
+    {
+        const symbol_idx_map<int_t> sm{{0, int_t{2}}, {1, int_t{-3}}, {2, int_t{5}}};
+        detail::sm_pow_table<int_t, std::int32_t> pt(sm);
+
+        for (const auto &p : {pm_t{1, 2, 3}, pm_t{0, 0, 0}, pm_t{4, 1, 3}}) {
+            REQUIRE(key_evaluate_with_table(p, pt, ss) == key_evaluate(p, sm, ss));
+        }
+        for (const auto &p : {dpm_t{1, 2, 3}, dpm_t{0, 0, 0}, dpm_t{4, 1, 3}}) {
+            REQUIRE(key_evaluate_with_table(p, pt, ss) == key_evaluate(p, sm, ss));
+        }
+    }
+
+    // Substitution.
+    {
+        const symbol_idx_map<int_t> sm{{0, int_t{2}}, {2, int_t{5}}};
+        detail::sm_pow_table<int_t, std::int32_t> pt(sm);
+
+        for (const auto &p : {pm_t{1, 2, 3}, pm_t{0, 0, 0}, pm_t{4, 1, 3}}) {
+            REQUIRE(monomial_subs_with_table(p, pt, ss) == monomial_subs(p, sm, ss));
+        }
+        for (const auto &p : {dpm_t{1, 2, 3}, dpm_t{0, 0, 0}, dpm_t{4, 1, 3}}) {
+            REQUIRE(monomial_subs_with_table(p, pt, ss) == monomial_subs(p, sm, ss));
+        }
+    }
+
+    // The powers are shared among the monomials.
+    {
+        const symbol_idx_map<cpow_t> sm{{0, cpow_t{2}}, {1, cpow_t{3}}, {2, cpow_t{1}}};
+        detail::sm_pow_table<cpow_t, std::int32_t> pt(sm);
+
+        n_pow = 0;
+        REQUIRE(key_evaluate_with_table(pm_t{1, 2, 3}, pt, ss) == cpow_t{18});
+        REQUIRE(key_evaluate_with_table(pm_t{1, 2, 4}, pt, ss) == cpow_t{18});
+        REQUIRE(key_evaluate_with_table(dpm_t{1, 2, 3}, pt, ss) == cpow_t{18});
+        REQUIRE(n_pow.load() == 4);
+    }
+}